@@ -14,6 +14,61 @@
 #include <string.h>
 #include <inttypes.h>
 #include <limits.h>
+#include <time.h>
+
+// SSE2 is used to scan buffers 16 bytes at a time where it is available. Define GF_NO_SIMD to only use plain C.
+#if !defined(GF_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define GF_SSE2
+#include <emmintrin.h>
+#endif
+
+// Files are checked with stat() and snapshots are mapped with mmap() where POSIX is available.
+// Define GF_NO_MMAP to read snapshots into memory instead.
+#if defined(__unix__) || defined(__APPLE__)
+#define GF_POSIX
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if !defined(GF_NO_MMAP)
+#define GF_MMAP
+#include <sys/mman.h>
+#endif
+#endif
+
+// Sharing snapshots also needs ftruncate(), which strict ISO C modes hide unless _POSIX_C_SOURCE is defined.
+// Older glibc needs -lrt for shm_open(). Define GF_NO_SHM to leave it out.
+#if defined(GF_MMAP) && !defined(GF_NO_SHM) && (!defined(__STRICT_ANSI__) || defined(_POSIX_C_SOURCE) || defined(_XOPEN_SOURCE))
+#define GF_SHM
+#endif
+
+// Files bigger than 2 GiB are seeked with fseeko() where POSIX has it and with _fseeki64() on Windows, since long can be 32 bits.
+// Strict ISO C modes hide fseeko() unless _POSIX_C_SOURCE is defined, and 32 bit glibc also needs _FILE_OFFSET_BITS=64.
+// Without them offsets that do not fit in a long fail instead of seeking to the wrong place.
+#if defined(_WIN32)
+#define GF_FSEEKI64
+#elif defined(GF_POSIX) && (!defined(__STRICT_ANSI__) || defined(_POSIX_C_SOURCE) || defined(_XOPEN_SOURCE))
+#define GF_FSEEKO
+#endif
+
+// gf_LoadBatch() loads files on threads where pthreads are available. Older glibc needs -pthread.
+// Define GF_NO_THREADS to load them one after another instead.
+#if defined(GF_POSIX) && !defined(GF_NO_THREADS)
+#define GF_THREADS
+#include <pthread.h>
+#endif
+
+// gf_LoadFiles() reads files with io_uring on Linux, which needs syscall(). Strict ISO C modes hide it unless _DEFAULT_SOURCE
+// or _GNU_SOURCE is defined. Otherwise, or where the kernel refuses io_uring, it reads them on threads. Define GF_NO_IO_URING to leave it out.
+#if defined(__linux__) && defined(GF_MMAP) && !defined(GF_NO_IO_URING) && (!defined(__STRICT_ANSI__) || defined(_DEFAULT_SOURCE) || defined(_GNU_SOURCE)) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <errno.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define GF_IO_URING
+#endif
+#endif
+#endif
 
 /*----------------------------------TYPEDEFS----------------------------------------*/
 
@@ -24,6 +79,15 @@ typedef int64_t  gf_s64;
 typedef float    gf_f32;
 typedef double   gf_f64;
 
+/*
+A string that is not copied. start points to the text and length is the number of bytes in it.
+The text is not NULL terminated.
+*/
+typedef struct gf_StringView {
+	const char *start; // The first character of the string.
+	gf_u64 length;     // The number of characters in the string.
+} gf_StringView;
+
 /*----------------------------------------------------------------------------------*/
 
 /*-------------------------STRING CONVERSIONS---------------------------------------*/
@@ -111,6 +175,36 @@ Returns:     Returns 1 if the conversion was successful. 0 if it was not success
 */
 int gf_StringSpanToF32(const char *start, uint64_t length, gf_f32 *value);
 
+/*
+The size of a buffer that can hold any finite 64 bit floating point number written by gf_F64ToString(), including the NULL terminator.
+*/
+#define GF_F64_STRING_CAPACITY 360
+
+/*
+Name:        int gf_F64ToString(gf_f64 value, char *buffer, gf_u64 capacity);
+Description: Writes value as text that loads back to the exact same double => 0.1, -2.5, 100.0
+             The fraction uses the fewest digits that load back to value. The integer part is written in full, since there is
+             no exponent, so 1e300 takes all 301 digits of the double nearest to it. That and the 324 decimals of the
+             smallest doubles are why GF_F64_STRING_CAPACITY is 360.
+             The text always has a decimal point and never uses an exponent, so the tokeniser reads it as a float.
+Assumptions: - *buffer is not NULL.
+             - capacity is the size of buffer including the NULL terminator. GF_F64_STRING_CAPACITY is always big enough.
+Returns:     Returns 1 if the conversion was successful. 0 if value is infinite or NaN, or the buffer is too small.
+*/
+int gf_F64ToString(gf_f64 value, char *buffer, gf_u64 capacity);
+
+/*
+Name:        gf_u64 gf_DecodeEscapes(const char *text, gf_u64 length, char *decoded);
+Description: Writes the text of a string with its escapes replaced => \" is ", \\ is \, \n, \t and \r are a newline, tab and carriage return.
+             A backslash before any other character is kept as it is written. The text between escapes is copied in runs that
+			 are found 16 bytes at a time with SSE2 where it is available.
+Assumptions: - *text is not NULL and is atleast length bytes long.
+             - *decoded is not NULL and is atleast length bytes long. The result is never longer than the text.
+			 - text and decoded do not overlap.
+Returns:     The length of the decoded text. No NULL terminator is written.
+*/
+gf_u64 gf_DecodeEscapes(const char *text, gf_u64 length, char *decoded);
+
 /*-----------------------------------------------------------------------------------*/
 
 /*-------------------------------------TOKENS----------------------------------------*/
@@ -128,6 +222,16 @@ typedef enum gf_TokenType {
 	GF_TOKEN_TYPE_VALUE_ASSIGN    // This token { which designates an assignment is about to happen for a composite token.
 } gf_TokenType;
 
+// Extra information about a token that is set while tokenising and parsing.
+typedef enum gf_TokenFlags {
+	GF_TOKEN_FLAG_NONE = 0,
+	GF_TOKEN_FLAG_HAS_VALUE_ASSIGN = 1 << 0, // A name token that is followed by a { so it is a list, even if the list is empty.
+	GF_TOKEN_FLAG_ESCAPED          = 1 << 1, // A string token whose text still has backslash escapes in it, as it was written in the buffer.
+	GF_TOKEN_FLAG_BINARY           = 1 << 2, // A number token loaded from a .gfb file. start points at its 8 byte little endian value, not at text.
+	GF_TOKEN_FLAG_UNSIGNED         = 1 << 3, // A binary integer token that holds a gf_u64 instead of a gf_s64.
+	GF_TOKEN_FLAG_DECODED          = 1 << 4  // A string token whose escapes were decoded into the arena. Where it was in the buffer is stored just before start.
+} gf_TokenFlags;
+
 /*
 Holds information about each token that is created from the tokeniser.
 Tokens are stored as a singly linked list where each token points to the next one.
@@ -136,8 +240,9 @@ typedef struct gf_Token {
 	const char *start;     // The pointer into the buffer that signifies the start string of the token.
 	gf_u64 length;         // The length of the start string.
 	gf_TokenType type;     // The token type
-	gf_u64 lineno;         // The line number that this token starts on.
-	gf_u64 colno;          // The column number on the current line that this token starts on.
+	gf_u32 flags;          // A combination of gf_TokenFlags.
+	gf_u64 lineno;         // The line number that this token starts on. 0 until it is worked out with gf_LocateToken().
+	gf_u64 colno;          // The column number on the current line that this token starts on. 0 until it is worked out with gf_LocateToken().
 	struct gf_Token *next; // The next token in the list
 } gf_Token;
 
@@ -165,6 +270,53 @@ Returns:     The names of the token type as a string. The string is NULL termina
 */
 const char *gf_TokenTypeToString(gf_TokenType type);
 
+/*
+Works out line and column numbers from the byte offsets of tokens, so that tokenising does not have to track them.
+Nothing is counted until a position is asked for, which normally only happens when an error is logged. If a loader
+is set the offsets of every line start are found once, in one pass, and kept in its arena. Otherwise the lines before
+the offset are counted each time.
+*/
+typedef struct gf_LineIndex {
+	const char *buffer;       // The buffer that the tokens point into. NULL if there is none.
+	gf_u64 count;             // The size of the buffer.
+	struct gf_Loader *loader; // The loader whose arena holds lineStarts. Can be NULL.
+	gf_u64 *lineStarts;       // The offset that each line after the first starts at. Built on first use.
+	gf_u64 lineCount;         // The number of offsets in lineStarts.
+	int built;                // 1 once lineStarts has been built.
+} gf_LineIndex;
+
+/*
+Name:        void gf_InitLineIndex(gf_LineIndex *lines, struct gf_Loader *loader, const char *buffer, gf_u64 count);
+Description: Points the line index at a buffer. Nothing is counted or allocated until a position is asked for.
+Assumptions: - *lines is not NULL.
+             - buffer can be NULL, in which case no token can be located.
+             - loader can be NULL. If it is not the line starts are allocated from its arena, so they are only valid until it is reset or unloaded.
+Returns:     Nothing.
+*/
+void gf_InitLineIndex(gf_LineIndex *lines, struct gf_Loader *loader, const char *buffer, gf_u64 count);
+
+/*
+Name:        int gf_LocateOffset(gf_LineIndex *lines, gf_u64 offset, gf_u64 *lineno, gf_u64 *colno);
+Description: Works out the line and column of a byte offset into the buffer of the line index. Lines and columns start at 1.
+             A \n, a \r or a \r\n ends a line.
+Assumptions: - *lines is not NULL and has been initialised with gf_InitLineIndex().
+             - *lineno and *colno are not NULL.
+Returns:     Returns 1 on success. 0 if the line index has no buffer. Offsets past the end of the buffer are clamped to the end.
+*/
+int gf_LocateOffset(gf_LineIndex *lines, gf_u64 offset, gf_u64 *lineno, gf_u64 *colno);
+
+/*
+Name:        int gf_LocateToken(gf_LineIndex *lines, gf_Token *token);
+Description: Fills in the lineno and colno of a token from where its start points in the buffer of the line index.
+             String tokens are located at their opening quote and the end token at the end of the text. A string with
+			 GF_TOKEN_FLAG_DECODED is located where it was before it was decoded.
+Assumptions: - *lines is not NULL and has been initialised with gf_InitLineIndex().
+             - *token is not NULL.
+Returns:     Returns 1 on success. 0 if the token does not point into the buffer, for instance a token made with the builder functions.
+             Its lineno and colno are left as they are then.
+*/
+int gf_LocateToken(gf_LineIndex *lines, gf_Token *token);
+
 /*----------------------------------------------------------------------------------*/
 
 /*-------------------------LOG AND FUNCTION POINTERS--------------------------*/
@@ -193,6 +345,25 @@ Description: This is the function signature for the free function. This can be u
 			 This function must be able to deal with NULL pointers.
 */
 typedef void (*gf_FreeFunctionPtr)(void *);
+/*
+Name:        gf_ContextAllocatorFunctionPtr
+Description: The signature of an allocation function that is passed the user context pointer of gf_LogAllocateFreeFunctions
+             along with the size. Use it to allocate from a per loader arena, a frame allocator or a per thread heap.
+			 It must allocate pointers that are not invalidated with subsequent allocations.
+*/
+typedef void *(*gf_ContextAllocatorFunctionPtr)(void *context, size_t size);
+/*
+Name:        gf_ContextFreeFunctionPtr
+Description: The signature of a free function that is passed the user context pointer. It must be able to deal with NULL pointers.
+*/
+typedef void (*gf_ContextFreeFunctionPtr)(void *context, void *pointer);
+/*
+Name:        gf_ContextReallocatorFunctionPtr
+Description: The signature of a reallocation function that is passed the user context pointer, the memory to grow or shrink,
+             its old size and the new size. Like realloc() it returns the new memory, which can be a different pointer, 
+			 and leaves the old memory alone if it fails.
+*/
+typedef void *(*gf_ContextReallocatorFunctionPtr)(void *context, void *pointer, size_t oldSize, size_t newSize);
 
 /*
 Name:        gf_LogAllocateFreeFunctions
@@ -200,11 +371,21 @@ Description: This is a helper struct that stores function pointers responsible f
              If any of these are NULL then gf_DefaultLog(), malloc() and free() are used respectively. 
 			 The allocator must obey the rules of malloc() which means it's pointers can not be invalidated after they 
 			 are allocated. free() must work on a NULL.
+			 If AllocateWithContext is not NULL the ...WithContext functions are used instead of Allocate and Free, and they
+			 are passed context. FreeWithContext can then be NULL for allocators that release everything at once, and 
+			 ReallocateWithContext can be NULL in which case memory is grown by allocating and copying.
+			 Zero initialise this struct so members you do not set are NULL => gf_LogAllocateFreeFunctions funcs = {0};
 */
 typedef struct gf_LogAllocateFreeFunctions {
 	gf_LogFunctionPtr Log;            // A pointer to the log function you want to use. If this is NULL gf_DefaultLog() is used
 	gf_AllocatorFunctionPtr Allocate; // A pointer to the allocation function you want to use. If this is NULL malloc() is used.
 	gf_FreeFunctionPtr Free;          // A pointer to the free function you want to use. If this is NULL free() is used.
+	void *context;                                        // Passed to the ...WithContext functions. Can be NULL.
+	gf_ContextAllocatorFunctionPtr AllocateWithContext;     // If this is not NULL it is used instead of Allocate.
+	gf_ContextFreeFunctionPtr FreeWithContext;              // Used instead of Free when AllocateWithContext is set. Can be NULL.
+	gf_ContextReallocatorFunctionPtr ReallocateWithContext; // Used to grow memory when AllocateWithContext is set. Can be NULL.
+	gf_u32 loaderFlags;                                     // A combination of gf_LoaderFlags. 0 for the defaults.
+	gf_u64 maxDepth;                                        // The deepest lists can be nested when loading. 0 for GF_DEFAULT_MAX_DEPTH.
 } gf_LogAllocateFreeFunctions;
 
 /*
@@ -216,6 +397,14 @@ Returns:     Nothing.
 */
 void gf_DefaultLog(gf_LogLevel level, int lineno, gf_Token *, const char *format, va_list vlist);
 
+/*
+Name:        void gf_NoLog(gf_LogLevel level, int lineno, gf_Token *, const char *format, va_list vlist);
+Description: A logging function that does nothing. Pass it in gf_LogAllocateFreeFunctions to keep a loader quiet.
+Assumptions: None.
+Returns:     Nothing.
+*/
+void gf_NoLog(gf_LogLevel level, int lineno, gf_Token *, const char *format, va_list vlist);
+
 /*
 Name:        void gf_Log(gf_LogFunctionPtr Log, gf_LogLevel level, int lineno, gf_Token *, const char *format, ...);
 Description: An internal function that is called when the logging macro is invoked. This function calls the user specified log function.
@@ -225,6 +414,16 @@ Returns:     Nothing.
 */
 void gf_Log(gf_LogFunctionPtr Log, gf_LogLevel level, int lineno, gf_Token *, const char *format, ...);
 
+/*
+Name:        void gf_LogAtToken(gf_LogFunctionPtr Log, gf_LineIndex *lines, gf_LogLevel level, int lineno, gf_Token *, const char *format, ...);
+Description: The same as gf_Log but a token that has not been located yet is passed to Log as a copy with its line and column
+             worked out from the line index. The token itself is not changed.
+Assumptions: - *lines is not NULL.
+			 - The token can be NULL.
+Returns:     Nothing.
+*/
+void gf_LogAtToken(gf_LogFunctionPtr Log, gf_LineIndex *lines, gf_LogLevel level, int lineno, gf_Token *, const char *format, ...);
+
 /*
 Name:        GF_LOG(loaderOrSaver, level, ...) gf_Log(loaderOrSaver->Log, level, __LINE__, NULL, __VA_ARGS__)
 Description: A helper macro that calls gf_Log which in turn, calls the users logging function. A macro is used so the line number can be obtained
@@ -234,30 +433,56 @@ Returns:     Nothing.
 #define GF_LOG(loaderOrSaver, level, ...) gf_Log(loaderOrSaver->Log, level, __LINE__, NULL, __VA_ARGS__)
 
 /*
-Name:        GF_LOG(loaderOrSaver, level, ...) gf_Log(loaderOrSaver->Log, level, __LINE__, NULL, __VA_ARGS__)
-Description: The same as GF_LOG but with a token too.
-Assumptions: - loaderOrSave is not NULL and is of type gf_Loader or gf_Saver.
+Name:        GF_LOG_WITH_TOKEN(loaderOrTokeniser, level, token, ...) gf_LogAtToken(loaderOrTokeniser->Log, &loaderOrTokeniser->lines, level, __LINE__, token, __VA_ARGS__)
+Description: The same as GF_LOG but with a token too. The line and column of the token are worked out when it is logged.
+Assumptions: - loaderOrTokeniser is not NULL and is of type gf_Loader or gf_Tokeniser.
              - The token can be NULL.
 Returns: Nothing.
 */
-#define GF_LOG_WITH_TOKEN(loaderOrSaver, level, token, ...) gf_Log(loaderOrSaver->Log, level, __LINE__, token, __VA_ARGS__)
+#define GF_LOG_WITH_TOKEN(loaderOrTokeniser, level, token, ...) gf_LogAtToken(loaderOrTokeniser->Log, &loaderOrTokeniser->lines, level, __LINE__, token, __VA_ARGS__)
 
 /*-----------------------------------------------------------------------------------*/
 
 /*--------------------------------------SAVER----------------------------------------*/
 
+// Used to specify how the gf_Saver lays out the text it writes.
+typedef enum gf_SaverFormat {
+	GF_SAVER_FORMAT_PRETTY = 0,  // Two spaces of indentation per level and a newline after every variable. This is the default.
+	GF_SAVER_FORMAT_COMPACT,     // No indentation, no padding around braces, single space separators and a newline after every variable.
+	GF_SAVER_FORMAT_SINGLE_LINE  // The same as compact but everything inside a top level list is written on a single line.
+} gf_SaverFormat;
+
+// Used to specify where the gf_Saver writes the text to.
+typedef enum gf_SaverTarget {
+	GF_SAVER_TARGET_FILE = 0, // Text is written to the FILE passed to each gf_Save...() function. This is the default.
+	GF_SAVER_TARGET_MEASURE,  // Nothing is written. The saver only counts how many bytes would have been written.
+	GF_SAVER_TARGET_MEMORY,   // Text is written into the memory passed to gf_SaverBeginMemory().
+	GF_SAVER_TARGET_COMPRESSED // Text is compressed and written to the file passed to gf_SaverBeginCompressed().
+} gf_SaverTarget;
+
 // A helper function used to save data. Use this to begin "serialisation".
 typedef struct gf_Saver {
-	gf_LogFunctionPtr Log; // The function used to log errors.
-	unsigned int indent;   // Tracks the current indent level of your data. Each level of nested data has an indentation.
+	gf_LogFunctionPtr Log;      // The function used to log errors.
+	unsigned int indent;        // Tracks the current indent level of your data. Each level of nested data has an indentation.
+	gf_SaverFormat format;      // How the saved text is laid out. This is chosen when the saver is initialised.
+	const char *openBrace;      // The text written between an identifier and its values. " { " or "{" depending on the format.
+	const char *closeBrace;     // The text written after the values of a variable. " }" or "}" depending on the format.
+	const char *valueSeparator; // The text written between the values of an array. ", " or " " depending on the format.
+	int needsSeparator;         // Set when the single line format must write a space before the next variable.
+	gf_SaverTarget target;      // Where the text is written to.
+	char *memory;               // The memory written to when the target is GF_SAVER_TARGET_MEMORY.
+	gf_u64 memoryCapacity;      // The size of memory in bytes, including room for the NULL terminator.
+	gf_u64 written;             // The number of bytes written (or measured) since the saver was initialised or the target was changed.
+	struct gf_Compressor *compressor; // Compresses the text when the target is GF_SAVER_TARGET_COMPRESSED.
 } gf_Saver;
 
 /*
 Name:        void gf_InitSaver(gf_Saver *saver, gf_LogFunctionPtr logfunction);
-Description: Initialises the gf_Saver. Must be called before using the gf_Saver. 
+Description: Initialises the gf_Saver. Must be called before using the gf_Saver.
              You can call it again to reset the saver.
              If the logfunction is set to the NULL the default gf_DefaultLog function is used instead.
              logfunction is a function pointer to a logging function of gf_LogFunctionPtr signature.
+			 The saver uses the GF_SAVER_FORMAT_PRETTY format. Use gf_InitSaverWithFormat to choose another one.
 Assumptions: - saver is not NULL.
              - logfunction can be NULL. If it is, the default logging function is used.
 Returns:     Nothing.
@@ -269,9 +494,121 @@ Examples:
 */
 void gf_InitSaver(gf_Saver *saver, gf_LogFunctionPtr logfunction);
 
+/*
+Name:        void gf_InitSaverWithFormat(gf_Saver *saver, gf_LogFunctionPtr logfunction, gf_SaverFormat format);
+Description: The same as gf_InitSaver but lets you choose how the saved text is laid out.
+             GF_SAVER_FORMAT_COMPACT drops the indentation and the padding so "a { 1, 2 }" is written as "a{1 2}".
+			 GF_SAVER_FORMAT_SINGLE_LINE additionally writes everything inside a top level list on one line,
+			 so each top level variable or list ends up on its own line.
+			 Every format can be loaded back with the gf_Loader. Use gf_Reformat to turn one format into another.
+Assumptions: - saver is not NULL.
+             - logfunction can be NULL. If it is, the default logging function is used.
+			 - format is a valid gf_SaverFormat.
+Returns:     Nothing.
+Examples:
+{
+	gf_Saver saver;
+	gf_InitSaverWithFormat(&saver, NULL, GF_SAVER_FORMAT_COMPACT);
+}
+*/
+void gf_InitSaverWithFormat(gf_Saver *saver, gf_LogFunctionPtr logfunction, gf_SaverFormat format);
+
+/*
+Name:        void gf_SaverBeginMeasure(gf_Saver *saver);
+Description: Switches the saver to measuring. Every following gf_Save...() call writes nothing and only counts the
+             number of bytes it would have written. Call gf_SaverGetWrittenCount() afterwards to get the exact size of the text.
+			 The file passed to the gf_Save...() functions can be NULL while measuring.
+			 Together with gf_SaverBeginMemory() this lets you save into one exactly sized allocation.
+Assumptions: - gf_InitSaver must have been called on saver atleast once.
+             - *saver is not NULL
+Returns:     Nothing.
+Examples:
+{
+	gf_Saver saver;
+	gf_InitSaver(&saver, NULL);
+
+	gf_u32 value = 1;
+
+	gf_SaverBeginMeasure(&saver);
+	gf_SaveVariableU32(&saver, NULL, "identifier", &value);
+	gf_u64 count = gf_SaverGetWrittenCount(&saver);
+
+	char *memory = malloc(count + 1);
+	gf_SaverBeginMemory(&saver, memory, count + 1);
+	gf_SaveVariableU32(&saver, NULL, "identifier", &value);
+
+	// memory now holds count characters followed by a NULL terminator.
+	free(memory);
+}
+*/
+void gf_SaverBeginMeasure(gf_Saver *saver);
+
+/*
+Name:        void gf_SaverBeginMemory(gf_Saver *saver, char *memory, gf_u64 capacity);
+Description: Switches the saver to writing into memory. Every following gf_Save...() call appends its text to memory.
+             The text is always kept NULL terminated so it can be passed straight to gf_LoadFromBuffer().
+			 capacity is the size of memory, so it must be atleast the measured size + 1 for the NULL terminator.
+			 Nothing is ever reallocated. If the text does not fit, the gf_Save...() call fails and the error is logged.
+			 The file passed to the gf_Save...() functions can be NULL while writing to memory.
+Assumptions: - gf_InitSaver must have been called on saver atleast once.
+             - *saver is not NULL
+			 - *memory is not NULL and is atleast capacity bytes long.
+			 - capacity is atleast 1.
+Returns:     Nothing.
+Examples: See gf_SaverBeginMeasure.
+*/
+void gf_SaverBeginMemory(gf_Saver *saver, char *memory, gf_u64 capacity);
+
+/*
+Name:        gf_u64 gf_SaverGetWrittenCount(gf_Saver *saver);
+Description: Returns the number of bytes written or measured since the saver was initialised, or since the last call
+             to gf_SaverBeginMeasure() or gf_SaverBeginMemory(). The NULL terminator kept in memory is not counted.
+Assumptions: - gf_InitSaver must have been called on saver atleast once.
+             - *saver is not NULL
+Returns:     The number of bytes.
+*/
+gf_u64 gf_SaverGetWrittenCount(gf_Saver *saver);
+
+/*
+Name:        int gf_SaverPrintf(gf_Saver *saver, FILE *file, const char *format, ...);
+Description: Internal function that every gf_Save...() function writes formatted text through.
+             Depending on the target of the saver this writes to the file, only counts the bytes, or writes into memory.
+Assumptions: - gf_InitSaver must have been called on saver atleast once.
+             - *saver is not NULL
+             - *file is not NULL and is a valid file when the target is GF_SAVER_TARGET_FILE.
+			 - *format is not NULL.
+Returns:     The number of bytes written like fprintf(). A negative value if writing failed or the memory is too small, which is logged.
+*/
+int gf_SaverPrintf(gf_Saver *saver, FILE *file, const char *format, ...);
+
+/*
+Name:        int gf_SaverWrite(gf_Saver *saver, FILE *file, const char *data, gf_u64 length);
+Description: Internal function that writes a span of bytes to the target of the saver. See gf_SaverPrintf.
+Assumptions: - gf_InitSaver must have been called on saver atleast once.
+             - *saver is not NULL
+             - *file is not NULL and is a valid file when the target is GF_SAVER_TARGET_FILE.
+			 - *data is not NULL and is atleast length bytes long.
+Returns:     1 if it was successful. 0 if not. If an error occurs this is logged.
+*/
+int gf_SaverWrite(gf_Saver *saver, FILE *file, const char *data, gf_u64 length);
+
+/*
+Name:        int gf_SaverWriteEscaped(gf_Saver *saver, FILE *file, const char *text, gf_u64 length);
+Description: Internal function that writes the text of a string with a backslash before every quote " and backslash \, so that
+             it loads back as the same text. The rest is written in runs that are found 16 bytes at a time with SSE2 where it is available.
+Assumptions: - gf_InitSaver must have been called on saver atleast once.
+             - *saver is not NULL
+             - *file is not NULL and is a valid file when the target is GF_SAVER_TARGET_FILE.
+			 - *text is not NULL and is atleast length bytes long.
+Returns:     1 if it was successful. 0 if not. If an error occurs this is logged.
+*/
+int gf_SaverWriteEscaped(gf_Saver *saver, FILE *file, const char *text, gf_u64 length);
+
 /*
 Name:        int gf_PrintIndent(gf_Saver *saver, FILE *file);
-Description: Internal function used to insert spaces into the file corresponding to the current indent level of the saver.
+Description: Internal function called before a variable is written. For the pretty format this inserts spaces into the file
+             corresponding to the current indent level of the saver. For the single line format this writes the space
+			 that separates the variable from the one before it.
 Assumptions: - gf_InitSaver must have been called on saver atleast once.
              - *saver is not NULL
              - *file is not NULL and is a valid file.
@@ -279,6 +616,17 @@ Returns:     1 if it was successful. 0 if not. If an error occurs this is logged
 */
 int gf_PrintIndent(gf_Saver *saver, FILE *file);
 
+/*
+Name:        int gf_PrintVariableEnd(gf_Saver *saver, FILE *file);
+Description: Internal function called after a variable is written. Writes a newline unless the single line format
+             is inside a list, in which case the next variable is separated by a space instead.
+Assumptions: - gf_InitSaver must have been called on saver atleast once.
+             - *saver is not NULL
+             - *file is not NULL and is a valid file.
+Returns:     1 if it was successful. 0 if not. If an error occurs this is logged.
+*/
+int gf_PrintVariableEnd(gf_Saver *saver, FILE *file);
+
 /*
 Name:        int gf_SaveVariableS64(gf_Saver *saver, FILE *file, const char *identifier, gf_s64 *value);
 Description: Saves a variable to the file with the given value. This will be in the format "a { 2 }" 
@@ -390,7 +738,7 @@ int gf_SaveVariableU64(gf_Saver *saver, FILE *file, const char *identifier, gf_u
 /*
 Name:        int gf_SaveVariableString(gf_Saver *saver, FILE *file, const char *identifier, const char *str);
 Description: Saves a string to the file with the given value. This will be in the format "a { "Hello, world" }" 
-             where "a" is the identifier and "Hello, world" is the string.
+             where "a" is the identifier and "Hello, world" is the string. Quotes and backslashes in the string are escaped.
 Assumptions: - gf_InitSaver must have been called on saver atleast once.
              - *saver is not NULL
              - *file is not NULL and is a valid file.
@@ -667,29 +1015,81 @@ Examples:
 */
 int gf_SaveEndList(gf_Saver *saver, FILE *file);
 
+/*
+Name:        int gf_SaveStartListSpan(gf_Saver *saver, FILE *file, const char *identifier, gf_u64 length);
+Description: The same as gf_SaveStartList but the identifier is a string span that does not need to be NULL terminated.
+Assumptions: - gf_InitSaver must have been called on saver atleast once.
+             - *saver is not NULL
+             - *file is not NULL and is a valid file.
+             - *identifier is not NULL and is atleast length characters long.
+             - When finished saving to this list you end with a call to gf_SaveEndList.
+Returns:     1 if it was successful. 0 if not. If an error occurs this is logged.
+*/
+int gf_SaveStartListSpan(gf_Saver *saver, FILE *file, const char *identifier, gf_u64 length);
+
+/*
+Name:        int gf_SaveToken(gf_Saver *saver, FILE *file, gf_Token *token);
+Description: Internal function that writes the text of a token to the file exactly as it appears in the buffer it was scanned from.
+             String tokens are surrounded by quotes. The text of a string token that was decoded by the loader, or made with the
+			 builder functions, is escaped again.
+Assumptions: - gf_InitSaver must have been called on saver atleast once.
+             - *saver is not NULL
+             - *file is not NULL and is a valid file.
+             - *token is not NULL and the buffer it points into is still valid.
+Returns:     1 if it was successful. 0 if not. If an error occurs this is logged.
+*/
+int gf_SaveToken(gf_Saver *saver, FILE *file, gf_Token *token);
+
+/*
+Name:        int gf_Reformat(gf_Saver *saver, FILE *file, const char *buffer, gf_u64 count);
+Description: Reads the graph text in buffer and writes it to the file again, laid out in the format of the saver.
+             Use this to pretty print a compact file for humans, or to compact a hand written file.
+			 This streams the tokens straight from the buffer to the file. Nothing is allocated and no node graph is built.
+			 Lists that only hold values are written on one line => "a { 1, 2, 3 }". Comments are not kept.
+Assumptions: - gf_InitSaver must have been called on saver atleast once.
+             - *saver is not NULL
+             - *file is not NULL and is a valid file.
+			 - *buffer is not NULL and is NULL terminated.
+			 - count is a valid length for the buffer.
+Returns:     1 if it was successful. 0 if the buffer could not be tokenised, the braces do not match or writing failed.
+             The error is logged.
+Examples:
+{
+	gf_Saver saver;
+	gf_InitSaverWithFormat(&saver, NULL, GF_SAVER_FORMAT_PRETTY);
+
+	const char *compact = "a{b{1 2 3}}";
+	gf_Reformat(&saver, stdout, compact, gf_StringLength(compact));
+}
+*/
+int gf_Reformat(gf_Saver *saver, FILE *file, const char *buffer, gf_u64 count);
+
 /*-----------------------------------------------------------------------------------*/
 
 /*------------------------------------LOADER-----------------------------------------*/
 
 /*
 Stores a pointer to a buffer that you want to tokeniser. Tracks the current index 
-into this buffer as you tokenise. Also tracks things like the current line number and 
-column number.
+into this buffer as you tokenise. Line and column numbers are not tracked, they are worked
+out from the line index when they are needed.
 */
 typedef struct gf_Tokeniser {
-	const char *buffer; // A pointer to a null terminated buffer that needs to be tokenised
-	gf_u64 index;       // The internal tracking index that records the current character in the buffer
-	gf_u64 count;       // The total size of the buffer.
-	gf_u64 lineno;      // The current line number.
-	gf_u64 colno;       // The current column number.
+	gf_LogFunctionPtr Log; // The function used to log errors found while tokenising.
+	const char *buffer;    // A pointer to a null terminated buffer that needs to be tokenised
+	gf_u64 index;          // The internal tracking index that records the current character in the buffer
+	gf_u64 count;          // The total size of the buffer.
+	gf_LineIndex lines;    // Locates tokens for error messages. It has no loader so nothing is allocated.
+	int validateUtf8;      // If this is not 0 string tokens must hold valid UTF-8. 0 by default.
+	const char *error;     // The message of the error that made gf_NextToken() fail. NULL if there was none.
 } gf_Tokeniser;
 
 /*
 Name:        void gf_InitTokeniser(gf_Tokeniser *tokeniser, const char *buffer, gf_u64 count);
-Description: Initialises the tokeniser. This must be called before using the tokeniser. You can call this multiple times to reset the tokeniser. 
-             The buffer you wish to tokenise is passed in, along with the buffer length (count). This is not copied. So, while you 
+Description: Initialises the tokeniser. This must be called before using the tokeniser. You can call this multiple times to reset the tokeniser.
+             The buffer you wish to tokenise is passed in, along with the buffer length (count). This is not copied. So, while you
 			 are tokenising and using the tokeniser, this buffer must be valid.
 			 This buffer must be NULL terminated.
+			 Errors are logged with gf_DefaultLog. Set the Log member afterwards to use your own logging function.
 Assumptions: - *tokeniser is not NULL
 			 - *buffer is not NULL and is NULL terminated.
 			 - The count must represent a valid length for the buffer. If NULL terminating character is 
@@ -719,15 +1119,6 @@ Returns:     Nothing.
 */
 void gf_IncrementIndex(gf_Tokeniser *tokeniser);
 
-/*
-Name:        void gf_IncrementLineNo(gf_Tokeniser *tokeniser);
-Description: Increments the current line number that is being tracked by the tokeniser.
-Assumptions: - tokeniser has been initialised with a call to gf_InitTokeniser();
-			 - *tokeniser is not NULL
-Returns:     Nothing.
-*/
-void gf_IncrementLineNo(gf_Tokeniser *tokeniser);
-
 /*
 Name:        const char *gf_Ptr(gf_Tokeniser *tokeniser);
 Description: Returns a pointer into the buffer pointed to by the tokeniser at the internal tokeniser index.
@@ -739,6 +1130,45 @@ Returns:     A pointer into the buffer that the tokeniser points to at the locat
 */
 const char *gf_Ptr(gf_Tokeniser *tokeniser);
 
+/*
+Name:        int gf_NextToken(gf_Tokeniser *tokeniser, gf_Token *token);
+Description: Scans the next token in the buffer pointed to by the tokeniser and writes it into *token.
+             Whitespace, commas and comments are skipped. Once the end of the buffer is reached every call
+			 returns a GF_TOKEN_TYPE_END_FILE token. Nothing is allocated, the token's start points into the buffer.
+			 The token's next member is set to NULL.
+Assumptions: - tokeniser has been initialised with a call to gf_InitTokeniser();
+			 - *tokeniser is not NULL
+			 - *token is not NULL
+Returns:     Returns 1 if a token was scanned. 0 if the text is not valid, for instance an unterminated string. The error is logged.
+*/
+int gf_NextToken(gf_Tokeniser *tokeniser, gf_Token *token);
+
+/*
+The class of a character as far as the tokeniser is concerned. Every character that can continue a name
+is GF_CHAR_CLASS_DIGIT or above.
+*/
+typedef enum gf_CharClass {
+	GF_CHAR_CLASS_INVALID = 0,  // A character that can not start a token.
+	GF_CHAR_CLASS_END,          // The NULL terminator.
+	GF_CHAR_CLASS_SPACE,        // A space, tab or comma.
+	GF_CHAR_CLASS_NEWLINE,      // \n
+	GF_CHAR_CLASS_RETURN,       // \r
+	GF_CHAR_CLASS_OPEN_BRACE,   // {
+	GF_CHAR_CLASS_CLOSE_BRACE,  // }
+	GF_CHAR_CLASS_SLASH,        // / which starts a comment.
+	GF_CHAR_CLASS_QUOTE,        // " which starts a string.
+	GF_CHAR_CLASS_SIGN,         // + or - which starts a number.
+	GF_CHAR_CLASS_DOT,          // . which is only part of a float.
+	GF_CHAR_CLASS_DIGIT,        // 0 to 9
+	GF_CHAR_CLASS_ALPHA,        // a to z and A to Z
+	GF_CHAR_CLASS_UNDERSCORE    // _ which is only part of a name.
+} gf_CharClass;
+
+/*
+Maps every byte to its gf_CharClass. Bytes above 127 are GF_CHAR_CLASS_INVALID.
+*/
+extern const unsigned char gf_CharClasses[256];
+
 /*
 A node that is stored as a graph that represents parsed text.
 A node has an associated token. When the text forms a list these 
@@ -755,6 +1185,55 @@ typedef struct gf_LoaderNode {
 	struct gf_LoaderNode *nextAllocated; // A helper linked list that tracks allocated nodes.
 } gf_LoaderNode;
 
+/*
+The default size of a block of memory that an arena allocates from the loader's allocator.
+Allocations bigger than this get a block of their own.
+*/
+#ifndef GF_ARENA_BLOCK_SIZE
+#define GF_ARENA_BLOCK_SIZE (64 * 1024)
+#endif
+
+/*
+Every allocation from an arena is aligned to this many bytes.
+*/
+#define GF_ARENA_ALIGNMENT 16
+
+/*
+The header of a block of memory owned by an arena. The memory handed out by the arena follows the header.
+*/
+typedef struct gf_ArenaBlock {
+	struct gf_ArenaBlock *next; // The next block of the arena.
+	gf_u64 capacity;            // The number of bytes after the header that can be handed out.
+	gf_u64 used;                // The number of bytes after the header that have been handed out.
+} gf_ArenaBlock;
+
+/*
+Hands out memory from big blocks that are allocated with the loader's allocator.
+Memory is never freed on its own, every block is freed at once in gf_Unload(). gf_ResetLoader() rewinds 
+the arena instead, so the blocks are handed out again by the next load.
+*/
+typedef struct gf_Arena {
+	gf_ArenaBlock *first;   // The first block of the arena.
+	gf_ArenaBlock *current; // The block that memory is currently handed out from.
+} gf_Arena;
+
+/*
+The deepest lists can be nested by default before loading fails => a { b { c { ... } } }
+Set maxDepth in gf_LogAllocateFreeFunctions to change it for a loader.
+*/
+#ifndef GF_DEFAULT_MAX_DEPTH
+#define GF_DEFAULT_MAX_DEPTH 1024
+#endif
+
+// Options that change how a loader loads. They are passed in with gf_LogAllocateFreeFunctions and kept by gf_Reload...().
+typedef enum gf_LoaderFlags {
+	GF_LOADER_FLAG_NONE          = 0,      // The default.
+	GF_LOADER_FLAG_PRESIZE       = 1 << 0, // Counts an upper bound of the tokens and nodes before tokenising and reserves the memory for them at once.
+	GF_LOADER_FLAG_VALIDATE_UTF8 = 1 << 1, // Fails the load if a string holds text that is not valid UTF-8. Names are always ASCII.
+	GF_LOADER_FLAG_CACHE         = 1 << 2, // gf_LoadFromFile() and gf_ReloadFromFile() keep a snapshot of the file next to it and map it instead when it is up to date.
+	GF_LOADER_FLAG_PIPELINE      = 1 << 3  // gf_LoadFromFile() and gf_ReloadFromFile() tokenise a big file while the rest of it is still being read.
+} gf_LoaderFlags;
+
 /*
 A helper function that is responsible for storing all tokens, nodes and potentially a buffer that
 was allocated when opening a file.
@@ -763,6 +1242,10 @@ typedef struct gf_Loader {
 	gf_LogFunctionPtr Log;            // The function used to log. 
 	gf_AllocatorFunctionPtr Allocate; // The function used to allocate. 
 	gf_FreeFunctionPtr Free;          // The function used to free
+	void *context;                                          // The user context passed to the ...WithContext functions.
+	gf_ContextAllocatorFunctionPtr AllocateWithContext;     // If this is not NULL it is used instead of Allocate.
+	gf_ContextFreeFunctionPtr FreeWithContext;              // Used instead of Free when AllocateWithContext is set. Can be NULL.
+	gf_ContextReallocatorFunctionPtr ReallocateWithContext; // Used to grow memory when AllocateWithContext is set. Can be NULL.
 	gf_Token rootToken;               // The root token that is always guaranteed to exist when parsing text.
 	gf_Token *lastToken;              // The last token in the token list.
 	gf_Token *firstToken;             // The first token in the token list.
@@ -770,7 +1253,15 @@ typedef struct gf_Loader {
 	gf_LoaderNode *rootNode;          // The root node in the node graph.
 	gf_LoaderNode *lastNode;          // The last allocated node in the node graph.
 	char *fileContentsBuffer;         // A pointer that points to memory allocated from a file.
+	gf_u64 fileContentsCapacity;      // The size of fileContentsBuffer. It is reused by gf_ReloadFromFile() when the file fits.
 	gf_u64 nestLevel;                 // When parsing, tracks how many {} we are nested in.
+	gf_Arena arena;                   // Holds the tokens and nodes of the graph and the text made with the builder functions.
+	gf_u32 flags;                     // A combination of gf_LoaderFlags.
+	gf_u64 maxDepth;                  // The deepest lists can be nested before loading fails.
+	gf_LineIndex lines;               // Locates tokens in the loaded text for error messages.
+	void *mapping;                    // The snapshot mapped by gf_MapSnapshot(). NULL when nothing is mapped.
+	gf_u64 mappingSize;               // The size of mapping in bytes.
+	int readOnly;                     // 1 when mapping can not be written to, so the builder functions can not change the graph.
 } gf_Loader;
 
 /*
@@ -787,6 +1278,38 @@ Returns:     Nothing.
 */
 void gf_InitLoader(gf_Loader *loader, gf_LogAllocateFreeFunctions *helperfunctions);
 
+/*
+Name:        void *gf_Allocate(gf_Loader *loader, gf_u64 size);
+Description: Allocates memory with the allocation function of the loader. AllocateWithContext is called with the user context
+             when it was given, otherwise Allocate is called. Every allocation the loader makes goes through here.
+Assumptions: - gf_InitLoader() has been called on *loader.
+			 - *loader is not NULL.
+Returns:     Returns the memory. Returns NULL if the allocation failed.
+*/
+void *gf_Allocate(gf_Loader *loader, gf_u64 size);
+
+/*
+Name:        void gf_Free(gf_Loader *loader, void *pointer);
+Description: Frees memory with the free function of the loader. Nothing happens when the context allocator has no free function.
+Assumptions: - gf_InitLoader() has been called on *loader.
+			 - *loader is not NULL.
+			 - pointer can be NULL.
+Returns:     Nothing.
+*/
+void gf_Free(gf_Loader *loader, void *pointer);
+
+/*
+Name:        void *gf_Reallocate(gf_Loader *loader, void *pointer, gf_u64 oldSize, gf_u64 newSize);
+Description: Grows or shrinks memory allocated with gf_Allocate(). ReallocateWithContext is called when it was given, otherwise
+             new memory is allocated, the smaller of the two sizes is copied and the old memory is freed.
+			 If this fails the old memory is left as it is.
+Assumptions: - gf_InitLoader() has been called on *loader.
+			 - *loader is not NULL.
+			 - pointer can be NULL, then oldSize must be 0.
+Returns:     Returns the new memory. Returns NULL if the allocation failed.
+*/
+void *gf_Reallocate(gf_Loader *loader, void *pointer, gf_u64 oldSize, gf_u64 newSize);
+
 /*
 Name:        void gf_IncrementLastTokenLength(gf_Loader *loader);
 Description: Increments the length of the last allocated token by loader.
@@ -798,9 +1321,9 @@ Returns:     Nothing.
 void gf_IncrementLastTokenLength(gf_Loader *loader);
 
 /*
-Name:        int gf_AddToken(gf_Loader *loader, const char *start, gf_TokenType type, gf_u64 lineno, gf_u64 colno);
-Description: Allocates a new token used by the loader. The user specified allocator is used when the loader is 
-             initialised. The token is given the specified type and lineno along with the start string within the loaded
+Name:        int gf_AddToken(gf_Loader *loader, const char *start, gf_TokenType type);
+Description: Allocates a new token used by the loader from the loader's arena. The arena allocates its blocks with
+             the user specified allocator of the loader. The token is given the specified type and lineno along with the start string within the loaded
 			 buffer. It starts with a length of 1.
 Assumptions: - gf_InitLoader() has been called on *loader.
 			 - gf_LoadInternal() has been called. i.e. some data has been loaded.
@@ -808,7 +1331,7 @@ Assumptions: - gf_InitLoader() has been called on *loader.
 			 - *start is not NULL
 Returns:     Returns 1 if it succeeds. 0 if it fails. The error is logged.
 */
-int gf_AddToken(gf_Loader *loader, const char *start, gf_TokenType type, gf_u64 lineno, gf_u64 colno);
+int gf_AddToken(gf_Loader *loader, const char *start, gf_TokenType type);
 
 /*
 Name:        char *gf_AllocateNullTerminatedBufferFromFile(gf_Loader *loader, const char *filename, gf_u64 *bufferCountWithNullTerminator);
@@ -825,6 +1348,105 @@ Returns:     Returns a terminated string that holds the entire contents of the f
 */
 char *gf_AllocateNullTerminatedBufferFromFile(gf_Loader *loader, const char *filename, gf_u64 *bufferCountWithNullTerminator);
 
+/*
+Name:        int gf_ReadFileIntoLoader(gf_Loader *loader, const char *filename, gf_u64 *bufferCountWithNullTerminator);
+Description: Reads the whole file into the file buffer of the loader and NULL terminates it. The buffer is only 
+             allocated again when the file does not fit into it. The buffer is owned by the loader and freed by gf_Unload().
+			 The size of the file including the NULL terminator is stored in bufferCountWithNullTerminator.
+Assumptions: - gf_InitLoader() has been called on *loader.
+			 - *loader is not NULL
+			 - *filename is NOT NULL
+			 - bufferCountWithNullTerminator is not NULL.
+Returns:     Returns 1 if this succeeds. 0 if the file could not be opened or read or the allocation failed. The error is logged.
+*/
+int gf_ReadFileIntoLoader(gf_Loader *loader, const char *filename, gf_u64 *bufferCountWithNullTerminator);
+
+/*
+Name:        int gf_SeekFile(FILE *file, gf_s64 offset, int origin);
+Description: fseek() with a 64 bit offset, so files bigger than 2 GiB can be seeked where long is 32 bits. See GF_FSEEKO.
+Assumptions: - *file is not NULL.
+             - origin is SEEK_SET, SEEK_CUR or SEEK_END.
+Returns:     Returns 1 if it succeeds. 0 if it fails or offset is further than this build can seek.
+*/
+int gf_SeekFile(FILE *file, gf_s64 offset, int origin);
+
+/*
+Name:        int gf_TellFile(FILE *file, gf_u64 *offset);
+Description: ftell() with a 64 bit offset. The position is stored in offset.
+Assumptions: - *file and *offset are not NULL.
+Returns:     Returns 1 if it succeeds. 0 if it fails or the position is further than this build can tell.
+*/
+int gf_TellFile(FILE *file, gf_u64 *offset);
+
+/*
+Name:        int gf_GetOpenFileSize(FILE *file, gf_u64 *size);
+Description: Stores the size of an open file in size and leaves the file at its start.
+Assumptions: - *file and *size are not NULL.
+Returns:     Returns 1 if it succeeds. 0 if the file can not be seeked or is bigger than this build can seek.
+*/
+int gf_GetOpenFileSize(FILE *file, gf_u64 *size);
+
+/*
+Name:        gf_u32 gf_CountBits(gf_u32 bits);
+Description: Counts the bits that are set.
+Assumptions: None.
+Returns:     The number of set bits.
+*/
+gf_u32 gf_CountBits(gf_u32 bits);
+
+/*
+Name:        void gf_CountTokenBounds(const char *buffer, gf_u64 count, gf_u64 *tokenCount, gf_u64 *nodeCount);
+Description: A fast pass over the buffer that works out how many tokens and nodes loading it can make at most, without tokenising it.
+             Braces, quotes, signs and the first character of every word and number are counted, 16 bytes at a time with SSE2 where
+			 it is available. Comments and the text inside strings are counted too, so the result can be bigger than what is loaded
+			 but never smaller for text that loads. Used by GF_LOADER_FLAG_PRESIZE.
+Assumptions: - *buffer is not NULL.
+			 - count is a valid length for the buffer.
+			 - *tokenCount and *nodeCount are not NULL.
+Returns:     Nothing. The token count includes the end token and the node count includes the root node.
+*/
+void gf_CountTokenBounds(const char *buffer, gf_u64 count, gf_u64 *tokenCount, gf_u64 *nodeCount);
+
+/*
+Name:        gf_u32 gf_LowestBit(gf_u32 bits);
+Description: Returns the index of the lowest bit that is set.
+Assumptions: - bits is not 0.
+Returns:     The index of the lowest set bit, from 0 to 31.
+*/
+gf_u32 gf_LowestBit(gf_u32 bits);
+
+/*
+Name:        gf_u64 gf_CountLineBreaks(const char *buffer, gf_u64 count, gf_u64 *lineStarts);
+Description: Counts the line breaks in the buffer, 16 bytes at a time with SSE2 where it is available. A \n, a \r or a
+             \r\n is one line break. If lineStarts is not NULL the offset just after each line break is written into it.
+			 Used to build a gf_LineIndex.
+Assumptions: - *buffer is not NULL.
+			 - count is a valid length for the buffer.
+			 - lineStarts is NULL or has room for every line break in the buffer.
+Returns:     The number of line breaks.
+*/
+gf_u64 gf_CountLineBreaks(const char *buffer, gf_u64 count, gf_u64 *lineStarts);
+
+/*
+Name:        const char *gf_FindFirstOf(const char *start, const char *end, char a, char b, char c);
+Description: Finds the first of three characters between start and end, 16 bytes at a time with SSE2 where it is available.
+             Used by the tokeniser to skip over the insides of strings and comments.
+Assumptions: - *start and *end are not NULL and start is not after end.
+Returns:     A pointer to the first a, b or c. end if there is none.
+*/
+const char *gf_FindFirstOf(const char *start, const char *end, char a, char b, char c);
+
+/*
+Name:        const char *gf_FindInvalidUtf8(const char *start, const char *end);
+Description: Finds the first byte between start and end that does not begin a valid UTF-8 sequence. Overlong encodings, surrogates,
+             code points above U+10FFFF and sequences cut short by end are invalid. Runs of ASCII are skipped 16 bytes at a time with
+			 SSE2 where it is available, so text that is mostly ASCII is checked at close to the speed it can be read.
+			 Used by the tokeniser when validateUtf8 is set.
+Assumptions: - *start and *end are not NULL and start is not after end.
+Returns:     A pointer to the first byte of the first invalid sequence. end if the text is valid.
+*/
+const char *gf_FindInvalidUtf8(const char *start, const char *end);
+
 /*
 Name:        int gf_TokeniseInternal(gf_Loader *loader, gf_Tokeniser *tokeniser);
 Description: An internal function that begins tokenising the buffer pointed to by the tokeniser.
@@ -836,6 +1458,19 @@ Returns:     Returns 1 if this succeeds. 0 if this fails. The error is logged.
 */
 int gf_TokeniseInternal(gf_Loader *loader, gf_Tokeniser *tokeniser);
 
+/*
+Name:        int gf_AddScannedToken(gf_Loader *loader, gf_Token *token);
+Description: An internal function that adds a token found by gf_NextToken() to the tokens of the loader. The text of a string
+             with escapes in it is decoded into the arena, after a pointer to where it was, so it can still be located. Every
+			 other token keeps pointing where it did. Its line and column are kept, so a caller that has worked them out
+			 already does not need the buffer to be located in later.
+Assumptions: - gf_InitLoader() has been called on *loader.
+			 - *loader is not NULL
+			 - *token is not NULL
+Returns:     Returns 1 if this succeeds. 0 if this fails. The error is logged.
+*/
+int gf_AddScannedToken(gf_Loader *loader, gf_Token *token);
+
 /*
 Name:        int gf_Tokenise(gf_Loader *loader, const char *buffer, gf_u64 count);
 Description: Tokenises the NULL terminated buffer that has the length count.
@@ -869,7 +1504,7 @@ gf_Token *gf_PeekToken(gf_Loader *loader);
 
 /*
 Name:        gf_LoaderNode *gf_AddNode(gf_Loader *loader, gf_Token *token);
-Description: Allocates a node using the specified allocation function. Assigns the token to this 
+Description: Allocates a node from the loader's arena. Assigns the token to this 
              node. Returns the newly allocated node.
 Assumptions: - gf_InitLoader() has been called on *loader.
 			 - *token is not NULL.
@@ -887,11 +1522,43 @@ Returns:     Nothing.
 */
 void gf_AddChild(gf_LoaderNode *parent, gf_LoaderNode *child);
 
+/*
+Name:        void *gf_ArenaAllocate(gf_Loader *loader, gf_u64 size);
+Description: Hands out size bytes from the arena of the loader. When the current block of the arena is full
+             a new block is allocated with the loader's allocator. The memory is aligned to GF_ARENA_ALIGNMENT
+			 and stays valid until gf_Unload() or gf_ResetLoader() is called. Blocks left over from before gf_ResetLoader() are
+			 used before new ones are allocated.
+Assumptions: - gf_InitLoader() has been called on *loader.
+			 - *loader is not NULL.
+Returns:     Returns the memory. Returns NULL if the allocation failed. The error is logged.
+*/
+void *gf_ArenaAllocate(gf_Loader *loader, gf_u64 size);
+
+/*
+Name:        int gf_ArenaReserve(gf_Loader *loader, gf_u64 size);
+Description: Makes sure the next size bytes allocated with gf_ArenaAllocate() come from one block without allocating again.
+             If the current block does not have the room, a left over block that does is used, or one big enough is allocated.
+Assumptions: - gf_InitLoader() has been called on *loader.
+			 - *loader is not NULL.
+Returns:     Returns 1 if it succeeds. Returns 0 if the allocation failed. The error is logged.
+*/
+int gf_ArenaReserve(gf_Loader *loader, gf_u64 size);
+
+/*
+Name:        void gf_FreeArena(gf_Loader *loader);
+Description: Frees every block of the arena of the loader with the loader's free function. This is called by gf_Unload().
+Assumptions: - gf_InitLoader() has been called on *loader.
+			 - *loader is not NULL.
+Returns:     Nothing.
+*/
+void gf_FreeArena(gf_Loader *loader);
+
 /*
 Name:        int gf_Parse(gf_Loader *loader, gf_LoaderNode *parentNode);
 Description: Parses the token list. The tokeniser must have been called before this happens and 
-             the root node of loader must have been created. This is a recursive function. The first time 
-			 you call it, parentNode must be the root node of the loader.
+             the root node of loader must have been created. The first time you call it, parentNode must be the root node of the loader.
+			 Nested lists are parsed in a loop that follows the parent links of the nodes back up, so the C stack does not grow with 
+			 the nesting. Nesting deeper than the maximum depth of the loader fails with an error.
 Assumptions: - gf_InitLoader() has been called on *loader.
 	         - The loader has performed tokenisation.
 			 - *loader is not NULL.
@@ -912,8 +1579,16 @@ Returns:     Returns 1 if it succeeds. Returns 0 if it fails. The error is logge
 int gf_LoadInternal(gf_Loader *loader, const char *buffer, gf_u64 bufferCount);
 
 /*
-Name:        int gf_LoadFromBuffer(gf_Loader *loader, const char *buffer, gf_u64 bufferCount, gf_LogAllocateFreeFunctions *funcs);
-Description: Begins tokenising and parsing the passed in buffer, preparing data that can be queried by the user.
+Name:        int gf_ParseTokens(gf_Loader *loader);
+Description: Internal function that parses the tokens of the loader into nodes under a new root node, once tokenising is done.
+Assumptions: - *loader is not NULL and has been tokenised.
+Returns:     Returns 1 if it succeeds. Returns 0 if it fails. The error is logged.
+*/
+int gf_ParseTokens(gf_Loader *loader);
+
+/*
+Name:        int gf_LoadFromBuffer(gf_Loader *loader, const char *buffer, gf_u64 bufferCount, gf_LogAllocateFreeFunctions *funcs);
+Description: Begins tokenising and parsing the passed in buffer, preparing data that can be queried by the user.
              This should be the first thing you call before using the loader. After you are done, you need to call gf_Unload(), even if this function fails.
 			 The buffer needs to be NULL terminated. The bufferCount needs to represent a valid span for the buffer.
 			 *funcs can be NULL or contain NULL function pointers. In this case, the default function pointers are used,
@@ -944,7 +1619,9 @@ Description: Begins tokenising and parsing the passed in buffer, preparing data
 			 *funcs can be NULL or contain NULL function pointers. In this case, the default function pointers are used,
 			 gf_DefaultLog, malloc() and free().
 			 This function allocates things using the passed in allocation function.
-			 This open
+			 With GF_LOADER_FLAG_CACHE an up to date snapshot kept next to the file is mapped instead. See gf_LoadFileWithCache.
+			 With GF_LOADER_FLAG_PIPELINE a file bigger than GF_PIPELINE_BLOCK_SIZE is tokenised while it is read. See gf_LoadFileWithPipeline.
+			 A compressed file is found by its header and tokenised while it is decompressed. See gf_SaverBeginCompressed.
 Assumptions: - *loader is not NULL.
 			 - *filename is not NULL.
 			 - funcs can be NULL.
@@ -981,6 +1658,67 @@ Examples:
 */
 void gf_Unload(gf_Loader *loader);
 
+/*
+Name:        void gf_ResetLoader(gf_Loader *loader);
+Description: Throws away the loaded graph but keeps the memory that held it, so the loader can load again without allocating.
+             The tokens, nodes and builder text of the next load are handed out from the same arena blocks, and gf_ReloadFromFile()
+			 reuses the file buffer when the next file fits. The loader keeps the largest capacity it has ever needed until
+			 gf_TrimLoader() or gf_Unload() is called.
+			 Every node and token of the old graph is invalid after this.
+Assumptions: - gf_LoadEmpty, gf_LoadFromBuffer or gf_LoadFromFile has been called, even if it failed.
+             - *loader is not NULL.
+Returns:     Nothing.
+*/
+void gf_ResetLoader(gf_Loader *loader);
+
+/*
+Name:        void gf_TrimLoader(gf_Loader *loader, gf_u64 maxRetainedBytes);
+Description: Gives memory kept by gf_ResetLoader() back to the allocator, so one huge document does not keep its memory forever.
+             Arena blocks are kept in order until keeping the next one would go over maxRetainedBytes, and the rest are freed. 
+			 The file buffer is freed if it is bigger than maxRetainedBytes. Pass 0 to free everything.
+Assumptions: - gf_ResetLoader() has been called and nothing has been loaded since.
+             - *loader is not NULL.
+Returns:     Nothing.
+*/
+void gf_TrimLoader(gf_Loader *loader, gf_u64 maxRetainedBytes);
+
+/*
+Name:        int gf_ReloadFromBuffer(gf_Loader *loader, const char *buffer, gf_u64 bufferCount);
+Description: Resets the loader with gf_ResetLoader() and loads the buffer into it, like gf_LoadFromBuffer(). 
+             The log and allocation functions the loader was first loaded with are kept. Once the loader has loaded a document
+			 that is atleast as big, this does not allocate at all. You still need to call gf_Unload() once you are done, even if this fails.
+Assumptions: - gf_LoadEmpty, gf_LoadFromBuffer or gf_LoadFromFile has been called, even if it failed.
+             - *loader is not NULL.
+			 - *buffer is not NULL and is NULL terminated.
+			 - bufferCount is a valid length for the buffer.
+Returns:     Returns 1 if it succeeds. Returns 0 if it fails. The error is logged.
+Examples:
+{
+	gf_Loader loader;
+	gf_LoadEmpty(&loader, NULL);
+
+	for (int i = 0; i < requestCount; i++) {
+		if (gf_ReloadFromBuffer(&loader, requests[i], requestLengths[i])) {
+			// ... do stuff ...
+		}
+	}
+
+	gf_Unload(&loader);
+}
+*/
+int gf_ReloadFromBuffer(gf_Loader *loader, const char *buffer, gf_u64 bufferCount);
+
+/*
+Name:        int gf_ReloadFromFile(gf_Loader *loader, const char *filename);
+Description: Resets the loader with gf_ResetLoader() and loads the file into it, like gf_LoadFromFile(). The file is read (or 
+             decompressed) into the buffer of the last file if it fits. You still need to call gf_Unload() once you are done, even if this fails.
+Assumptions: - gf_LoadEmpty, gf_LoadFromBuffer or gf_LoadFromFile has been called, even if it failed.
+             - *loader is not NULL.
+			 - *filename is not NULL.
+Returns:     Returns 1 if it succeeds. Returns 0 if it fails. The error is logged.
+*/
+int gf_ReloadFromFile(gf_Loader *loader, const char *filename);
+
 /*
 Name:        int gf_LoaderNodeToU32(gf_Loader *loader, gf_LoaderNode *node, gf_u32 *value);
 Description: Converts the value of the node and copies it into value.
@@ -1155,6 +1893,7 @@ Description: Converts the value of the node and copies it into src.
 		     srcCapacityIncludesNullTerminator is the length of src + the NULL terminating character.
 			 Does type checking of the node.
 			 A string node is a string node. This takes the form => "Hello!"
+			 The string is copied with its escapes already decoded by the loader, see gf_DecodeEscapes().
 Assumptions: - gf_LoadFromBuffer or gf_LoadFromFile has been called and was successful.
 			 - *loader is not NULL.
 			 - *src is not NULL.
@@ -1178,6 +1917,33 @@ Examples:
 */
 int gf_LoaderNodeToString(gf_Loader *loader, gf_LoaderNode *node, char *src, gf_u64 srcCapacityIncludesNullTerminator);
 
+/*
+Name:        int gf_LoaderNodeToStringView(gf_Loader *loader, gf_LoaderNode *node, gf_StringView *view);
+Description: The same as gf_LoaderNodeToString() but nothing is copied. The view points at the text of the string
+             in the loaded buffer, or in the loader's arena if it held escapes.
+			 The view is valid until the loader is unloaded, reset or reloaded, or the node is changed with gf_SetString().
+Assumptions: - gf_LoadFromBuffer or gf_LoadFromFile has been called and was successful.
+			 - *loader is not NULL.
+			 - *view is not NULL.
+			 - node can be NULL.
+Returns:     Returns 1 if successful. Returns 0 if node was NULL or the node was not a string type. The error is logged.
+Examples:
+{
+	gf_Loader loader;
+	gf_LoadFromFile(&loader, "myfile.gf", NULL);
+
+	gf_LoaderNode *child = gf_GetChild(&loader, gf_GetRoot(&loader));
+
+	gf_StringView view;
+	if (gf_LoaderNodeToStringView(&loader, child, &view) && gf_AreStringSpansEqual(view.start, view.length, "hello", 5)) {
+		...
+	}
+
+	gf_Unload(&loader);
+}
+*/
+int gf_LoaderNodeToStringView(gf_Loader *loader, gf_LoaderNode *node, gf_StringView *view);
+
 /*
 Name:        gf_LoaderNode *gf_GetRoot(gf_Loader *loader);
 Description: Gets the root node of the parsed contents of a file. gf_LoadFromBuffer or gf_LoadFromFile 
@@ -1562,6 +2328,33 @@ Examples:
 */
 int gf_LoadVariableString(gf_Loader *loader, gf_LoaderNode *node, char *str, gf_u64 lenWithNullTerminator);
 
+/*
+Name:        int gf_LoadVariableStringView(gf_Loader *loader, gf_LoaderNode *node, gf_StringView *view);
+Description: The same as gf_LoadVariableString() but nothing is copied, so there is no limit on the length of the string.
+			 If the node has the form => Var { "Hello, world" }, where Var corresponds to the passed in node, the view
+			 points at the string inside the braces. See gf_LoaderNodeToStringView() for how long the view is valid.
+Assumptions: - gf_LoadFromBuffer or gf_LoadFromFile has been called and was successful.
+			 - *loader is not NULL.
+			 - node can be NULL
+			 - *view is not NULL.
+Returns:     Returns 1 if successful. Returns 0 if the node is not in the form as described in the description,
+			 the value node is not a string or node is NULL. The error is logged.
+Examples:
+{
+	gf_Loader loader;
+	gf_LoadFromFile(&loader, "myfile.gf", NULL);
+
+	gf_LoaderNode *childNode = gf_FindFirstChild(&loader, gf_GetRoot(&loader), "ChildName");
+
+	gf_StringView name;
+	gf_LoadVariableStringView(&loader, childNode, &name);
+	printf("%.*s\n", (int)name.length, name.start);
+
+	gf_Unload(&loader);
+}
+*/
+int gf_LoadVariableStringView(gf_Loader *loader, gf_LoaderNode *node, gf_StringView *view);
+
 /*
 Name:        int gf_LoadArrayS32(gf_Loader *loader, gf_LoaderNode *node, gf_s32 *value, gf_u64 count);
 Description: A helper function that takes a set of nodes in a certain form and converts them to a value.
@@ -1595,1701 +2388,10014 @@ int gf_LoadArrayS32(gf_Loader *loader, gf_LoaderNode *node, gf_s32 *value, gf_u6
 
 /*-----------------------------------------------------------------------------------*/
 
-/*-------------------------TESTING---------------------------------------------------*/
-
-#ifdef GF_IMPLEMENTATION_WITH_TESTS
-
-#define GF_TEST_ASSERT(arg, str) if (!(arg)) { printf("[%s]: test failed! Check logs for more.", str); return 0; }
+/*-------------------------------------VALIDATE--------------------------------------*/
 
-int gf_Test(void);
+/*
+Describes the first error gf_Validate() found.
+*/
+typedef struct gf_ValidateError {
+	const char *message; // What is wrong. This points to a constant string and does not need to be freed.
+	gf_u64 offset;       // The offset in bytes from the start of the buffer to where the error is.
+	gf_u64 lineno;       // The line of the error.
+	gf_u64 colno;        // The column of the error.
+} gf_ValidateError;
 
-#endif
+/*
+Name:        int gf_Validate(const char *buffer, gf_u64 count, gf_ValidateError *error);
+Description: Checks that the buffer would load, without loading it. It tokenises the buffer and does the same brace and structure
+             checks as gf_LoadFromBuffer(), but nothing is allocated, nothing is logged and no node graph is built.
+			 Nesting is checked against GF_DEFAULT_MAX_DEPTH.
+			 Use it to reject broken input cheaply. Values are not converted, so a number that does not fit the type 
+			 you read it as is only found when you read it.
+			 If the buffer is not valid, the first error is written to *error.
+Assumptions: - *buffer is not NULL and is NULL terminated.
+			 - count is a valid length for the buffer.
+			 - error can be NULL.
+Returns:     Returns 1 if the buffer is valid. 0 if it is not.
+Examples:
+{
+	gf_ValidateError error;
+	if (!gf_Validate(upload, uploadLength, &error)) {
+		printf("line %" PRIu64 " column %" PRIu64 ": %s\n", error.lineno, error.colno, error.message);
+	}
+}
+*/
+int gf_Validate(const char *buffer, gf_u64 count, gf_ValidateError *error);
 
 /*-----------------------------------------------------------------------------------*/
 
-// IMPLEMENTATION
-#if defined(GF_IMPLEMENTATION) || defined(GF_IMPLEMENTATION_WITH_TESTS)
+/*-----------------------------------TREE SAVER--------------------------------------*/
 
-/*-------------------------STRING CONVERSIONS---------------------------------------*/
+/*
+Name:        int gf_SaveNode(gf_Saver *saver, FILE *file, gf_LoaderNode *node);
+Description: Saves a node and everything below it, so a loaded (and possibly edited) graph can be written back out.
+             If node is the root node, all of its children are saved. Value tokens are copied straight from the
+			 buffer they were loaded from, numbers are not converted or reformatted. The layout follows the format of the saver,
+			 and lists that only hold values are written on one line => "a { 1, 2, 3 }". Comments are not kept.
+			 Like every gf_Save...() function this writes to the target of the saver, so you can call gf_SaverBeginMeasure()
+			 first to get the exact size of the saved tree and then save it into one allocation with gf_SaverBeginMemory().
+			 The tree is walked without recursion, so deeply nested data does not grow the stack.
+Assumptions: - gf_InitSaver must have been called on saver atleast once.
+             - *saver is not NULL
+             - *file is not NULL and is a valid file when the target of the saver is GF_SAVER_TARGET_FILE.
+			 - The loader that node belongs to is still loaded.
+			 - node can be NULL.
+Returns:     1 if it was successful. 0 if node is NULL or writing failed. The error is logged.
+Examples:
+{
+	gf_Loader loader;
+	gf_LoadFromFile(&loader, "myfile.gf", NULL);
 
-int gf_AreStringSpansEqual(const char *a, gf_u64 alength, const char *b, gf_u64 blength) {
-	assert(a);
-	assert(b);
+	gf_Saver saver;
+	gf_InitSaver(&saver, NULL);
 
-	if (alength != blength) return 0;
-	gf_u64 i = 0;
-	while (i < alength) {
-		if (a[i] == '\0' && b[i] != '\0') return 0;
-		if (a[i] != '\0' && b[i] == '\0') return 0;
-		if (a[i] != b[i]) return 0;
-		i++;
+	FILE *file = fopen("copy.gf", "wb");
+	if (file) {
+		gf_SaveNode(&saver, file, gf_GetRoot(&loader));
+		fclose(file);
 	}
-	return 1;
-}
-
-gf_u64 gf_StringLength(const char *str) {
-	assert(str);
 
-	gf_u64 len = 0;
-	while (str[len] != '\0') len++;
-	return len;
+	gf_Unload(&loader);
 }
+*/
+int gf_SaveNode(gf_Saver *saver, FILE *file, gf_LoaderNode *node);
 
-int gf_StringSpanToU32(const char *start, uint64_t length, gf_u32 *value) {
-	assert(start);
+/*-----------------------------------------------------------------------------------*/
 
-	if (*start == '-') {
-		return 0;
-	}
+/*-------------------------------------BUILDER---------------------------------------*/
 
-	gf_u32 i = strtoul(start, NULL, 10);
-	// 0 could mean a failure, or it could just mean the string is actually 0. 
-	if (i == 0) {
-		uint64_t index = 0;
-		while (!isdigit(start[index]) && index < length) {
-			index++;
-		}
-		if (start[index] != '0') {
-			return 0;
-		}
-	}
-	if (i == ULONG_MAX) {
-		return 0;
-	}
-	*value = i;
-	return 1;
-}
+/*
+Name:        int gf_LoadEmpty(gf_Loader *loader, gf_LogAllocateFreeFunctions *funcs);
+Description: Initialises the loader with an empty graph that only holds the root node. Nodes can then be created and
+             added to it with the gf_Create...() and gf_AppendChild() functions. After you are done, you need to call gf_Unload(),
+			 even if this function fails.
+			 The builder functions also work on a loader that was loaded from a buffer or file, so a loaded graph can be edited,
+			 but not on a snapshot gf_AttachSnapshot() shares read only.
+			 Everything the builder creates is allocated in big blocks of the loader's arena with the allocation function in *funcs,
+			 and is freed at once by gf_Unload().
+Assumptions: - *loader is not NULL.
+			 - funcs can be NULL.
+Returns:     Returns 1 if it succeeds. Returns 0 if it fails. The error is logged.
+Examples:
+{
+	gf_Loader loader;
+	gf_LoadEmpty(&loader, NULL);
 
-int gf_StringSpanToU64(const char *start, uint64_t length, gf_u64 *value) {
-	assert(start);
+	gf_LoaderNode *player = gf_CreateComposite(&loader, "Player");
+	gf_AppendChild(&loader, gf_GetRoot(&loader), player);
 
-	if (*start == '-') {
-		return 0;
-	}
+	gf_LoaderNode *health = gf_CreateComposite(&loader, "health");
+	gf_AppendChild(&loader, player, health);
+	gf_AppendChild(&loader, health, gf_CreateS64(&loader, 100));
 
-	gf_u64 i = strtoull(start, NULL, 10);
-	// 0 could mean a failure, or it could just mean the string is actually 0. 
-	if (i == 0) {
-		uint64_t index = 0;
-		while (!isdigit(start[index]) && index < length) {
-			index++;
-		}
-		if (start[index] != '0') {
-			return 0;
-		}
-	}
-	if (i == ULLONG_MAX) {
-		return 0;
-	}
-	*value = i;
-	return 1;
+	gf_Saver saver;
+	gf_InitSaver(&saver, NULL);
+	gf_SaveNode(&saver, stdout, gf_GetRoot(&loader));
+
+	gf_Unload(&loader);
 }
+*/
+int gf_LoadEmpty(gf_Loader *loader, gf_LogAllocateFreeFunctions *funcs);
 
-int gf_StringSpanToS32(const char *start, uint64_t length, gf_s32 *value) {
-	assert(start);
+/*
+Name:        gf_LoaderNode *gf_CreateComposite(gf_Loader *loader, const char *name);
+Description: Creates a node that holds a list => name { }. The node is not part of the graph until it is added with
+             gf_AppendChild(), gf_InsertBefore() or gf_InsertAfter().
+			 The name is copied. It has to start with a letter and only hold letters, digits and underscores.
+Assumptions: - gf_LoadEmpty, gf_LoadFromBuffer or gf_LoadFromFile has been called.
+			 - *loader is not NULL.
+			 - *name is not NULL and is NULL terminated.
+Returns:     Returns the new node. Returns NULL if the name is not valid or the allocation failed. The error is logged.
+*/
+gf_LoaderNode *gf_CreateComposite(gf_Loader *loader, const char *name);
 
-	gf_s32 i = strtol(start, NULL, 10);
-	// 0 could mean a failure
-	if (i == 0) {
-		uint64_t index = 0;
-		while (!isdigit(start[index]) && index < length) {
-			index++;
-		}
-		if (start[index] != '0') {
-			return 0;
-		}
-	}
-	if (i == LONG_MIN || i == LONG_MAX) {
-		return 0;
-	}
-	*value = i;
-	return 1;
-}
+/*
+Name:        gf_LoaderNode *gf_CreateName(gf_Loader *loader, const char *name);
+Description: Creates a name node without a list => name. The name is copied and follows the same rules as gf_CreateComposite().
+             Adding a child to it turns it into a list.
+Assumptions: - gf_LoadEmpty, gf_LoadFromBuffer or gf_LoadFromFile has been called.
+			 - *loader is not NULL.
+			 - *name is not NULL and is NULL terminated.
+Returns:     Returns the new node. Returns NULL if the name is not valid or the allocation failed. The error is logged.
+*/
+gf_LoaderNode *gf_CreateName(gf_Loader *loader, const char *name);
 
-int gf_StringSpanToS64(const char *start, uint64_t length, gf_s64 *value) {
-	assert(start);
+/*
+Name:        gf_LoaderNode *gf_CreateS64(gf_Loader *loader, gf_s64 value);
+Description: Creates an integer value node. It can be read back with gf_LoaderNodeToS64() or any of the other integer conversions
+             the value fits into.
+Assumptions: - gf_LoadEmpty, gf_LoadFromBuffer or gf_LoadFromFile has been called.
+			 - *loader is not NULL.
+Returns:     Returns the new node. Returns NULL if the allocation failed. The error is logged.
+*/
+gf_LoaderNode *gf_CreateS64(gf_Loader *loader, gf_s64 value);
 
-	gf_s64 i = strtoll(start, NULL, 10);
-	// 0 could mean a failure, or it could just mean the string is actually 0.
-	if (i == 0) {
-		uint64_t index = 0;
-		while (!isdigit(start[index]) && index < length) {
-			index++;
-		}
-		if (start[index] != '0') {
-			return 0;
-		}
-	}
-	if (i == LLONG_MIN || i == LLONG_MAX) {
-		return 0;
-	}
-	*value = i;
-	return 1;
-}
+/*
+Name:        gf_LoaderNode *gf_CreateU64(gf_Loader *loader, gf_u64 value);
+Description: Creates an integer value node from an unsigned value.
+Assumptions: - gf_LoadEmpty, gf_LoadFromBuffer or gf_LoadFromFile has been called.
+			 - *loader is not NULL.
+Returns:     Returns the new node. Returns NULL if the allocation failed. The error is logged.
+*/
+gf_LoaderNode *gf_CreateU64(gf_Loader *loader, gf_u64 value);
 
-int gf_StringSpanToF64(const char *start, uint64_t length, gf_f64 *value) {
-	assert(start);
+/*
+Name:        gf_LoaderNode *gf_CreateF64(gf_Loader *loader, gf_f64 value);
+Description: Creates a floating point value node. The value is stored with enough digits that it loads back to the exact same double.
+Assumptions: - gf_LoadEmpty, gf_LoadFromBuffer or gf_LoadFromFile has been called.
+			 - *loader is not NULL.
+Returns:     Returns the new node. Returns NULL if the value is infinite or NaN, or the allocation failed. The error is logged.
+*/
+gf_LoaderNode *gf_CreateF64(gf_Loader *loader, gf_f64 value);
 
-	double d = strtod(start, NULL);
-	// 0.0 could mean a failure, or it could just mean the string is actually 0.
-	if (d == 0.0) {
-		uint64_t index = 0;
-		while (!isdigit(start[index]) && index < length) {
-			index++;
-		}
-		if (start[index] != '0') {
-			return 0;
-		}
-	}
-	else if (d == HUGE_VAL || d == -HUGE_VAL) {
-		return 0;
-	}
-	*value = d;
-	return 1;
-}
+/*
+Name:        gf_LoaderNode *gf_CreateString(gf_Loader *loader, const char *value);
+Description: Creates a string value node. The string is copied. Quotes and backslashes in it are escaped when it is saved.
+Assumptions: - gf_LoadEmpty, gf_LoadFromBuffer or gf_LoadFromFile has been called.
+			 - *loader is not NULL.
+			 - *value is not NULL and is NULL terminated.
+Returns:     Returns the new node. Returns NULL if the allocation failed. The error is logged.
+*/
+gf_LoaderNode *gf_CreateString(gf_Loader *loader, const char *value);
 
-int gf_StringSpanToF32(const char *start, uint64_t length, gf_f32 *value) {
-	assert(start);
+/*
+Name:        int gf_AppendChild(gf_Loader *loader, gf_LoaderNode *parent, gf_LoaderNode *child);
+Description: Adds child to the end of the children of parent. If child is already part of the graph it is moved.
+             parent can be the root node, a list or a name node, which then becomes a list. Adding a name or list to a list turns it into 
+			 a composite node, the same as when the text is parsed.
+Assumptions: - gf_LoadEmpty, gf_LoadFromBuffer or gf_LoadFromFile has been called.
+			 - *loader is not NULL.
+			 - parent and child can be NULL.
+Returns:     Returns 1 if it succeeds. Returns 0 if either node is NULL, parent is a value node, child is the root node
+             or child is parent or one of its parents. The error is logged.
+*/
+int gf_AppendChild(gf_Loader *loader, gf_LoaderNode *parent, gf_LoaderNode *child);
 
-	float f = strtof(start, NULL);
-	// 0.0 could mean a failure, or it could just mean the string is actually 0
-	if (f == 0.0) {
-		uint64_t index = 0;
-		while (!isdigit(start[index]) && index < length) {
-			index++;
+/*
+Name:        int gf_InsertBefore(gf_Loader *loader, gf_LoaderNode *sibling, gf_LoaderNode *child);
+Description: Adds child to the children of the parent of sibling, right before sibling. If child is already part of the graph it is moved.
+             The same rules as gf_AppendChild() apply to the parent of sibling.
+Assumptions: - gf_LoadEmpty, gf_LoadFromBuffer or gf_LoadFromFile has been called.
+			 - *loader is not NULL.
+			 - sibling and child can be NULL.
+Returns:     Returns 1 if it succeeds. Returns 0 if either node is NULL, sibling has no parent or child can not be added to
+             the parent of sibling. The error is logged.
+*/
+int gf_InsertBefore(gf_Loader *loader, gf_LoaderNode *sibling, gf_LoaderNode *child);
+
+/*
+Name:        int gf_InsertAfter(gf_Loader *loader, gf_LoaderNode *sibling, gf_LoaderNode *child);
+Description: Adds child to the children of the parent of sibling, right after sibling. If child is already part of the graph it is moved.
+             The same rules as gf_AppendChild() apply to the parent of sibling.
+Assumptions: - gf_LoadEmpty, gf_LoadFromBuffer or gf_LoadFromFile has been called.
+			 - *loader is not NULL.
+			 - sibling and child can be NULL.
+Returns:     Returns 1 if it succeeds. Returns 0 if either node is NULL, sibling has no parent or child can not be added to
+             the parent of sibling. The error is logged.
+*/
+int gf_InsertAfter(gf_Loader *loader, gf_LoaderNode *sibling, gf_LoaderNode *child);
+
+/*
+Name:        int gf_RemoveNode(gf_Loader *loader, gf_LoaderNode *node);
+Description: Takes node and everything below it out of the graph. The node stays valid until gf_Unload() is called,
+             so it can be added again somewhere else.
+Assumptions: - gf_LoadEmpty, gf_LoadFromBuffer or gf_LoadFromFile has been called.
+			 - *loader is not NULL.
+			 - node can be NULL.
+Returns:     Returns 1 if it succeeds or node was not part of the graph. Returns 0 if node is NULL or the root node. The error is logged.
+*/
+int gf_RemoveNode(gf_Loader *loader, gf_LoaderNode *node);
+
+/*
+Name:        int gf_SetS64(gf_Loader *loader, gf_LoaderNode *node, gf_s64 value);
+Description: Changes the value of a value node to an integer. The node can have held any kind of value before.
+Assumptions: - gf_LoadEmpty, gf_LoadFromBuffer or gf_LoadFromFile has been called.
+			 - *loader is not NULL.
+			 - node can be NULL.
+Returns:     Returns 1 if it succeeds. Returns 0 if node is NULL, is not a value node or the allocation failed. The error is logged.
+*/
+int gf_SetS64(gf_Loader *loader, gf_LoaderNode *node, gf_s64 value);
+
+/*
+Name:        int gf_SetU64(gf_Loader *loader, gf_LoaderNode *node, gf_u64 value);
+Description: Changes the value of a value node to an unsigned integer. The node can have held any kind of value before.
+Assumptions: - gf_LoadEmpty, gf_LoadFromBuffer or gf_LoadFromFile has been called.
+			 - *loader is not NULL.
+			 - node can be NULL.
+Returns:     Returns 1 if it succeeds. Returns 0 if node is NULL, is not a value node or the allocation failed. The error is logged.
+*/
+int gf_SetU64(gf_Loader *loader, gf_LoaderNode *node, gf_u64 value);
+
+/*
+Name:        int gf_SetF64(gf_Loader *loader, gf_LoaderNode *node, gf_f64 value);
+Description: Changes the value of a value node to a floating point number. The node can have held any kind of value before.
+Assumptions: - gf_LoadEmpty, gf_LoadFromBuffer or gf_LoadFromFile has been called.
+			 - *loader is not NULL.
+			 - node can be NULL.
+Returns:     Returns 1 if it succeeds. Returns 0 if node is NULL, is not a value node, the value is infinite or NaN or 
+             the allocation failed. The error is logged.
+*/
+int gf_SetF64(gf_Loader *loader, gf_LoaderNode *node, gf_f64 value);
+
+/*
+Name:        int gf_SetString(gf_Loader *loader, gf_LoaderNode *node, const char *value);
+Description: Changes the value of a value node to a string. The node can have held any kind of value before.
+             The string follows the same rules as gf_CreateString().
+Assumptions: - gf_LoadEmpty, gf_LoadFromBuffer or gf_LoadFromFile has been called.
+			 - *loader is not NULL.
+			 - node can be NULL.
+			 - *value is not NULL and is NULL terminated.
+Returns:     Returns 1 if it succeeds. Returns 0 if node is NULL, is not a value node or the allocation failed. The error is logged.
+*/
+int gf_SetString(gf_Loader *loader, gf_LoaderNode *node, const char *value);
+
+/*
+Name:        int gf_SetName(gf_Loader *loader, gf_LoaderNode *node, const char *name);
+Description: Renames a name, list or composite node. The name follows the same rules as gf_CreateComposite().
+Assumptions: - gf_LoadEmpty, gf_LoadFromBuffer or gf_LoadFromFile has been called.
+			 - *loader is not NULL.
+			 - node can be NULL.
+			 - *name is not NULL and is NULL terminated.
+Returns:     Returns 1 if it succeeds. Returns 0 if node is NULL, is a value or the root node, the name is not valid or 
+             the allocation failed. The error is logged.
+*/
+int gf_SetName(gf_Loader *loader, gf_LoaderNode *node, const char *name);
+
+/*
+Name:        int gf_IsValidName(const char *name, gf_u64 length);
+Description: Checks that the name spanning length characters can be read back by the tokeniser as a name. 
+             It starts with a letter and only holds letters, digits and underscores.
+Assumptions: - *name is not NULL.
+Returns:     Returns 1 if it is a valid name. 0 if it is not.
+*/
+int gf_IsValidName(const char *name, gf_u64 length);
+
+/*
+Name:        int gf_SetTokenText(gf_Loader *loader, gf_Token *token, gf_TokenType type, const char *text, gf_u64 length);
+Description: Copies the text into the arena of the loader, NULL terminates it and points the token at the copy with the given type.
+Assumptions: - gf_InitLoader() has been called on *loader.
+			 - *loader, *token and *text are not NULL.
+Returns:     Returns 1 if it succeeds. 0 if the allocation failed. The error is logged.
+*/
+int gf_SetTokenText(gf_Loader *loader, gf_Token *token, gf_TokenType type, const char *text, gf_u64 length);
+
+/*
+Name:        gf_LoaderNode *gf_CreateNodeInArena(gf_Loader *loader, gf_TokenType type, const char *text, gf_u64 length);
+Description: Allocates a node and its token in the arena of the loader. The token gets the type and a copy of the text. 
+             The node has no parent, siblings or children.
+Assumptions: - gf_InitLoader() has been called on *loader.
+			 - *loader and *text are not NULL.
+Returns:     Returns the new node. Returns NULL if the allocation failed. The error is logged.
+*/
+gf_LoaderNode *gf_CreateNodeInArena(gf_Loader *loader, gf_TokenType type, const char *text, gf_u64 length);
+
+/*
+Name:        int gf_CanAddChild(gf_Loader *loader, gf_LoaderNode *parent, gf_LoaderNode *child);
+Description: Checks that child can be added to the children of parent. See gf_AppendChild() for the rules.
+Assumptions: - *loader is not NULL.
+			 - parent and child can be NULL.
+Returns:     Returns 1 if the child can be added. 0 if it can not. The error is logged.
+*/
+int gf_CanAddChild(gf_Loader *loader, gf_LoaderNode *parent, gf_LoaderNode *child);
+
+/*
+Name:        void gf_DetachNode(gf_LoaderNode *node);
+Description: Unlinks node from its parent and siblings. Its own children stay with it.
+Assumptions: - *node is not NULL.
+Returns:     Nothing.
+*/
+void gf_DetachNode(gf_LoaderNode *node);
+
+/*
+Name:        void gf_MarkAsList(gf_LoaderNode *parent, gf_LoaderNode *child);
+Description: Updates the token of parent after child was added to it, so it is saved and queried as a list or composite node.
+Assumptions: - *parent and *child are not NULL.
+Returns:     Nothing.
+*/
+void gf_MarkAsList(gf_LoaderNode *parent, gf_LoaderNode *child);
+
+/*
+Name:        int gf_IsValueNode(gf_Loader *loader, gf_LoaderNode *node);
+Description: Checks that node is an integer, float or string node so its value can be changed.
+Assumptions: - *loader is not NULL.
+			 - node can be NULL.
+Returns:     Returns 1 if it is a value node. 0 if node is NULL or not a value node. The error is logged.
+*/
+int gf_IsValueNode(gf_Loader *loader, gf_LoaderNode *node);
+
+/*
+Name:        int gf_CanChangeGraph(gf_Loader *loader);
+Description: Checks that the builder functions can change the graph of the loader. They can not when it is a snapshot that
+             gf_AttachSnapshot() mapped read only.
+Assumptions: - *loader is not NULL.
+Returns:     Returns 1 if the graph can be changed. 0 if it can not. The error is logged.
+*/
+int gf_CanChangeGraph(gf_Loader *loader);
+
+/*-----------------------------------------------------------------------------------*/
+
+/*-------------------------------------BINARY----------------------------------------*/
+
+/*
+The .gfb binary format holds the same graph as the text format, but it is loaded without tokenising or converting any numbers.
+gf_LoadFromBuffer(), gf_LoadFromFile() and the reload functions recognise it by its first bytes and load it into the same
+nodes, so gf_GetChild(), gf_GetNext(), gf_LoadVariable...() and gf_SaveNode() work the same on both formats.
+Every number in the file is little endian and every record starts on a multiple of 8 bytes.
+
+header   "GFB", the version byte and 4 bytes that are 0.
+records  Each record starts with 8 bytes: a gf_BinaryTag byte, 3 bytes that are 0 and a u32 that depends on the tag.
+         The data after it is padded with zeros up to a multiple of 8 bytes.
+         NAME     The u32 is the length of the name, followed by the name.                        => a
+         LIST     The u32 is the length of the name, followed by the name, then the records in the
+                  list and an END record.                                                         => a { ... }
+         END      The u32 is 0. Closes the innermost LIST.
+         STRINGS  The u32 is the number of strings. Each one is a u32 length then its text. Escapes are already decoded.
+         S64S, U64S, F64S
+                  The u32 is the number of values, followed by the 8 byte values.                 => 1, 2, 3
+table    The u64 offset from the start of the file of every record that is not inside a list.
+footer   The u64 number of nodes, the u64 offset of the table and the u64 number of records in the table.
+*/
+
+#define GF_BINARY_VERSION 1
+#define GF_BINARY_HEADER_SIZE 8
+#define GF_BINARY_FOOTER_SIZE 24
+
+// The kind of a record in a .gfb file. 0 is never used so padding can not be read as a record.
+typedef enum gf_BinaryTag {
+	GF_BINARY_TAG_NAME = 1,
+	GF_BINARY_TAG_LIST,
+	GF_BINARY_TAG_END,
+	GF_BINARY_TAG_STRINGS,
+	GF_BINARY_TAG_S64S,
+	GF_BINARY_TAG_U64S,
+	GF_BINARY_TAG_F64S
+} gf_BinaryTag;
+
+/*
+Name:        int gf_IsBinary(const char *buffer, gf_u64 count);
+Description: Checks if the buffer starts like a .gfb file.
+Assumptions: - *buffer is not NULL and is atleast count bytes long.
+Returns:     1 if it starts with the .gfb header. 0 if not, so it is loaded as text.
+*/
+int gf_IsBinary(const char *buffer, gf_u64 count);
+
+/*
+Name:        gf_u64 gf_ReadU64LE(const char *bytes);
+Description: Reads a little endian u64. Compilers turn this into a single load on little endian machines.
+Assumptions: - *bytes is not NULL and is atleast 8 bytes long. It does not need to be aligned.
+Returns:     The value.
+*/
+gf_u64 gf_ReadU64LE(const char *bytes);
+
+/*
+Name:        gf_u32 gf_ReadU32LE(const char *bytes);
+Description: Reads a little endian u32.
+Assumptions: - *bytes is not NULL and is atleast 4 bytes long. It does not need to be aligned.
+Returns:     The value.
+*/
+gf_u32 gf_ReadU32LE(const char *bytes);
+
+/*
+Name:        void gf_WriteU64LE(char *bytes, gf_u64 value);
+Description: Writes value as a little endian u64.
+Assumptions: - *bytes is not NULL and is atleast 8 bytes long.
+Returns:     Nothing.
+*/
+void gf_WriteU64LE(char *bytes, gf_u64 value);
+
+/*
+Name:        void gf_WriteU32LE(char *bytes, gf_u32 value);
+Description: Writes value as a little endian u32.
+Assumptions: - *bytes is not NULL and is atleast 4 bytes long.
+Returns:     Nothing.
+*/
+void gf_WriteU32LE(char *bytes, gf_u32 value);
+
+/*
+Name:        int gf_BinaryTokenToS64(const gf_Token *token, gf_s64 *value);
+Description: Reads the value of an integer token that has GF_TOKEN_FLAG_BINARY.
+Assumptions: - *token and *value are not NULL.
+             - token is an integer token with GF_TOKEN_FLAG_BINARY.
+Returns:     1 if it was successful. 0 if the value is unsigned and too big for a gf_s64.
+*/
+int gf_BinaryTokenToS64(const gf_Token *token, gf_s64 *value);
+
+/*
+Name:        int gf_BinaryTokenToU64(const gf_Token *token, gf_u64 *value);
+Description: Reads the value of an integer token that has GF_TOKEN_FLAG_BINARY.
+Assumptions: - *token and *value are not NULL.
+             - token is an integer token with GF_TOKEN_FLAG_BINARY.
+Returns:     1 if it was successful. 0 if the value is negative.
+*/
+int gf_BinaryTokenToU64(const gf_Token *token, gf_u64 *value);
+
+/*
+Name:        gf_f64 gf_BinaryTokenToF64(const gf_Token *token);
+Description: Reads the value of a float token that has GF_TOKEN_FLAG_BINARY.
+Assumptions: - *token is not NULL.
+             - token is a float token with GF_TOKEN_FLAG_BINARY.
+Returns:     The value.
+*/
+gf_f64 gf_BinaryTokenToF64(const gf_Token *token);
+
+/*
+Name:        int gf_BinaryTokenToString(const gf_Token *token, char *buffer, gf_u64 capacity, gf_u64 *length);
+Description: Writes the value of a number token that has GF_TOKEN_FLAG_BINARY as text that loads back to the same value.
+             Used to save and print these tokens like any other.
+Assumptions: - *token, *buffer and *length are not NULL.
+             - token is a number token with GF_TOKEN_FLAG_BINARY.
+             - capacity is the size of buffer including the NULL terminator. GF_F64_STRING_CAPACITY is always big enough.
+Returns:     1 if it was successful and the length of the text is stored in *length. 0 if the float is infinite or NaN.
+*/
+int gf_BinaryTokenToString(const gf_Token *token, char *buffer, gf_u64 capacity, gf_u64 *length);
+
+/*
+Name:        int gf_SaveBinary(gf_Saver *saver, FILE *file, gf_LoaderNode *node);
+Description: Saves a node and everything below it in the .gfb format. If node is the root node, all of its children are saved.
+             Values that are next to each other and have the same kind are saved as one record. Integers are saved as gf_s64
+			 when they fit and as gf_u64 otherwise. Floats are saved as gf_f64. Comments and the layout of the text are not kept,
+			 so saving the loaded .gfb with gf_SaveNode() gives the same values, not the same text.
+			 Like every gf_Save...() function this writes to the target of the saver, so it can be measured or saved into memory.
+			 It needs no memory of its own. The offset table is worked out by measuring each top level record after it is written.
+Assumptions: - gf_InitSaver must have been called on saver atleast once.
+             - *saver is not NULL
+             - *file is not NULL and is a valid file opened in binary mode when the target of the saver is GF_SAVER_TARGET_FILE.
+			 - The loader that node belongs to is still loaded.
+			 - node can be NULL.
+Returns:     1 if it was successful. 0 if node is NULL, a number does not fit its binary type, a name or string is longer
+             than a u32 can hold, or writing failed. The error is logged.
+Examples:
+{
+	gf_Loader loader;
+	gf_LoadFromFile(&loader, "myfile.graph", NULL);
+
+	gf_Saver saver;
+	gf_InitSaver(&saver, NULL);
+
+	FILE *file = fopen("myfile.gfb", "wb");
+	if (file) {
+		gf_SaveBinary(&saver, file, gf_GetRoot(&loader));
+		fclose(file);
+	}
+
+	gf_Unload(&loader);
+}
+*/
+int gf_SaveBinary(gf_Saver *saver, FILE *file, gf_LoaderNode *node);
+
+/*
+Name:        int gf_SaveBinaryRecord(gf_Saver *saver, FILE *file, gf_LoaderNode **node, int savingSiblings, gf_u64 *nodeCount);
+Description: Internal function that saves the record that starts at *node, with everything inside it if it is a list.
+             A run of values takes the siblings after *node with it when savingSiblings is set.
+			 *node is moved to the node after the record and nodeCount is increased by the number of nodes saved.
+Assumptions: - *saver, *node and *nodeCount are not NULL.
+             - *file is not NULL and is a valid file when the target of the saver is GF_SAVER_TARGET_FILE.
+Returns:     1 if it was successful. 0 if not. The error is logged.
+*/
+int gf_SaveBinaryRecord(gf_Saver *saver, FILE *file, gf_LoaderNode **node, int savingSiblings, gf_u64 *nodeCount);
+
+/*
+Name:        int gf_LoadBinaryInternal(gf_Loader *loader, const char *buffer, gf_u64 count);
+Description: Internal function called by gf_LoadInternal() when the buffer is a .gfb file. The names, strings and numbers
+             of the tokens point into the buffer, so like text the buffer must outlive the loader. Every offset and length
+			 in the file is checked against count before it is used, and lists are nested no deeper than the maximum depth.
+			 A NULL terminator after the file, as gf_ReadFileIntoLoader() adds, is ignored.
+Assumptions: - gf_InitLoader() or gf_ResetLoader() has been called on *loader.
+             - *buffer is not NULL and is atleast count bytes long.
+Returns:     1 if it was successful. 0 if the file is damaged or memory ran out. The error is logged.
+*/
+int gf_LoadBinaryInternal(gf_Loader *loader, const char *buffer, gf_u64 count);
+
+/*
+Name:        int gf_ConvertToBinary(const char *inputFilename, const char *outputFilename, gf_LogAllocateFreeFunctions *funcs);
+Description: Loads a .graph (or .gfb) file and saves it as a .gfb file.
+Assumptions: - *inputFilename and *outputFilename are not NULL and are different files.
+             - funcs can be NULL.
+Returns:     1 if it was successful. 0 if not. The error is logged.
+Examples:
+{
+	gf_ConvertToBinary("level.graph", "level.gfb", NULL);
+}
+*/
+int gf_ConvertToBinary(const char *inputFilename, const char *outputFilename, gf_LogAllocateFreeFunctions *funcs);
+
+/*
+Name:        int gf_ConvertToText(const char *inputFilename, const char *outputFilename, gf_SaverFormat format, gf_LogAllocateFreeFunctions *funcs);
+Description: Loads a .gfb (or .graph) file and saves it as text with the given format.
+Assumptions: - *inputFilename and *outputFilename are not NULL and are different files.
+             - format is a valid gf_SaverFormat.
+             - funcs can be NULL.
+Returns:     1 if it was successful. 0 if not. The error is logged.
+Examples:
+{
+	gf_ConvertToText("level.gfb", "level.graph", GF_SAVER_FORMAT_PRETTY, NULL);
+}
+*/
+int gf_ConvertToText(const char *inputFilename, const char *outputFilename, gf_SaverFormat format, gf_LogAllocateFreeFunctions *funcs);
+
+/*-----------------------------------------------------------------------------------*/
+
+/*-------------------------------------SNAPSHOT--------------------------------------*/
+
+/*
+A snapshot is an image of a loaded graph that is mapped back into memory instead of being loaded, for graphs that are loaded
+again and again. It holds the nodes and tokens laid out exactly as the loader keeps them, followed by the text of every token.
+Names are only stored once and strings are stored decoded. Nothing is tokenised, parsed or allocated to use it.
+
+Every pointer in it is stored as a base address plus the offset of what it points to in the snapshot. gf_MapSnapshot() asks
+for the mapping to be placed at that base address. When it is, every pointer is already right and the pages of the file are
+only read in as the graph is used, so mapping takes the same time however big the graph is. When the address is taken, for
+instance by another snapshot, the pointers are moved to where it was mapped in one pass over the nodes and tokens.
+The layout depends on the sizes of the structs and the byte order of the machine, which are checked when it is mapped, so a
+snapshot should be made by the same build that maps it. Keep the .graph file as the source and remake the snapshot from it.
+*/
+
+#define GF_SNAPSHOT_VERSION 1
+
+/*
+The address snapshots are saved to be mapped at. It is far away from where 64 bit systems place the heap, stack and libraries.
+0 on 32 bit systems, where there is no room to spare, so snapshots are always relocated there.
+*/
+#ifndef GF_SNAPSHOT_BASE
+#define GF_SNAPSHOT_BASE (sizeof(void *) == 8 ? 0x100000000000ULL : 0ULL)
+#endif
+
+// The start of every snapshot. Written as it is in memory.
+typedef struct gf_SnapshotHeader {
+	char magic[8];       // "GFSNAP", the version and 0.
+	gf_u32 tokenSize;    // sizeof(gf_Token) of the build that wrote it.
+	gf_u32 nodeSize;     // sizeof(gf_LoaderNode) of the build that wrote it.
+	gf_u32 pointerSize;  // sizeof(void *) of the build that wrote it.
+	gf_u32 byteOrder;    // 0x01020304 as the machine that wrote it stores it.
+	gf_u64 base;         // The address the pointers in the snapshot are relative to. GF_SNAPSHOT_BASE when it was saved.
+	gf_u64 sourceSize;   // The size of the file a cache was made from. See GF_LOADER_FLAG_CACHE. 0 for gf_SaveSnapshot().
+	gf_s64 sourceTime;   // The modification time of that file. 0 when it was too recent to be trusted or is not known.
+	gf_u64 sourceHash;   // gf_HashBytes() of that file.
+	gf_u64 nodeCount;    // The number of nodes, and of tokens. The first node is the root.
+	gf_u64 nodesOffset;  // Where the nodes start. A multiple of GF_ARENA_ALIGNMENT.
+	gf_u64 tokensOffset; // Where the tokens start. Token i belongs to node i. A multiple of GF_ARENA_ALIGNMENT.
+	gf_u64 textOffset;   // Where the text of the tokens starts.
+	gf_u64 textSize;     // The size of the text in bytes. The text of each token is followed by a NULL terminator.
+	gf_u64 size;         // The size of the whole snapshot in bytes.
+} gf_SnapshotHeader;
+
+/*
+Name:        int gf_SaveSnapshot(gf_Saver *saver, FILE *file, gf_Loader *loader);
+Description: Saves the graph of the loader as a snapshot that gf_MapSnapshot() can map. Every node the loader holds is saved,
+             including ones the builder functions detached. Like every gf_Save...() function this writes to the target of the
+			 saver, so it can be measured or saved into memory. The names are interned with a table that is allocated with
+			 the allocator of the loader and freed before it returns.
+Assumptions: - gf_InitSaver must have been called on saver atleast once.
+             - *saver and *loader are not NULL.
+             - *file is not NULL and is a valid file opened in binary mode when the target of the saver is GF_SAVER_TARGET_FILE.
+			 - The loader has loaded a graph.
+Returns:     1 if it was successful. 0 if nothing is loaded, the table could not be allocated or writing failed. The error is logged.
+Examples:
+{
+	gf_Loader loader;
+	gf_LoadFromFile(&loader, "config.graph", NULL);
+
+	gf_Saver saver;
+	gf_InitSaver(&saver, NULL);
+
+	FILE *file = fopen("config.gfs", "wb");
+	if (file) {
+		gf_SaveSnapshot(&saver, file, &loader);
+		fclose(file);
+	}
+	gf_Unload(&loader);
+
+	// Later, at every start.
+	gf_MapSnapshot(&loader, "config.gfs", NULL);
+	gf_LoaderNode *node = gf_FindFirstChild(&loader, gf_GetRoot(&loader), "port");
+	gf_Unload(&loader);
+}
+*/
+int gf_SaveSnapshot(gf_Saver *saver, FILE *file, gf_Loader *loader);
+
+/*
+Name:        int gf_MapSnapshot(gf_Loader *loader, const char *filename, gf_LogAllocateFreeFunctions *funcs);
+Description: Maps a snapshot saved with gf_SaveSnapshot() and makes it the graph of the loader, so every gf_Get...(),
+             gf_Find...() and gf_LoadVariable...() function works on it straight away. The file is mapped copy on write with
+			 mmap() where it is available. When it is mapped at the base address it was saved for, it is used without being
+			 read through, so only its header is checked. Only map snapshots you made. Otherwise it is relocated and every
+			 pointer is checked. Elsewhere, or when GF_NO_MMAP is defined, the file is read into the file buffer of the loader
+			 and relocated there.
+			 The builder functions can still add to the graph. The mapping is released by gf_Unload() or gf_ResetLoader().
+Assumptions: - *loader, *filename are not NULL.
+             - funcs can be NULL.
+Returns:     1 if it was successful. 0 if the file could not be mapped, is damaged, or was made by a build with a different
+             layout. The error is logged. Call gf_Unload() either way.
+Examples: See gf_SaveSnapshot.
+*/
+int gf_MapSnapshot(gf_Loader *loader, const char *filename, gf_LogAllocateFreeFunctions *funcs);
+
+/*
+Name:        int gf_LoadSnapshotFromBuffer(gf_Loader *loader, char *buffer, gf_u64 count, gf_LogAllocateFreeFunctions *funcs);
+Description: The same as gf_MapSnapshot() but for a snapshot that is already in memory. It is relocated in place, so the
+             buffer is changed and must outlive the loader. The buffer is not freed by gf_Unload().
+Assumptions: - *loader and *buffer are not NULL.
+             - buffer is aligned to GF_ARENA_ALIGNMENT and is atleast count bytes long.
+             - funcs can be NULL.
+Returns:     1 if it was successful. 0 if the snapshot is damaged or was made by a build with a different layout. The error is logged.
+*/
+int gf_LoadSnapshotFromBuffer(gf_Loader *loader, char *buffer, gf_u64 count, gf_LogAllocateFreeFunctions *funcs);
+
+/*
+Name:        int gf_ShareSnapshot(gf_Loader *loader, const char *name);
+Description: Saves the graph of the loader as a snapshot into a new POSIX shared memory segment, so processes on the same machine
+             can attach to one copy of it with gf_AttachSnapshot() instead of each loading their own.
+			 The segment stays until gf_UnshareSnapshot() is called, even after this process exits.
+			 A marker is written after the snapshot once it is complete, so attaching before then fails instead of seeing half of it.
+			 Only a process that maps the segment at GF_SNAPSHOT_BASE shares its pages. That is one segment per process, as the
+			 next one finds the address taken, and never on 32 bit systems, where GF_SNAPSHOT_BASE is 0. Every other attach
+			 gets a private copy of the nodes and tokens. See gf_AttachSnapshot().
+			 Needs GF_SHM. See the top of this file.
+Assumptions: - *loader and *name are not NULL.
+             - The loader has loaded a graph.
+			 - name is a valid shm_open() name like "/game_data".
+Returns:     1 if it was successful. 0 if sharing is not available, a segment with the name exists or it could not be written. The error is logged.
+Examples:
+{
+	// In the process that starts the workers.
+	gf_Loader loader;
+	gf_LoadFromFile(&loader, "game_data.graph", NULL);
+	gf_ShareSnapshot(&loader, "/game_data");
+	gf_Unload(&loader);
+
+	// In each worker.
+	gf_Loader shared;
+	gf_AttachSnapshot(&shared, "/game_data", NULL);
+	gf_LoaderNode *units = gf_FindFirstChild(&shared, gf_GetRoot(&shared), "units");
+	gf_Unload(&shared);
+
+	// Once every worker is done.
+	gf_UnshareSnapshot("/game_data");
+}
+*/
+int gf_ShareSnapshot(gf_Loader *loader, const char *name);
+
+/*
+Name:        int gf_AttachSnapshot(gf_Loader *loader, const char *name, gf_LogAllocateFreeFunctions *funcs);
+Description: Maps a snapshot shared with gf_ShareSnapshot() and makes it the graph of the loader. It is mapped read only at the
+             base address of the snapshot, so every process shares the same pages and nothing is copied. The builder functions
+			 then log an error and return 0 or NULL instead of changing the graph. If the base address is taken in this process,
+			 which it is once another segment is attached at it, or the base is 0 as it is on 32 bit systems, the segment is
+			 mapped copy on write and relocated instead. Then the pages of nodes and tokens are copied and only the text is
+			 shared, and the builder functions work like they do on a loaded graph.
+			 The mapping is released by gf_Unload().
+			 Needs GF_SHM. See the top of this file.
+Assumptions: - *loader and *name are not NULL.
+             - funcs can be NULL.
+Returns:     1 if it was successful. 0 if sharing is not available, there is no complete snapshot with the name, or it was made by a
+             build with a different layout. The error is logged. Call gf_Unload() either way.
+Examples: See gf_ShareSnapshot.
+*/
+int gf_AttachSnapshot(gf_Loader *loader, const char *name, gf_LogAllocateFreeFunctions *funcs);
+
+/*
+Name:        int gf_UnshareSnapshot(const char *name);
+Description: Removes a segment made by gf_ShareSnapshot(). Processes that are attached keep their mapping until they unload it.
+Assumptions: - *name is not NULL.
+Returns:     1 if it was removed. 0 if there was no such segment or sharing is not available.
+*/
+int gf_UnshareSnapshot(const char *name);
+
+/*
+Name:        int gf_RelocateSnapshot(gf_Loader *loader, char *image, gf_u64 count, int check);
+Description: Internal function that checks a snapshot and moves its pointers from its base address to image. Every pointer is
+             checked against the sections of the snapshot, so a damaged file fails instead of pointing outside of it.
+			 If image is at the base address nothing is moved and only the header is checked, unless check is 1.
+			 Then every pointer is still checked, and only the ones that are wrong are written to.
+Assumptions: - *loader and *image are not NULL.
+             - image is aligned to GF_ARENA_ALIGNMENT and is atleast count bytes long.
+             - image is writable, unless it is at the base address and check is 0.
+Returns:     1 if it was successful. 0 if not. The error is logged.
+*/
+int gf_RelocateSnapshot(gf_Loader *loader, char *image, gf_u64 count, int check);
+
+/*
+Name:        int gf_MapSnapshotFile(gf_Loader *loader, const char *filename, int check);
+Description: Internal function that does the work of gf_MapSnapshot() on a loader that is already initialised or reset.
+             check is passed to gf_RelocateSnapshot(). It is 1 for files the caller did not pick, like the cache of
+             GF_LOADER_FLAG_CACHE, so they are never trusted because they happen to land at their base address.
+Assumptions: - gf_InitLoader() or gf_ResetLoader() has been called on *loader.
+             - *filename is not NULL.
+Returns:     1 if it was successful. 0 if not. The error is logged.
+*/
+int gf_MapSnapshotFile(gf_Loader *loader, const char *filename, int check);
+
+/*
+Name:        int gf_SnapshotLayoutMatches(const gf_SnapshotHeader *header);
+Description: Checks that a snapshot is of this version and was made by a build with the same layout as this one.
+Assumptions: - *header is not NULL.
+Returns:     1 if it can be mapped by this build. 0 if not.
+*/
+int gf_SnapshotLayoutMatches(const gf_SnapshotHeader *header);
+
+/*
+Name:        int gf_SaveSnapshotOfFile(gf_Saver *saver, FILE *file, gf_Loader *loader, gf_u64 sourceSize, gf_s64 sourceTime, gf_u64 sourceHash);
+Description: Internal function that saves a snapshot like gf_SaveSnapshot() and records the file it was made from in its header.
+Assumptions: See gf_SaveSnapshot.
+Returns:     1 if it was successful. 0 if not. The error is logged.
+*/
+int gf_SaveSnapshotOfFile(gf_Saver *saver, FILE *file, gf_Loader *loader, gf_u64 sourceSize, gf_s64 sourceTime, gf_u64 sourceHash);
+
+/*
+Name:        gf_u64 gf_HashBytes(const char *bytes, gf_u64 count);
+Description: A fast 64 bit hash of the bytes, 8 bytes at a time. Used to tell if a file changed. It is not a cryptographic hash,
+             and the result depends on the byte order of the machine.
+Assumptions: - *bytes is not NULL and is atleast count bytes long.
+Returns:     The hash.
+*/
+gf_u64 gf_HashBytes(const char *bytes, gf_u64 count);
+
+/*
+Name:        int gf_GetFileInfo(const char *filename, gf_u64 *size, gf_s64 *modified);
+Description: Gets the size and the modification time of a file. The time is 0 where stat() is not available.
+Assumptions: - *filename, *size and *modified are not NULL.
+Returns:     1 if it was successful. 0 if the file could not be found.
+*/
+int gf_GetFileInfo(const char *filename, gf_u64 *size, gf_s64 *modified);
+
+/*
+Name:        int gf_LoadFileWithCache(gf_Loader *loader, const char *filename);
+Description: Internal function used by gf_LoadFromFile() and gf_ReloadFromFile() when the loader has GF_LOADER_FLAG_CACHE.
+             The cache of "level.graph" is the snapshot "level.graph.gfs". It is used when it was made by this build from a
+			 file of the same size, and either the modification time is the same or the contents hash the same. A file changed
+			 in the last second might change again without its time changing, so the time of such a file is not trusted and
+			 its contents are hashed every time until the cache is made again.
+			 Otherwise the file is loaded as text and the cache is made again. It is written to a temporary file that is renamed
+			 over the old one, so a loader in another process never maps half a cache. Failing to write the cache is logged as a
+			 warning and does not fail the load.
+Assumptions: - gf_InitLoader() or gf_ResetLoader() has been called on *loader.
+             - *filename is not NULL.
+Returns:     1 if it was successful. 0 if the file could not be loaded. The error is logged.
+*/
+int gf_LoadFileWithCache(gf_Loader *loader, const char *filename);
+
+/*
+Name:        int gf_WriteCache(gf_Loader *loader, const char *cacheFilename, gf_u64 sourceSize, gf_s64 sourceTime, gf_u64 sourceHash);
+Description: Internal function that saves the graph of the loader as the cache of a file. See gf_LoadFileWithCache.
+Assumptions: - *loader has a graph loaded.
+             - *cacheFilename is not NULL.
+Returns:     1 if it was successful. 0 if not. This is logged as a warning.
+*/
+int gf_WriteCache(gf_Loader *loader, const char *cacheFilename, gf_u64 sourceSize, gf_s64 sourceTime, gf_u64 sourceHash);
+
+/*
+Name:        void gf_UnmapSnapshot(gf_Loader *loader);
+Description: Internal function that releases the mapping made by gf_MapSnapshot(). Does nothing if nothing is mapped.
+Assumptions: - *loader is not NULL.
+Returns:     Nothing.
+*/
+void gf_UnmapSnapshot(gf_Loader *loader);
+
+/*-----------------------------------------------------------------------------------*/
+
+/*-------------------------------------INDEX-----------------------------------------*/
+
+/*
+A .gfi file sits next to a text file and lists where each top level record of the file is, so one record can be loaded
+by reading and parsing only its bytes instead of everything before it. A record is a name with its list => a { ... },
+a name on its own => a, or a value at the top level => 1. Records are numbered from 0 in the order they are in the file.
+Every number in the file is little endian.
+
+header   "GFI", the version byte and 4 bytes that are 0.
+records  For each record the u64 offset of its first byte from the start of the file, its u64 length, the u32 length of
+         its name and then the name. Values have no name.
+footer   The u64 number of records and the u64 size of the file that was indexed.
+*/
+
+#define GF_INDEX_VERSION 1
+#define GF_INDEX_HEADER_SIZE 8
+#define GF_INDEX_FOOTER_SIZE 16
+
+// Where a top level record is in an indexed file.
+typedef struct gf_IndexRecord {
+	gf_u64 offset;     // The offset of the first byte of the record from the start of the file.
+	gf_u64 length;     // The number of bytes in the record.
+	const char *name;  // The name of the record. It is not NULL terminated.
+	gf_u64 nameLength; // The length of name. 0 for a value.
+} gf_IndexRecord;
+
+// The records of a file, opened with gf_OpenIndex().
+typedef struct gf_Index {
+	gf_Loader storage;       // Holds the .gfi file, the records and the table. Its log and allocator are used for everything the index does.
+	char *filename;          // The name of the indexed file.
+	gf_IndexRecord *records; // Every record in the order they are in the file.
+	gf_u64 recordCount;      // The number of records.
+	gf_u64 *slots;           // Finds records by name. Each slot holds the number of a record plus 1, or 0 when it is empty.
+	gf_u64 slotMask;         // The number of slots minus 1. The number of slots is a power of 2.
+} gf_Index;
+
+/*
+Name:        int gf_IndexFile(const char *filename, gf_LogAllocateFreeFunctions *funcs);
+Description: Reads a text file once and writes the index of its records to the file name with ".gfi" added => "data.graph.gfi".
+             Use gf_SaveIndexed() to write the index while saving instead.
+Assumptions: - *filename is not NULL.
+             - funcs can be NULL.
+Returns:     1 if it was successful. 0 if the file could not be read, is a .gfb file (those already hold a table of their records),
+             its braces do not match or the index could not be written. The error is logged.
+Examples:
+{
+	gf_IndexFile("world.graph", NULL);
+
+	gf_Index index;
+	gf_OpenIndex(&index, "world.graph", NULL);
+
+	gf_Loader loader;
+	gf_LoadRecord(&loader, &index, "player", NULL);
+	gf_LoaderNode *player = gf_FindFirstChild(&loader, gf_GetRoot(&loader), "player");
+	gf_Unload(&loader);
+
+	gf_CloseIndex(&index);
+}
+*/
+int gf_IndexFile(const char *filename, gf_LogAllocateFreeFunctions *funcs);
+
+/*
+Name:        int gf_IndexBuffer(gf_Saver *saver, FILE *indexFile, const char *buffer, gf_u64 count);
+Description: Writes the index of the records in the text in buffer with saver. Only the braces are matched, so text that does
+             not load still gets an index. Loading a record of it fails instead.
+Assumptions: - *saver is not NULL.
+             - *indexFile is not NULL and is a valid file when the target of the saver is GF_SAVER_TARGET_FILE.
+             - *buffer is not NULL and is atleast count bytes long. count is the size of the file, without a NULL terminator.
+Returns:     1 if it was successful. 0 if not. The error is logged.
+*/
+int gf_IndexBuffer(gf_Saver *saver, FILE *indexFile, const char *buffer, gf_u64 count);
+
+/*
+Name:        int gf_SaveIndexed(gf_Saver *saver, FILE *file, FILE *indexFile, gf_LoaderNode *node);
+Description: The same as gf_SaveNode(), but it also writes the index of every record it saves to indexFile, so the file does not
+             have to be read again with gf_IndexFile(). The offsets are counted from the first byte saver wrote, so use a saver that
+			 was just initialised and a file that is empty. Values at the top level are saved on a line each.
+Assumptions: - *saver is not NULL.
+             - *file is not NULL and is a valid file when the target of the saver is GF_SAVER_TARGET_FILE.
+             - *indexFile is not NULL and is a valid file.
+             - node can be NULL.
+Returns:     1 if it was successful. 0 if node is NULL or writing failed. The error is logged.
+Examples:
+{
+	gf_Saver saver;
+	gf_InitSaver(&saver, NULL);
+
+	FILE *file = fopen("world.graph", "wb");
+	FILE *indexFile = fopen("world.graph.gfi", "wb");
+	gf_SaveIndexed(&saver, file, indexFile, gf_GetRoot(&loader));
+	fclose(indexFile);
+	fclose(file);
+}
+*/
+int gf_SaveIndexed(gf_Saver *saver, FILE *file, FILE *indexFile, gf_LoaderNode *node);
+
+/*
+Name:        int gf_OpenIndex(gf_Index *index, const char *filename, gf_LogAllocateFreeFunctions *funcs);
+Description: Reads the index of filename from the file name with ".gfi" added. Call gf_CloseIndex() when done with it.
+Assumptions: - *index and *filename are not NULL.
+             - funcs can be NULL.
+Returns:     1 if it was successful. 0 if there is no index, it is damaged or the size of filename is not the size that was
+             indexed, so the index is out of date. The error is logged. Call gf_CloseIndex() either way.
+Examples: See gf_IndexFile.
+*/
+int gf_OpenIndex(gf_Index *index, const char *filename, gf_LogAllocateFreeFunctions *funcs);
+
+/*
+Name:        void gf_CloseIndex(gf_Index *index);
+Description: Frees everything gf_OpenIndex() allocated.
+Assumptions: - *index is not NULL and gf_OpenIndex() was called on it.
+Returns:     Nothing.
+*/
+void gf_CloseIndex(gf_Index *index);
+
+/*
+Name:        int gf_FindRecord(gf_Index *index, const char *name, gf_u64 occurrence, gf_u64 *ordinal);
+Description: Finds the number of a record by its name without reading the indexed file. occurrence picks one of the
+             records that share the name, 0 is the first one in the file.
+Assumptions: - *index, *name and *ordinal are not NULL.
+Returns:     1 if the record was found. 0 if not.
+Examples:
+{
+	gf_u64 ordinals[2];
+	if (gf_FindRecord(&index, "level", 3, &ordinals[0]) && gf_FindRecord(&index, "player", 0, &ordinals[1])) {
+		gf_LoadRecords(&loader, &index, ordinals, 2, NULL);
+	}
+}
+*/
+int gf_FindRecord(gf_Index *index, const char *name, gf_u64 occurrence, gf_u64 *ordinal);
+
+/*
+Name:        int gf_LoadRecords(gf_Loader *loader, gf_Index *index, const gf_u64 *ordinals, gf_u64 count, gf_LogAllocateFreeFunctions *funcs);
+Description: Loads only the records with the given numbers from the indexed file. Each record is read with a seek, then they
+             are parsed together, so the root holds the records in the order of ordinals. Line numbers in errors are counted
+			 from the first record that was read.
+Assumptions: - *loader and *index are not NULL and the index is open.
+             - *ordinals is not NULL and is atleast count numbers long.
+             - funcs can be NULL.
+Returns:     1 if it was successful. 0 if a number is past the last record, the file could not be read, a record does not
+             start with its name because the index is out of date or it failed to parse. The error is logged. Call gf_Unload() either way.
+Examples: See gf_FindRecord.
+*/
+int gf_LoadRecords(gf_Loader *loader, gf_Index *index, const gf_u64 *ordinals, gf_u64 count, gf_LogAllocateFreeFunctions *funcs);
+
+/*
+Name:        int gf_LoadRecord(gf_Loader *loader, gf_Index *index, const char *name, gf_LogAllocateFreeFunctions *funcs);
+Description: Loads the first record with the name from the indexed file. See gf_LoadRecords.
+Assumptions: - *loader, *index and *name are not NULL and the index is open.
+             - funcs can be NULL.
+Returns:     1 if it was successful. 0 if there is no record with the name or loading it failed. The error is logged. Call gf_Unload() either way.
+Examples: See gf_IndexFile.
+*/
+int gf_LoadRecord(gf_Loader *loader, gf_Index *index, const char *name, gf_LogAllocateFreeFunctions *funcs);
+
+/*
+Name:        int gf_SaveIndexRecord(gf_Saver *saver, FILE *indexFile, gf_u64 offset, gf_u64 length, const char *name, gf_u64 nameLength);
+Description: Internal function that writes one record to a .gfi file.
+Assumptions: - *saver is not NULL.
+             - *indexFile is not NULL and is a valid file when the target of the saver is GF_SAVER_TARGET_FILE.
+             - *name is not NULL and is atleast nameLength characters long.
+Returns:     1 if it was successful. 0 if not. The error is logged.
+*/
+int gf_SaveIndexRecord(gf_Saver *saver, FILE *indexFile, gf_u64 offset, gf_u64 length, const char *name, gf_u64 nameLength);
+
+/*
+Name:        char *gf_MakeIndexFilename(gf_Loader *loader, const char *filename);
+Description: Internal function that allocates the name of the .gfi file of filename with the allocator of the loader.
+Assumptions: - *loader and *filename are not NULL.
+Returns:     The name. Free it with gf_Free(). NULL if it is out of memory, which is logged.
+*/
+char *gf_MakeIndexFilename(gf_Loader *loader, const char *filename);
+
+/*-----------------------------------------------------------------------------------*/
+
+/*-----------------------------------RECORD LOG--------------------------------------*/
+
+/*
+A record log is a text file that only ever grows. gf_AppendRecords() adds top level records to the end of it, and a
+gf_RecordReader reads them back one at a time. The reader keeps only the part of the file that holds the record it is
+reading, so a log of any size is read in the memory of its biggest record. A reader that tails the log waits for records
+that are still being written instead of failing on them.
+*/
+
+// How many bytes a gf_RecordReader asks for when it reads more of the file. The reader can change it before reading.
+#ifndef GF_RECORD_READ_SIZE
+#define GF_RECORD_READ_SIZE (64 * 1024)
+#endif
+
+// The biggest record a gf_RecordReader reads by default. The reader can change it before reading.
+#ifndef GF_DEFAULT_MAX_RECORD_SIZE
+#define GF_DEFAULT_MAX_RECORD_SIZE (64 * 1024 * 1024)
+#endif
+
+// What gf_NextRecord() did.
+typedef enum gf_RecordStatus {
+	GF_RECORD_ERROR = 0, // Reading failed. The error is logged.
+	GF_RECORD_READY,     // A record was read. It is the first child of the root of the loader of the reader.
+	GF_RECORD_END        // There is no complete record left. When tailing, calling again reads the records written since.
+} gf_RecordStatus;
+
+// Reads the records of a file one at a time. Opened with gf_OpenRecords().
+typedef struct gf_RecordReader {
+	gf_Loader loader;     // Holds the record that was read last. Its file buffer holds the part of the file that has not been read as records yet.
+	FILE *file;           // The file being read.
+	int tail;             // If this is not 0 the file may still be written to, so its end is not treated as the end of the last record.
+	gf_u64 start;         // The offset in the buffer of the first byte that has not been read as a record.
+	gf_u64 end;           // The number of bytes of the file in the buffer.
+	gf_u64 offset;        // The offset in the file of the first byte in the buffer.
+	gf_u64 recordOffset;  // The offset in the file of the record that was read last.
+	gf_u64 readSize;      // How many bytes to read from the file at a time. GF_RECORD_READ_SIZE by default.
+	gf_u64 maxRecordSize; // Reading fails on a record bigger than this. GF_DEFAULT_MAX_RECORD_SIZE by default.
+} gf_RecordReader;
+
+/*
+Name:        int gf_AppendRecords(gf_Saver *saver, FILE *file, FILE *indexFile, gf_LoaderNode *node);
+Description: Adds a record to the end of a file, or every child of node if it is the root. Nothing before the end of the
+             file is read or written, apart from its last byte, which is checked to see if a newline has to be written first.
+			 If indexFile is not NULL the records are added to the index of the file too. Its footer is overwritten, so the
+			 index has to be opened with "r+b", or "w+b" when it is new. It has to be up to date with the file.
+			 The file is flushed once the records are written, so a reader tailing it sees them.
+Assumptions: - *saver is not NULL and its target is GF_SAVER_TARGET_FILE.
+             - *file is not NULL and was opened with "a+b". "ab" works but always writes a newline first.
+			 - indexFile can be NULL.
+			 - node can be NULL.
+Returns:     1 if it was successful. 0 if node is NULL, the index does not match the file or writing failed. The error is logged.
+Examples:
+{
+	gf_Saver saver;
+	gf_InitSaverWithFormat(&saver, NULL, GF_SAVER_FORMAT_SINGLE_LINE);
+
+	FILE *file = fopen("telemetry.graph", "a+b");
+	for (int frame = 0; frame < frameCount; frame++) {
+		gf_AppendRecords(&saver, file, NULL, gf_GetRoot(&frames[frame]));
+	}
+	fclose(file);
+}
+*/
+int gf_AppendRecords(gf_Saver *saver, FILE *file, FILE *indexFile, gf_LoaderNode *node);
+
+/*
+Name:        int gf_OpenRecords(gf_RecordReader *reader, const char *filename, int tail, gf_LogAllocateFreeFunctions *funcs);
+Description: Opens a file to read its records one at a time with gf_NextRecord(). Nothing is read yet.
+             If tail is not 0 the file is expected to still be written to. A record at the end of it is only read once it
+			 is known to be complete, and running out of records is not the end of the file. Call gf_CloseRecords() when done.
+Assumptions: - *reader and *filename are not NULL.
+             - funcs can be NULL.
+Returns:     1 if it was successful. 0 if the file could not be opened. The error is logged. Call gf_CloseRecords() either way.
+Examples:
+{
+	gf_RecordReader reader;
+	gf_OpenRecords(&reader, "telemetry.graph", 1, NULL);
+
+	while (running) {
+		gf_RecordStatus status = gf_NextRecord(&reader);
+		if (status == GF_RECORD_READY) {
+			gf_LoaderNode *record = gf_GetChild(&reader.loader, gf_GetRoot(&reader.loader));
+			// ... do stuff ...
+		}
+		else if (status == GF_RECORD_END) {
+			Sleep(100);
+		}
+		else {
+			break;
+		}
+	}
+
+	gf_CloseRecords(&reader);
+}
+*/
+int gf_OpenRecords(gf_RecordReader *reader, const char *filename, int tail, gf_LogAllocateFreeFunctions *funcs);
+
+/*
+Name:        gf_RecordStatus gf_NextRecord(gf_RecordReader *reader);
+Description: Reads the next record of the file into the loader of the reader. The record read before it is gone, as the
+             memory of the loader and its buffer are reused. A record ends where the next one starts or where its list is closed.
+Assumptions: - *reader is not NULL and gf_OpenRecords() was successful.
+Returns:     GF_RECORD_READY if a record was read. GF_RECORD_END if there is no complete record left. GF_RECORD_ERROR if the file
+             could not be read, a record is bigger than maxRecordSize or does not parse, or the file ends inside a record when
+			 it is not being tailed. The error is logged.
+Examples: See gf_OpenRecords.
+*/
+gf_RecordStatus gf_NextRecord(gf_RecordReader *reader);
+
+/*
+Name:        void gf_CloseRecords(gf_RecordReader *reader);
+Description: Closes the file and frees everything the reader allocated.
+Assumptions: - *reader is not NULL and gf_OpenRecords() was called on it.
+Returns:     Nothing.
+*/
+void gf_CloseRecords(gf_RecordReader *reader);
+
+/*
+Name:        int gf_FindNextRecord(gf_RecordReader *reader, int final, gf_u64 *recordStart, gf_u64 *recordEnd);
+Description: Internal function that looks for a complete record in the buffer of the reader. If final is not 0 nothing
+             more will be read, so the end of the buffer ends the last record.
+Assumptions: - *reader, *recordStart and *recordEnd are not NULL.
+Returns:     1 if a record was found, with its offsets in the buffer. 0 if more of the file is needed. -1 if the text
+             can not be split into records. The error is logged.
+*/
+int gf_FindNextRecord(gf_RecordReader *reader, int final, gf_u64 *recordStart, gf_u64 *recordEnd);
+
+/*
+Name:        int gf_ReadMoreRecords(gf_RecordReader *reader, gf_u64 *readCount);
+Description: Internal function that moves what has not been read as records to the start of the buffer and reads more of the file after it.
+Assumptions: - *reader and *readCount are not NULL.
+Returns:     1 if it was successful, even if nothing more was read. 0 if the buffer would have to grow past maxRecordSize or
+             it is out of memory. The error is logged.
+*/
+int gf_ReadMoreRecords(gf_RecordReader *reader, gf_u64 *readCount);
+
+/*-----------------------------------------------------------------------------------*/
+
+/*-------------------------------------BATCH-----------------------------------------*/
+
+// The most threads gf_LoadBatch() uses, including the thread that calls it.
+#ifndef GF_MAX_BATCH_THREADS
+#define GF_MAX_BATCH_THREADS 64
+#endif
+
+// The files of one call to gf_LoadBatch(), shared by the threads that load them.
+typedef struct gf_Batch {
+	gf_Loader *loaders;                  // The loader of each file.
+	const char *const *filenames;        // The files to load.
+	int *results;                        // What loading each file returned. Can be NULL.
+	gf_u64 count;                        // The number of files.
+	gf_LogAllocateFreeFunctions *funcs;  // Passed to gf_LoadFromFile() for every file. Can be NULL.
+	gf_u64 next;                         // The next file a thread takes.
+	gf_u64 failures;                     // The number of files that failed to load.
+#ifdef GF_THREADS
+	pthread_mutex_t lock;                // Guards next and failures.
+#endif
+} gf_Batch;
+
+/*
+Name:        int gf_LoadBatch(gf_Loader *loaders, const char *const *filenames, int *results, gf_u64 count, gf_u32 threadCount, gf_LogAllocateFreeFunctions *funcs);
+Description: Loads many files at once with gf_LoadFromFile(), each into its own loader, so reading and parsing them is spread
+             over threadCount threads. The calling thread is one of them. Files are handed out one at a time to whichever
+			 thread is free, so a few big files do not hold up the rest. loaders[i] holds filenames[i] once it returns.
+			 If threadCount is 0 a thread per core is used. Without GF_THREADS the files are loaded one after another.
+			 funcs is shared by every thread, so its log and allocation functions have to be safe to call from many threads at once.
+			 malloc(), free() and gf_DefaultLog() are.
+Assumptions: - *loaders and *filenames are not NULL and are atleast count long.
+             - results can be NULL. If not it is atleast count long.
+			 - funcs can be NULL.
+Returns:     1 if every file was loaded. 0 if any failed. The error of each is logged and results[i] is what loading filenames[i]
+             returned. Call gf_Unload() on every loader either way.
+Examples:
+{
+	const char *filenames[3] = { "level.graph", "units.graph", "items.graph" };
+	gf_Loader loaders[3];
+	int results[3];
+
+	gf_LoadBatch(loaders, filenames, results, 3, 0, NULL);
+	for (int i = 0; i < 3; i++) {
+		if (results[i]) {
+			// ... do stuff ...
+		}
+		gf_Unload(&loaders[i]);
+	}
+}
+*/
+int gf_LoadBatch(gf_Loader *loaders, const char *const *filenames, int *results, gf_u64 count, gf_u32 threadCount, gf_LogAllocateFreeFunctions *funcs);
+
+/*
+Name:        void gf_LoadBatchFiles(gf_Batch *batch);
+Description: Internal function that each thread of gf_LoadBatch() runs. It loads files of the batch until there are none left.
+Assumptions: - *batch is not NULL.
+Returns:     Nothing.
+*/
+void gf_LoadBatchFiles(gf_Batch *batch);
+
+/*
+Name:        gf_u32 gf_CountCores(void);
+Description: Internal function that finds how many cores can run threads.
+Returns:     The number of cores. 1 if it is not known.
+*/
+gf_u32 gf_CountCores(void);
+
+/*-----------------------------------------------------------------------------------*/
+
+/*------------------------------------ASYNC READ-------------------------------------*/
+
+// How many files gf_LoadFiles() reads at once when it is given 0.
+#ifndef GF_DEFAULT_READS_IN_FLIGHT
+#define GF_DEFAULT_READS_IN_FLIGHT 16
+#endif
+
+// The most bytes asked for by one read. Bigger files are read in parts.
+#define GF_MAX_READ_SIZE (1 << 30)
+
+// The files of one call to gf_LoadFiles() and where reading each of them is.
+typedef struct gf_FileLoads {
+	gf_Loader *loaders;            // The loader of each file. Each file is read into the file buffer of its loader.
+	const char *const *filenames;  // The files to load.
+	int *results;                  // What loading each file returned. Can be NULL.
+	gf_u64 count;                  // The number of files.
+	gf_u64 next;                   // The next file to start reading.
+	gf_u64 failures;               // The number of files that failed to load.
+	gf_u64 *sizes;                 // The size of each file, plus 1 for the NULL terminator once it is read.
+	gf_u64 *readCounts;            // How many bytes of each file have been read with io_uring.
+	int *fds;                      // The file descriptor of each file while io_uring reads it.
+	int *readResults;              // 1 for each file that was read, 0 for each file that failed to read.
+	gf_u64 *completed;             // The files in the order their reads finished.
+	gf_u64 completedCount;         // The number of files in completed.
+#ifdef GF_THREADS
+	pthread_mutex_t lock;          // Guards next, completed and completedCount when files are read on threads.
+	pthread_cond_t readFinished;   // Signalled when a thread adds a file to completed.
+#endif
+} gf_FileLoads;
+
+#ifdef GF_IO_URING
+// The rings shared with the kernel by io_uring.
+typedef struct gf_Ring {
+	int fd;                     // The io_uring file descriptor.
+	unsigned *sqHead;           // The first submission the kernel has not taken yet.
+	unsigned *sqTail;           // The end of the submissions.
+	unsigned *sqMask;           // Turns a position into an index of the submission ring.
+	unsigned *sqArray;          // The index of the submission entry at each position.
+	unsigned sqEntries;         // The number of submission entries.
+	struct io_uring_sqe *sqes;  // The submission entries.
+	unsigned *cqHead;           // The first completion that has not been reaped.
+	unsigned *cqTail;           // The end of the completions.
+	unsigned *cqMask;           // Turns a position into an index of the completion ring.
+	struct io_uring_cqe *cqes;  // The completion entries.
+	void *sqRing;               // The mapping of the submission ring.
+	gf_u64 sqRingSize;          // The size of sqRing.
+	void *cqRing;               // The mapping of the completion ring. The same as sqRing when the kernel maps them together.
+	gf_u64 cqRingSize;          // The size of cqRing.
+	gf_u64 sqesSize;            // The size of the mapping of sqes.
+} gf_Ring;
+#endif
+
+/*
+Name:        int gf_LoadFiles(gf_Loader *loaders, const char *const *filenames, int *results, gf_u64 count, gf_u32 readsInFlight, gf_LogAllocateFreeFunctions *funcs);
+Description: Loads many files, each into its own loader, while keeping up to readsInFlight reads going at once. Each file
+             is parsed on the calling thread as soon as its read finishes, while the rest are still being read, so loading from a
+			 cold disk does not wait on each read in turn. loaders[i] holds filenames[i] once it returns.
+			 The files are read with io_uring where GF_IO_URING is defined and the kernel allows it, otherwise on readsInFlight
+			 threads, or one after another without GF_THREADS. Use gf_LoadBatch() instead to parse on many threads too.
+			 GF_LOADER_FLAG_CACHE is not used.
+			 The threads that read files allocate and log with funcs, so they have to be safe to call from many threads at once.
+			 malloc(), free() and gf_DefaultLog() are.
+Assumptions: - *loaders and *filenames are not NULL and are atleast count long.
+             - results can be NULL. If not it is atleast count long.
+			 - readsInFlight is 0 to use GF_DEFAULT_READS_IN_FLIGHT.
+			 - funcs can be NULL.
+Returns:     1 if every file was loaded. 0 if any failed. The error of each is logged and results[i] is 1 if filenames[i] was loaded.
+             Call gf_Unload() on every loader either way.
+Examples:
+{
+	const char *filenames[3] = { "level.graph", "units.graph", "items.graph" };
+	gf_Loader loaders[3];
+	int results[3];
+
+	gf_LoadFiles(loaders, filenames, results, 3, 0, NULL);
+	for (int i = 0; i < 3; i++) {
+		gf_Unload(&loaders[i]);
+	}
+}
+*/
+int gf_LoadFiles(gf_Loader *loaders, const char *const *filenames, int *results, gf_u64 count, gf_u32 readsInFlight, gf_LogAllocateFreeFunctions *funcs);
+
+/*
+Name:        void gf_ParseReadFile(gf_FileLoads *loads, gf_u64 index);
+Description: Internal function that parses a file of gf_LoadFiles() once it has been read, and records the result.
+Assumptions: - *loads is not NULL and index is less than its count.
+Returns:     Nothing.
+*/
+void gf_ParseReadFile(gf_FileLoads *loads, gf_u64 index);
+
+/*
+Name:        void gf_ReadFileLoads(gf_FileLoads *loads);
+Description: Internal function that each thread reading the files of gf_LoadFiles() runs. It reads files until there are none left.
+Assumptions: - *loads is not NULL.
+Returns:     Nothing.
+*/
+void gf_ReadFileLoads(gf_FileLoads *loads);
+
+/*
+Name:        void gf_LoadFilesWithThreads(gf_FileLoads *loads, gf_u32 readsInFlight);
+Description: Internal function that reads the files on threads, or one after another without GF_THREADS, and parses each as it is read.
+Assumptions: - *loads is not NULL.
+Returns:     Nothing.
+*/
+void gf_LoadFilesWithThreads(gf_FileLoads *loads, gf_u32 readsInFlight);
+
+#ifdef GF_IO_URING
+/*
+Name:        int gf_OpenRing(gf_Ring *ring, gf_u32 entries);
+Description: Internal function that sets up io_uring with room for entries reads.
+Assumptions: - *ring is not NULL.
+Returns:     1 if it was successful. 0 if the kernel does not allow io_uring.
+*/
+int gf_OpenRing(gf_Ring *ring, gf_u32 entries);
+
+/*
+Name:        void gf_CloseRing(gf_Ring *ring);
+Description: Internal function that releases what gf_OpenRing() made.
+Assumptions: - *ring is not NULL and gf_OpenRing() was successful.
+Returns:     Nothing.
+*/
+void gf_CloseRing(gf_Ring *ring);
+
+/*
+Name:        int gf_QueueRingRead(gf_Ring *ring, int fd, char *buffer, gf_u32 length, gf_u64 offset, gf_u64 userData);
+Description: Internal function that adds a read to the submission ring. It is started by the next gf_EnterRing().
+Assumptions: - *ring is not NULL and *buffer is atleast length bytes long.
+Returns:     1 if it was added. 0 if the ring is full.
+*/
+int gf_QueueRingRead(gf_Ring *ring, int fd, char *buffer, gf_u32 length, gf_u64 offset, gf_u64 userData);
+
+/*
+Name:        int gf_EnterRing(gf_Ring *ring, int wait);
+Description: Internal function that starts every queued read, and waits for one to finish if wait is not 0.
+Assumptions: - *ring is not NULL.
+Returns:     1 if it was successful. 0 if not.
+*/
+int gf_EnterRing(gf_Ring *ring, int wait);
+
+/*
+Name:        int gf_ReapRing(gf_Ring *ring, gf_u64 *userData, gf_s32 *result);
+Description: Internal function that takes the next finished read from the completion ring.
+Assumptions: - *ring, *userData and *result are not NULL.
+Returns:     1 if a read had finished. 0 if none had.
+*/
+int gf_ReapRing(gf_Ring *ring, gf_u64 *userData, gf_s32 *result);
+
+/*
+Name:        int gf_LoadFilesWithRing(gf_FileLoads *loads, gf_u32 readsInFlight);
+Description: Internal function that reads the files with io_uring and parses each as soon as it is read.
+Assumptions: - *loads is not NULL.
+Returns:     1 if io_uring was used. 0 if the kernel does not allow it and nothing was done.
+*/
+int gf_LoadFilesWithRing(gf_FileLoads *loads, gf_u32 readsInFlight);
+#endif
+
+/*-----------------------------------------------------------------------------------*/
+
+/*-------------------------------------PIPELINE--------------------------------------*/
+
+// How many bytes are read at a time when a file is tokenised while it is read. See GF_LOADER_FLAG_PIPELINE.
+#ifndef GF_PIPELINE_BLOCK_SIZE
+#define GF_PIPELINE_BLOCK_SIZE (1024 * 1024)
+#endif
+
+// How many blocks the reading thread can get ahead of the tokeniser. Only this many blocks are ever in memory at once.
+#ifndef GF_PIPELINE_BLOCK_COUNT
+#define GF_PIPELINE_BLOCK_COUNT 4
+#endif
+
+// A file that one thread reads a block at a time into a few buffers, used in turn, while another tokenises the blocks read so far.
+typedef struct gf_Pipeline {
+	const char *filename;       // The name of the file, for errors.
+	FILE *file;                 // The file being read.
+	gf_u64 size;                // The size of the file, or of the text it decompresses to.
+	gf_u64 offset;              // How many bytes of the text have been read.
+	gf_u64 blockSize;           // How many bytes are read at a time. The most a block decompresses to for a compressed file.
+	int compressed;             // 1 if the file is compressed. Each block is decompressed once it is read.
+	char *compressedBlock;      // Where a compressed block is read before it is decompressed. blockSize bytes big.
+	char *blocks;               // GF_PIPELINE_BLOCK_COUNT buffers of blockSize bytes that blocks are read into in turn.
+	gf_u64 lengths[GF_PIPELINE_BLOCK_COUNT]; // How many bytes were read into each buffer.
+	gf_u64 read;                // How many blocks have been read.
+	gf_u64 used;                // How many blocks the tokeniser is done with. Their buffers can be read into again.
+	gf_u64 windowEnd;           // How many bytes of the text the tokeniser has added to its window. See gf_FillPipelineWindow().
+	int threaded;               // 1 if a thread reads the blocks. Otherwise each block is read when the tokeniser waits for it.
+	int failed;                 // 1 once a read has failed.
+	int stop;                   // 1 once the rest of the file is not needed.
+#ifdef GF_THREADS
+	pthread_mutex_t lock;       // Guards read, used, failed and stop.
+	pthread_cond_t blockRead;   // Signalled when a block has been read or reading failed.
+	pthread_cond_t blockUsed;   // Signalled when the tokeniser is done with a block or stop is set.
+#endif
+} gf_Pipeline;
+
+/*
+Name:        int gf_LoadFileWithPipeline(gf_Loader *loader, const char *filename, gf_u64 blockSize);
+Description: Internal function that gf_LoadFromFile() and gf_ReloadFromFile() load files with.
+             The file is read blockSize bytes at a time on another thread while the calling thread tokenises the blocks that
+			 have been read, so tokenising a big file takes little longer than reading it. A token cut off at the end of a block
+			 is scanned again once the next block is read. It is parsed once it is all tokenised.
+			 The text of each token is copied into the arena and its line and column are worked out as it is scanned, so only
+			 GF_PIPELINE_BLOCK_COUNT blocks and the tokens cut off at the end of them are in memory besides the loaded tree. The
+			 file buffer of the loader is only as big as that, and the line index of the loader has no buffer.
+			 A compressed file is read in the blocks it was compressed in, whatever blockSize is, and each is decompressed on the
+			 reading thread. Without GF_THREADS the blocks are read one after another as they are tokenised, which saves the same
+			 memory but does not overlap the two.
+			 blockSize 0, or a file that is one block or less, is read in one go and loaded like gf_LoadFromBuffer(). So is a
+			 binary file, as the tokens of a binary file point into it. GF_LOADER_FLAG_PRESIZE is not used while tokenising as the
+			 file is read, as counting needs the whole file.
+Assumptions: - gf_InitLoader() or gf_ResetLoader() has been called on *loader.
+             - *filename is not NULL.
+Returns:     1 if it was successful. 0 if the file could not be loaded. The error is logged.
+*/
+int gf_LoadFileWithPipeline(gf_Loader *loader, const char *filename, gf_u64 blockSize);
+
+/*
+Name:        int gf_ReadPipelineBlock(gf_Pipeline *pipeline, char *destination, gf_u64 *length);
+Description: Internal function that reads the next block of the file of the pipeline into destination, decompressing it if the
+             file is compressed, and stores how many bytes of text it holds in length.
+Assumptions: - *pipeline, *destination and *length are not NULL.
+             - destination has room for blockSize bytes, or for the rest of the text if it is less.
+Returns:     1 if it was successful. 0 if the read failed or a compressed block is broken.
+*/
+int gf_ReadPipelineBlock(gf_Pipeline *pipeline, char *destination, gf_u64 *length);
+
+/*
+Name:        void gf_ReadPipeline(gf_Pipeline *pipeline);
+Description: Internal function that the reading thread runs. It reads the file of the pipeline a block at a time into the buffer
+             the tokeniser is done with longest ago, making each block available once it is read. It waits while every buffer
+			 holds a block the tokeniser has not used yet. It stops early if a read fails or stop is set.
+Assumptions: - *pipeline is not NULL.
+Returns:     Nothing.
+*/
+void gf_ReadPipeline(gf_Pipeline *pipeline);
+
+/*
+Name:        int gf_WaitForPipeline(gf_Pipeline *pipeline, const char **block, gf_u64 *length);
+Description: Internal function that waits until the next block the tokeniser has not used has been read, then points block at it.
+             Without a reading thread the block is read there and then. It stays valid until gf_UsePipelineBlock() is called.
+Assumptions: - *pipeline, *block and *length are not NULL.
+             - Not all of the file has been used yet.
+Returns:     1 if it was successful. 0 if reading the file failed.
+*/
+int gf_WaitForPipeline(gf_Pipeline *pipeline, const char **block, gf_u64 *length);
+
+/*
+Name:        void gf_UsePipelineBlock(gf_Pipeline *pipeline);
+Description: Internal function that marks the block gf_WaitForPipeline() returned as used, so its buffer can be read into again.
+Assumptions: - *pipeline is not NULL and gf_WaitForPipeline() has returned a block that has not been used yet.
+Returns:     Nothing.
+*/
+void gf_UsePipelineBlock(gf_Pipeline *pipeline);
+
+/*
+Name:        int gf_FillPipelineWindow(gf_Loader *loader, gf_Pipeline *pipeline, gf_u64 *windowLength, gf_u64 wanted);
+Description: Internal function that adds blocks to the end of the window until it holds atleast wanted bytes or the rest of the
+             text. The window is the file buffer of the loader. It starts at the first byte that has not been tokenised yet,
+			 and grows when a cut off token and the next block do not fit in it. It is NULL terminated.
+Assumptions: - *loader, *pipeline and *windowLength are not NULL.
+             - *windowLength is how many bytes the window holds.
+Returns:     1 if it was successful. 0 if reading failed or there was not enough memory. The error is logged.
+*/
+int gf_FillPipelineWindow(gf_Loader *loader, gf_Pipeline *pipeline, gf_u64 *windowLength, gf_u64 wanted);
+
+/*
+Name:        int gf_TokenisePipeline(gf_Loader *loader, gf_Pipeline *pipeline, gf_u64 windowLength);
+Description: Internal function that tokenises the file of the pipeline as it is read, starting with the window, which holds the first
+             windowLength bytes. A token that fails or reaches the end of the window before the whole file is read might only be
+			 cut off, so it is scanned again once the next block is added to it. An error is logged with the line and column it
+			 is at in the file.
+Assumptions: - gf_InitLoader() or gf_ResetLoader() has been called on *loader.
+             - *pipeline is not NULL and the window holds the first windowLength bytes of the text.
+Returns:     1 if it was successful. 0 if not. The error is logged.
+*/
+int gf_TokenisePipeline(gf_Loader *loader, gf_Pipeline *pipeline, gf_u64 windowLength);
+
+/*-----------------------------------------------------------------------------------*/
+
+/*-----------------------------------COMPRESSION-------------------------------------*/
+
+#define GF_COMPRESSED_VERSION 1
+// "GFZ", the version and the most bytes of text a block holds as a u32.
+#define GF_COMPRESSED_HEADER_SIZE 8
+// The number of bytes of text in the block and the number of bytes it is stored in, both as u32. They are the same for
+// a block that is stored as it is.
+#define GF_COMPRESSED_BLOCK_HEADER_SIZE 8
+// A block header of zeros that ends the blocks, then the number of bytes of text in all of them as a u64.
+#define GF_COMPRESSED_FOOTER_SIZE 16
+
+// How many bytes of text are compressed at a time. Each block is compressed on its own.
+#ifndef GF_COMPRESS_BLOCK_SIZE
+#define GF_COMPRESS_BLOCK_SIZE (64 * 1024)
+#endif
+
+// The biggest block a compressed file can have and still be loaded.
+#define GF_MAX_COMPRESS_BLOCK_SIZE (1 << 24)
+
+// The shortest and furthest back a match can be.
+#define GF_COMPRESS_MIN_MATCH 4
+#define GF_COMPRESS_MAX_OFFSET 65535
+
+// The table of where each 4 bytes were last seen has 1 << GF_COMPRESS_HASH_BITS entries.
+#define GF_COMPRESS_HASH_BITS 14
+
+// The most bytes that length bytes can be compressed to. Text that does not compress grows by a byte every 255 bytes.
+#define GF_COMPRESS_BOUND(length) ((length) + (length) / 255 + 16)
+
+// Compresses the text a saver writes. See gf_SaverBeginCompressed.
+typedef struct gf_Compressor {
+	gf_Loader storage;     // Its log and allocator are used for the buffers below.
+	FILE *file;            // The compressed blocks are written to this.
+	char *block;           // The text waiting to be compressed. GF_COMPRESS_BLOCK_SIZE bytes and a NULL terminator.
+	gf_u64 blockUsed;      // How many bytes of text are in block.
+	char *compressed;      // Where a block is compressed to. GF_COMPRESS_BOUND(GF_COMPRESS_BLOCK_SIZE) bytes.
+	gf_u32 *table;         // Where each hash of 4 bytes was last seen in the block being compressed.
+	gf_u64 total;          // How many bytes of text have been written out so far.
+} gf_Compressor;
+
+/*
+Name:        int gf_SaverBeginCompressed(gf_Saver *saver, gf_Compressor *compressor, FILE *file, gf_LogAllocateFreeFunctions *funcs);
+Description: Switches the saver to compressing. Every following gf_Save...() call has its text collected into blocks of
+             GF_COMPRESS_BLOCK_SIZE bytes, which are compressed and written to file. The file passed to the gf_Save...() functions
+			 is not used and can be NULL. Call gf_SaverEndCompressed() once everything is saved to write the last block.
+			 gf_LoadFromFile(), gf_LoadFromBuffer() and the rest of the loading functions find compressed files by their header and
+			 load them like any other. gf_LoadFromFile() tokenises each block while the next is decompressed.
+			 The compression is LZ77 with a hash table, in the same sequences as LZ4, so it decompresses many times faster than
+			 the text tokenises. Repetitive text like saved graphs is usually several times smaller. Binary files compress too.
+			 Its buffers are allocated with funcs and freed by gf_SaverEndCompressed().
+Assumptions: - gf_InitSaver must have been called on saver atleast once.
+             - *saver, *compressor and *file are not NULL. file is opened in binary mode.
+			 - funcs can be NULL.
+Returns:     1 if it was successful. 0 if not, in which case the saver is left as it was. The error is logged.
+Examples:
+{
+	gf_Saver saver;
+	gf_InitSaver(&saver, NULL);
+
+	gf_Compressor compressor;
+	FILE *file = fopen("level.gfz", "wb");
+	if (gf_SaverBeginCompressed(&saver, &compressor, file, NULL)) {
+		gf_SaveNode(&saver, NULL, gf_GetRoot(&loader));
+		gf_SaverEndCompressed(&saver);
+	}
+	fclose(file);
+}
+*/
+int gf_SaverBeginCompressed(gf_Saver *saver, gf_Compressor *compressor, FILE *file, gf_LogAllocateFreeFunctions *funcs);
+
+/*
+Name:        int gf_SaverEndCompressed(gf_Saver *saver);
+Description: Compresses and writes the last block of the text and the footer, frees the buffers of the compressor and switches
+             the saver back to writing to files. Must be called after gf_SaverBeginCompressed() succeeds, even if saving failed.
+Assumptions: - *saver is not NULL and its target is GF_SAVER_TARGET_COMPRESSED.
+Returns:     1 if it was successful. 0 if not. The error is logged.
+*/
+int gf_SaverEndCompressed(gf_Saver *saver);
+
+/*
+Name:        int gf_CompressFile(const char *inputFilename, const char *outputFilename, gf_LogAllocateFreeFunctions *funcs);
+Description: Compresses a .graph or .gfb file as it is, without loading it. gf_ConvertToText() turns it back into text.
+Assumptions: - *inputFilename and *outputFilename are not NULL and are different files.
+             - funcs can be NULL.
+Returns:     1 if it was successful. 0 if not. The error is logged.
+Examples:
+{
+	gf_CompressFile("level.graph", "level.gfz", NULL);
+}
+*/
+int gf_CompressFile(const char *inputFilename, const char *outputFilename, gf_LogAllocateFreeFunctions *funcs);
+
+/*
+Name:        int gf_IsCompressed(const char *buffer, gf_u64 count);
+Description: Checks if the buffer starts with the header of a compressed file.
+Assumptions: - *buffer is not NULL and is atleast count bytes long.
+Returns:     1 if it is compressed. 0 if it is not.
+*/
+int gf_IsCompressed(const char *buffer, gf_u64 count);
+
+/*
+Name:        gf_u64 gf_CompressBlock(const char *source, gf_u64 length, char *destination, gf_u32 *table);
+Description: Internal function that compresses length bytes into a sequence of literals and matches. Each sequence is a token
+             byte holding the number of literals and the length of the match less 4, 15 meaning more bytes of the length
+			 follow, then the literals, then how far back the match is as a u16. The last sequence has no match.
+Assumptions: - *source is not NULL and is atleast length bytes long.
+             - *destination is not NULL and is atleast GF_COMPRESS_BOUND(length) bytes long.
+			 - *table is not NULL and has 1 << GF_COMPRESS_HASH_BITS entries.
+			 - length is not bigger than GF_MAX_COMPRESS_BLOCK_SIZE.
+Returns:     The number of bytes written to destination.
+*/
+gf_u64 gf_CompressBlock(const char *source, gf_u64 length, char *destination, gf_u32 *table);
+
+/*
+Name:        int gf_DecompressBlock(const char *source, gf_u64 sourceLength, char *destination, gf_u64 length);
+Description: Internal function that decompresses a block made by gf_CompressBlock(). Every length and match is checked, so
+             a broken block fails instead of reading or writing outside the buffers.
+Assumptions: - *source is not NULL and is atleast sourceLength bytes long.
+             - *destination is not NULL and is atleast length bytes long.
+Returns:     1 if the block decompressed to exactly length bytes. 0 if not.
+*/
+int gf_DecompressBlock(const char *source, gf_u64 sourceLength, char *destination, gf_u64 length);
+
+/*
+Name:        int gf_DecompressBuffer(const char *buffer, gf_u64 count, char *text, gf_u64 *textLength);
+Description: Internal function that decompresses all the blocks of a compressed file in memory into text. If text is NULL
+             nothing is decompressed and only the length of the text is worked out, so text can be allocated to fit.
+			 Bytes after the footer are ignored.
+Assumptions: - *buffer is not NULL and is atleast count bytes long.
+             - text can be NULL. If not it is atleast *textLength bytes long, as worked out by a call with text NULL.
+			 - *textLength is not NULL.
+Returns:     1 if it was successful. 0 if the buffer is not a valid compressed file.
+*/
+int gf_DecompressBuffer(const char *buffer, gf_u64 count, char *text, gf_u64 *textLength);
+
+/*
+Name:        int gf_LoadCompressedInternal(gf_Loader *loader, const char *buffer, gf_u64 bufferCount);
+Description: Internal function used by gf_LoadInternal() for a compressed buffer. The text is decompressed into the arena of
+             the loader and loaded from there.
+Assumptions: - *loader and *buffer are not NULL.
+             - gf_IsCompressed(buffer, bufferCount) is 1.
+Returns:     Returns 1 if it succeeds. Returns 0 if it fails. The error is logged.
+*/
+int gf_LoadCompressedInternal(gf_Loader *loader, const char *buffer, gf_u64 bufferCount);
+
+/*
+Name:        int gf_OpenCompressedFile(gf_Loader *loader, FILE *file, const char *filename, const char *header, gf_u64 fileSize, gf_u64 *blockSize, gf_u64 *textSize);
+Description: Internal function used by gf_LoadFileWithPipeline() that reads the footer of a compressed file and leaves the
+             file at its first block.
+Assumptions: - *loader, *file, *filename, *header, *blockSize and *textSize are not NULL.
+             - header holds the first GF_COMPRESSED_HEADER_SIZE bytes of the file and gf_IsCompressed() is 1 for it.
+			 - fileSize is atleast GF_COMPRESSED_HEADER_SIZE + GF_COMPRESSED_FOOTER_SIZE.
+Returns:     1 if it was successful. 0 if not. The error is logged.
+*/
+int gf_OpenCompressedFile(gf_Loader *loader, FILE *file, const char *filename, const char *header, gf_u64 fileSize, gf_u64 *blockSize, gf_u64 *textSize);
+
+/*
+Name:        int gf_ReadCompressedBlock(FILE *file, char *compressedBlock, gf_u64 blockSize, char *destination, gf_u64 remaining, gf_u64 *length);
+Description: Internal function that reads the next block of a compressed file and decompresses it into destination.
+Assumptions: - *file, *compressedBlock, *destination and *length are not NULL.
+             - compressedBlock is atleast blockSize bytes long and destination is atleast remaining bytes long.
+Returns:     1 if it was successful and *length is set to the length of the text. 0 if the read failed or the block is broken.
+*/
+int gf_ReadCompressedBlock(FILE *file, char *compressedBlock, gf_u64 blockSize, char *destination, gf_u64 remaining, gf_u64 *length);
+
+/*
+Name:        int gf_CompressorWrite(gf_Compressor *compressor, const char *data, gf_u64 length);
+Description: Internal function that adds text to the compressor, compressing and writing out each block that fills up.
+Assumptions: - *compressor is not NULL and gf_SaverBeginCompressed() has been called with it.
+             - *data is not NULL and is atleast length bytes long.
+Returns:     1 if it was successful. 0 if not. The error is logged.
+*/
+int gf_CompressorWrite(gf_Compressor *compressor, const char *data, gf_u64 length);
+
+/*
+Name:        int gf_CompressorPrintf(gf_Compressor *compressor, const char *format, va_list args, va_list retry);
+Description: Internal function used by gf_SaverPrintf() that formats text straight into the block of the compressor. Text that
+             does not fit is formatted again with retry once the block has been written out.
+Assumptions: - *compressor is not NULL and gf_SaverBeginCompressed() has been called with it.
+             - *format is not NULL. args and retry are copies of the same arguments.
+Returns:     The number of bytes written like fprintf(). A negative value if it failed, which is logged.
+*/
+int gf_CompressorPrintf(gf_Compressor *compressor, const char *format, va_list args, va_list retry);
+
+/*
+Name:        int gf_FlushCompressor(gf_Compressor *compressor);
+Description: Internal function that compresses the text in the block of the compressor and writes it out. A block that does
+             not get smaller is written as it is.
+Assumptions: - *compressor is not NULL and gf_SaverBeginCompressed() has been called with it.
+Returns:     1 if it was successful. 0 if not. The error is logged.
+*/
+int gf_FlushCompressor(gf_Compressor *compressor);
+
+/*-----------------------------------------------------------------------------------*/
+
+/*-------------------------TESTING---------------------------------------------------*/
+
+#ifdef GF_IMPLEMENTATION_WITH_TESTS
+
+#define GF_TEST_ASSERT(arg, str) if (!(arg)) { printf("[%s]: test failed! Check logs for more.", str); return 0; }
+
+int gf_Test(void);
+
+#endif
+
+/*-----------------------------------------------------------------------------------*/
+
+// IMPLEMENTATION
+#if defined(GF_IMPLEMENTATION) || defined(GF_IMPLEMENTATION_WITH_TESTS)
+
+/*-------------------------STRING CONVERSIONS---------------------------------------*/
+
+int gf_AreStringSpansEqual(const char *a, gf_u64 alength, const char *b, gf_u64 blength) {
+	assert(a);
+	assert(b);
+
+	if (alength != blength) return 0;
+	gf_u64 i = 0;
+	while (i < alength) {
+		if (a[i] == '\0' && b[i] != '\0') return 0;
+		if (a[i] != '\0' && b[i] == '\0') return 0;
+		if (a[i] != b[i]) return 0;
+		i++;
+	}
+	return 1;
+}
+
+gf_u64 gf_StringLength(const char *str) {
+	assert(str);
+
+	gf_u64 len = 0;
+	while (str[len] != '\0') len++;
+	return len;
+}
+
+int gf_StringSpanToU32(const char *start, uint64_t length, gf_u32 *value) {
+	assert(start);
+
+	if (*start == '-') {
+		return 0;
+	}
+
+	gf_u32 i = strtoul(start, NULL, 10);
+	// 0 could mean a failure, or it could just mean the string is actually 0. 
+	if (i == 0) {
+		uint64_t index = 0;
+		while (!isdigit(start[index]) && index < length) {
+			index++;
+		}
+		if (start[index] != '0') {
+			return 0;
+		}
+	}
+	if (i == ULONG_MAX) {
+		return 0;
+	}
+	*value = i;
+	return 1;
+}
+
+int gf_StringSpanToU64(const char *start, uint64_t length, gf_u64 *value) {
+	assert(start);
+
+	if (*start == '-') {
+		return 0;
+	}
+
+	gf_u64 i = strtoull(start, NULL, 10);
+	// 0 could mean a failure, or it could just mean the string is actually 0. 
+	if (i == 0) {
+		uint64_t index = 0;
+		while (!isdigit(start[index]) && index < length) {
+			index++;
+		}
+		if (start[index] != '0') {
+			return 0;
+		}
+	}
+	if (i == ULLONG_MAX) {
+		return 0;
+	}
+	*value = i;
+	return 1;
+}
+
+int gf_StringSpanToS32(const char *start, uint64_t length, gf_s32 *value) {
+	assert(start);
+
+	gf_s32 i = strtol(start, NULL, 10);
+	// 0 could mean a failure
+	if (i == 0) {
+		uint64_t index = 0;
+		while (!isdigit(start[index]) && index < length) {
+			index++;
+		}
+		if (start[index] != '0') {
+			return 0;
+		}
+	}
+	if (i == LONG_MIN || i == LONG_MAX) {
+		return 0;
+	}
+	*value = i;
+	return 1;
+}
+
+int gf_StringSpanToS64(const char *start, uint64_t length, gf_s64 *value) {
+	assert(start);
+
+	gf_s64 i = strtoll(start, NULL, 10);
+	// 0 could mean a failure, or it could just mean the string is actually 0.
+	if (i == 0) {
+		uint64_t index = 0;
+		while (!isdigit(start[index]) && index < length) {
+			index++;
+		}
+		if (start[index] != '0') {
+			return 0;
+		}
+	}
+	if (i == LLONG_MIN || i == LLONG_MAX) {
+		return 0;
+	}
+	*value = i;
+	return 1;
+}
+
+int gf_StringSpanToF64(const char *start, uint64_t length, gf_f64 *value) {
+	assert(start);
+
+	double d = strtod(start, NULL);
+	// 0.0 could mean a failure, or it could just mean the string is actually 0.
+	if (d == 0.0) {
+		uint64_t index = 0;
+		while (!isdigit(start[index]) && index < length) {
+			index++;
+		}
+		if (start[index] != '0') {
+			return 0;
+		}
+	}
+	else if (d == HUGE_VAL || d == -HUGE_VAL) {
+		return 0;
+	}
+	*value = d;
+	return 1;
+}
+
+int gf_StringSpanToF32(const char *start, uint64_t length, gf_f32 *value) {
+	assert(start);
+
+	float f = strtof(start, NULL);
+	// 0.0 could mean a failure, or it could just mean the string is actually 0
+	if (f == 0.0) {
+		uint64_t index = 0;
+		while (!isdigit(start[index]) && index < length) {
+			index++;
+		}
+		if (start[index] != '0') {
+			return 0;
+		}
+	}
+	else if (f == HUGE_VALF || f == -HUGE_VALF) {
+		return 0;
+	}
+	*value = f;
+	return 1;
+}
+
+int gf_F64ToString(gf_f64 value, char *buffer, gf_u64 capacity) {
+	assert(buffer);
+
+	if (value != value || value == HUGE_VAL || value == -HUGE_VAL) {
+		return 0;
+	}
+
+	// Numbers below 1 need atleast as many decimals as they have leading zeros before any digit shows up. The exponent that
+	// printf() writes gives that without needing the maths library. If it is rounded up a digit the search below makes up for it.
+	int precision = 1;
+	if (value != 0.0 && value < 1.0 && value > -1.0) {
+		char exponent[32];
+		snprintf(exponent, sizeof(exponent), "%.0e", value);
+		const char *e = strchr(exponent, 'e');
+		if (e) {
+			precision = -(int)strtol(e + 1, NULL, 10);
+		}
+		if (precision < 1) {
+			precision = 1;
+		}
+	}
+
+	// A double never needs more than 17 significant digits, so this ends after a handful of tries.
+	for (; precision <= 345; precision++) {
+		int length = snprintf(buffer, (size_t)capacity, "%.*f", precision, value);
+		if (length < 0 || (gf_u64)length >= capacity) {
+			return 0;
+		}
+		if (strtod(buffer, NULL) == value) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+gf_u64 gf_DecodeEscapes(const char *text, gf_u64 length, char *decoded) {
+	assert(text);
+	assert(decoded);
+
+	const char *p = text;
+	const char *end = text + length;
+	char *out = decoded;
+
+	while (p < end) {
+		const char *backslash = gf_FindFirstOf(p, end, '\\', '\\', '\\');
+		memcpy(out, p, (size_t)(backslash - p));
+		out += backslash - p;
+		p = backslash;
+		if (p == end) {
+			break;
+		}
+
+		p++;
+		if (p == end) {
+			*out++ = '\\';
+			break;
+		}
+		switch (*p) {
+		case 'n':  *out++ = '\n'; break;
+		case 't':  *out++ = '\t'; break;
+		case 'r':  *out++ = '\r'; break;
+		case '\"': *out++ = '\"'; break;
+		case '\\': *out++ = '\\'; break;
+		default:
+			*out++ = '\\';
+			*out++ = *p;
+			break;
+		}
+		p++;
+	}
+
+	return (gf_u64)(out - decoded);
+}
+
+/*-----------------------------------------------------------------------------------*/
+
+/*-------------------------------------TOKENS----------------------------------------*/
+
+void gf_PrintToken(gf_Token *token) {
+	assert(token);
+
+	char text[GF_F64_STRING_CAPACITY];
+	gf_u64 length = 0;
+	if ((token->flags & GF_TOKEN_FLAG_BINARY) && gf_BinaryTokenToString(token, text, sizeof(text), &length)) {
+		printf("%s", text);
+		return;
+	}
+
+	for (gf_u64 i = 0; i < token->length; i++) {
+		printf("%c", token->start[i]);
+	}
+}
+
+void gf_PrintLineToken(gf_Token *token) {
+	assert(token);
+
+	gf_PrintToken(token);
+	printf("\n");
+}
+
+const char *gf_TokenTypeToString(gf_TokenType type) {
+	switch (type) {
+	case GF_TOKEN_TYPE_ROOT: return "GF_TOKEN_TYPE_ROOT";
+	case GF_TOKEN_TYPE_NAME: return "GF_TOKEN_TYPE_NAME";
+	case GF_TOKEN_TYPE_CURLY_CLOSE: return "GF_TOKEN_TYPE_CURLY_CLOSE";
+	case GF_TOKEN_TYPE_COMMENT: return "GF_TOKEN_TYPE_COMMENT";
+	case GF_TOKEN_TYPE_COMPOSITE_TYPE: return "GF_TOKEN_TYPE_COMPOSITE_TYPE";
+	case GF_TOKEN_TYPE_STRING: return "GF_TOKEN_TYPE_STRING";
+	case GF_TOKEN_TYPE_FLOAT: return "GF_TOKEN_TYPE_FLOAT";
+	case GF_TOKEN_TYPE_INTEGER: return "GF_TOKEN_TYPE_INTEGER";
+	case GF_TOKEN_TYPE_END_FILE: return "GF_TOKEN_TYPE_END_FILE";
+	case GF_TOKEN_TYPE_VALUE_ASSIGN: return "GF_TOKEN_TYPE_VALUE_ASSIGN";
+	default: return "<unknown token type>";
+	}
+}
+
+void gf_InitLineIndex(gf_LineIndex *lines, struct gf_Loader *loader, const char *buffer, gf_u64 count) {
+	assert(lines);
+
+	lines->buffer = buffer;
+	lines->count = count;
+	lines->loader = loader;
+	lines->lineStarts = NULL;
+	lines->lineCount = 0;
+	lines->built = 0;
+}
+
+int gf_LocateOffset(gf_LineIndex *lines, gf_u64 offset, gf_u64 *lineno, gf_u64 *colno) {
+	assert(lines);
+	assert(lineno);
+	assert(colno);
+
+	if (!lines->buffer) {
+		return 0;
+	}
+	if (offset > lines->count) {
+		offset = lines->count;
+	}
+
+	if (!lines->built && lines->loader) {
+		gf_u64 lineCount = gf_CountLineBreaks(lines->buffer, lines->count, NULL);
+		gf_u64 *lineStarts = NULL;
+		if (lineCount > 0) {
+			lineStarts = (gf_u64 *)gf_ArenaAllocate(lines->loader, lineCount * sizeof(gf_u64));
+		}
+		// Without the memory every position is counted from the start instead.
+		if (lineCount == 0 || lineStarts) {
+			gf_CountLineBreaks(lines->buffer, lines->count, lineStarts);
+			lines->lineStarts = lineStarts;
+			lines->lineCount = lineCount;
+			lines->built = 1;
+		}
+	}
+
+	gf_u64 lineStart = 0;
+	if (lines->built) {
+		// Finds how many lines start at or before the offset.
+		gf_u64 low = 0;
+		gf_u64 high = lines->lineCount;
+		while (low < high) {
+			gf_u64 middle = low + (high - low) / 2;
+			if (lines->lineStarts[middle] <= offset) {
+				low = middle + 1;
+			}
+			else {
+				high = middle;
+			}
+		}
+		*lineno = low + 1;
+		if (low > 0) {
+			lineStart = lines->lineStarts[low - 1];
+		}
+	}
+	else {
+		// A \r that is followed by a \n only ends the line at the \n.
+		lineStart = offset;
+		if (lineStart > 0 && lineStart < lines->count && lines->buffer[lineStart - 1] == '\r' && lines->buffer[lineStart] == '\n') {
+			lineStart--;
+		}
+		*lineno = gf_CountLineBreaks(lines->buffer, lineStart, NULL) + 1;
+		while (lineStart > 0 && lines->buffer[lineStart - 1] != '\n' && lines->buffer[lineStart - 1] != '\r') {
+			lineStart--;
+		}
+	}
+
+	*colno = offset - lineStart + 1;
+	return 1;
+}
+
+int gf_LocateToken(gf_LineIndex *lines, gf_Token *token) {
+	assert(lines);
+	assert(token);
+
+	if (!lines->buffer) {
+		return 0;
+	}
+
+	const char *start = token->start;
+	if (token->flags & GF_TOKEN_FLAG_DECODED) {
+		memcpy(&start, token->start - sizeof(const char *), sizeof(const char *));
+	}
+
+	gf_u64 offset;
+	if (token->type == GF_TOKEN_TYPE_END_FILE) {
+		// The end token does not point into the buffer. Tokenising stops at the first NULL terminator.
+		const char *terminator = (const char *)memchr(lines->buffer, '\0', (size_t)lines->count);
+		offset = terminator ? (gf_u64)(terminator - lines->buffer) : lines->count;
+	}
+	else if (start >= lines->buffer && start <= lines->buffer + lines->count) {
+		offset = (gf_u64)(start - lines->buffer);
+		// The start of a string token is after its opening quote.
+		if (token->type == GF_TOKEN_TYPE_STRING && offset > 0) {
+			offset--;
+		}
+	}
+	else {
+		return 0;
+	}
+
+	return gf_LocateOffset(lines, offset, &token->lineno, &token->colno);
+}
+
+/*-----------------------------------------------------------------------------------*/
+
+/*-------------------------------------LOGGING----------------------------------------*/
+
+void gf_DefaultLog(gf_LogLevel level, int lineno, gf_Token *token, const char *format, va_list vlist) {
+	switch (level) {
+	case GF_LOG_ERROR:   printf("[ERROR][%d]", lineno);   break;
+	case GF_LOG_WARNING: printf("[WARNING][%d]", lineno); break;
+	case GF_LOG_INFO:    printf("[INFO][%d]", lineno);    break;
+	}
+	if (token) {
+		printf("[\"");
+		gf_PrintToken(token);
+		printf("\"]");
+		printf("[lineno: %" PRIu64 "]", token->lineno);
+		printf("[colno: %" PRIu64 "]", token->colno);
+	}
+	printf(": ");
+	vprintf(format, vlist);
+	printf("\n");
+}
+
+void gf_NoLog(gf_LogLevel level, int lineno, gf_Token *token, const char *format, va_list vlist) {
+	(void)level;
+	(void)lineno;
+	(void)token;
+	(void)format;
+	(void)vlist;
+}
+
+void gf_Log(gf_LogFunctionPtr Log, gf_LogLevel level, int lineno, gf_Token *token, const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	Log(level, lineno, token, format, args);
+	va_end(args);
+};
+
+void gf_LogAtToken(gf_LogFunctionPtr Log, gf_LineIndex *lines, gf_LogLevel level, int lineno, gf_Token *token, const char *format, ...) {
+	assert(lines);
+
+	gf_Token located;
+	if (token && token->lineno == 0) {
+		located = *token;
+		gf_LocateToken(lines, &located);
+		token = &located;
+	}
+
+	va_list args;
+	va_start(args, format);
+	Log(level, lineno, token, format, args);
+	va_end(args);
+}
+
+/*-----------------------------------------------------------------------------------*/
+
+/*-------------------------------------SAVER----------------------------------------*/
+
+void gf_InitSaver(gf_Saver *saver, gf_LogFunctionPtr logfunction) {
+	gf_InitSaverWithFormat(saver, logfunction, GF_SAVER_FORMAT_PRETTY);
+}
+
+void gf_InitSaverWithFormat(gf_Saver *saver, gf_LogFunctionPtr logfunction, gf_SaverFormat format) {
+	assert(saver);
+
+	saver->indent = 0;
+	saver->needsSeparator = 0;
+	saver->target = GF_SAVER_TARGET_FILE;
+	saver->memory = NULL;
+	saver->memoryCapacity = 0;
+	saver->written = 0;
+	saver->compressor = NULL;
+	if (logfunction == NULL) {
+		saver->Log = gf_DefaultLog;
+	}
+	else {
+		saver->Log = logfunction;
+	}
+
+	saver->format = format;
+	if (format == GF_SAVER_FORMAT_PRETTY) {
+		saver->openBrace = " { ";
+		saver->closeBrace = " }";
+		saver->valueSeparator = ", ";
+	}
+	else {
+		saver->openBrace = "{";
+		saver->closeBrace = "}";
+		saver->valueSeparator = " ";
+	}
+}
+
+void gf_SaverBeginMeasure(gf_Saver *saver) {
+	assert(saver);
+
+	saver->target = GF_SAVER_TARGET_MEASURE;
+	saver->memory = NULL;
+	saver->memoryCapacity = 0;
+	saver->written = 0;
+}
+
+void gf_SaverBeginMemory(gf_Saver *saver, char *memory, gf_u64 capacity) {
+	assert(saver);
+	assert(memory);
+	assert(capacity > 0);
+
+	saver->target = GF_SAVER_TARGET_MEMORY;
+	saver->memory = memory;
+	saver->memoryCapacity = capacity;
+	saver->written = 0;
+	saver->memory[0] = '\0';
+}
+
+gf_u64 gf_SaverGetWrittenCount(gf_Saver *saver) {
+	assert(saver);
+	return saver->written;
+}
+
+int gf_SaverPrintf(gf_Saver *saver, FILE *file, const char *format, ...) {
+	assert(saver);
+	assert(format);
+
+	int result = 0;
+	va_list args;
+	va_start(args, format);
+
+	if (saver->target == GF_SAVER_TARGET_FILE) {
+		assert(file);
+		result = vfprintf(file, format, args);
+	}
+	else if (saver->target == GF_SAVER_TARGET_MEASURE) {
+		result = vsnprintf(NULL, 0, format, args);
+	}
+	else if (saver->target == GF_SAVER_TARGET_COMPRESSED) {
+		va_list retry;
+		va_copy(retry, args);
+		result = gf_CompressorPrintf(saver->compressor, format, args, retry);
+		va_end(retry);
+	}
+	else {
+		// The memory always has room for the NULL terminator, so there is always atleast one byte remaining.
+		gf_u64 remaining = saver->memoryCapacity - saver->written;
+		result = vsnprintf(saver->memory + saver->written, (size_t)remaining, format, args);
+		if (result >= 0 && (gf_u64)result >= remaining) {
+			saver->memory[saver->written] = '\0';
+			result = -1;
+			va_end(args);
+			GF_LOG(saver, GF_LOG_ERROR, "Out of memory. The memory given to gf_SaverBeginMemory has a capacity of [%" PRIu64 "] bytes", saver->memoryCapacity);
+			return result;
+		}
+	}
+
+	va_end(args);
+
+	if (result > 0) {
+		saver->written += (gf_u64)result;
+	}
+	return result;
+}
+
+int gf_SaverWrite(gf_Saver *saver, FILE *file, const char *data, gf_u64 length) {
+	assert(saver);
+	assert(data);
+
+	if (saver->target == GF_SAVER_TARGET_FILE) {
+		assert(file);
+		if (fwrite(data, 1, (size_t)length, file) != length) {
+			GF_LOG(saver, GF_LOG_ERROR, "fwrite failed to write [%" PRIu64 "] bytes in gf_SaverWrite", length);
+			return 0;
+		}
+	}
+	else if (saver->target == GF_SAVER_TARGET_COMPRESSED) {
+		if (!gf_CompressorWrite(saver->compressor, data, length)) {
+			return 0;
+		}
+	}
+	else if (saver->target == GF_SAVER_TARGET_MEMORY) {
+		if (length >= saver->memoryCapacity - saver->written) {
+			GF_LOG(saver, GF_LOG_ERROR, "Out of memory. The memory given to gf_SaverBeginMemory has a capacity of [%" PRIu64 "] bytes", saver->memoryCapacity);
+			return 0;
+		}
+		memcpy(saver->memory + saver->written, data, (size_t)length);
+		saver->memory[saver->written + length] = '\0';
+	}
+
+	saver->written += length;
+	return 1;
+}
+
+int gf_SaverWriteEscaped(gf_Saver *saver, FILE *file, const char *text, gf_u64 length) {
+	assert(saver);
+	assert(text);
+
+	const char *p = text;
+	const char *end = text + length;
+	while (p < end) {
+		const char *special = gf_FindFirstOf(p, end, '\"', '\\', '\\');
+		if (!gf_SaverWrite(saver, file, p, (gf_u64)(special - p))) {
+			return 0;
+		}
+		if (special == end) {
+			break;
+		}
+		char escaped[2];
+		escaped[0] = '\\';
+		escaped[1] = *special;
+		if (!gf_SaverWrite(saver, file, escaped, 2)) {
+			return 0;
+		}
+		p = special + 1;
+	}
+	return 1;
+}
+
+int gf_PrintIndent(gf_Saver *saver, FILE *file) {
+	assert(saver);
+	assert(file || saver->target != GF_SAVER_TARGET_FILE);
+
+	int result = 0;
+	if (saver->format == GF_SAVER_FORMAT_PRETTY) {
+		for (unsigned int i = 0; i < saver->indent; i++) {
+			result = gf_SaverPrintf(saver, file, "  ");
+			if (result < 0) {
+				GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_PrintIndent", result);
+				return 0;
+			}
+		}
+	}
+	else if (saver->needsSeparator) {
+		result = gf_SaverPrintf(saver, file, " ");
+		if (result < 0) {
+			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_PrintIndent", result);
+			return 0;
+		}
+		saver->needsSeparator = 0;
+	}
+	return 1;
+}
+
+int gf_PrintVariableEnd(gf_Saver *saver, FILE *file) {
+	assert(saver);
+	assert(file || saver->target != GF_SAVER_TARGET_FILE);
+
+	// The single line format only breaks the line once the top level list is closed.
+	if (saver->format == GF_SAVER_FORMAT_SINGLE_LINE && saver->indent > 0) {
+		saver->needsSeparator = 1;
+		return 1;
+	}
+
+	int result = gf_SaverPrintf(saver, file, "\n");
+	if (result < 0) {
+		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_PrintVariableEnd", result);
+		return 0;
+	}
+	return 1;
+}
+
+int gf_SaveVariableS64(gf_Saver *saver, FILE *file, const char *identifier, gf_s64 *value) {
+	assert(saver);
+	assert(file || saver->target != GF_SAVER_TARGET_FILE);
+	assert(identifier);
+	assert(value);
+
+	int result = 0;
+
+	result = gf_PrintIndent(saver, file);
+	if (!result) { return 0; }
+
+	result = gf_SaverPrintf(saver, file, "%s%s%" PRIi64 "%s", identifier, saver->openBrace, *value, saver->closeBrace);
+	if (result < 0) {
+		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableS64", result);
+		return 0;
+	}
+	return gf_PrintVariableEnd(saver, file);
+}
+
+int gf_SaveVariableS32(gf_Saver *saver, FILE *file, const char *identifier, gf_s32 *value) {
+	assert(saver);
+	assert(file || saver->target != GF_SAVER_TARGET_FILE);
+	assert(identifier);
+	assert(value);
+
+	int result = 0;
+
+	result = gf_PrintIndent(saver, file);
+	if (!result) { return 0; }
+
+	result = gf_SaverPrintf(saver, file, "%s%s%" PRIi32 "%s", identifier, saver->openBrace, *value, saver->closeBrace);
+	if (result < 0) {
+		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableS32", result);
+		return 0;
+	}
+	return gf_PrintVariableEnd(saver, file);
+}
+
+int gf_SaveVariableU32(gf_Saver *saver, FILE *file, const char *identifier, gf_u32 *value) {
+	assert(saver);
+	assert(file || saver->target != GF_SAVER_TARGET_FILE);
+	assert(identifier);
+	assert(value);
+
+	int result = 0;
+
+	result = gf_PrintIndent(saver, file);
+	if (!result) { return 0; }
+
+	result = gf_SaverPrintf(saver, file, "%s%s%" PRIu32 "%s", identifier, saver->openBrace, *value, saver->closeBrace);
+	if (result < 0) {
+		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableU32", result);
+		return 0;
+	}
+	return gf_PrintVariableEnd(saver, file);
+}
+
+
+int gf_SaveVariableU64(gf_Saver *saver, FILE *file, const char *identifier, gf_u64 *value) {
+	assert(saver);
+	assert(file || saver->target != GF_SAVER_TARGET_FILE);
+	assert(identifier);
+	assert(value);
+
+	int result = 0;
+
+	result = gf_PrintIndent(saver, file);
+	if (!result) { return 0; }
+
+	result = gf_SaverPrintf(saver, file, "%s%s%" PRIu64 "%s", identifier, saver->openBrace, *value, saver->closeBrace);
+	if (result < 0) {
+		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableU64", result);
+		return 0;
+	}
+	return gf_PrintVariableEnd(saver, file);
+}
+
+int gf_SaveVariableString(gf_Saver *saver, FILE *file, const char *identifier, const char *str) {
+	assert(saver);
+	assert(file || saver->target != GF_SAVER_TARGET_FILE);
+	assert(identifier);
+	assert(str);
+
+	int result = 0;
+
+	result = gf_PrintIndent(saver, file);
+	if (!result) { return 0; }
+
+	result = gf_SaverPrintf(saver, file, "%s%s\"", identifier, saver->openBrace);
+	if (result < 0) {
+		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableString", result);
+		return 0;
+	}
+	if (!gf_SaverWriteEscaped(saver, file, str, gf_StringLength(str))) {
+		return 0;
+	}
+	result = gf_SaverPrintf(saver, file, "\"%s", saver->closeBrace);
+	if (result < 0) {
+		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableString", result);
+		return 0;
+	}
+	return gf_PrintVariableEnd(saver, file);
+}
+
+int gf_SaveVariableF32(gf_Saver *saver, FILE *file, const char *identifier, gf_f32 *value) {
+	assert(saver);
+	assert(file || saver->target != GF_SAVER_TARGET_FILE);
+	assert(identifier);
+	assert(value);
+
+	int result = 0;
+
+	result = gf_PrintIndent(saver, file);
+	if (!result) { return 0; }
+
+	result = gf_SaverPrintf(saver, file, "%s%s%f%s", identifier, saver->openBrace, *value, saver->closeBrace);
+	if (result < 0) {
+		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableF32", result);
+		return 0;
+	}
+
+	return gf_PrintVariableEnd(saver, file);
+}
+
+int gf_SaveVariableF64(gf_Saver *saver, FILE *file, const char *identifier, gf_f64 *value) {
+	assert(saver);
+	assert(file || saver->target != GF_SAVER_TARGET_FILE);
+	assert(identifier);
+	assert(value);
+
+	int result = 0;
+
+	result = gf_PrintIndent(saver, file);
+	if (!result) { return 0; }
+
+	result = gf_SaverPrintf(saver, file, "%s%s%lf%s", identifier, saver->openBrace, *value, saver->closeBrace);
+	if (result < 0) {
+		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableF64", result);
+		return 0;
+	}
+
+	return gf_PrintVariableEnd(saver, file);
+}
+
+int gf_SaveVariableStringSpan(gf_Saver *saver, FILE *file, const char *identifier, const char *str, int strLen) {
+	assert(saver);
+	assert(file || saver->target != GF_SAVER_TARGET_FILE);
+	assert(identifier);
+	assert(str);
+
+	int result = 0;
+
+	result = gf_PrintIndent(saver, file);
+	if (!result) { return 0; }
+
+	result = gf_SaverPrintf(saver, file, "%s%s\"", identifier, saver->openBrace);
+	if (result < 0) {
+		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableStringSpan", result);
+		return 0;
+	}
+
+	int length = 0;
+	while (length < strLen && str[length] != '\0') length++;
+	if (!gf_SaverWriteEscaped(saver, file, str, (gf_u64)length)) {
+		return 0;
+	}
+	result = gf_SaverPrintf(saver, file, "\"%s", saver->closeBrace);
+	if (result < 0) {
+		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableStringSpan", result);
+		return 0;
+	}
+
+	return gf_PrintVariableEnd(saver, file);
+}
+
+int gf_SaveVariableVec3(gf_Saver *saver, FILE *file, const char *identifier, gf_f32 *x, gf_f32 *y, gf_f32 *z) {
+	assert(saver);
+	assert(file || saver->target != GF_SAVER_TARGET_FILE);
+	assert(identifier);
+	assert(x && y && z);
+
+	int result = 0;
+
+	result = gf_PrintIndent(saver, file);
+	if (!result) { return 0; }
+
+	result = gf_SaverPrintf(saver, file, "%s%s%f%s%f%s%f%s", identifier, saver->openBrace,
+		*x, saver->valueSeparator, *y, saver->valueSeparator, *z, saver->closeBrace);
+	if (result < 0) {
+		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableVec3", result);
+		return 0;
+	}
+
+	return gf_PrintVariableEnd(saver, file);
+}
+
+int gf_SaveArrayU64(gf_Saver *saver, FILE *file, const char *identifier, gf_u64 *value, int count) {
+	int result = 0;
+
+	if (count) {
+		result = gf_PrintIndent(saver, file);
+		if (!result) { return 0; }
+
+		result = gf_SaverPrintf(saver, file, "%s%s", identifier, saver->openBrace);
+		if (result < 0) {
+			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayU64", result);
+			return 0;
+		}
+		result = gf_SaverPrintf(saver, file, "%" PRIu64, value[0]);
+		if (result < 0) {
+			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayU64", result);
+			return 0;
+		}
+		for (int i = 1; i < count; i++) {
+			result = gf_SaverPrintf(saver, file, "%s%" PRIu64, saver->valueSeparator, value[i]);
+			if (result < 0) {
+				GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayU64", result);
+				return 0;
+			}
+		}
+		result = gf_SaverPrintf(saver, file, "%s", saver->closeBrace);
+		if (result < 0) {
+			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayU64", result);
+			return 0;
+		}
+		return gf_PrintVariableEnd(saver, file);
+	}
+
+	return 1;
+}
+
+int gf_SaveArrayS64(gf_Saver *saver, FILE *file, const char *identifier, gf_s64 *value, int count) {
+	int result = 0;
+
+	if (count) {
+		result = gf_PrintIndent(saver, file);
+		if (!result) { return 0; }
+
+		result = gf_SaverPrintf(saver, file, "%s%s", identifier, saver->openBrace);
+		if (result < 0) {
+			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayI64", result);
+			return 0;
+		}
+		result = gf_SaverPrintf(saver, file, "%" PRIi64, value[0]);
+		if (result < 0) {
+			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayI64", result);
+			return 0;
+		}
+		for (int i = 1; i < count; i++) {
+			result = gf_SaverPrintf(saver, file, "%s%" PRIi64, saver->valueSeparator, value[i]);
+			if (result < 0) {
+				GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayI64", result);
+				return 0;
+			}
+		}
+		result = gf_SaverPrintf(saver, file, "%s", saver->closeBrace);
+		if (result < 0) {
+			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayI64", result);
+			return 0;
+		}
+		return gf_PrintVariableEnd(saver, file);
+	}
+
+	return 1;
+}
+
+
+int gf_SaveArrayS32(gf_Saver *saver, FILE *file, const char *identifier, gf_s32 *value, int count) {
+	int result = 0;
+
+	if (count) {
+		result = gf_PrintIndent(saver, file);
+		if (!result) { return 0; }
+
+		result = gf_SaverPrintf(saver, file, "%s%s", identifier, saver->openBrace);
+		if (result < 0) {
+			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayS32", result);
+			return 0;
+		}
+		result = gf_SaverPrintf(saver, file, "%" PRIi32, value[0]);
+		if (result < 0) {
+			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayS32", result);
+			return 0;
+		}
+		for (int i = 1; i < count; i++) {
+			result = gf_SaverPrintf(saver, file, "%s%" PRIi32, saver->valueSeparator, value[i]);
+			if (result < 0) {
+				GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayS32", result);
+				return 0;
+			}
+		}
+		result = gf_SaverPrintf(saver, file, "%s", saver->closeBrace);
+		if (result < 0) {
+			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayS32", result);
+			return 0;
+		}
+		return gf_PrintVariableEnd(saver, file);
+	}
+
+	return 1;
+}
+
+int gf_SaveStartList(gf_Saver *saver, FILE *file, const char *identifier) {
+	return gf_SaveStartListSpan(saver, file, identifier, gf_StringLength(identifier));
+}
+
+int gf_SaveStartListSpan(gf_Saver *saver, FILE *file, const char *identifier, gf_u64 length) {
+	int result = 0;
+
+	result = gf_PrintIndent(saver, file);
+	if (!result) { return 0; }
+
+	if (!gf_SaverWrite(saver, file, identifier, length)) {
+		return 0;
+	}
+	if (saver->format == GF_SAVER_FORMAT_SINGLE_LINE) {
+		result = gf_SaverPrintf(saver, file, "{");
+	}
+	else if (saver->format == GF_SAVER_FORMAT_COMPACT) {
+		result = gf_SaverPrintf(saver, file, "{\n");
+	}
+	else {
+		result = gf_SaverPrintf(saver, file, " {\n");
+	}
+	if (result < 0) {
+		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveStartList", result);
+		return 0;
+	}
+	saver->indent++;
+
+	return 1;
+}
+
+int gf_SaveEndList(gf_Saver *saver, FILE *file) {
+	int result = 0;
+
+	if (saver->format == GF_SAVER_FORMAT_PRETTY && saver->indent) {
+		for (unsigned int i = 0; i < saver->indent - 1; i++) {
+			result = gf_SaverPrintf(saver, file, "  ");
+			if (result < 0) {
+				GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveEndList", result);
+				return 0;
+			}
+		}
+	}
+	result = gf_SaverPrintf(saver, file, "}");
+	if (result < 0) {
+		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveEndList", result);
+		return 0;
+	}
+	if (saver->indent) saver->indent--;
+	saver->needsSeparator = 0;
+
+	return gf_PrintVariableEnd(saver, file);
+}
+
+int gf_SaveToken(gf_Saver *saver, FILE *file, gf_Token *token) {
+	assert(saver);
+	assert(file || saver->target != GF_SAVER_TARGET_FILE);
+	assert(token);
+
+	int isString = token->type == GF_TOKEN_TYPE_STRING;
+
+	if (isString && !gf_SaverWrite(saver, file, "\"", 1)) {
+		return 0;
+	}
+	if (isString && !(token->flags & GF_TOKEN_FLAG_ESCAPED)) {
+		if (!gf_SaverWriteEscaped(saver, file, token->start, token->length)) {
+			return 0;
+		}
+	}
+	else if (token->flags & GF_TOKEN_FLAG_BINARY) {
+		// Numbers loaded from a .gfb file are written as text that loads back to the same value.
+		char text[GF_F64_STRING_CAPACITY];
+		gf_u64 length = 0;
+		if (!gf_BinaryTokenToString(token, text, sizeof(text), &length)) {
+			GF_LOG(saver, GF_LOG_ERROR, "A float that is infinite or not a number can not be saved as text");
+			return 0;
+		}
+		if (!gf_SaverWrite(saver, file, text, length)) {
+			return 0;
+		}
+	}
+	else if (!gf_SaverWrite(saver, file, token->start, token->length)) {
+		return 0;
+	}
+	if (isString && !gf_SaverWrite(saver, file, "\"", 1)) {
+		return 0;
+	}
+	return 1;
+}
+
+int gf_Reformat(gf_Saver *saver, FILE *file, const char *buffer, gf_u64 count) {
+	assert(saver);
+	assert(file || saver->target != GF_SAVER_TARGET_FILE);
+	assert(buffer);
+
+	gf_Tokeniser tokeniser;
+	gf_InitTokeniser(&tokeniser, buffer, count);
+	tokeniser.Log = saver->Log;
+
+	gf_Token token;
+	gf_Token next;
+	gf_u64 depth = 0;
+
+	if (!gf_NextToken(&tokeniser, &token)) {
+		return 0;
+	}
+
+	while (token.type != GF_TOKEN_TYPE_END_FILE) {
+
+		if (token.type == GF_TOKEN_TYPE_NAME) {
+
+			if (!gf_NextToken(&tokeniser, &next)) {
+				return 0;
+			}
+
+			if (next.type != GF_TOKEN_TYPE_VALUE_ASSIGN) {
+				// A name on its own without a list => a
+				if (!gf_PrintIndent(saver, file)) return 0;
+				if (!gf_SaveToken(saver, file, &token)) return 0;
+				if (!gf_PrintVariableEnd(saver, file)) return 0;
+				token = next;
+				continue;
+			}
+
+			// Look ahead to see if the list only holds values. If it does it is written on one line => a { 1, 2, 3 }
+			gf_Tokeniser lookahead = tokeniser;
+			gf_u64 valueCount = 0;
+			while (1) {
+				if (!gf_NextToken(&lookahead, &next)) {
+					return 0;
+				}
+				if (next.type != GF_TOKEN_TYPE_STRING && next.type != GF_TOKEN_TYPE_FLOAT && next.type != GF_TOKEN_TYPE_INTEGER) {
+					break;
+				}
+				valueCount++;
+			}
+
+			if (next.type == GF_TOKEN_TYPE_CURLY_CLOSE && valueCount > 0) {
+				if (!gf_PrintIndent(saver, file)) return 0;
+				if (!gf_SaveToken(saver, file, &token)) return 0;
+				if (!gf_SaverWrite(saver, file, saver->openBrace, gf_StringLength(saver->openBrace))) {
+					return 0;
+				}
+				for (gf_u64 i = 0; i < valueCount; i++) {
+					gf_NextToken(&tokeniser, &next);
+					if (i > 0 && !gf_SaverWrite(saver, file, saver->valueSeparator, gf_StringLength(saver->valueSeparator))) {
+						return 0;
+					}
+					if (!gf_SaveToken(saver, file, &next)) return 0;
+				}
+				if (!gf_SaverWrite(saver, file, saver->closeBrace, gf_StringLength(saver->closeBrace))) {
+					return 0;
+				}
+				if (!gf_PrintVariableEnd(saver, file)) return 0;
+
+				// Consume the closing brace we peeked at.
+				gf_NextToken(&tokeniser, &next);
+			}
+			else {
+				if (!gf_SaveStartListSpan(saver, file, token.start, token.length)) return 0;
+				depth++;
+			}
+		}
+		else if (token.type == GF_TOKEN_TYPE_STRING || token.type == GF_TOKEN_TYPE_FLOAT || token.type == GF_TOKEN_TYPE_INTEGER) {
+
+			// Values that are next to each other are written on the same line => 1, 2, 3
+			if (!gf_PrintIndent(saver, file)) return 0;
+			if (!gf_SaveToken(saver, file, &token)) return 0;
+			while (1) {
+				if (!gf_NextToken(&tokeniser, &next)) {
+					return 0;
+				}
+				if (next.type != GF_TOKEN_TYPE_STRING && next.type != GF_TOKEN_TYPE_FLOAT && next.type != GF_TOKEN_TYPE_INTEGER) {
+					break;
+				}
+				if (!gf_SaverWrite(saver, file, saver->valueSeparator, gf_StringLength(saver->valueSeparator))) {
+					return 0;
+				}
+				if (!gf_SaveToken(saver, file, &next)) return 0;
+			}
+			if (!gf_PrintVariableEnd(saver, file)) return 0;
+			token = next;
+			continue;
+		}
+		else if (token.type == GF_TOKEN_TYPE_CURLY_CLOSE) {
+			if (depth == 0) {
+				GF_LOG_WITH_TOKEN((&tokeniser), GF_LOG_ERROR, &token, "There is a closing brace } without a matching open brace {");
+				return 0;
+			}
+			if (!gf_SaveEndList(saver, file)) return 0;
+			depth--;
+		}
+		else {
+			GF_LOG_WITH_TOKEN((&tokeniser), GF_LOG_ERROR, &token, "unexpected value assign at token. It is likely because the token before it is not an identifier node.");
+			return 0;
+		}
+
+		if (!gf_NextToken(&tokeniser, &token)) {
+			return 0;
+		}
+	}
+
+	if (depth != 0) {
+		GF_LOG(saver, GF_LOG_ERROR, "There is a missing closing brace }. A brace has been opened { without a matching close.");
+		return 0;
+	}
+
+	return 1;
+}
+
+/*-----------------------------------------------------------------------------------*/
+
+/*-------------------------------------LOADER----------------------------------------*/
+
+void gf_InitLoader(gf_Loader *loader, gf_LogAllocateFreeFunctions *helperfunctions) {
+	assert(loader);
+
+	if (!helperfunctions || helperfunctions->Log == NULL) {
+		loader->Log = gf_DefaultLog;
+	}
+	else {
+		loader->Log = helperfunctions->Log;
+	}
+	if (!helperfunctions || helperfunctions->Allocate == NULL) {
+		loader->Allocate = malloc;
+	}
+	else {
+		loader->Allocate = helperfunctions->Allocate;
+	}
+	if (!helperfunctions || helperfunctions->Free == NULL) {
+		loader->Free = free;
+	}
+	else {
+		loader->Free = helperfunctions->Free;
+	}
+
+	loader->context = NULL;
+	loader->AllocateWithContext = NULL;
+	loader->FreeWithContext = NULL;
+	loader->ReallocateWithContext = NULL;
+	if (helperfunctions && helperfunctions->AllocateWithContext) {
+		loader->context = helperfunctions->context;
+		loader->AllocateWithContext = helperfunctions->AllocateWithContext;
+		loader->FreeWithContext = helperfunctions->FreeWithContext;
+		loader->ReallocateWithContext = helperfunctions->ReallocateWithContext;
+	}
+
+	loader->curToken = NULL;
+	loader->rootNode = NULL;
+	loader->lastNode = NULL;
+	loader->firstToken = NULL;
+
+	// Set up the root token
+	loader->rootToken.start = "root";
+	loader->rootToken.length = 4;
+	loader->rootToken.lineno = 0;
+	loader->rootToken.colno = 0;
+	loader->rootToken.next = NULL;
+	loader->rootToken.type = GF_TOKEN_TYPE_ROOT;
+	loader->rootToken.flags = GF_TOKEN_FLAG_NONE;
+
+	loader->lastToken = &loader->rootToken;
+	gf_InitLineIndex(&loader->lines, loader, NULL, 0);
+
+	loader->fileContentsBuffer = NULL;
+	loader->fileContentsCapacity = 0;
+	loader->nestLevel = 0;
+	loader->mapping = NULL;
+	loader->mappingSize = 0;
+	loader->readOnly = 0;
+
+	loader->arena.first = NULL;
+	loader->arena.current = NULL;
+	loader->flags = helperfunctions ? helperfunctions->loaderFlags : (gf_u32)GF_LOADER_FLAG_NONE;
+	loader->maxDepth = helperfunctions && helperfunctions->maxDepth ? helperfunctions->maxDepth : GF_DEFAULT_MAX_DEPTH;
+}
+
+void *gf_Allocate(gf_Loader *loader, gf_u64 size) {
+	assert(loader);
+
+	if (loader->AllocateWithContext) {
+		return loader->AllocateWithContext(loader->context, (size_t)size);
+	}
+	return loader->Allocate((size_t)size);
+}
+
+void gf_Free(gf_Loader *loader, void *pointer) {
+	assert(loader);
+
+	if (loader->AllocateWithContext) {
+		if (loader->FreeWithContext) {
+			loader->FreeWithContext(loader->context, pointer);
+		}
+		return;
+	}
+	loader->Free(pointer);
+}
+
+void *gf_Reallocate(gf_Loader *loader, void *pointer, gf_u64 oldSize, gf_u64 newSize) {
+	assert(loader);
+
+	if (loader->AllocateWithContext && loader->ReallocateWithContext) {
+		return loader->ReallocateWithContext(loader->context, pointer, (size_t)oldSize, (size_t)newSize);
+	}
+
+	void *memory = gf_Allocate(loader, newSize);
+	if (!memory) {
+		return NULL;
+	}
+	if (pointer) {
+		memcpy(memory, pointer, (size_t)(oldSize < newSize ? oldSize : newSize));
+		gf_Free(loader, pointer);
+	}
+	return memory;
+}
+
+void gf_IncrementLastTokenLength(gf_Loader *loader) {
+	assert(loader);
+	assert(loader->lastToken);
+	loader->lastToken->length++;
+}
+
+int gf_AddToken(gf_Loader *loader, const char *start, gf_TokenType type) {
+	assert(loader->lastToken);
+
+	if (!start) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, loader->lastToken, "Expecting a token but at the end of the file/buffer");
+		return 0;
+	}
+
+	gf_Token *token = (gf_Token *)gf_ArenaAllocate(loader, sizeof(gf_Token));
+	if (!token) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, loader->lastToken, "Out of memory in gf_AddToken");
+		return 0;
+	}
+
+	if (!loader->firstToken) {
+		loader->firstToken = token;
+	}
+
+	loader->lastToken->next = token;
+	loader->lastToken = token;
+
+	token->start = start;
+	token->type = type;
+	token->flags = GF_TOKEN_FLAG_NONE;
+	token->length = 1;
+	token->lineno = 0;
+	token->colno = 0;
+	token->next = NULL;
+
+	return 1;
+}
+
+char *gf_AllocateNullTerminatedBufferFromFile(gf_Loader *loader, const char *filename, gf_u64 *bufferCountWithNullTerminator) {
+	assert(loader);
+	assert(filename);
+	assert(bufferCountWithNullTerminator);
+
+	gf_u64 fileSize = 0;
+	uint64_t readBytes = 0;
+	FILE *file = NULL;
+
+	file = fopen(filename, "rb");
+	if (file == NULL) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to load file [%s]. It could not be opened", filename);
+		return NULL;
+	}
+	if (!gf_GetOpenFileSize(file, &fileSize) || fileSize > (gf_u64)SIZE_MAX - 1) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to load file [%s]. Its size could not be found, or it is too big for this build", filename);
+		fclose(file);
+		return NULL;
+	}
+
+	char *buffer = (char *)gf_Allocate(loader, fileSize + 1);
+	if (buffer == NULL) {
+		GF_LOG(loader, GF_LOG_ERROR, "Out of memory. Failed to allocate buffer for file [%s]", filename);
+		fclose(file);
+		return NULL;
+	}
+
+	readBytes = fread(buffer, fileSize, sizeof(char), file);
+	if (readBytes != 1) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to read file [%s]", filename);
+		fclose(file);
+		return NULL;
+	}
+
+	fclose(file);
+
+	buffer[fileSize] = '\0';
+
+	*bufferCountWithNullTerminator = fileSize + 1;
+
+	return buffer;
+}
+
+int gf_ReadFileIntoLoader(gf_Loader *loader, const char *filename, gf_u64 *bufferCountWithNullTerminator) {
+	assert(loader);
+	assert(filename);
+	assert(bufferCountWithNullTerminator);
+
+	FILE *file = fopen(filename, "rb");
+	if (file == NULL) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to load file [%s]. It could not be opened", filename);
+		return 0;
+	}
+	gf_u64 fileSize = 0;
+	if (!gf_GetOpenFileSize(file, &fileSize) || fileSize > (gf_u64)SIZE_MAX - 1) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to load file [%s]. Its size could not be found, or it is too big for this build", filename);
+		fclose(file);
+		return 0;
+	}
+
+	if (fileSize + 1 > loader->fileContentsCapacity) {
+		gf_Free(loader, loader->fileContentsBuffer);
+		loader->fileContentsCapacity = 0;
+		loader->fileContentsBuffer = (char *)gf_Allocate(loader, fileSize + 1);
+		if (loader->fileContentsBuffer == NULL) {
+			GF_LOG(loader, GF_LOG_ERROR, "Out of memory. Failed to allocate buffer for file [%s]", filename);
+			fclose(file);
+			return 0;
+		}
+		loader->fileContentsCapacity = fileSize + 1;
+	}
+
+	if (fileSize > 0 && fread(loader->fileContentsBuffer, fileSize, sizeof(char), file) != 1) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to read file [%s]", filename);
+		fclose(file);
+		return 0;
+	}
+
+	fclose(file);
+
+	loader->fileContentsBuffer[fileSize] = '\0';
+	*bufferCountWithNullTerminator = fileSize + 1;
+
+	return 1;
+}
+
+int gf_SeekFile(FILE *file, gf_s64 offset, int origin) {
+	assert(file);
+
+#if defined(GF_FSEEKI64)
+	return _fseeki64(file, (__int64)offset, origin) == 0;
+#elif defined(GF_FSEEKO)
+	if ((gf_s64)(off_t)offset != offset) {
+		return 0;
+	}
+	return fseeko(file, (off_t)offset, origin) == 0;
+#else
+	if ((gf_s64)(long)offset != offset) {
+		return 0;
+	}
+	return fseek(file, (long)offset, origin) == 0;
+#endif
+}
+
+int gf_TellFile(FILE *file, gf_u64 *offset) {
+	assert(file);
+	assert(offset);
+
+#if defined(GF_FSEEKI64)
+	gf_s64 position = (gf_s64)_ftelli64(file);
+#elif defined(GF_FSEEKO)
+	gf_s64 position = (gf_s64)ftello(file);
+#else
+	gf_s64 position = (gf_s64)ftell(file);
+#endif
+	if (position < 0) {
+		return 0;
+	}
+	*offset = (gf_u64)position;
+	return 1;
+}
+
+int gf_GetOpenFileSize(FILE *file, gf_u64 *size) {
+	assert(file);
+	assert(size);
+
+	return gf_SeekFile(file, 0, SEEK_END) && gf_TellFile(file, size) && gf_SeekFile(file, 0, SEEK_SET);
+}
+
+void gf_InitTokeniser(gf_Tokeniser *tokeniser, const char *buffer, gf_u64 count) {
+	assert(tokeniser);
+	assert(buffer);
+
+	tokeniser->Log = gf_DefaultLog;
+	tokeniser->buffer = buffer;
+	tokeniser->count = count;
+	tokeniser->index = 0;
+	gf_InitLineIndex(&tokeniser->lines, NULL, buffer, count);
+	tokeniser->validateUtf8 = 0;
+	tokeniser->error = NULL;
+}
+
+char gf_GetChar(gf_Tokeniser *tokeniser) {
+	if (tokeniser->index >= tokeniser->count) {
+		return '\0';
+	}
+	return tokeniser->buffer[tokeniser->index];
+}
+
+void gf_IncrementIndex(gf_Tokeniser *tokeniser) {
+	if (tokeniser->index < tokeniser->count) {
+		tokeniser->index++;
+	}
+}
+
+const char *gf_Ptr(gf_Tokeniser *tokeniser) {
+	if (tokeniser->index < tokeniser->count) {
+		return &tokeniser->buffer[tokeniser->index];
+	}
+	return NULL;
+}
+
+const unsigned char gf_CharClasses[256] = {
+	 1,  0,  0,  0,  0,  0,  0,  0,  0,  2,  3,  0,  0,  4,  0,  0, // 0x00 - 0x0F
+	 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, // 0x10 - 0x1F
+	 2,  0,  8,  0,  0,  0,  0,  0,  0,  0,  0,  9,  2,  9, 10,  7, // 0x20 - 0x2F
+	11, 11, 11, 11, 11, 11, 11, 11, 11, 11,  0,  0,  0,  0,  0,  0, // 0x30 - 0x3F
+	 0, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, // 0x40 - 0x4F
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,  0,  0,  0,  0, 13, // 0x50 - 0x5F
+	 0, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, // 0x60 - 0x6F
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,  5,  0,  6,  0,  0, // 0x70 - 0x7F
+	 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, // 0x80 - 0x8F
+	 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, // 0x90 - 0x9F
+	 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, // 0xA0 - 0xAF
+	 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, // 0xB0 - 0xBF
+	 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, // 0xC0 - 0xCF
+	 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, // 0xD0 - 0xDF
+	 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, // 0xE0 - 0xEF
+	 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, // 0xF0 - 0xFF
+};
+
+int gf_NextToken(gf_Tokeniser *tokeniser, gf_Token *token) {
+	assert(tokeniser);
+	assert(token);
+
+	// The scan works on raw pointers and only writes the position back to the tokeniser once the token is found.
+	// Lines and columns are not tracked here, see gf_LocateToken().
+	const char *buffer = tokeniser->buffer;
+	const char *end = buffer + tokeniser->count;
+	const char *p = buffer + tokeniser->index;
+	int result = 1;
+	int scanning = 1;
+
+	token->next = NULL;
+	token->flags = GF_TOKEN_FLAG_NONE;
+
+	while (scanning) {
+
+		unsigned char charClass = p < end ? gf_CharClasses[(unsigned char)*p] : (unsigned char)GF_CHAR_CLASS_END;
+
+		token->start = p;
+		token->length = 1;
+		token->lineno = 0;
+		token->colno = 0;
+
+		switch (charClass) {
+
+		case GF_CHAR_CLASS_END:
+			token->start = "<end token>";
+			token->length = 11;
+			token->type = GF_TOKEN_TYPE_END_FILE;
+			scanning = 0;
+			break;
+
+		case GF_CHAR_CLASS_SPACE:
+		case GF_CHAR_CLASS_NEWLINE:
+		case GF_CHAR_CLASS_RETURN:
+			p++;
+			while (p < end && gf_CharClasses[(unsigned char)*p] >= GF_CHAR_CLASS_SPACE && gf_CharClasses[(unsigned char)*p] <= GF_CHAR_CLASS_RETURN) {
+				p++;
+			}
+			break;
+
+		case GF_CHAR_CLASS_OPEN_BRACE:
+			token->type = GF_TOKEN_TYPE_VALUE_ASSIGN;
+			p++;
+			scanning = 0;
+			break;
+
+		case GF_CHAR_CLASS_CLOSE_BRACE:
+			token->type = GF_TOKEN_TYPE_CURLY_CLOSE;
+			p++;
+			scanning = 0;
+			break;
+
+		case GF_CHAR_CLASS_SLASH:
+			token->type = GF_TOKEN_TYPE_COMMENT;
+			p++;
+			if (p < end && *p == '*') {
+
+				int nestedCommentDepth = 1;
+				p++;
+
+				while (nestedCommentDepth > 0) {
+
+					// Only a / or a * can change the depth, everything between them is skipped at once.
+					p = gf_FindFirstOf(p, end, '/', '*', '\0');
+
+					if (p >= end || *p == '\0') {
+						tokeniser->error = "Comment does not end before the file ends";
+						GF_LOG_WITH_TOKEN(tokeniser, GF_LOG_ERROR, token, "%s", tokeniser->error);
+						result = 0;
+						scanning = 0;
+						break;
+					}
+					else if (*p == '/') {
+						p++;
+						if (p < end && *p == '*') {
+							nestedCommentDepth++;
+						}
+					}
+					else {
+						p++;
+						if (p < end && *p == '/') {
+							nestedCommentDepth--;
+						}
+					}
+				}
+			}
+			break;
+
+		case GF_CHAR_CLASS_QUOTE: {
+
+			token->type = GF_TOKEN_TYPE_STRING;
+			p++;
+
+			// The token spans the contents of the string, not the quotes.
+			token->start = p;
+			while (1) {
+				p = gf_FindFirstOf(p, end, '\"', '\\', '\0');
+
+				if (p >= end || *p == '\0') {
+					tokeniser->error = "String does not end before the file ends";
+					GF_LOG(tokeniser, GF_LOG_ERROR, "%s", tokeniser->error);
+					result = 0;
+					break;
+				}
+				else if (*p == '\"') {
+					break;
+				}
+
+				// A backslash escapes the character after it, including another backslash.
+				token->flags |= GF_TOKEN_FLAG_ESCAPED;
+				p++;
+				if (p < end && *p != '\0') {
+					p++;
+				}
+			}
+
+			token->length = (gf_u64)(p - token->start);
+
+			if (result && tokeniser->validateUtf8) {
+				const char *invalid = gf_FindInvalidUtf8(token->start, p);
+				if (invalid != p) {
+					gf_u64 lineno = 0;
+					gf_u64 colno = 0;
+					gf_LocateOffset(&tokeniser->lines, (gf_u64)(invalid - buffer), &lineno, &colno);
+					tokeniser->error = "String holds text that is not valid UTF-8";
+					GF_LOG_WITH_TOKEN(tokeniser, GF_LOG_ERROR, token, "%s. The byte 0x%02X at line %" PRIu64 " column %" PRIu64 " is invalid",
+						tokeniser->error, (unsigned int)(unsigned char)*invalid, lineno, colno);
+					// The tokeniser is left at the invalid byte.
+					p = invalid;
+					result = 0;
+				}
+			}
+
+			if (result) {
+				p++;
+			}
+			scanning = 0;
+			break;
+		}
+
+		case GF_CHAR_CLASS_ALPHA:
+			token->type = GF_TOKEN_TYPE_NAME;
+			p++;
+			while (p < end && gf_CharClasses[(unsigned char)*p] >= GF_CHAR_CLASS_DIGIT) {
+				p++;
+			}
+			token->length = (gf_u64)(p - token->start);
+			scanning = 0;
+			break;
+
+		case GF_CHAR_CLASS_DIGIT:
+		case GF_CHAR_CLASS_SIGN: {
+
+			int hasFloatingPoint = 0;
+			int hasPlusOrMinus = charClass == GF_CHAR_CLASS_SIGN;
+			p++;
+
+			while (p < end) {
+				unsigned char nextClass = gf_CharClasses[(unsigned char)*p];
+				if (nextClass == GF_CHAR_CLASS_DIGIT) {
+					p++;
+				}
+				else if (nextClass == GF_CHAR_CLASS_DOT) {
+					hasFloatingPoint = 1;
+					p++;
+					while (p < end && gf_CharClasses[(unsigned char)*p] == GF_CHAR_CLASS_DIGIT) {
+						p++;
+					}
+					break;
+				}
+				else {
+					break;
+				}
+			}
+
+			token->type = hasFloatingPoint ? GF_TOKEN_TYPE_FLOAT : GF_TOKEN_TYPE_INTEGER;
+			token->length = (gf_u64)(p - token->start);
+
+			// Prevents just having a + or - as a valid number
+			if (hasPlusOrMinus && token->length == 1) {
+				tokeniser->error = "There is a + or - without a number after it.";
+				GF_LOG_WITH_TOKEN(tokeniser, GF_LOG_ERROR, token, "%s", tokeniser->error);
+				result = 0;
+			}
+			scanning = 0;
+			break;
+		}
+
+		default:
+			token->type = GF_TOKEN_TYPE_NAME;
+			tokeniser->error = "Unrecognised character";
+			GF_LOG_WITH_TOKEN(tokeniser, GF_LOG_ERROR, token, "Unrecognised character %c", *p);
+			result = 0;
+			scanning = 0;
+			break;
+		}
+	}
+
+	tokeniser->index = (gf_u64)(p - buffer);
+	return result;
+}
+
+gf_u32 gf_CountBits(gf_u32 bits) {
+#if defined(__GNUC__)
+	return (gf_u32)__builtin_popcount(bits);
+#else
+	gf_u32 count = 0;
+	while (bits) {
+		bits &= bits - 1;
+		count++;
+	}
+	return count;
+#endif
+}
+
+gf_u32 gf_LowestBit(gf_u32 bits) {
+	assert(bits);
+#if defined(__GNUC__)
+	return (gf_u32)__builtin_ctz(bits);
+#else
+	gf_u32 index = 0;
+	while (!(bits & 1)) {
+		bits >>= 1;
+		index++;
+	}
+	return index;
+#endif
+}
+
+gf_u64 gf_CountLineBreaks(const char *buffer, gf_u64 count, gf_u64 *lineStarts) {
+	assert(buffer);
+
+	gf_u64 breaks = 0;
+	gf_u64 i = 0;
+
+#ifdef GF_SSE2
+	const __m128i newline = _mm_set1_epi8('\n');
+	const __m128i carriageReturn = _mm_set1_epi8('\r');
+
+	// Stops a byte early so the byte after each block can be read.
+	for (; i + 16 < count; i += 16) {
+		__m128i block = _mm_loadu_si128((const __m128i *)(buffer + i));
+		gf_u32 newlines = (gf_u32)_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+		gf_u32 returns = (gf_u32)_mm_movemask_epi8(_mm_cmpeq_epi8(block, carriageReturn));
+
+		// A \r followed by a \n is counted at the \n.
+		gf_u32 beforeNewline = (newlines >> 1) | ((gf_u32)(buffer[i + 16] == '\n') << 15);
+		gf_u32 lineBreaks = newlines | (returns & ~beforeNewline);
+
+		if (lineStarts) {
+			while (lineBreaks) {
+				lineStarts[breaks++] = i + gf_LowestBit(lineBreaks) + 1;
+				lineBreaks &= lineBreaks - 1;
+			}
+		}
+		else {
+			breaks += gf_CountBits(lineBreaks);
+		}
+	}
+#endif
+
+	for (; i < count; i++) {
+		if (buffer[i] == '\n' || (buffer[i] == '\r' && (i + 1 >= count || buffer[i + 1] != '\n'))) {
+			if (lineStarts) {
+				lineStarts[breaks] = i + 1;
+			}
+			breaks++;
+		}
+	}
+
+	return breaks;
+}
+
+const char *gf_FindFirstOf(const char *start, const char *end, char a, char b, char c) {
+	assert(start);
+	assert(end);
+	assert(start <= end);
+
+	const char *p = start;
+
+#ifdef GF_SSE2
+	const __m128i first = _mm_set1_epi8(a);
+	const __m128i second = _mm_set1_epi8(b);
+	const __m128i third = _mm_set1_epi8(c);
+
+	while (end - p >= 16) {
+		__m128i block = _mm_loadu_si128((const __m128i *)p);
+		__m128i matches = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, first), _mm_cmpeq_epi8(block, second)), _mm_cmpeq_epi8(block, third));
+		gf_u32 mask = (gf_u32)_mm_movemask_epi8(matches);
+		if (mask) {
+			return p + gf_LowestBit(mask);
+		}
+		p += 16;
+	}
+#endif
+
+	while (p < end && *p != a && *p != b && *p != c) {
+		p++;
+	}
+	return p;
+}
+
+const char *gf_FindInvalidUtf8(const char *start, const char *end) {
+	assert(start);
+	assert(end);
+	assert(start <= end);
+
+	const unsigned char *p = (const unsigned char *)start;
+	const unsigned char *last = (const unsigned char *)end;
+
+	while (p < last) {
+
+#ifdef GF_SSE2
+		if (last - p >= 16) {
+			gf_u32 highBits = (gf_u32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)p));
+			if (!highBits) {
+				p += 16;
+				continue;
+			}
+			p += gf_LowestBit(highBits);
+		}
+#endif
+
+		if (*p < 0x80) {
+			p++;
+			continue;
+		}
+
+		// The number of continuation bytes and the range the first of them must be in.
+		gf_u64 continuations = 0;
+		unsigned char low = 0x80;
+		unsigned char high = 0xBF;
+		if (*p >= 0xC2 && *p <= 0xDF) {
+			continuations = 1;
+		}
+		else if (*p == 0xE0) {
+			continuations = 2;
+			low = 0xA0; // Overlong.
+		}
+		else if (*p == 0xED) {
+			continuations = 2;
+			high = 0x9F; // Surrogates.
+		}
+		else if (*p >= 0xE1 && *p <= 0xEF) {
+			continuations = 2;
+		}
+		else if (*p == 0xF0) {
+			continuations = 3;
+			low = 0x90; // Overlong.
+		}
+		else if (*p >= 0xF1 && *p <= 0xF3) {
+			continuations = 3;
+		}
+		else if (*p == 0xF4) {
+			continuations = 3;
+			high = 0x8F; // Above U+10FFFF.
+		}
+		else {
+			return (const char *)p;
+		}
+
+		if ((gf_u64)(last - p) <= continuations || p[1] < low || p[1] > high) {
+			return (const char *)p;
+		}
+		for (gf_u64 i = 2; i <= continuations; i++) {
+			if ((p[i] & 0xC0) != 0x80) {
+				return (const char *)p;
+			}
+		}
+		p += continuations + 1;
+	}
+
+	return end;
+}
+
+void gf_CountTokenBounds(const char *buffer, gf_u64 count, gf_u64 *tokenCount, gf_u64 *nodeCount) {
+	assert(buffer);
+	assert(tokenCount);
+	assert(nodeCount);
+
+	gf_u64 values = 0;     // Names, numbers and strings. Each one is a token and a node.
+	gf_u64 structural = 0; // Braces. Each one is a token.
+
+	// A letter starts a name unless it follows a letter or underscore. A digit starts a number unless it follows
+	// anything a name or number can be made of. Signs always start a number.
+	gf_u32 afterNameChar = 0;
+	gf_u32 afterNumberChar = 0;
+	gf_u64 index = 0;
+
+#ifdef GF_SSE2
+	const __m128i lowerCase = _mm_set1_epi8(0x20);
+	for (; index + 16 <= count; index += 16) {
+		__m128i chunk = _mm_loadu_si128((const __m128i *)(buffer + index));
+		__m128i lower = _mm_or_si128(chunk, lowerCase);
+
+		gf_u32 alpha = (gf_u32)_mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1))));
+		gf_u32 digit = (gf_u32)_mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(chunk, _mm_set1_epi8('9' + 1))));
+		gf_u32 underscore = (gf_u32)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('_')));
+		gf_u32 dot = (gf_u32)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('.')));
+		gf_u32 sign = (gf_u32)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('+')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('-'))));
+		gf_u32 quote = (gf_u32)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\"')));
+		gf_u32 brace = (gf_u32)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('{')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('}'))));
+
+		gf_u32 nameChars = alpha | underscore;
+		gf_u32 numberChars = nameChars | digit | dot | sign;
+		gf_u32 nameStarts = alpha & ~((nameChars << 1) | afterNameChar);
+		gf_u32 numberStarts = digit & ~((numberChars << 1) | afterNumberChar);
+
+		values += gf_CountBits(nameStarts & 0xFFFF) + gf_CountBits(numberStarts & 0xFFFF) + gf_CountBits(sign) + gf_CountBits(quote);
+		structural += gf_CountBits(brace);
+
+		afterNameChar = (nameChars >> 15) & 1;
+		afterNumberChar = (numberChars >> 15) & 1;
+	}
+#endif
+
+	for (; index < count; index++) {
+		char c = buffer[index];
+		gf_u32 isAlpha = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+		gf_u32 isDigit = c >= '0' && c <= '9';
+		gf_u32 isSign = c == '+' || c == '-';
+
+		values += (isAlpha && !afterNameChar) + (isDigit && !afterNumberChar) + isSign + (c == '\"');
+		structural += c == '{' || c == '}';
+
+		afterNameChar = isAlpha || c == '_';
+		afterNumberChar = afterNameChar || isDigit || isSign || c == '.';
+	}
+
+	*tokenCount = values + structural + 1;
+	*nodeCount = values + 1;
+}
+
+int gf_TokeniseInternal(gf_Loader *loader, gf_Tokeniser *tokeniser) {
+	assert(loader);
+	assert(tokeniser);
+
+	gf_Token token;
+	tokeniser->Log = loader->Log;
+
+	while (1) {
+
+		if (!gf_NextToken(tokeniser, &token)) {
+			return 0;
+		}
+
+		if (!gf_AddScannedToken(loader, &token)) {
+			return 0;
+		}
+
+		if (token.type == GF_TOKEN_TYPE_END_FILE) {
+			break;
+		}
+	}
+
+	return 1;
+}
+
+int gf_AddScannedToken(gf_Loader *loader, gf_Token *token) {
+	assert(loader);
+	assert(token);
+
+	if (!gf_AddToken(loader, token->start, token->type)) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, token, "Failed to add %s token", gf_TokenTypeToString(token->type));
+		return 0;
+	}
+	loader->lastToken->length = token->length;
+	loader->lastToken->lineno = token->lineno;
+	loader->lastToken->colno = token->colno;
+
+	// Only strings that hold escapes are copied, every other token points into the buffer.
+	if (token->flags & GF_TOKEN_FLAG_ESCAPED) {
+		char *decoded = (char *)gf_ArenaAllocate(loader, sizeof(const char *) + token->length + 1);
+		if (!decoded) {
+			GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, token, "Out of memory while decoding a string");
+			return 0;
+		}
+		memcpy(decoded, &token->start, sizeof(const char *));
+		decoded += sizeof(const char *);
+		loader->lastToken->length = gf_DecodeEscapes(token->start, token->length, decoded);
+		decoded[loader->lastToken->length] = '\0';
+		loader->lastToken->start = decoded;
+		loader->lastToken->flags |= GF_TOKEN_FLAG_DECODED;
+	}
+
+	return 1;
+}
+
+int gf_Tokenise(gf_Loader *loader, const char *buffer, gf_u64 count) {
+	assert(loader);
+	assert(buffer);
+
+	gf_Tokeniser tokeniser;
+	gf_InitTokeniser(&tokeniser, buffer, count);
+	tokeniser.validateUtf8 = (loader->flags & GF_LOADER_FLAG_VALIDATE_UTF8) != 0;
+
+	return gf_TokeniseInternal(loader, &tokeniser);
+}
+
+gf_Token *gf_ConsumeToken(gf_Loader *loader) {
+	gf_Token *token = loader->curToken;
+	if (!token) {
+		return NULL;
+	}
+	loader->curToken = loader->curToken->next;
+	return token;
+}
+
+gf_Token *gf_PeekToken(gf_Loader *loader) {
+	return loader->curToken;
+}
+
+gf_LoaderNode *gf_AddNode(gf_Loader *loader, gf_Token *token) {
+	gf_LoaderNode *node = (gf_LoaderNode *)gf_ArenaAllocate(loader, sizeof(gf_LoaderNode));
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "Out of memory. Failed to allocate loader node");
+		return NULL;
+	}
+
+	if (loader->lastNode) {
+		loader->lastNode->nextAllocated = node;
+	}
+	loader->lastNode = node;
+
+	node->token = token;
+	node->parent = NULL;
+	node->next = NULL;
+	node->prev = NULL;
+	node->childrenHead = NULL;
+	node->childrenTail = NULL;
+	node->nextAllocated = NULL;
+	return node;
+}
+
+void gf_AddChild(gf_LoaderNode *parent, gf_LoaderNode *child) {
+	if (parent == NULL) return;
+	if (parent->childrenHead == NULL) {
+		parent->childrenHead = child;
+		parent->childrenTail = child;
+		child->next = NULL;
+		child->prev = NULL;
+	}
+	else {
+		parent->childrenTail->next = child;
+		child->prev = parent->childrenTail;
+		child->next = NULL;
+		parent->childrenTail = child;
+	}
+	child->parent = parent;
+}
+
+int gf_ArenaReserve(gf_Loader *loader, gf_u64 size) {
+	assert(loader);
+
+	gf_u64 alignMask = (gf_u64)GF_ARENA_ALIGNMENT - 1;
+	gf_u64 headerSize = (sizeof(gf_ArenaBlock) + alignMask) & ~alignMask;
+	size = (size + alignMask) & ~alignMask;
+
+	gf_ArenaBlock *block = loader->arena.current;
+	if (!block || block->capacity - block->used < size) {
+
+		// Blocks after the current one are left over from before gf_ResetLoader() and are empty.
+		while (block && block->next) {
+			block = block->next;
+			if (block->capacity >= size) {
+				break;
+			}
+		}
+
+		if (!block || block->capacity - block->used < size) {
+			gf_u64 capacity = size > GF_ARENA_BLOCK_SIZE ? size : GF_ARENA_BLOCK_SIZE;
+			gf_ArenaBlock *newBlock = (gf_ArenaBlock *)gf_Allocate(loader, headerSize + capacity);
+			if (!newBlock) {
+				GF_LOG(loader, GF_LOG_ERROR, "Out of memory. Failed to allocate an arena block of %" PRIu64 " bytes", capacity);
+				return 0;
+			}
+			newBlock->next = NULL;
+			newBlock->capacity = capacity;
+			newBlock->used = 0;
+
+			if (block) {
+				block->next = newBlock;
+			}
+			else {
+				loader->arena.first = newBlock;
+			}
+			block = newBlock;
+		}
+		loader->arena.current = block;
+	}
+	return 1;
+}
+
+void *gf_ArenaAllocate(gf_Loader *loader, gf_u64 size) {
+	assert(loader);
+
+	gf_u64 alignMask = (gf_u64)GF_ARENA_ALIGNMENT - 1;
+	gf_u64 headerSize = (sizeof(gf_ArenaBlock) + alignMask) & ~alignMask;
+	size = (size + alignMask) & ~alignMask;
+
+	if (!gf_ArenaReserve(loader, size)) {
+		return NULL;
+	}
+
+	gf_ArenaBlock *block = loader->arena.current;
+	void *memory = (char *)block + headerSize + block->used;
+	block->used += size;
+	return memory;
+}
+
+void gf_FreeArena(gf_Loader *loader) {
+	assert(loader);
+
+	gf_ArenaBlock *block = loader->arena.first;
+	gf_ArenaBlock *nextBlock;
+	while (block) {
+		nextBlock = block->next;
+		gf_Free(loader, block);
+		block = nextBlock;
+	}
+	loader->arena.first = NULL;
+	loader->arena.current = NULL;
+}
+
+int gf_Parse(gf_Loader *loader, gf_LoaderNode *parentNode) {
+	assert(loader);
+	assert(loader->curToken);
+	assert(loader->lastToken);
+	assert(parentNode);
+
+	// The lists that are open are the parents of parentNode up to the node we started with.
+	gf_u64 depth = 0;
+	gf_Token *token = NULL;
+	while ((token = gf_ConsumeToken(loader))) {
+
+		if (token->type == GF_TOKEN_TYPE_NAME) {
+
+			if (parentNode->token->type != GF_TOKEN_TYPE_ROOT) {
+				parentNode->token->type = GF_TOKEN_TYPE_COMPOSITE_TYPE;
+			}
+
+			gf_Token *peek = gf_PeekToken(loader);
+			if (!peek) {
+				return 0;
+			}
+
+			gf_LoaderNode *node = gf_AddNode(loader, token);
+			if (!node) {
+				return 0;
+			}
+			gf_AddChild(parentNode, node);
+
+			if (peek->type == GF_TOKEN_TYPE_VALUE_ASSIGN) {
+
+				if (loader->nestLevel >= loader->maxDepth) {
+					GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, token, "Lists are nested deeper than the maximum depth of %" PRIu64, loader->maxDepth);
+					return 0;
+				}
+
+				token->flags |= GF_TOKEN_FLAG_HAS_VALUE_ASSIGN;
+				gf_ConsumeToken(loader);
+
+				// Step into the list. Its values and children are added to it until the matching } is found.
+				loader->nestLevel++;
+				depth++;
+				parentNode = node;
+			}
+		}
+		else if (token->type == GF_TOKEN_TYPE_STRING || token->type == GF_TOKEN_TYPE_FLOAT || token->type == GF_TOKEN_TYPE_INTEGER) {
+
+			gf_LoaderNode *node = gf_AddNode(loader, token);
+			if (!node) {
+				return 0;
+			}
+
+			gf_AddChild(parentNode, node);
+		}
+		else if (token->type == GF_TOKEN_TYPE_CURLY_CLOSE) {
+			if (loader->nestLevel == 0) {
+				GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, token, "There is a closing brace } without a matching open brace {");
+				return 0;
+			}
+			loader->nestLevel--;
+			if (depth == 0) {
+				break;
+			}
+			depth--;
+			parentNode = parentNode->parent;
+		}
+		else if (token->type == GF_TOKEN_TYPE_END_FILE) {
+			break;
+		}
+		else if (token->type == GF_TOKEN_TYPE_VALUE_ASSIGN)  {
+			GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, token, "unexpected value assign at token. It is likely because the token before it is not an identifier node.");
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+
+int gf_LoadInternal(gf_Loader *loader, const char *buffer, gf_u64 bufferCount) {
+	assert(loader);
+	assert(buffer);
+
+	if (gf_IsCompressed(buffer, bufferCount)) {
+		return gf_LoadCompressedInternal(loader, buffer, bufferCount);
+	}
+	if (gf_IsBinary(buffer, bufferCount)) {
+		return gf_LoadBinaryInternal(loader, buffer, bufferCount);
+	}
+
+	gf_InitLineIndex(&loader->lines, loader, buffer, bufferCount);
+
+	if (loader->flags & GF_LOADER_FLAG_PRESIZE) {
+		gf_u64 tokenCount = 0;
+		gf_u64 nodeCount = 0;
+		gf_CountTokenBounds(buffer, bufferCount, &tokenCount, &nodeCount);
+
+		gf_u64 alignMask = (gf_u64)GF_ARENA_ALIGNMENT - 1;
+		gf_u64 tokenSize = (sizeof(gf_Token) + alignMask) & ~alignMask;
+		gf_u64 nodeSize = (sizeof(gf_LoaderNode) + alignMask) & ~alignMask;
+		if (!gf_ArenaReserve(loader, tokenCount * tokenSize + nodeCount * nodeSize)) {
+			return 0;
+		}
+	}
+
+	if (!gf_Tokenise(loader, buffer, bufferCount)) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to tokenise");
+		return 0;
+	}
+
+	return gf_ParseTokens(loader);
+}
+
+int gf_ParseTokens(gf_Loader *loader) {
+	assert(loader);
+
+	loader->rootNode = gf_AddNode(loader, &loader->rootToken);
+	if (!loader->rootNode) {
+		return 0;
+	}
+	loader->curToken = &loader->rootToken;
+
+	loader->nestLevel = 0;
+	int result = gf_Parse(loader, loader->rootNode);
+
+	if (loader->nestLevel != 0) {
+		GF_LOG(loader, GF_LOG_ERROR, "There is a missing closing brace }. A brace has been opened { without a matching close.");
+		result = 0;
+	}
+
+	if (!result) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to parse");
+		return 0;
+	}
+
+	return 1;
+}
+
+int gf_LoadFromBuffer(gf_Loader *loader, const char *buffer, gf_u64 bufferCount, gf_LogAllocateFreeFunctions *funcs) {
+	assert(loader);
+	assert(buffer);
+
+	gf_InitLoader(loader, funcs);
+
+	return gf_LoadInternal(loader, buffer, bufferCount);
+}
+
+int gf_LoadFromFile(gf_Loader *loader, const char *filename, gf_LogAllocateFreeFunctions *funcs) {
+	assert(loader);
+	assert(filename);
+
+	gf_InitLoader(loader, funcs);
+
+	if (loader->flags & GF_LOADER_FLAG_CACHE) {
+		return gf_LoadFileWithCache(loader, filename);
+	}
+
+	return gf_LoadFileWithPipeline(loader, filename, (loader->flags & GF_LOADER_FLAG_PIPELINE) ? GF_PIPELINE_BLOCK_SIZE : 0);
+}
+
+void gf_Unload(gf_Loader *loader) {
+	assert(loader);
+
+	gf_Free(loader, loader->fileContentsBuffer);
+	loader->fileContentsBuffer = NULL;
+	loader->fileContentsCapacity = 0;
+
+	gf_FreeArena(loader);
+	gf_UnmapSnapshot(loader);
+	gf_InitLineIndex(&loader->lines, loader, NULL, 0);
+}
+
+void gf_ResetLoader(gf_Loader *loader) {
+	assert(loader);
+
+	for (gf_ArenaBlock *block = loader->arena.first; block; block = block->next) {
+		block->used = 0;
+	}
+	loader->arena.current = loader->arena.first;
+
+	loader->curToken = NULL;
+	loader->rootNode = NULL;
+	loader->lastNode = NULL;
+	loader->firstToken = NULL;
+	loader->rootToken.next = NULL;
+	loader->rootToken.type = GF_TOKEN_TYPE_ROOT;
+	loader->rootToken.flags = GF_TOKEN_FLAG_NONE;
+	loader->lastToken = &loader->rootToken;
+	loader->nestLevel = 0;
+	gf_UnmapSnapshot(loader);
+	gf_InitLineIndex(&loader->lines, loader, NULL, 0);
+}
+
+void gf_TrimLoader(gf_Loader *loader, gf_u64 maxRetainedBytes) {
+	assert(loader);
+
+	gf_u64 retained = 0;
+	gf_ArenaBlock *lastKept = NULL;
+	gf_ArenaBlock *block = loader->arena.first;
+	while (block && retained + block->capacity <= maxRetainedBytes) {
+		retained += block->capacity;
+		lastKept = block;
+		block = block->next;
+	}
+
+	gf_ArenaBlock *nextBlock;
+	while (block) {
+		nextBlock = block->next;
+		gf_Free(loader, block);
+		block = nextBlock;
+	}
+
+	if (lastKept) {
+		lastKept->next = NULL;
+	}
+	else {
+		loader->arena.first = NULL;
+	}
+	loader->arena.current = loader->arena.first;
+
+	if (loader->fileContentsCapacity > maxRetainedBytes) {
+		gf_Free(loader, loader->fileContentsBuffer);
+		loader->fileContentsBuffer = NULL;
+		loader->fileContentsCapacity = 0;
+	}
+}
+
+int gf_ReloadFromBuffer(gf_Loader *loader, const char *buffer, gf_u64 bufferCount) {
+	assert(loader);
+	assert(buffer);
+
+	gf_ResetLoader(loader);
+
+	return gf_LoadInternal(loader, buffer, bufferCount);
+}
+
+int gf_ReloadFromFile(gf_Loader *loader, const char *filename) {
+	assert(loader);
+	assert(filename);
+
+	gf_ResetLoader(loader);
+
+	if (loader->flags & GF_LOADER_FLAG_CACHE) {
+		return gf_LoadFileWithCache(loader, filename);
+	}
+
+	return gf_LoadFileWithPipeline(loader, filename, (loader->flags & GF_LOADER_FLAG_PIPELINE) ? GF_PIPELINE_BLOCK_SIZE : 0);
+}
+
+int gf_LoaderNodeToU32(gf_Loader *loader, gf_LoaderNode *node, gf_u32 *value) {
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null in gf_LoaderNodeToU32");
+		return 0;
+	}
+	if (node->token->type != GF_TOKEN_TYPE_INTEGER) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "node type is not integer");
+		return 0;
+	}
+	int converted = 0;
+	if (node->token->flags & GF_TOKEN_FLAG_BINARY) {
+		gf_u64 wide = 0;
+		converted = gf_BinaryTokenToU64(node->token, &wide) && wide <= UINT32_MAX;
+		if (converted) {
+			*value = (gf_u32)wide;
+		}
+	}
+	else {
+		converted = gf_StringSpanToU32(node->token->start, node->token->length, value);
+	}
+	if (!converted) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "unable to convert token to u32 in gf_LoaderNodeToU32");
+		return 0;
+	}
+	return 1;
+}
+
+int gf_LoaderNodeToU64(gf_Loader *loader, gf_LoaderNode *node, gf_u64 *value) {
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null in gf_LoaderNodeToU64");
+		return 0;
+	}
+	if (node->token->type != GF_TOKEN_TYPE_INTEGER) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "node type is not integer");
+		return 0;
+	}
+	int converted = node->token->flags & GF_TOKEN_FLAG_BINARY ?
+		gf_BinaryTokenToU64(node->token, value) :
+		gf_StringSpanToU64(node->token->start, node->token->length, value);
+	if (!converted) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "unable to convert token to u64 in gf_LoaderNodeToU64");
+		return 0;
+	}
+	return 1;
+}
+
+int gf_LoaderNodeToS32(gf_Loader *loader, gf_LoaderNode *node, gf_s32 *value) {
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null in gf_LoaderNodeToS32");
+		return 0;
+	}
+	if (node->token->type != GF_TOKEN_TYPE_INTEGER) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "node type is not integer");
+		return 0;
+	}
+	int converted = 0;
+	if (node->token->flags & GF_TOKEN_FLAG_BINARY) {
+		gf_s64 wide = 0;
+		converted = gf_BinaryTokenToS64(node->token, &wide) && wide >= INT32_MIN && wide <= INT32_MAX;
+		if (converted) {
+			*value = (gf_s32)wide;
+		}
+	}
+	else {
+		converted = gf_StringSpanToS32(node->token->start, node->token->length, value);
+	}
+	if (!converted) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "unable to convert token to S64 in gf_LoaderNodeToS32");
+		return 0;
+	}
+	return 1;
+}
+
+
+int gf_LoaderNodeToS64(gf_Loader *loader, gf_LoaderNode *node, gf_s64 *value) {
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null in gf_LoaderNodeToS64");
+		return 0;
+	}
+	if (node->token->type != GF_TOKEN_TYPE_INTEGER) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "node type is not integer");
+		return 0;
+	}
+	int converted = node->token->flags & GF_TOKEN_FLAG_BINARY ?
+		gf_BinaryTokenToS64(node->token, value) :
+		gf_StringSpanToS64(node->token->start, node->token->length, value);
+	if (!converted) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "unable to convert token to S64 in gf_LoaderNodeToS64");
+		return 0;
+	}
+	return 1;
+}
+
+int gf_LoaderNodeToF64(gf_Loader *loader, gf_LoaderNode *node, gf_f64 *value) {
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null in gf_LoaderNodeToF64");
+		return 0;
+	}
+	if (node->token->type != GF_TOKEN_TYPE_FLOAT) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "node type is not float");
+		return 0;
+	}
+	if (node->token->flags & GF_TOKEN_FLAG_BINARY) {
+		*value = gf_BinaryTokenToF64(node->token);
+	}
+	else if (!gf_StringSpanToF64(node->token->start, node->token->length, value)) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "unable to convert token to S64 in gf_LoaderNodeToF64");
+		return 0;
+	}
+	return 1;
+}
+
+int gf_LoaderNodeToF32(gf_Loader *loader, gf_LoaderNode *node, gf_f32 *value) {
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null in gf_LoaderNodeToF32");
+		return 0;
+	}
+	if (node->token->type != GF_TOKEN_TYPE_FLOAT) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "node type is not float");
+		return 0;
+	}
+	if (node->token->flags & GF_TOKEN_FLAG_BINARY) {
+		*value = (gf_f32)gf_BinaryTokenToF64(node->token);
+	}
+	else if (!gf_StringSpanToF32(node->token->start, node->token->length, value)) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "unable to convert token to S64 in gf_LoaderNodeToF32");
+		return 0;
+	}
+	return 1;
+}
+
+int gf_LoaderNodeToString(gf_Loader *loader, gf_LoaderNode *node, char *src, gf_u64 srcCapacityIncludesNullTerminator) {
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null in gf_LoaderNodeToString");
+		return 0;
+	}
+	if (node->token->type != GF_TOKEN_TYPE_STRING) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "node type is not a string");
+		return 0;
+	}
+	if (node->token->length >= srcCapacityIncludesNullTerminator) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "unable to convert token to string in gf_LoaderNodeToString");
+		return 0;
+	}
+	memcpy(src, node->token->start, node->token->length);
+	src[node->token->length] = '\0';
+
+	return 1;
+}
+
+int gf_LoaderNodeToStringView(gf_Loader *loader, gf_LoaderNode *node, gf_StringView *view) {
+	assert(view);
+
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null in gf_LoaderNodeToStringView");
+		return 0;
+	}
+	if (node->token->type != GF_TOKEN_TYPE_STRING) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "node type is not a string");
+		return 0;
+	}
+	view->start = node->token->start;
+	view->length = node->token->length;
+
+	return 1;
+}
+
+
+gf_LoaderNode *gf_GetRoot(gf_Loader *loader) {
+	assert(loader);
+
+	if (!loader->rootNode) {
+		GF_LOG(loader, GF_LOG_WARNING, "loader has no root node");
+		return NULL;
+	}
+	return loader->rootNode;
+}
+
+gf_LoaderNode *gf_GetNext(gf_Loader *loader, gf_LoaderNode *node) {
+	assert(loader);
+
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null");
+		return NULL;
+	}
+	else if (!node->next) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_WARNING, node->token, "node's next is null");
+		return NULL;
+	}
+	else {
+		return node->next;
+	}
+}
+
+gf_LoaderNode *gf_GetChild(gf_Loader *loader, gf_LoaderNode *node) {
+	assert(loader);
+
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null");
+		return NULL;
+	}
+	else if (!node->childrenHead) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_WARNING, node->token, "node's child is null");
+		return NULL;
+	}
+	else {
+		return node->childrenHead;
+	}
+}
+
+gf_TokenType gf_GetType(gf_Loader *loader, gf_LoaderNode *node) {
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null");
+		return GF_TOKEN_TYPE_END_FILE;
+	}
+	return node->token->type;
+}
+
+gf_LoaderNode *gf_FindFirstChild(gf_Loader *loader, gf_LoaderNode *node, const char *str) {
+	// TODO: change to hash map?
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null");
+		return NULL;
+	}
+
+	gf_u64 len = gf_StringLength(str);
+
+	gf_LoaderNode *child = node->childrenHead;
+	while (child) {
+		if (child->token->type == GF_TOKEN_TYPE_COMPOSITE_TYPE || child->token->type == GF_TOKEN_TYPE_NAME) {
+			if (gf_AreStringSpansEqual(child->token->start, child->token->length, str, len)) {
+				return child;
+			}
+		}
+		child = child->next;
+	}
+
+	return NULL;
+}
+
+gf_LoaderNode *gf_FindFirstNext(gf_Loader *loader, gf_LoaderNode *node, const char *str) {
+	// TODO: change to hash map?
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null");
+		return NULL;
+	}
+
+	gf_u64 len = gf_StringLength(str);
+
+	gf_LoaderNode *next = node->next;
+	while (next) {
+		if (next->token->type == GF_TOKEN_TYPE_COMPOSITE_TYPE || next->token->type == GF_TOKEN_TYPE_NAME) {
+			if (gf_AreStringSpansEqual(next->token->start, next->token->length, str, len)) {
+				return next;
+			}
+		}
+		next = next->next;
+	}
+
+	return NULL;
+}
+
+int gf_LoadVariableU32(gf_Loader *loader, gf_LoaderNode *node, gf_u32 *value) {
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null");
+		return 0;
+	}
+
+	gf_LoaderNode *child = gf_GetChild(loader, node);
+	if (!child) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "child is null");
+		return 0;
+	}
+	return gf_LoaderNodeToU32(loader, child, value);
+}
+
+
+int gf_LoadVariableU64(gf_Loader *loader, gf_LoaderNode *node, gf_u64 *value) {
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null");
+		return 0;
+	}
+
+	gf_LoaderNode *child = gf_GetChild(loader, node);
+	if (!child) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "child is null");
+		return 0;
+	}
+	return gf_LoaderNodeToU64(loader, child, value);
+}
+
+int gf_LoadVariableS32(gf_Loader *loader, gf_LoaderNode *node, gf_s32 *value) {
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null");
+		return 0;
+	}
+
+	gf_LoaderNode *child = gf_GetChild(loader, node);
+	if (!child) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "child is null");
+		return 0;
+	}
+	return gf_LoaderNodeToS32(loader, child, value);
+}
+
+int gf_LoadVariableS64(gf_Loader *loader, gf_LoaderNode *node, gf_s64 *value) {
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null");
+		return 0;
+	}
+
+	gf_LoaderNode *child = gf_GetChild(loader, node);
+	if (!child) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "child is null");
+		return 0;
+	}
+	return gf_LoaderNodeToS64(loader, child, value);
+}
+
+int gf_LoadVariableF64(gf_Loader *loader, gf_LoaderNode *node, gf_f64 *value) {
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null");
+		return 0;
+	}
+
+	gf_LoaderNode *child = gf_GetChild(loader, node);
+	if (!child) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "child is null");
+		return 0;
+	}
+	return gf_LoaderNodeToF64(loader, child, value);
+}
+
+
+int gf_LoadVariableF32(gf_Loader *loader, gf_LoaderNode *node, gf_f32 *value) {
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null");
+		return 0;
+	}
+
+	gf_LoaderNode *child = gf_GetChild(loader, node);
+	if (!child) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "child is null");
+		return 0;
+	}
+	return gf_LoaderNodeToF32(loader, child, value);
+}
+
+int gf_LoadVariableVec3(gf_Loader *loader, gf_LoaderNode *node, gf_f32 *x, gf_f32 *y, gf_f32 *z) {
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null");
+		return 0;
+	}
+
+	gf_LoaderNode *nodeX = gf_GetChild(loader, node);
+	if (!nodeX) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "child is null");
+		return 0;
+	}
+
+	gf_LoaderNode *nodeY = gf_GetNext(loader, nodeX);
+	if (!nodeY) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, nodeX->token, "y value is null");
+		return 0;
+	}
+
+	gf_LoaderNode *nodeZ = gf_GetNext(loader, nodeY);
+	if (!nodeZ) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, nodeY->token, "z value is null");
+		return 0;
+	}
+
+	if (!gf_LoaderNodeToF32(loader, nodeX, x)) {
+		return 0;
+	}
+	if (!gf_LoaderNodeToF32(loader, nodeY, y)) {
+		return 0;
+	}
+	if (!gf_LoaderNodeToF32(loader, nodeZ, z)) {
+		return 0;
+	}
+
+	return 1;
+}
+
+int gf_LoadVariableString(gf_Loader *loader, gf_LoaderNode *node, char *str, gf_u64 lenWithNullTerminator) {
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null");
+		return 0;
+	}
+
+	gf_LoaderNode *child = gf_GetChild(loader, node);
+	if (!child) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "child is null");
+		return 0;
+	}
+
+	gf_u64 index = 0;
+	for (index = 0; index < lenWithNullTerminator - 1 && index < child->token->length; index++) {
+		str[index] = child->token->start[index];
+	}
+	str[index] = '\0';
+
+	return 1;
+}
+
+int gf_LoadVariableStringView(gf_Loader *loader, gf_LoaderNode *node, gf_StringView *view) {
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null");
+		return 0;
+	}
+
+	gf_LoaderNode *child = gf_GetChild(loader, node);
+	if (!child) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "child is null");
+		return 0;
+	}
+
+	return gf_LoaderNodeToStringView(loader, child, view);
+}
+
+int gf_LoadArrayS32(gf_Loader *loader, gf_LoaderNode *node, gf_s32 *value, gf_u64 count) {
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null");
+		return 0;
+	}
+
+	gf_LoaderNode *child = gf_GetChild(loader, node);
+	if (!child) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "child is null");
+		return 0;
+	}
+
+	gf_u64 index = 0;
+	while (child && index < count) {
+		if (!gf_LoaderNodeToS32(loader, child, &value[index])) {
+			return 0;
+		}
+		child = child->next;
+		index++;
+	}
+
+	return 1;
+}
+
+/*-----------------------------------------------------------------------------------*/
+
+/*-------------------------------------VALIDATE--------------------------------------*/
+
+int gf_Validate(const char *buffer, gf_u64 count, gf_ValidateError *error) {
+	assert(buffer);
+
+	gf_Tokeniser tokeniser;
+	gf_InitTokeniser(&tokeniser, buffer, count);
+	tokeniser.Log = gf_NoLog;
+
+	gf_Token token;
+	const char *message = NULL;
+	gf_TokenType previousType = GF_TOKEN_TYPE_ROOT;
+	gf_u64 depth = 0;
+
+	while (1) {
+
+		if (!gf_NextToken(&tokeniser, &token)) {
+			message = tokeniser.error;
+			break;
+		}
+
+		if (token.type == GF_TOKEN_TYPE_VALUE_ASSIGN) {
+			// Only a name can open a list => name { ... }
+			if (previousType != GF_TOKEN_TYPE_NAME) {
+				message = "unexpected value assign at token. It is likely because the token before it is not an identifier node.";
+				break;
+			}
+			if (depth == GF_DEFAULT_MAX_DEPTH) {
+				message = "Lists are nested deeper than the maximum depth";
+				break;
+			}
+			depth++;
+		}
+		else if (token.type == GF_TOKEN_TYPE_CURLY_CLOSE) {
+			if (depth == 0) {
+				message = "There is a closing brace } without a matching open brace {";
+				break;
+			}
+			depth--;
+		}
+		else if (token.type == GF_TOKEN_TYPE_END_FILE) {
+			if (depth != 0) {
+				message = "There is a missing closing brace }. A brace has been opened { without a matching close.";
+			}
+			break;
+		}
+		previousType = token.type;
+	}
+
+	if (!message) {
+		return 1;
+	}
+
+	if (error) {
+		error->message = message;
+		// The end token does not point into the buffer.
+		if (token.start >= buffer && token.start <= buffer + count) {
+			error->offset = (gf_u64)(token.start - buffer);
+		}
+		else {
+			error->offset = tokeniser.index;
+		}
+		gf_LocateOffset(&tokeniser.lines, error->offset, &error->lineno, &error->colno);
+	}
+	return 0;
+}
+
+/*-----------------------------------------------------------------------------------*/
+
+/*-----------------------------------TREE SAVER--------------------------------------*/
+
+int gf_SaveNode(gf_Saver *saver, FILE *file, gf_LoaderNode *node) {
+	assert(saver);
+	assert(file || saver->target != GF_SAVER_TARGET_FILE);
+
+	if (!node) {
+		GF_LOG(saver, GF_LOG_ERROR, "node is null in gf_SaveNode");
+		return 0;
+	}
+
+	gf_LoaderNode *top = node;
+	if (node->token->type == GF_TOKEN_TYPE_ROOT) {
+		top = node->childrenHead;
+	}
+
+	// When saving the root every child of the root is saved, otherwise the walk stops once node is saved.
+	int savingSiblings = top != node;
+	gf_u64 depth = 0;
+
+	node = top;
+	while (node) {
+
+		gf_Token *token = node->token;
+
+		if (token->type == GF_TOKEN_TYPE_STRING || token->type == GF_TOKEN_TYPE_FLOAT || token->type == GF_TOKEN_TYPE_INTEGER) {
+
+			// Values that are next to each other are written on the same line => 1, 2, 3
+			if (!gf_PrintIndent(saver, file)) return 0;
+			if (!gf_SaveToken(saver, file, token)) return 0;
+			while (node->next && (depth > 0 || savingSiblings)) {
+				gf_TokenType type = node->next->token->type;
+				if (type != GF_TOKEN_TYPE_STRING && type != GF_TOKEN_TYPE_FLOAT && type != GF_TOKEN_TYPE_INTEGER) {
+					break;
+				}
+				node = node->next;
+				if (!gf_SaverWrite(saver, file, saver->valueSeparator, gf_StringLength(saver->valueSeparator))) return 0;
+				if (!gf_SaveToken(saver, file, node->token)) return 0;
+			}
+			if (!gf_PrintVariableEnd(saver, file)) return 0;
+		}
+		else if (node->childrenHead || token->type == GF_TOKEN_TYPE_COMPOSITE_TYPE || (token->flags & GF_TOKEN_FLAG_HAS_VALUE_ASSIGN)) {
+
+			int onlyValues = node->childrenHead != NULL;
+			for (gf_LoaderNode *child = node->childrenHead; child; child = child->next) {
+				gf_TokenType type = child->token->type;
+				if (type != GF_TOKEN_TYPE_STRING && type != GF_TOKEN_TYPE_FLOAT && type != GF_TOKEN_TYPE_INTEGER) {
+					onlyValues = 0;
+					break;
+				}
+			}
+
+			if (onlyValues) {
+				// A list that only holds values is written on one line => a { 1, 2, 3 }
+				if (!gf_PrintIndent(saver, file)) return 0;
+				if (!gf_SaveToken(saver, file, token)) return 0;
+				if (!gf_SaverWrite(saver, file, saver->openBrace, gf_StringLength(saver->openBrace))) return 0;
+				for (gf_LoaderNode *child = node->childrenHead; child; child = child->next) {
+					if (child != node->childrenHead && !gf_SaverWrite(saver, file, saver->valueSeparator, gf_StringLength(saver->valueSeparator))) return 0;
+					if (!gf_SaveToken(saver, file, child->token)) return 0;
+				}
+				if (!gf_SaverWrite(saver, file, saver->closeBrace, gf_StringLength(saver->closeBrace))) return 0;
+				if (!gf_PrintVariableEnd(saver, file)) return 0;
+			}
+			else {
+				if (!gf_SaveStartListSpan(saver, file, token->start, token->length)) return 0;
+				if (node->childrenHead) {
+					// Step into the list. It is closed once its last child has been saved.
+					node = node->childrenHead;
+					depth++;
+					continue;
+				}
+				if (!gf_SaveEndList(saver, file)) return 0;
+			}
+		}
+		else {
+			// A name on its own without a list => a
+			if (!gf_PrintIndent(saver, file)) return 0;
+			if (!gf_SaveToken(saver, file, token)) return 0;
+			if (!gf_PrintVariableEnd(saver, file)) return 0;
+		}
+
+		// Move to the next node to save, closing every list whose last child we just saved.
+		while (depth > 0 && !node->next) {
+			node = node->parent;
+			depth--;
+			if (!gf_SaveEndList(saver, file)) return 0;
+		}
+		if (depth == 0 && !savingSiblings) {
+			break;
+		}
+		node = node->next;
+	}
+
+	return 1;
+}
+
+/*-----------------------------------------------------------------------------------*/
+
+/*-------------------------------------BUILDER---------------------------------------*/
+
+int gf_LoadEmpty(gf_Loader *loader, gf_LogAllocateFreeFunctions *funcs) {
+	assert(loader);
+
+	gf_InitLoader(loader, funcs);
+
+	loader->rootNode = gf_AddNode(loader, &loader->rootToken);
+	if (!loader->rootNode) {
+		return 0;
+	}
+	return 1;
+}
+
+int gf_IsValidName(const char *name, gf_u64 length) {
+	assert(name);
+
+	if (length == 0 || !isalpha(name[0])) {
+		return 0;
+	}
+	for (gf_u64 i = 1; i < length; i++) {
+		if (!isalpha(name[i]) && !isdigit(name[i]) && name[i] != '_') {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int gf_SetTokenText(gf_Loader *loader, gf_Token *token, gf_TokenType type, const char *text, gf_u64 length) {
+	assert(loader);
+	assert(token);
+	assert(text);
+
+	char *copy = (char *)gf_ArenaAllocate(loader, length + 1);
+	if (!copy) {
+		return 0;
+	}
+	memcpy(copy, text, length);
+	copy[length] = '\0';
+
+	token->start = copy;
+	token->length = length;
+	token->type = type;
+	token->flags &= ~(gf_u32)(GF_TOKEN_FLAG_BINARY | GF_TOKEN_FLAG_UNSIGNED | GF_TOKEN_FLAG_DECODED);
+	return 1;
+}
+
+gf_LoaderNode *gf_CreateNodeInArena(gf_Loader *loader, gf_TokenType type, const char *text, gf_u64 length) {
+	assert(loader);
+	assert(text);
+
+	// Every node is linked to the one allocated before it, which can be in the snapshot.
+	if (!gf_CanChangeGraph(loader)) {
+		return NULL;
+	}
+
+	gf_Token *token = (gf_Token *)gf_ArenaAllocate(loader, sizeof(gf_Token));
+	if (!token) {
+		return NULL;
+	}
+
+	token->lineno = 0;
+	token->colno = 0;
+	token->next = NULL;
+	token->flags = GF_TOKEN_FLAG_NONE;
+	if (!gf_SetTokenText(loader, token, type, text, length)) {
+		return NULL;
+	}
+
+	return gf_AddNode(loader, token);
+}
+
+gf_LoaderNode *gf_CreateComposite(gf_Loader *loader, const char *name) {
+	gf_LoaderNode *node = gf_CreateName(loader, name);
+	if (node) {
+		node->token->flags |= GF_TOKEN_FLAG_HAS_VALUE_ASSIGN;
+	}
+	return node;
+}
+
+gf_LoaderNode *gf_CreateName(gf_Loader *loader, const char *name) {
+	assert(loader);
+	assert(name);
+
+	gf_u64 length = gf_StringLength(name);
+	if (!gf_IsValidName(name, length)) {
+		GF_LOG(loader, GF_LOG_ERROR, "\"%s\" is not a valid name. A name starts with a letter and only holds letters, digits and underscores", name);
+		return NULL;
+	}
+	return gf_CreateNodeInArena(loader, GF_TOKEN_TYPE_NAME, name, length);
+}
+
+gf_LoaderNode *gf_CreateS64(gf_Loader *loader, gf_s64 value) {
+	assert(loader);
+
+	char text[32];
+	int length = snprintf(text, sizeof(text), "%" PRIi64, value);
+	return gf_CreateNodeInArena(loader, GF_TOKEN_TYPE_INTEGER, text, (gf_u64)length);
+}
+
+gf_LoaderNode *gf_CreateU64(gf_Loader *loader, gf_u64 value) {
+	assert(loader);
+
+	char text[32];
+	int length = snprintf(text, sizeof(text), "%" PRIu64, value);
+	return gf_CreateNodeInArena(loader, GF_TOKEN_TYPE_INTEGER, text, (gf_u64)length);
+}
+
+gf_LoaderNode *gf_CreateF64(gf_Loader *loader, gf_f64 value) {
+	assert(loader);
+
+	char text[GF_F64_STRING_CAPACITY];
+	if (!gf_F64ToString(value, text, sizeof(text))) {
+		GF_LOG(loader, GF_LOG_ERROR, "Unable to store the floating point value %f. Infinity and NaN can not be stored", value);
+		return NULL;
+	}
+	return gf_CreateNodeInArena(loader, GF_TOKEN_TYPE_FLOAT, text, gf_StringLength(text));
+}
+
+gf_LoaderNode *gf_CreateString(gf_Loader *loader, const char *value) {
+	assert(loader);
+	assert(value);
+
+	return gf_CreateNodeInArena(loader, GF_TOKEN_TYPE_STRING, value, gf_StringLength(value));
+}
+
+int gf_CanAddChild(gf_Loader *loader, gf_LoaderNode *parent, gf_LoaderNode *child) {
+	assert(loader);
+
+	if (!gf_CanChangeGraph(loader)) {
+		return 0;
+	}
+	if (!parent || !child) {
+		GF_LOG(loader, GF_LOG_ERROR, "Can not add a child, the parent or child node is null");
+		return 0;
+	}
+
+	gf_TokenType type = parent->token->type;
+	if (type != GF_TOKEN_TYPE_ROOT && type != GF_TOKEN_TYPE_NAME && type != GF_TOKEN_TYPE_COMPOSITE_TYPE) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, parent->token, "Can not add a child to a value node");
+		return 0;
+	}
+	if (child->token->type == GF_TOKEN_TYPE_ROOT) {
+		GF_LOG(loader, GF_LOG_ERROR, "The root node can not be added as a child");
+		return 0;
+	}
+	for (gf_LoaderNode *node = parent; node; node = node->parent) {
+		if (node == child) {
+			GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, child->token, "A node can not be added to itself or to one of its own children");
+			return 0;
+		}
+	}
+	return 1;
+}
+
+void gf_DetachNode(gf_LoaderNode *node) {
+	assert(node);
+
+	if (node->parent) {
+		if (node->prev) {
+			node->prev->next = node->next;
+		}
+		else {
+			node->parent->childrenHead = node->next;
+		}
+		if (node->next) {
+			node->next->prev = node->prev;
+		}
+		else {
+			node->parent->childrenTail = node->prev;
+		}
+	}
+	node->parent = NULL;
+	node->next = NULL;
+	node->prev = NULL;
+}
+
+void gf_MarkAsList(gf_LoaderNode *parent, gf_LoaderNode *child) {
+	gf_Token *token = parent->token;
+	if (token->type == GF_TOKEN_TYPE_ROOT) {
+		return;
+	}
+	token->flags |= GF_TOKEN_FLAG_HAS_VALUE_ASSIGN;
+	if (child->token->type == GF_TOKEN_TYPE_NAME || child->token->type == GF_TOKEN_TYPE_COMPOSITE_TYPE) {
+		token->type = GF_TOKEN_TYPE_COMPOSITE_TYPE;
+	}
+}
+
+int gf_AppendChild(gf_Loader *loader, gf_LoaderNode *parent, gf_LoaderNode *child) {
+	assert(loader);
+
+	if (!gf_CanAddChild(loader, parent, child)) {
+		return 0;
+	}
+
+	gf_DetachNode(child);
+	gf_AddChild(parent, child);
+	gf_MarkAsList(parent, child);
+	return 1;
+}
+
+int gf_InsertBefore(gf_Loader *loader, gf_LoaderNode *sibling, gf_LoaderNode *child) {
+	assert(loader);
+
+	if (!sibling || !sibling->parent) {
+		GF_LOG(loader, GF_LOG_ERROR, "Can not insert before a node that is null or has no parent");
+		return 0;
+	}
+	if (sibling == child) {
+		return 1;
+	}
+	gf_LoaderNode *parent = sibling->parent;
+	if (!gf_CanAddChild(loader, parent, child)) {
+		return 0;
+	}
+
+	gf_DetachNode(child);
+	child->parent = parent;
+	child->next = sibling;
+	child->prev = sibling->prev;
+	if (sibling->prev) {
+		sibling->prev->next = child;
+	}
+	else {
+		parent->childrenHead = child;
+	}
+	sibling->prev = child;
+	gf_MarkAsList(parent, child);
+	return 1;
+}
+
+int gf_InsertAfter(gf_Loader *loader, gf_LoaderNode *sibling, gf_LoaderNode *child) {
+	assert(loader);
+
+	if (!sibling || !sibling->parent) {
+		GF_LOG(loader, GF_LOG_ERROR, "Can not insert after a node that is null or has no parent");
+		return 0;
+	}
+	if (sibling == child) {
+		return 1;
+	}
+	gf_LoaderNode *parent = sibling->parent;
+	if (!gf_CanAddChild(loader, parent, child)) {
+		return 0;
+	}
+
+	gf_DetachNode(child);
+	child->parent = parent;
+	child->prev = sibling;
+	child->next = sibling->next;
+	if (sibling->next) {
+		sibling->next->prev = child;
+	}
+	else {
+		parent->childrenTail = child;
+	}
+	sibling->next = child;
+	gf_MarkAsList(parent, child);
+	return 1;
+}
+
+int gf_RemoveNode(gf_Loader *loader, gf_LoaderNode *node) {
+	assert(loader);
+
+	if (!gf_CanChangeGraph(loader)) {
+		return 0;
+	}
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null in gf_RemoveNode");
+		return 0;
+	}
+	if (node->token->type == GF_TOKEN_TYPE_ROOT) {
+		GF_LOG(loader, GF_LOG_ERROR, "The root node can not be removed");
+		return 0;
+	}
+	gf_DetachNode(node);
+	return 1;
+}
+
+int gf_IsValueNode(gf_Loader *loader, gf_LoaderNode *node) {
+	assert(loader);
+
+	if (!gf_CanChangeGraph(loader)) {
+		return 0;
+	}
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "Can not set the value of a node that is null");
+		return 0;
+	}
+	gf_TokenType type = node->token->type;
+	if (type != GF_TOKEN_TYPE_INTEGER && type != GF_TOKEN_TYPE_FLOAT && type != GF_TOKEN_TYPE_STRING) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "Can not set the value of a node that is not a value node");
+		return 0;
+	}
+	return 1;
+}
+
+int gf_SetS64(gf_Loader *loader, gf_LoaderNode *node, gf_s64 value) {
+	if (!gf_IsValueNode(loader, node)) {
+		return 0;
+	}
+
+	char text[32];
+	int length = snprintf(text, sizeof(text), "%" PRIi64, value);
+	return gf_SetTokenText(loader, node->token, GF_TOKEN_TYPE_INTEGER, text, (gf_u64)length);
+}
+
+int gf_SetU64(gf_Loader *loader, gf_LoaderNode *node, gf_u64 value) {
+	if (!gf_IsValueNode(loader, node)) {
+		return 0;
+	}
+
+	char text[32];
+	int length = snprintf(text, sizeof(text), "%" PRIu64, value);
+	return gf_SetTokenText(loader, node->token, GF_TOKEN_TYPE_INTEGER, text, (gf_u64)length);
+}
+
+int gf_SetF64(gf_Loader *loader, gf_LoaderNode *node, gf_f64 value) {
+	if (!gf_IsValueNode(loader, node)) {
+		return 0;
+	}
+
+	char text[GF_F64_STRING_CAPACITY];
+	if (!gf_F64ToString(value, text, sizeof(text))) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "Unable to store the floating point value %f. Infinity and NaN can not be stored", value);
+		return 0;
+	}
+	return gf_SetTokenText(loader, node->token, GF_TOKEN_TYPE_FLOAT, text, gf_StringLength(text));
+}
+
+int gf_SetString(gf_Loader *loader, gf_LoaderNode *node, const char *value) {
+	assert(value);
+
+	if (!gf_IsValueNode(loader, node)) {
+		return 0;
+	}
+	return gf_SetTokenText(loader, node->token, GF_TOKEN_TYPE_STRING, value, gf_StringLength(value));
+}
+
+int gf_SetName(gf_Loader *loader, gf_LoaderNode *node, const char *name) {
+	assert(loader);
+	assert(name);
+
+	if (!gf_CanChangeGraph(loader)) {
+		return 0;
+	}
+	if (!node) {
+		GF_LOG(loader, GF_LOG_ERROR, "node is null in gf_SetName");
+		return 0;
+	}
+	gf_TokenType type = node->token->type;
+	if (type != GF_TOKEN_TYPE_NAME && type != GF_TOKEN_TYPE_COMPOSITE_TYPE) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "Only name and composite nodes can be renamed");
+		return 0;
+	}
+
+	gf_u64 length = gf_StringLength(name);
+	if (!gf_IsValidName(name, length)) {
+		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "\"%s\" is not a valid name. A name starts with a letter and only holds letters, digits and underscores", name);
+		return 0;
+	}
+	return gf_SetTokenText(loader, node->token, type, name, length);
+}
+
+int gf_CanChangeGraph(gf_Loader *loader) {
+	assert(loader);
+
+	if (loader->readOnly) {
+		GF_LOG(loader, GF_LOG_ERROR, "The graph can not be changed. It is a snapshot shared read only with other processes");
+		return 0;
+	}
+	return 1;
+}
+
+/*-----------------------------------------------------------------------------------*/
+
+/*-------------------------------------BINARY----------------------------------------*/
+
+int gf_IsBinary(const char *buffer, gf_u64 count) {
+	assert(buffer);
+
+	return count >= GF_BINARY_HEADER_SIZE && buffer[0] == 'G' && buffer[1] == 'F' && buffer[2] == 'B' && buffer[3] == GF_BINARY_VERSION;
+}
+
+gf_u64 gf_ReadU64LE(const char *bytes) {
+	assert(bytes);
+
+	const unsigned char *b = (const unsigned char *)bytes;
+	return (gf_u64)b[0] | ((gf_u64)b[1] << 8) | ((gf_u64)b[2] << 16) | ((gf_u64)b[3] << 24) |
+		((gf_u64)b[4] << 32) | ((gf_u64)b[5] << 40) | ((gf_u64)b[6] << 48) | ((gf_u64)b[7] << 56);
+}
+
+gf_u32 gf_ReadU32LE(const char *bytes) {
+	assert(bytes);
+
+	const unsigned char *b = (const unsigned char *)bytes;
+	return (gf_u32)b[0] | ((gf_u32)b[1] << 8) | ((gf_u32)b[2] << 16) | ((gf_u32)b[3] << 24);
+}
+
+void gf_WriteU64LE(char *bytes, gf_u64 value) {
+	assert(bytes);
+
+	for (int i = 0; i < 8; i++) {
+		bytes[i] = (char)(unsigned char)(value >> (8 * i));
+	}
+}
+
+void gf_WriteU32LE(char *bytes, gf_u32 value) {
+	assert(bytes);
+
+	for (int i = 0; i < 4; i++) {
+		bytes[i] = (char)(unsigned char)(value >> (8 * i));
+	}
+}
+
+int gf_BinaryTokenToS64(const gf_Token *token, gf_s64 *value) {
+	assert(token);
+	assert(value);
+
+	gf_u64 bits = gf_ReadU64LE(token->start);
+	if ((token->flags & GF_TOKEN_FLAG_UNSIGNED) && bits > (gf_u64)INT64_MAX) {
+		return 0;
+	}
+	// Converting through the bits keeps negative values without relying on how out of range unsigned values convert.
+	gf_s64 signedValue;
+	memcpy(&signedValue, &bits, sizeof(signedValue));
+	*value = signedValue;
+	return 1;
+}
+
+int gf_BinaryTokenToU64(const gf_Token *token, gf_u64 *value) {
+	assert(token);
+	assert(value);
+
+	gf_u64 bits = gf_ReadU64LE(token->start);
+	if (!(token->flags & GF_TOKEN_FLAG_UNSIGNED) && bits > (gf_u64)INT64_MAX) {
+		return 0;
+	}
+	*value = bits;
+	return 1;
+}
+
+gf_f64 gf_BinaryTokenToF64(const gf_Token *token) {
+	assert(token);
+
+	gf_u64 bits = gf_ReadU64LE(token->start);
+	gf_f64 value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+int gf_BinaryTokenToString(const gf_Token *token, char *buffer, gf_u64 capacity, gf_u64 *length) {
+	assert(token);
+	assert(buffer);
+	assert(length);
+
+	if (token->type == GF_TOKEN_TYPE_FLOAT) {
+		if (!gf_F64ToString(gf_BinaryTokenToF64(token), buffer, capacity)) {
+			return 0;
+		}
+	}
+	else {
+		gf_u64 bits = gf_ReadU64LE(token->start);
+		if (token->flags & GF_TOKEN_FLAG_UNSIGNED) {
+			snprintf(buffer, (size_t)capacity, "%" PRIu64, bits);
+		}
+		else {
+			gf_s64 signedValue;
+			memcpy(&signedValue, &bits, sizeof(signedValue));
+			snprintf(buffer, (size_t)capacity, "%" PRIi64, signedValue);
+		}
+	}
+	*length = gf_StringLength(buffer);
+	return 1;
+}
+
+/*
+Works out the record tag a value token is saved with and its 8 bytes. Integers that are written as text are read here
+instead of with gf_StringSpanToS64(), because the whole range of gf_s64 and gf_u64 has to be kept.
+*/
+int gf_BinaryValueOf(gf_Saver *saver, gf_Token *token, gf_BinaryTag *tag, gf_u64 *bits) {
+	assert(saver);
+	assert(token);
+	assert(tag);
+	assert(bits);
+
+	if (token->type == GF_TOKEN_TYPE_STRING) {
+		*tag = GF_BINARY_TAG_STRINGS;
+		*bits = 0;
+		return 1;
+	}
+
+	if (token->flags & GF_TOKEN_FLAG_BINARY) {
+		*bits = gf_ReadU64LE(token->start);
+		if (token->type == GF_TOKEN_TYPE_FLOAT) {
+			*tag = GF_BINARY_TAG_F64S;
+		}
+		else if ((token->flags & GF_TOKEN_FLAG_UNSIGNED) && *bits > (gf_u64)INT64_MAX) {
+			*tag = GF_BINARY_TAG_U64S;
+		}
+		else {
+			*tag = GF_BINARY_TAG_S64S;
+		}
+		return 1;
+	}
+
+	if (token->type == GF_TOKEN_TYPE_FLOAT) {
+		gf_f64 value;
+		if (!gf_StringSpanToF64(token->start, token->length, &value)) {
+			GF_LOG(saver, GF_LOG_ERROR, "The float %.*s can not be saved as a 64 bit float", (int)token->length, token->start);
+			return 0;
+		}
+		memcpy(bits, &value, sizeof(value));
+		*tag = GF_BINARY_TAG_F64S;
+		return 1;
+	}
+
+	gf_u64 index = 0;
+	int negative = 0;
+	if (index < token->length && (token->start[index] == '-' || token->start[index] == '+')) {
+		negative = token->start[index] == '-';
+		index++;
+	}
+
+	gf_u64 magnitude = 0;
+	int overflowed = index == token->length;
+	for (; index < token->length && !overflowed; index++) {
+		gf_u64 digit = (gf_u64)(token->start[index] - '0');
+		if (digit > 9 || magnitude > (UINT64_MAX - digit) / 10) {
+			overflowed = 1;
+		}
+		magnitude = magnitude * 10 + digit;
+	}
+
+	if (overflowed || (negative && magnitude > (gf_u64)INT64_MAX + 1)) {
+		GF_LOG(saver, GF_LOG_ERROR, "The integer %.*s does not fit in a 64 bit integer so it can not be saved as binary", (int)token->length, token->start);
+		return 0;
+	}
+
+	*bits = negative ? (gf_u64)0 - magnitude : magnitude;
+	*tag = !negative && magnitude > (gf_u64)INT64_MAX ? GF_BINARY_TAG_U64S : GF_BINARY_TAG_S64S;
+	return 1;
+}
+
+/*
+Writes the 8 byte header of a record.
+*/
+int gf_SaveBinaryRecordHeader(gf_Saver *saver, FILE *file, gf_BinaryTag tag, gf_u32 value) {
+	char header[8] = { 0 };
+	header[0] = (char)tag;
+	gf_WriteU32LE(header + 4, value);
+	return gf_SaverWrite(saver, file, header, sizeof(header));
+}
+
+/*
+Writes the zeros that pad a record of the given length up to a multiple of 8 bytes.
+*/
+int gf_SaveBinaryPadding(gf_Saver *saver, FILE *file, gf_u64 length) {
+	static const char zeros[8] = { 0 };
+	gf_u64 padding = (8 - (length & 7)) & 7;
+	return gf_SaverWrite(saver, file, zeros, padding);
+}
+
+int gf_SaveBinaryRecord(gf_Saver *saver, FILE *file, gf_LoaderNode **cursor, int savingSiblings, gf_u64 *nodeCount) {
+	assert(saver);
+	assert(cursor);
+	assert(*cursor);
+	assert(nodeCount);
+
+	gf_LoaderNode *node = *cursor;
+	gf_u64 depth = 0;
+
+	while (node) {
+
+		gf_Token *token = node->token;
+		(*nodeCount)++;
+
+		if (token->type == GF_TOKEN_TYPE_STRING || token->type == GF_TOKEN_TYPE_FLOAT || token->type == GF_TOKEN_TYPE_INTEGER) {
+
+			// Values of the same kind that are next to each other are saved as one record => 1, 2, 3
+			gf_BinaryTag tag;
+			gf_u64 bits;
+			if (!gf_BinaryValueOf(saver, token, &tag, &bits)) return 0;
+
+			gf_u64 count = 1;
+			gf_LoaderNode *last = node;
+			while (last->next && count < UINT32_MAX && (depth > 0 || savingSiblings)) {
+				gf_TokenType type = last->next->token->type;
+				if (type != GF_TOKEN_TYPE_STRING && type != GF_TOKEN_TYPE_FLOAT && type != GF_TOKEN_TYPE_INTEGER) {
+					break;
+				}
+				gf_BinaryTag nextTag;
+				if (!gf_BinaryValueOf(saver, last->next->token, &nextTag, &bits)) return 0;
+				if (nextTag != tag) {
+					break;
+				}
+				last = last->next;
+				count++;
+			}
+			*nodeCount += count - 1;
+
+			if (!gf_SaveBinaryRecordHeader(saver, file, tag, (gf_u32)count)) return 0;
+
+			gf_u64 stringBytes = 0;
+			for (gf_u64 i = 0; i < count; i++, node = node->next) {
+				if (tag == GF_BINARY_TAG_STRINGS) {
+					if (node->token->length > UINT32_MAX) {
+						GF_LOG(saver, GF_LOG_ERROR, "A string of %" PRIu64 " bytes is too long to be saved as binary", node->token->length);
+						return 0;
+					}
+					char length[4];
+					gf_WriteU32LE(length, (gf_u32)node->token->length);
+					if (!gf_SaverWrite(saver, file, length, sizeof(length))) return 0;
+					if (!gf_SaverWrite(saver, file, node->token->start, node->token->length)) return 0;
+					stringBytes += sizeof(length) + node->token->length;
+				}
+				else {
+					char value[8];
+					gf_BinaryTag valueTag;
+					gf_BinaryValueOf(saver, node->token, &valueTag, &bits);
+					gf_WriteU64LE(value, bits);
+					if (!gf_SaverWrite(saver, file, value, sizeof(value))) return 0;
+				}
+			}
+			if (!gf_SaveBinaryPadding(saver, file, stringBytes)) return 0;
+			node = last;
+		}
+		else {
+			int isList = node->childrenHead || token->type == GF_TOKEN_TYPE_COMPOSITE_TYPE || (token->flags & GF_TOKEN_FLAG_HAS_VALUE_ASSIGN);
+			if (token->length > UINT32_MAX) {
+				GF_LOG(saver, GF_LOG_ERROR, "A name of %" PRIu64 " bytes is too long to be saved as binary", token->length);
+				return 0;
+			}
+			if (!gf_SaveBinaryRecordHeader(saver, file, isList ? GF_BINARY_TAG_LIST : GF_BINARY_TAG_NAME, (gf_u32)token->length)) return 0;
+			if (!gf_SaverWrite(saver, file, token->start, token->length)) return 0;
+			if (!gf_SaveBinaryPadding(saver, file, token->length)) return 0;
+
+			if (isList && node->childrenHead) {
+				// Step into the list. It is closed once its last child has been saved.
+				node = node->childrenHead;
+				depth++;
+				continue;
+			}
+			if (isList && !gf_SaveBinaryRecordHeader(saver, file, GF_BINARY_TAG_END, 0)) return 0;
+		}
+
+		// Move to the next node to save, closing every list whose last child we just saved.
+		while (depth > 0 && !node->next) {
+			node = node->parent;
+			depth--;
+			if (!gf_SaveBinaryRecordHeader(saver, file, GF_BINARY_TAG_END, 0)) return 0;
+		}
+		if (depth == 0) {
+			break;
+		}
+		node = node->next;
+	}
+
+	*cursor = node->next;
+	return 1;
+}
+
+int gf_SaveBinary(gf_Saver *saver, FILE *file, gf_LoaderNode *node) {
+	assert(saver);
+	assert(file || saver->target != GF_SAVER_TARGET_FILE);
+
+	if (!node) {
+		GF_LOG(saver, GF_LOG_ERROR, "node is null in gf_SaveBinary");
+		return 0;
+	}
+
+	gf_LoaderNode *top = node;
+	if (node->token->type == GF_TOKEN_TYPE_ROOT) {
+		top = node->childrenHead;
+	}
+	int savingSiblings = top != node;
+
+	char header[GF_BINARY_HEADER_SIZE] = { 'G', 'F', 'B', GF_BINARY_VERSION, 0, 0, 0, 0 };
+	if (!gf_SaverWrite(saver, file, header, sizeof(header))) return 0;
+
+	gf_u64 nodeCount = 0;
+	gf_u64 recordCount = 0;
+	for (gf_LoaderNode *record = top; record; recordCount++) {
+		if (!gf_SaveBinaryRecord(saver, file, &record, savingSiblings, &nodeCount)) return 0;
+		if (!savingSiblings) {
+			record = NULL;
+		}
+	}
+
+	// The records are measured one at a time to find where each one starts, so no offsets have to be kept while writing.
+	gf_Saver measure;
+	gf_InitSaver(&measure, saver->Log);
+	gf_SaverBeginMeasure(&measure);
+
+	gf_u64 offset = GF_BINARY_HEADER_SIZE;
+	gf_u64 measuredNodes = 0;
+	for (gf_LoaderNode *record = top; record; ) {
+		char entry[8];
+		gf_WriteU64LE(entry, offset);
+		if (!gf_SaverWrite(saver, file, entry, sizeof(entry))) return 0;
+
+		gf_u64 before = gf_SaverGetWrittenCount(&measure);
+		if (!gf_SaveBinaryRecord(&measure, NULL, &record, savingSiblings, &measuredNodes)) return 0;
+		offset += gf_SaverGetWrittenCount(&measure) - before;
+		if (!savingSiblings) {
+			record = NULL;
+		}
+	}
+
+	char footer[GF_BINARY_FOOTER_SIZE];
+	gf_WriteU64LE(footer, nodeCount);
+	gf_WriteU64LE(footer + 8, offset);
+	gf_WriteU64LE(footer + 16, recordCount);
+	return gf_SaverWrite(saver, file, footer, sizeof(footer));
+}
+
+/*
+Allocates a token and a node for a record of a .gfb file and adds the node to parent.
+*/
+gf_LoaderNode *gf_AddBinaryNode(gf_Loader *loader, gf_LoaderNode *parent, gf_TokenType type, gf_u32 flags, const char *start, gf_u64 length) {
+	gf_Token *token = (gf_Token *)gf_ArenaAllocate(loader, sizeof(gf_Token));
+	if (!token) {
+		GF_LOG(loader, GF_LOG_ERROR, "Out of memory. Failed to allocate a token");
+		return NULL;
+	}
+	token->start = start;
+	token->length = length;
+	token->type = type;
+	token->flags = flags;
+	token->lineno = 0;
+	token->colno = 0;
+	token->next = NULL;
+
+	gf_LoaderNode *node = gf_AddNode(loader, token);
+	if (!node) {
+		return NULL;
+	}
+	if (type == GF_TOKEN_TYPE_NAME && parent->token->type != GF_TOKEN_TYPE_ROOT) {
+		parent->token->type = GF_TOKEN_TYPE_COMPOSITE_TYPE;
+	}
+	gf_AddChild(parent, node);
+	return node;
+}
+
+int gf_LoadBinaryInternal(gf_Loader *loader, const char *buffer, gf_u64 count) {
+	assert(loader);
+	assert(buffer);
+
+	if (count % 8 == 1 && buffer[count - 1] == '\0') {
+		count--;
+	}
+	if (count < GF_BINARY_HEADER_SIZE + GF_BINARY_FOOTER_SIZE || count % 8 != 0) {
+		GF_LOG(loader, GF_LOG_ERROR, "The binary file is %" PRIu64 " bytes, which is not the size of a whole .gfb file", count);
+		return 0;
+	}
+
+	const char *footer = buffer + count - GF_BINARY_FOOTER_SIZE;
+	gf_u64 nodeCount = gf_ReadU64LE(footer);
+	gf_u64 tableOffset = gf_ReadU64LE(footer + 8);
+	gf_u64 recordCount = gf_ReadU64LE(footer + 16);
+	gf_u64 tableEnd = count - GF_BINARY_FOOTER_SIZE;
+	if (tableOffset < GF_BINARY_HEADER_SIZE || tableOffset > tableEnd || tableOffset % 8 != 0 ||
+		recordCount != (tableEnd - tableOffset) / 8 || nodeCount > count) {
+		GF_LOG(loader, GF_LOG_ERROR, "The footer of the binary file does not match its size. The file is damaged");
+		return 0;
+	}
+
+	gf_u64 alignMask = (gf_u64)GF_ARENA_ALIGNMENT - 1;
+	gf_u64 tokenSize = (sizeof(gf_Token) + alignMask) & ~alignMask;
+	gf_u64 nodeSize = (sizeof(gf_LoaderNode) + alignMask) & ~alignMask;
+	if (!gf_ArenaReserve(loader, nodeCount * tokenSize + (nodeCount + 1) * nodeSize)) {
+		return 0;
+	}
+
+	loader->rootNode = gf_AddNode(loader, &loader->rootToken);
+	if (!loader->rootNode) {
+		return 0;
+	}
+	loader->curToken = &loader->rootToken;
+	loader->nestLevel = 0;
+
+	gf_LoaderNode *parent = loader->rootNode;
+	gf_u64 recordIndex = 0;
+	gf_u64 nodesAdded = 0;
+	gf_u64 offset = GF_BINARY_HEADER_SIZE;
+
+	while (offset < tableOffset) {
+
+		if (loader->nestLevel == 0) {
+			if (recordIndex >= recordCount || gf_ReadU64LE(buffer + tableOffset + recordIndex * 8) != offset) {
+				GF_LOG(loader, GF_LOG_ERROR, "The record at byte %" PRIu64 " is not in the offset table. The file is damaged", offset);
+				return 0;
+			}
+			recordIndex++;
+		}
+
+		if (tableOffset - offset < 8) {
+			GF_LOG(loader, GF_LOG_ERROR, "The record at byte %" PRIu64 " runs past the end of the records", offset);
+			return 0;
+		}
+		unsigned int tag = (unsigned char)buffer[offset];
+		gf_u64 value = gf_ReadU32LE(buffer + offset + 4);
+		gf_u64 recordStart = offset;
+		offset += 8;
+
+		if (tag == GF_BINARY_TAG_NAME || tag == GF_BINARY_TAG_LIST) {
+
+			if (tableOffset - offset < value || !gf_IsValidName(buffer + offset, value)) {
+				GF_LOG(loader, GF_LOG_ERROR, "The name at byte %" PRIu64 " is not a valid name or runs past the end of the records", recordStart);
+				return 0;
+			}
+			gf_u32 flags = tag == GF_BINARY_TAG_LIST ? GF_TOKEN_FLAG_HAS_VALUE_ASSIGN : GF_TOKEN_FLAG_NONE;
+			gf_LoaderNode *node = gf_AddBinaryNode(loader, parent, GF_TOKEN_TYPE_NAME, flags, buffer + offset, value);
+			if (!node) {
+				return 0;
+			}
+			nodesAdded++;
+			offset += (value + 7) & ~(gf_u64)7;
+
+			if (tag == GF_BINARY_TAG_LIST) {
+				if (loader->nestLevel >= loader->maxDepth) {
+					GF_LOG(loader, GF_LOG_ERROR, "Lists are nested deeper than the maximum depth of %" PRIu64, loader->maxDepth);
+					return 0;
+				}
+				loader->nestLevel++;
+				parent = node;
+			}
+		}
+		else if (tag == GF_BINARY_TAG_END) {
+			if (loader->nestLevel == 0) {
+				GF_LOG(loader, GF_LOG_ERROR, "The end of a list at byte %" PRIu64 " does not have a list to close", recordStart);
+				return 0;
+			}
+			loader->nestLevel--;
+			parent = parent->parent;
+		}
+		else if (tag == GF_BINARY_TAG_STRINGS) {
+			for (gf_u64 i = 0; i < value; i++) {
+				if (tableOffset - offset < 4 || tableOffset - offset - 4 < gf_ReadU32LE(buffer + offset)) {
+					GF_LOG(loader, GF_LOG_ERROR, "A string in the record at byte %" PRIu64 " runs past the end of the records", recordStart);
+					return 0;
+				}
+				gf_u64 length = gf_ReadU32LE(buffer + offset);
+				const char *start = buffer + offset + 4;
+				if (loader->flags & GF_LOADER_FLAG_VALIDATE_UTF8) {
+					const char *invalid = gf_FindInvalidUtf8(start, start + length);
+					if (invalid != start + length) {
+						GF_LOG(loader, GF_LOG_ERROR, "Invalid UTF-8 byte 0x%02X at byte %" PRIu64 " in a string", (unsigned int)(unsigned char)*invalid, (gf_u64)(invalid - buffer));
+						return 0;
+					}
+				}
+				if (!gf_AddBinaryNode(loader, parent, GF_TOKEN_TYPE_STRING, GF_TOKEN_FLAG_NONE, start, length)) {
+					return 0;
+				}
+				nodesAdded++;
+				offset += 4 + length;
+			}
+			offset = (offset + 7) & ~(gf_u64)7;
+		}
+		else if (tag == GF_BINARY_TAG_S64S || tag == GF_BINARY_TAG_U64S || tag == GF_BINARY_TAG_F64S) {
+			if ((tableOffset - offset) / 8 < value) {
+				GF_LOG(loader, GF_LOG_ERROR, "The numbers in the record at byte %" PRIu64 " run past the end of the records", recordStart);
+				return 0;
+			}
+			gf_TokenType type = tag == GF_BINARY_TAG_F64S ? GF_TOKEN_TYPE_FLOAT : GF_TOKEN_TYPE_INTEGER;
+			gf_u32 flags = GF_TOKEN_FLAG_BINARY | (tag == GF_BINARY_TAG_U64S ? GF_TOKEN_FLAG_UNSIGNED : GF_TOKEN_FLAG_NONE);
+			for (gf_u64 i = 0; i < value; i++) {
+				if (!gf_AddBinaryNode(loader, parent, type, flags, buffer + offset, 8)) {
+					return 0;
+				}
+				nodesAdded++;
+				offset += 8;
+			}
+		}
+		else {
+			GF_LOG(loader, GF_LOG_ERROR, "Unknown record type %u at byte %" PRIu64 ". The file is damaged", tag, recordStart);
+			return 0;
+		}
+	}
+
+	if (loader->nestLevel != 0) {
+		GF_LOG(loader, GF_LOG_ERROR, "The binary file ends with %" PRIu64 " lists that are not closed", loader->nestLevel);
+		return 0;
+	}
+	if (offset != tableOffset || recordIndex != recordCount || nodesAdded != nodeCount) {
+		GF_LOG(loader, GF_LOG_ERROR, "The records do not match the offset table and the node count of the footer. The file is damaged");
+		return 0;
+	}
+	return 1;
+}
+
+int gf_ConvertToBinary(const char *inputFilename, const char *outputFilename, gf_LogAllocateFreeFunctions *funcs) {
+	assert(inputFilename);
+	assert(outputFilename);
+
+	gf_Loader loader;
+	if (!gf_LoadFromFile(&loader, inputFilename, funcs)) {
+		gf_Unload(&loader);
+		return 0;
+	}
+
+	gf_Saver saver;
+	gf_InitSaver(&saver, funcs ? funcs->Log : NULL);
+
+	int result = 0;
+	FILE *file = fopen(outputFilename, "wb");
+	if (!file) {
+		GF_LOG((&loader), GF_LOG_ERROR, "Failed to open %s to write to", outputFilename);
+	}
+	else {
+		result = gf_SaveBinary(&saver, file, gf_GetRoot(&loader));
+		if (fclose(file) != 0) {
+			result = 0;
 		}
-		if (start[index] != '0') {
+	}
+
+	gf_Unload(&loader);
+	return result;
+}
+
+int gf_ConvertToText(const char *inputFilename, const char *outputFilename, gf_SaverFormat format, gf_LogAllocateFreeFunctions *funcs) {
+	assert(inputFilename);
+	assert(outputFilename);
+
+	gf_Loader loader;
+	if (!gf_LoadFromFile(&loader, inputFilename, funcs)) {
+		gf_Unload(&loader);
+		return 0;
+	}
+
+	gf_Saver saver;
+	gf_InitSaverWithFormat(&saver, funcs ? funcs->Log : NULL, format);
+
+	int result = 0;
+	FILE *file = fopen(outputFilename, "wb");
+	if (!file) {
+		GF_LOG((&loader), GF_LOG_ERROR, "Failed to open %s to write to", outputFilename);
+	}
+	else {
+		result = gf_SaveNode(&saver, file, gf_GetRoot(&loader));
+		if (fclose(file) != 0) {
+			result = 0;
+		}
+	}
+
+	gf_Unload(&loader);
+	return result;
+}
+
+/*-----------------------------------------------------------------------------------*/
+
+/*-------------------------------------SNAPSHOT--------------------------------------*/
+
+/*
+Writes zeros from offset from up to offset to.
+*/
+int gf_SaveSnapshotPadding(gf_Saver *saver, FILE *file, gf_u64 from, gf_u64 to) {
+	static const char zeros[GF_ARENA_ALIGNMENT] = { 0 };
+	assert(to - from <= sizeof(zeros));
+	return gf_SaverWrite(saver, file, zeros, to - from);
+}
+
+/*
+Looks up the index of a node in the open addressing table built by gf_SaveSnapshot(). The slots hold the index + 1 of each node.
+*/
+gf_u64 *gf_FindSnapshotNodeSlot(const gf_LoaderNode *node, gf_LoaderNode **nodes, gf_u64 *slots, gf_u64 mask) {
+	gf_u64 hash = (gf_u64)(uintptr_t)node;
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+
+	gf_u64 slot = hash & mask;
+	while (slots[slot] && nodes[slots[slot] - 1] != node) {
+		slot = (slot + 1) & mask;
+	}
+	return &slots[slot];
+}
+
+/*
+Looks up the first node whose token has the same name as token, so the name is only stored once.
+*/
+gf_u64 *gf_FindSnapshotNameSlot(const gf_Token *token, gf_LoaderNode **nodes, gf_u64 *slots, gf_u64 mask) {
+	gf_u64 hash = 14695981039346656037ULL;
+	for (gf_u64 i = 0; i < token->length; i++) {
+		hash = (hash ^ (unsigned char)token->start[i]) * 1099511628211ULL;
+	}
+
+	gf_u64 slot = hash & mask;
+	while (slots[slot]) {
+		const gf_Token *other = nodes[slots[slot] - 1]->token;
+		if (other->length == token->length && memcmp(other->start, token->start, (size_t)token->length) == 0) {
+			break;
+		}
+		slot = (slot + 1) & mask;
+	}
+	return &slots[slot];
+}
+
+/*
+Turns a node pointer into the pointer that is stored in the snapshot in its place, where nodesAddress is where the nodes
+start when the snapshot is at its base address. NULL stays NULL.
+*/
+gf_LoaderNode *gf_SnapshotNodePointer(const gf_LoaderNode *node, gf_LoaderNode **nodes, gf_u64 *slots, gf_u64 mask, gf_u64 nodesAddress) {
+	if (!node) {
+		return NULL;
+	}
+	gf_u64 index = *gf_FindSnapshotNodeSlot(node, nodes, slots, mask) - 1;
+	return (gf_LoaderNode *)(uintptr_t)(nodesAddress + index * sizeof(gf_LoaderNode));
+}
+
+/*
+Writes the snapshot once gf_SaveSnapshot() has numbered the nodes and laid out the text.
+*/
+int gf_WriteSnapshot(gf_Saver *saver, FILE *file, gf_LoaderNode **nodes, gf_u64 nodeCount, gf_u64 *textOffsets, gf_u64 textSize, gf_u64 *nodeSlots, gf_u64 mask, gf_SnapshotHeader header) {
+	gf_u64 alignMask = (gf_u64)GF_ARENA_ALIGNMENT - 1;
+
+	memcpy(header.magic, "GFSNAP", 6);
+	header.magic[6] = GF_SNAPSHOT_VERSION;
+	header.tokenSize = (gf_u32)sizeof(gf_Token);
+	header.nodeSize = (gf_u32)sizeof(gf_LoaderNode);
+	header.pointerSize = (gf_u32)sizeof(void *);
+	header.byteOrder = 0x01020304;
+	header.base = GF_SNAPSHOT_BASE;
+	header.nodeCount = nodeCount;
+	header.nodesOffset = (sizeof(header) + alignMask) & ~alignMask;
+	header.tokensOffset = header.nodesOffset + ((nodeCount * sizeof(gf_LoaderNode) + alignMask) & ~alignMask);
+	header.textOffset = header.tokensOffset + ((nodeCount * sizeof(gf_Token) + alignMask) & ~alignMask);
+	header.textSize = textSize;
+	header.size = header.textOffset + textSize;
+
+	if (!gf_SaverWrite(saver, file, (const char *)&header, sizeof(header))) return 0;
+	if (!gf_SaveSnapshotPadding(saver, file, sizeof(header), header.nodesOffset)) return 0;
+
+	gf_u64 nodesAddress = header.base + header.nodesOffset;
+	for (gf_u64 i = 0; i < nodeCount; i++) {
+		gf_LoaderNode node;
+		memset(&node, 0, sizeof(node));
+		node.token = (gf_Token *)(uintptr_t)(header.base + header.tokensOffset + i * sizeof(gf_Token));
+		node.parent = gf_SnapshotNodePointer(nodes[i]->parent, nodes, nodeSlots, mask, nodesAddress);
+		node.next = gf_SnapshotNodePointer(nodes[i]->next, nodes, nodeSlots, mask, nodesAddress);
+		node.prev = gf_SnapshotNodePointer(nodes[i]->prev, nodes, nodeSlots, mask, nodesAddress);
+		node.childrenHead = gf_SnapshotNodePointer(nodes[i]->childrenHead, nodes, nodeSlots, mask, nodesAddress);
+		node.childrenTail = gf_SnapshotNodePointer(nodes[i]->childrenTail, nodes, nodeSlots, mask, nodesAddress);
+		node.nextAllocated = gf_SnapshotNodePointer(nodes[i]->nextAllocated, nodes, nodeSlots, mask, nodesAddress);
+		if (!gf_SaverWrite(saver, file, (const char *)&node, sizeof(node))) return 0;
+	}
+	if (!gf_SaveSnapshotPadding(saver, file, header.nodesOffset + nodeCount * sizeof(gf_LoaderNode), header.tokensOffset)) return 0;
+
+	for (gf_u64 i = 0; i < nodeCount; i++) {
+		gf_Token token;
+		memset(&token, 0, sizeof(token));
+		token.start = (const char *)(uintptr_t)(header.base + header.textOffset + textOffsets[i]);
+		token.length = nodes[i]->token->length;
+		token.type = nodes[i]->token->type;
+		// The text is written without the pointer a decoded string keeps before it.
+		token.flags = nodes[i]->token->flags & ~(gf_u32)GF_TOKEN_FLAG_DECODED;
+		if (!gf_SaverWrite(saver, file, (const char *)&token, sizeof(token))) return 0;
+	}
+	if (!gf_SaveSnapshotPadding(saver, file, header.tokensOffset + nodeCount * sizeof(gf_Token), header.textOffset)) return 0;
+
+	// The text of a name that was seen before is not written again.
+	gf_u64 written = 0;
+	for (gf_u64 i = 0; i < nodeCount; i++) {
+		if (textOffsets[i] != written) {
+			continue;
+		}
+		const gf_Token *token = nodes[i]->token;
+		if (!gf_SaverWrite(saver, file, token->start, token->length)) return 0;
+		if (!gf_SaverWrite(saver, file, "", 1)) return 0;
+		written += token->length + 1;
+	}
+	return 1;
+}
+
+int gf_SaveSnapshot(gf_Saver *saver, FILE *file, gf_Loader *loader) {
+	return gf_SaveSnapshotOfFile(saver, file, loader, 0, 0, 0);
+}
+
+int gf_SaveSnapshotOfFile(gf_Saver *saver, FILE *file, gf_Loader *loader, gf_u64 sourceSize, gf_s64 sourceTime, gf_u64 sourceHash) {
+	assert(saver);
+	assert(file || saver->target != GF_SAVER_TARGET_FILE);
+	assert(loader);
+
+	if (!loader->rootNode) {
+		GF_LOG(saver, GF_LOG_ERROR, "Nothing is loaded to save as a snapshot");
+		return 0;
+	}
+
+	// The root is the first node the loader allocates, so every node can be reached from it through nextAllocated.
+	gf_u64 nodeCount = 0;
+	for (gf_LoaderNode *node = loader->rootNode; node; node = node->nextAllocated) {
+		nodeCount++;
+	}
+	gf_u64 capacity = 16;
+	while (capacity < nodeCount * 2) {
+		capacity *= 2;
+	}
+	gf_u64 mask = capacity - 1;
+
+	gf_u64 size = nodeCount * (sizeof(gf_LoaderNode *) + sizeof(gf_u64)) + capacity * 2 * sizeof(gf_u64);
+	char *memory = (char *)gf_Allocate(loader, size);
+	if (!memory) {
+		GF_LOG(saver, GF_LOG_ERROR, "Out of memory. Failed to allocate %" PRIu64 " bytes to number the nodes of the snapshot", size);
+		return 0;
+	}
+	memset(memory, 0, (size_t)size);
+	gf_LoaderNode **nodes = (gf_LoaderNode **)memory;
+	gf_u64 *textOffsets = (gf_u64 *)(memory + nodeCount * sizeof(gf_LoaderNode *));
+	gf_u64 *nodeSlots = textOffsets + nodeCount;
+	gf_u64 *nameSlots = nodeSlots + capacity;
+
+	gf_u64 textSize = 0;
+	gf_u64 index = 0;
+	for (gf_LoaderNode *node = loader->rootNode; node; node = node->nextAllocated, index++) {
+		nodes[index] = node;
+		*gf_FindSnapshotNodeSlot(node, nodes, nodeSlots, mask) = index + 1;
+
+		gf_TokenType type = node->token->type;
+		if (type == GF_TOKEN_TYPE_NAME || type == GF_TOKEN_TYPE_COMPOSITE_TYPE) {
+			gf_u64 *slot = gf_FindSnapshotNameSlot(node->token, nodes, nameSlots, mask);
+			if (*slot) {
+				textOffsets[index] = textOffsets[*slot - 1];
+				continue;
+			}
+			*slot = index + 1;
+		}
+		textOffsets[index] = textSize;
+		textSize += node->token->length + 1;
+	}
+
+	gf_SnapshotHeader header;
+	memset(&header, 0, sizeof(header));
+	header.sourceSize = sourceSize;
+	header.sourceTime = sourceTime;
+	header.sourceHash = sourceHash;
+
+	int result = gf_WriteSnapshot(saver, file, nodes, nodeCount, textOffsets, textSize, nodeSlots, mask, header);
+	gf_Free(loader, memory);
+	return result;
+}
+
+int gf_SnapshotLayoutMatches(const gf_SnapshotHeader *header) {
+	assert(header);
+
+	return memcmp(header->magic, "GFSNAP", 6) == 0 && header->magic[6] == GF_SNAPSHOT_VERSION &&
+		header->tokenSize == sizeof(gf_Token) && header->nodeSize == sizeof(gf_LoaderNode) &&
+		header->pointerSize == sizeof(void *) && header->byteOrder == 0x01020304;
+}
+
+/*
+Moves a node pointer of a snapshot from where the nodes are at its base address to nodes. Fails if it does not point at a node.
+It is only written to when it changes, so checking a snapshot at its base address does not copy its pages.
+*/
+int gf_RelocateNodePointer(gf_LoaderNode **pointer, gf_u64 nodesAddress, gf_LoaderNode *nodes, gf_u64 nodeCount) {
+	if (!*pointer) {
+		return 1;
+	}
+	gf_u64 offset = (gf_u64)(uintptr_t)*pointer - nodesAddress;
+	if (offset % sizeof(gf_LoaderNode) != 0 || offset / sizeof(gf_LoaderNode) >= nodeCount) {
+		return 0;
+	}
+	gf_LoaderNode *moved = nodes + offset / sizeof(gf_LoaderNode);
+	if (*pointer != moved) {
+		*pointer = moved;
+	}
+	return 1;
+}
+
+int gf_RelocateSnapshot(gf_Loader *loader, char *image, gf_u64 count, int check) {
+	assert(loader);
+	assert(image);
+
+	gf_SnapshotHeader header;
+	if (count < sizeof(header) || (uintptr_t)image % GF_ARENA_ALIGNMENT != 0) {
+		GF_LOG(loader, GF_LOG_ERROR, "The snapshot is smaller than its header or is not aligned to %d bytes", GF_ARENA_ALIGNMENT);
+		return 0;
+	}
+	memcpy(&header, image, sizeof(header));
+
+	if (!gf_SnapshotLayoutMatches(&header)) {
+		GF_LOG(loader, GF_LOG_ERROR, "The file is not a version %d snapshot or was made by a build with a different layout. Make it again from the .graph file", GF_SNAPSHOT_VERSION);
+		return 0;
+	}
+
+	gf_u64 nodeCount = header.nodeCount;
+	if (header.size > count || header.nodesOffset < sizeof(header) || header.nodesOffset % GF_ARENA_ALIGNMENT != 0 || header.tokensOffset % GF_ARENA_ALIGNMENT != 0 ||
+		nodeCount == 0 || header.tokensOffset > header.size || header.textOffset > header.size || header.textSize != header.size - header.textOffset ||
+		header.nodesOffset > header.tokensOffset || nodeCount > (header.tokensOffset - header.nodesOffset) / sizeof(gf_LoaderNode) ||
+		header.tokensOffset > header.textOffset || nodeCount > (header.textOffset - header.tokensOffset) / sizeof(gf_Token)) {
+		GF_LOG(loader, GF_LOG_ERROR, "The sections of the snapshot do not fit in its %" PRIu64 " bytes. The file is damaged", count);
+		return 0;
+	}
+
+	gf_LoaderNode *nodes = (gf_LoaderNode *)(void *)(image + header.nodesOffset);
+	gf_Token *tokens = (gf_Token *)(void *)(image + header.tokensOffset);
+	const char *text = image + header.textOffset;
+	gf_u64 nodesAddress = header.base + header.nodesOffset;
+
+	// Mapped at the address it was saved for, so every pointer is already right and the pages do not have to be touched.
+	// Unless the caller does not trust the file. Then it is read through, but a good file is still not written to.
+	int relocate = (gf_u64)(uintptr_t)image != header.base;
+
+	for (gf_u64 i = 0; i < nodeCount && (relocate || check); i++) {
+		gf_Token *token = &tokens[i];
+		gf_u64 offset = (gf_u64)(uintptr_t)token->start - (header.base + header.textOffset);
+		if (offset >= header.textSize || token->length >= header.textSize - offset) {
+			GF_LOG(loader, GF_LOG_ERROR, "The text of token %" PRIu64 " is outside of the snapshot. The file is damaged", i);
+			return 0;
+		}
+		if (token->start != text + offset) {
+			token->start = text + offset;
+		}
+		if (token->next) {
+			token->next = NULL;
+		}
+
+		gf_LoaderNode *node = &nodes[i];
+		if (node->token != token) {
+			node->token = token;
+		}
+		if (!gf_RelocateNodePointer(&node->parent, nodesAddress, nodes, nodeCount) || !gf_RelocateNodePointer(&node->next, nodesAddress, nodes, nodeCount) ||
+			!gf_RelocateNodePointer(&node->prev, nodesAddress, nodes, nodeCount) || !gf_RelocateNodePointer(&node->childrenHead, nodesAddress, nodes, nodeCount) ||
+			!gf_RelocateNodePointer(&node->childrenTail, nodesAddress, nodes, nodeCount) || !gf_RelocateNodePointer(&node->nextAllocated, nodesAddress, nodes, nodeCount)) {
+			GF_LOG(loader, GF_LOG_ERROR, "Node %" PRIu64 " points outside of the snapshot. The file is damaged", i);
+			return 0;
+		}
+	}
+
+	if (tokens[0].type != GF_TOKEN_TYPE_ROOT || nodes[0].parent) {
+		GF_LOG(loader, GF_LOG_ERROR, "The first node of the snapshot is not the root. The file is damaged");
+		return 0;
+	}
+
+	loader->rootNode = nodes;
+	loader->lastNode = &nodes[nodeCount - 1];
+	return 1;
+}
+
+int gf_LoadSnapshotFromBuffer(gf_Loader *loader, char *buffer, gf_u64 count, gf_LogAllocateFreeFunctions *funcs) {
+	assert(loader);
+	assert(buffer);
+
+	gf_InitLoader(loader, funcs);
+
+	return gf_RelocateSnapshot(loader, buffer, count, 0);
+}
+
+int gf_MapSnapshot(gf_Loader *loader, const char *filename, gf_LogAllocateFreeFunctions *funcs) {
+	assert(loader);
+	assert(filename);
+
+	gf_InitLoader(loader, funcs);
+
+	return gf_MapSnapshotFile(loader, filename, 0);
+}
+
+int gf_MapSnapshotFile(gf_Loader *loader, const char *filename, int check) {
+	assert(loader);
+	assert(filename);
+
+#ifdef GF_MMAP
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to map snapshot [%s]. It could not be opened", filename);
+		return 0;
+	}
+
+	struct stat info;
+	gf_SnapshotHeader header;
+	if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(header) || read(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to map snapshot [%s]. It is smaller than the header of a snapshot or could not be read", filename);
+		close(fd);
+		return 0;
+	}
+
+	// Private so relocating copies only the pages it writes to, and the file itself is never changed.
+	// The base address is only a hint. The mapping goes elsewhere if something is already there.
+	void *hint = (void *)(uintptr_t)header.base;
+	void *mapping = mmap(hint, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to map snapshot [%s]. mmap failed", filename);
+		return 0;
+	}
+	loader->mapping = mapping;
+	loader->mappingSize = (gf_u64)info.st_size;
+
+	return gf_RelocateSnapshot(loader, (char *)mapping, loader->mappingSize, check);
+#else
+	gf_u64 count = 0;
+	if (!gf_ReadFileIntoLoader(loader, filename, &count)) {
+		return 0;
+	}
+	return gf_RelocateSnapshot(loader, loader->fileContentsBuffer, count - 1, check);
+#endif
+}
+
+gf_u64 gf_HashBytes(const char *bytes, gf_u64 count) {
+	assert(bytes);
+
+	const gf_u64 k0 = 0x9E3779B97F4A7C15ULL;
+	const gf_u64 k1 = 0xBF58476D1CE4E5B9ULL;
+	gf_u64 hash = count * k0;
+	gf_u64 word;
+
+	gf_u64 i = 0;
+	for (; i + 8 <= count; i += 8) {
+		memcpy(&word, bytes + i, 8);
+		hash ^= word * k1;
+		hash = ((hash << 27) | (hash >> 37)) * k0;
+	}
+	if (i < count) {
+		word = 0;
+		memcpy(&word, bytes + i, (size_t)(count - i));
+		hash ^= word * k1;
+		hash = ((hash << 27) | (hash >> 37)) * k0;
+	}
+
+	hash ^= hash >> 31;
+	hash *= 0x94D049BB133111EBULL;
+	hash ^= hash >> 29;
+	return hash;
+}
+
+int gf_GetFileInfo(const char *filename, gf_u64 *size, gf_s64 *modified) {
+	assert(filename);
+	assert(size);
+	assert(modified);
+
+#ifdef GF_POSIX
+	struct stat info;
+	if (stat(filename, &info) != 0) {
+		return 0;
+	}
+	*size = (gf_u64)info.st_size;
+	*modified = (gf_s64)info.st_mtime;
+	return 1;
+#else
+	FILE *file = fopen(filename, "rb");
+	if (!file) {
+		return 0;
+	}
+	int result = gf_GetOpenFileSize(file, size);
+	*modified = 0;
+	fclose(file);
+	return result;
+#endif
+}
+
+int gf_WriteCache(gf_Loader *loader, const char *cacheFilename, gf_u64 sourceSize, gf_s64 sourceTime, gf_u64 sourceHash) {
+	assert(loader);
+	assert(cacheFilename);
+
+	gf_u64 capacity = gf_StringLength(cacheFilename) + 64;
+	char *temporaryFilename = (char *)gf_Allocate(loader, capacity);
+	if (!temporaryFilename) {
+		GF_LOG(loader, GF_LOG_WARNING, "Out of memory. The cache [%s] was not written", cacheFilename);
+		return 0;
+	}
+	// Each call writes its own temporary file, so two processes or two threads making the same cache do not write into one file.
+	// Calls that run at the same time in one process are on different loaders, so the address of the loader tells them apart.
+#ifdef GF_POSIX
+	snprintf(temporaryFilename, (size_t)capacity, "%s.%ld.%" PRIxPTR ".tmp", cacheFilename, (long)getpid(), (uintptr_t)loader);
+#else
+	snprintf(temporaryFilename, (size_t)capacity, "%s.%" PRIxPTR ".tmp", cacheFilename, (uintptr_t)loader);
+#endif
+
+	int result = 0;
+	FILE *file = fopen(temporaryFilename, "wb");
+	if (file) {
+		gf_Saver saver;
+		gf_InitSaver(&saver, loader->Log);
+		result = gf_SaveSnapshotOfFile(&saver, file, loader, sourceSize, sourceTime, sourceHash);
+		if (fclose(file) != 0) {
+			result = 0;
+		}
+	}
+	if (result && rename(temporaryFilename, cacheFilename) != 0) {
+		// rename() does not replace a file that exists everywhere.
+		remove(cacheFilename);
+		result = rename(temporaryFilename, cacheFilename) == 0;
+	}
+	if (!result) {
+		remove(temporaryFilename);
+		GF_LOG(loader, GF_LOG_WARNING, "The cache [%s] could not be written", cacheFilename);
+	}
+
+	gf_Free(loader, temporaryFilename);
+	return result;
+}
+
+/*
+Loads a file through its cache once gf_LoadFileWithCache() has named the cache.
+*/
+int gf_LoadThroughCache(gf_Loader *loader, const char *filename, const char *cacheFilename) {
+	gf_u64 size = 0;
+	gf_s64 modified = 0;
+	if (!gf_GetFileInfo(filename, &size, &modified)) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to load file [%s]. It could not be opened", filename);
+		return 0;
+	}
+	gf_s64 trustedTime = modified < (gf_s64)time(NULL) - 1 ? modified : 0;
+
+	gf_SnapshotHeader header;
+	int useCache = 0;
+	FILE *file = fopen(cacheFilename, "rb");
+	if (file) {
+		useCache = fread(&header, sizeof(header), 1, file) == 1 && gf_SnapshotLayoutMatches(&header) && header.sourceSize == size;
+		fclose(file);
+	}
+
+	gf_u64 bufferCount = 0;
+	int haveText = 0;
+	if (useCache && (header.sourceTime == 0 || header.sourceTime != modified)) {
+		// The time does not show the file is unchanged, so its contents are compared instead.
+		if (!gf_ReadFileIntoLoader(loader, filename, &bufferCount)) {
 			return 0;
 		}
+		haveText = 1;
+		useCache = gf_HashBytes(loader->fileContentsBuffer, bufferCount - 1) == header.sourceHash;
+	}
+
+	if (useCache) {
+		// The cache is mapped for every file that is loaded with the flag, so it is checked as if it was damaged.
+		if (gf_MapSnapshotFile(loader, cacheFilename, 1)) {
+			if (trustedTime != 0 && header.sourceTime != trustedTime) {
+				// The file was only touched. Saving its time lets the next load skip reading it.
+				gf_WriteCache(loader, cacheFilename, size, trustedTime, header.sourceHash);
+			}
+			return 1;
+		}
+		// Without mmap the snapshot was read over the text.
+		gf_ResetLoader(loader);
+		haveText = 0;
+	}
+
+	if (!haveText && !gf_ReadFileIntoLoader(loader, filename, &bufferCount)) {
+		return 0;
+	}
+	if (!gf_LoadInternal(loader, loader->fileContentsBuffer, bufferCount)) {
+		return 0;
+	}
+	gf_WriteCache(loader, cacheFilename, size, trustedTime, gf_HashBytes(loader->fileContentsBuffer, bufferCount - 1));
+	return 1;
+}
+
+int gf_LoadFileWithCache(gf_Loader *loader, const char *filename) {
+	assert(loader);
+	assert(filename);
+
+	gf_u64 length = gf_StringLength(filename);
+	char *cacheFilename = (char *)gf_Allocate(loader, length + 5);
+	if (!cacheFilename) {
+		GF_LOG(loader, GF_LOG_ERROR, "Out of memory. Failed to allocate the name of the cache of [%s]", filename);
+		return 0;
+	}
+	memcpy(cacheFilename, filename, (size_t)length);
+	memcpy(cacheFilename + length, ".gfs", 5);
+
+	int result = gf_LoadThroughCache(loader, filename, cacheFilename);
+	gf_Free(loader, cacheFilename);
+	return result;
+}
+
+/*
+Where the marker gf_ShareSnapshot() writes once the snapshot is complete goes, after the snapshot and the NULL terminator the saver adds.
+*/
+gf_u64 gf_SharedReadyOffset(gf_u64 snapshotSize) {
+	return (snapshotSize + 8) & ~(gf_u64)7;
+}
+
+int gf_ShareSnapshot(gf_Loader *loader, const char *name) {
+	assert(loader);
+	assert(name);
+
+#ifdef GF_SHM
+	gf_Saver saver;
+	gf_InitSaver(&saver, loader->Log);
+	gf_SaverBeginMeasure(&saver);
+	if (!gf_SaveSnapshot(&saver, NULL, loader)) {
+		return 0;
+	}
+	gf_u64 size = gf_SaverGetWrittenCount(&saver);
+	gf_u64 segmentSize = gf_SharedReadyOffset(size) + 8;
+
+	int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (fd < 0) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to share snapshot [%s]. The segment could not be made or already exists", name);
+		return 0;
+	}
+	if (ftruncate(fd, (off_t)segmentSize) != 0) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to share snapshot [%s]. The segment could not be made %" PRIu64 " bytes big", name, segmentSize);
+		close(fd);
+		shm_unlink(name);
+		return 0;
+	}
+	void *mapping = mmap(NULL, (size_t)segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to share snapshot [%s]. mmap failed", name);
+		shm_unlink(name);
+		return 0;
+	}
+
+	gf_SaverBeginMemory(&saver, (char *)mapping, size + 1);
+	int result = gf_SaveSnapshot(&saver, NULL, loader);
+	if (result) {
+#if defined(__GNUC__)
+		__sync_synchronize();
+#endif
+		memcpy((char *)mapping + gf_SharedReadyOffset(size), "GFREADY", 8);
+	}
+
+	munmap(mapping, (size_t)segmentSize);
+	if (!result) {
+		shm_unlink(name);
+	}
+	return result;
+#else
+	GF_LOG(loader, GF_LOG_ERROR, "Failed to share snapshot [%s]. Shared memory is not available in this build", name);
+	return 0;
+#endif
+}
+
+int gf_AttachSnapshot(gf_Loader *loader, const char *name, gf_LogAllocateFreeFunctions *funcs) {
+	assert(loader);
+	assert(name);
+
+	gf_InitLoader(loader, funcs);
+
+#ifdef GF_SHM
+	int fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to attach to snapshot [%s]. There is no such segment", name);
+		return 0;
 	}
-	else if (f == HUGE_VALF || f == -HUGE_VALF) {
+
+	struct stat info;
+	gf_SnapshotHeader header;
+	if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(header) || read(fd, &header, sizeof(header)) != (ssize_t)sizeof(header) ||
+		!gf_SnapshotLayoutMatches(&header) || header.size > (gf_u64)info.st_size || gf_SharedReadyOffset(header.size) + 8 > (gf_u64)info.st_size) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to attach to snapshot [%s]. It is not finished being shared or was made by a build with a different layout", name);
+		close(fd);
 		return 0;
 	}
-	*value = f;
-	return 1;
+	gf_u64 segmentSize = (gf_u64)info.st_size;
+
+	void *base = (void *)(uintptr_t)header.base;
+	void *mapping = mmap(base, (size_t)segmentSize, PROT_READ, MAP_SHARED, fd, 0);
+	if (mapping != MAP_FAILED && mapping != base) {
+		// A read only mapping can not be relocated, so this process gets a copy of the pages that relocating writes to.
+		munmap(mapping, (size_t)segmentSize);
+		mapping = mmap(NULL, (size_t)segmentSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	}
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to attach to snapshot [%s]. mmap failed", name);
+		return 0;
+	}
+	loader->mapping = mapping;
+	loader->mappingSize = segmentSize;
+	loader->readOnly = mapping == base;
+
+	if (memcmp((const char *)mapping + gf_SharedReadyOffset(header.size), "GFREADY", 8) != 0) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to attach to snapshot [%s]. It is not finished being shared", name);
+		return 0;
+	}
+	return gf_RelocateSnapshot(loader, (char *)mapping, header.size, 0);
+#else
+	GF_LOG(loader, GF_LOG_ERROR, "Failed to attach to snapshot [%s]. Shared memory is not available in this build", name);
+	return 0;
+#endif
+}
+
+int gf_UnshareSnapshot(const char *name) {
+	assert(name);
+
+#ifdef GF_SHM
+	return shm_unlink(name) == 0;
+#else
+	return 0;
+#endif
+}
+
+void gf_UnmapSnapshot(gf_Loader *loader) {
+	assert(loader);
+
+#ifdef GF_MMAP
+	if (loader->mapping) {
+		munmap(loader->mapping, (size_t)loader->mappingSize);
+	}
+#endif
+	loader->mapping = NULL;
+	loader->mappingSize = 0;
+	loader->readOnly = 0;
 }
 
 /*-----------------------------------------------------------------------------------*/
 
-/*-------------------------------------TOKENS----------------------------------------*/
+/*-------------------------------------INDEX-----------------------------------------*/
 
-void gf_PrintToken(gf_Token *token) {
-	assert(token);
+char *gf_MakeIndexFilename(gf_Loader *loader, const char *filename) {
+	assert(loader);
+	assert(filename);
 
-	for (gf_u64 i = 0; i < token->length; i++) {
-		printf("%c", token->start[i]);
+	gf_u64 length = gf_StringLength(filename);
+	char *indexFilename = (char *)gf_Allocate(loader, length + 5);
+	if (!indexFilename) {
+		GF_LOG(loader, GF_LOG_ERROR, "Out of memory. Failed to allocate the name of the index of [%s]", filename);
+		return NULL;
 	}
+	memcpy(indexFilename, filename, (size_t)length);
+	memcpy(indexFilename + length, ".gfi", 5);
+	return indexFilename;
 }
 
-void gf_PrintLineToken(gf_Token *token) {
-	assert(token);
+int gf_SaveIndexRecord(gf_Saver *saver, FILE *indexFile, gf_u64 offset, gf_u64 length, const char *name, gf_u64 nameLength) {
+	assert(saver);
+	assert(name);
 
-	gf_PrintToken(token);
-	printf("\n");
+	char entry[20];
+	gf_WriteU64LE(entry, offset);
+	gf_WriteU64LE(entry + 8, length);
+	gf_WriteU32LE(entry + 16, (gf_u32)nameLength);
+	return gf_SaverWrite(saver, indexFile, entry, sizeof(entry)) && gf_SaverWrite(saver, indexFile, name, nameLength);
 }
 
-const char *gf_TokenTypeToString(gf_TokenType type) {
-	switch (type) {
-	case GF_TOKEN_TYPE_ROOT: return "GF_TOKEN_TYPE_ROOT";
-	case GF_TOKEN_TYPE_NAME: return "GF_TOKEN_TYPE_NAME";
-	case GF_TOKEN_TYPE_CURLY_CLOSE: return "GF_TOKEN_TYPE_CURLY_CLOSE";
-	case GF_TOKEN_TYPE_COMMENT: return "GF_TOKEN_TYPE_COMMENT";
-	case GF_TOKEN_TYPE_COMPOSITE_TYPE: return "GF_TOKEN_TYPE_COMPOSITE_TYPE";
-	case GF_TOKEN_TYPE_STRING: return "GF_TOKEN_TYPE_STRING";
-	case GF_TOKEN_TYPE_FLOAT: return "GF_TOKEN_TYPE_FLOAT";
-	case GF_TOKEN_TYPE_INTEGER: return "GF_TOKEN_TYPE_INTEGER";
-	case GF_TOKEN_TYPE_END_FILE: return "GF_TOKEN_TYPE_END_FILE";
-	case GF_TOKEN_TYPE_VALUE_ASSIGN: return "GF_TOKEN_TYPE_VALUE_ASSIGN";
-	default: return "<unknown token type>";
+int gf_IndexBuffer(gf_Saver *saver, FILE *indexFile, const char *buffer, gf_u64 count) {
+	assert(saver);
+	assert(buffer);
+
+	if (gf_IsBinary(buffer, count)) {
+		GF_LOG(saver, GF_LOG_ERROR, "Failed to index a .gfb file. It already holds a table of its records");
+		return 0;
 	}
-}
 
-/*-----------------------------------------------------------------------------------*/
+	char header[GF_INDEX_HEADER_SIZE] = { 'G', 'F', 'I', GF_INDEX_VERSION, 0, 0, 0, 0 };
+	if (!gf_SaverWrite(saver, indexFile, header, sizeof(header))) return 0;
 
-/*-------------------------------------LOGGING----------------------------------------*/
+	gf_Tokeniser tokeniser;
+	gf_InitTokeniser(&tokeniser, buffer, count);
+	tokeniser.Log = saver->Log;
 
-void gf_DefaultLog(gf_LogLevel level, int lineno, gf_Token *token, const char *format, va_list vlist) {
-	switch (level) {
-	case GF_LOG_ERROR:   printf("[ERROR][%d]", lineno);   break;
-	case GF_LOG_WARNING: printf("[WARNING][%d]", lineno); break;
-	case GF_LOG_INFO:    printf("[INFO][%d]", lineno);    break;
+	gf_Token token;
+	gf_u64 depth = 0;
+	gf_u64 recordCount = 0;
+	const char *recordStart = NULL;
+	const char *recordEnd = NULL;
+	const char *name = "";
+	gf_u64 nameLength = 0;
+
+	while (1) {
+
+		if (!gf_NextToken(&tokeniser, &token)) {
+			return 0;
+		}
+
+		const char *start = token.start;
+		const char *end = token.start + token.length;
+
+		if (token.type == GF_TOKEN_TYPE_END_FILE) {
+			break;
+		}
+		else if (token.type == GF_TOKEN_TYPE_COMMENT) {
+			continue;
+		}
+		else if (token.type == GF_TOKEN_TYPE_VALUE_ASSIGN) {
+			depth++;
+			continue;
+		}
+		else if (token.type == GF_TOKEN_TYPE_CURLY_CLOSE) {
+			if (depth == 0) {
+				GF_LOG(saver, GF_LOG_ERROR, "Failed to index. There is a closing brace } without a matching open brace {");
+				return 0;
+			}
+			depth--;
+			if (depth == 0) {
+				recordEnd = end;
+			}
+			continue;
+		}
+		else if (depth > 0) {
+			continue;
+		}
+
+		// A token at the top level starts the next record, so the one before it is complete.
+		if (recordStart) {
+			if (!gf_SaveIndexRecord(saver, indexFile, (gf_u64)(recordStart - buffer), (gf_u64)(recordEnd - recordStart), name, nameLength)) return 0;
+			recordCount++;
+		}
+
+		name = "";
+		nameLength = 0;
+		if (token.type == GF_TOKEN_TYPE_NAME) {
+			name = token.start;
+			nameLength = token.length;
+		}
+		else if (token.type == GF_TOKEN_TYPE_STRING) {
+			// The token does not span the quotes.
+			start--;
+			end++;
+		}
+		recordStart = start;
+		recordEnd = end;
 	}
-	if (token) {
-		printf("[\"");
-		gf_PrintToken(token);
-		printf("\"]");
-		printf("[lineno: %" PRIu64 "]", token->lineno);
-		printf("[colno: %" PRIu64 "]", token->colno);
+
+	if (depth != 0) {
+		GF_LOG(saver, GF_LOG_ERROR, "Failed to index. There is a missing closing brace }");
+		return 0;
 	}
-	printf(": ");
-	vprintf(format, vlist);
-	printf("\n");
+	if (recordStart) {
+		if (!gf_SaveIndexRecord(saver, indexFile, (gf_u64)(recordStart - buffer), (gf_u64)(recordEnd - recordStart), name, nameLength)) return 0;
+		recordCount++;
+	}
+
+	char footer[GF_INDEX_FOOTER_SIZE];
+	gf_WriteU64LE(footer, recordCount);
+	gf_WriteU64LE(footer + 8, count);
+	return gf_SaverWrite(saver, indexFile, footer, sizeof(footer));
 }
 
-void gf_Log(gf_LogFunctionPtr Log, gf_LogLevel level, int lineno, gf_Token *token, const char *format, ...) {
-	va_list args;
-	va_start(args, format);
-	Log(level, lineno, token, format, args);
-	va_end(args);
-};
+int gf_IndexFile(const char *filename, gf_LogAllocateFreeFunctions *funcs) {
+	assert(filename);
 
-/*-----------------------------------------------------------------------------------*/
+	gf_Loader loader;
+	gf_InitLoader(&loader, funcs);
 
-/*-------------------------------------SAVER----------------------------------------*/
+	gf_u64 bufferCount = 0;
+	char *indexFilename = NULL;
+	if (!gf_ReadFileIntoLoader(&loader, filename, &bufferCount) || !(indexFilename = gf_MakeIndexFilename(&loader, filename))) {
+		gf_Unload(&loader);
+		return 0;
+	}
 
-void gf_InitSaver(gf_Saver *saver, gf_LogFunctionPtr logfunction) {
+	int result = 0;
+	FILE *file = fopen(indexFilename, "wb");
+	if (!file) {
+		GF_LOG((&loader), GF_LOG_ERROR, "Failed to open %s to write to", indexFilename);
+	}
+	else {
+		gf_Saver saver;
+		gf_InitSaver(&saver, loader.Log);
+		result = gf_IndexBuffer(&saver, file, loader.fileContentsBuffer, bufferCount - 1);
+		if (fclose(file) != 0) {
+			result = 0;
+		}
+		if (!result) {
+			remove(indexFilename);
+		}
+	}
+
+	gf_Free(&loader, indexFilename);
+	gf_Unload(&loader);
+	return result;
+}
+
+int gf_SaveIndexed(gf_Saver *saver, FILE *file, FILE *indexFile, gf_LoaderNode *node) {
 	assert(saver);
+	assert(file || saver->target != GF_SAVER_TARGET_FILE);
+	assert(indexFile);
 
-	saver->indent = 0;
-	if (logfunction == NULL) {
-		saver->Log = gf_DefaultLog;
+	if (!node) {
+		GF_LOG(saver, GF_LOG_ERROR, "node is null in gf_SaveIndexed");
+		return 0;
+	}
+
+	gf_Saver indexSaver;
+	gf_InitSaver(&indexSaver, saver->Log);
+
+	char header[GF_INDEX_HEADER_SIZE] = { 'G', 'F', 'I', GF_INDEX_VERSION, 0, 0, 0, 0 };
+	if (!gf_SaverWrite(&indexSaver, indexFile, header, sizeof(header))) return 0;
+
+	gf_LoaderNode *top = node;
+	if (node->token->type == GF_TOKEN_TYPE_ROOT) {
+		top = node->childrenHead;
+	}
+	int savingSiblings = top != node;
+
+	gf_u64 recordCount = 0;
+	for (gf_LoaderNode *record = top; record; record = savingSiblings ? record->next : NULL) {
+		gf_u64 offset = gf_SaverGetWrittenCount(saver);
+		if (!gf_SaveNode(saver, file, record)) return 0;
+
+		gf_Token *token = record->token;
+		int named = token->type == GF_TOKEN_TYPE_NAME || token->type == GF_TOKEN_TYPE_COMPOSITE_TYPE;
+		if (!gf_SaveIndexRecord(&indexSaver, indexFile, offset, gf_SaverGetWrittenCount(saver) - offset, named ? token->start : "", named ? token->length : 0)) return 0;
+		recordCount++;
 	}
+
+	char footer[GF_INDEX_FOOTER_SIZE];
+	gf_WriteU64LE(footer, recordCount);
+	gf_WriteU64LE(footer + 8, gf_SaverGetWrittenCount(saver));
+	return gf_SaverWrite(&indexSaver, indexFile, footer, sizeof(footer));
 }
 
-int gf_PrintIndent(gf_Saver *saver, FILE *file) {
-	assert(saver);
-	assert(file);
+int gf_OpenIndex(gf_Index *index, const char *filename, gf_LogAllocateFreeFunctions *funcs) {
+	assert(index);
+	assert(filename);
 
-	int result = 0;
-	for (unsigned int i = 0; i < saver->indent; i++) {
-		result = fprintf(file, "  ");
-		if (result < 0) {
-			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_PrintIndent", result);
-			return 0;
+	gf_Loader *storage = &index->storage;
+	gf_InitLoader(storage, funcs);
+	index->filename = NULL;
+	index->records = NULL;
+	index->recordCount = 0;
+	index->slots = NULL;
+	index->slotMask = 0;
+
+	gf_u64 length = gf_StringLength(filename);
+	index->filename = (char *)gf_ArenaAllocate(storage, length + 1);
+	char *indexFilename = gf_MakeIndexFilename(storage, filename);
+	if (!index->filename || !indexFilename) {
+		gf_Free(storage, indexFilename);
+		return 0;
+	}
+	memcpy(index->filename, filename, (size_t)(length + 1));
+
+	gf_u64 bufferCount = 0;
+	int result = gf_ReadFileIntoLoader(storage, indexFilename, &bufferCount);
+	gf_Free(storage, indexFilename);
+	if (!result) {
+		return 0;
+	}
+
+	const char *buffer = storage->fileContentsBuffer;
+	gf_u64 size = bufferCount - 1;
+	if (size < GF_INDEX_HEADER_SIZE + GF_INDEX_FOOTER_SIZE || buffer[0] != 'G' || buffer[1] != 'F' || buffer[2] != 'I' || buffer[3] != GF_INDEX_VERSION) {
+		GF_LOG(storage, GF_LOG_ERROR, "The index of [%s] is not a .gfi file of this version", filename);
+		return 0;
+	}
+
+	const char *end = buffer + size - GF_INDEX_FOOTER_SIZE;
+	gf_u64 recordCount = gf_ReadU64LE(end);
+	gf_u64 indexedSize = gf_ReadU64LE(end + 8);
+
+	gf_u64 fileSize = 0;
+	gf_s64 modified = 0;
+	if (!gf_GetFileInfo(filename, &fileSize, &modified) || fileSize != indexedSize) {
+		GF_LOG(storage, GF_LOG_ERROR, "The index of [%s] is out of date. Index the file again", filename);
+		return 0;
+	}
+	// Every record takes atleast 20 bytes, which stops a damaged count from allocating too much.
+	if (recordCount > (size - GF_INDEX_HEADER_SIZE - GF_INDEX_FOOTER_SIZE) / 20) {
+		GF_LOG(storage, GF_LOG_ERROR, "The index of [%s] is damaged", filename);
+		return 0;
+	}
+
+	gf_u64 slotCount = 1;
+	while (slotCount < recordCount * 2) {
+		slotCount *= 2;
+	}
+	index->records = (gf_IndexRecord *)gf_ArenaAllocate(storage, (recordCount + 1) * sizeof(gf_IndexRecord));
+	index->slots = (gf_u64 *)gf_ArenaAllocate(storage, slotCount * sizeof(gf_u64));
+	if (!index->records || !index->slots) {
+		GF_LOG(storage, GF_LOG_ERROR, "Out of memory. Failed to allocate the index of [%s]", filename);
+		return 0;
+	}
+	memset(index->slots, 0, (size_t)(slotCount * sizeof(gf_u64)));
+	index->slotMask = slotCount - 1;
+
+	const char *p = buffer + GF_INDEX_HEADER_SIZE;
+	for (gf_u64 i = 0; i < recordCount; i++) {
+		gf_IndexRecord *record = &index->records[i];
+		if (end - p < 20) {
+			break;
+		}
+		record->offset = gf_ReadU64LE(p);
+		record->length = gf_ReadU64LE(p + 8);
+		record->nameLength = gf_ReadU32LE(p + 16);
+		record->name = p + 20;
+		p += 20;
+		if ((gf_u64)(end - p) < record->nameLength || record->offset > indexedSize || record->length > indexedSize - record->offset) {
+			break;
+		}
+		p += record->nameLength;
+
+		// Records that share a name are found in the order they were added, which is the order they are in the file.
+		gf_u64 slot = gf_HashBytes(record->name, record->nameLength) & index->slotMask;
+		while (index->slots[slot]) {
+			slot = (slot + 1) & index->slotMask;
 		}
+		index->slots[slot] = i + 1;
+		index->recordCount++;
+	}
+
+	if (index->recordCount != recordCount || p != end) {
+		GF_LOG(storage, GF_LOG_ERROR, "The index of [%s] is damaged", filename);
+		return 0;
 	}
 	return 1;
 }
 
-int gf_SaveVariableS64(gf_Saver *saver, FILE *file, const char *identifier, gf_s64 *value) {
-	assert(saver);
-	assert(file);
-	assert(identifier);
-	assert(value);
+void gf_CloseIndex(gf_Index *index) {
+	assert(index);
 
-	int result = 0;
+	gf_Unload(&index->storage);
+	index->filename = NULL;
+	index->records = NULL;
+	index->recordCount = 0;
+	index->slots = NULL;
+	index->slotMask = 0;
+}
 
-	result = gf_PrintIndent(saver, file);
-	if (!result) { return 0; }
+int gf_FindRecord(gf_Index *index, const char *name, gf_u64 occurrence, gf_u64 *ordinal) {
+	assert(index);
+	assert(name);
+	assert(ordinal);
 
-	result = fprintf(file, "%s { %" PRIi64 " }\n", identifier, *value);
-	if (result < 0) {
-		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableS64", result);
+	if (!index->slots) {
 		return 0;
 	}
-	return 1;
+
+	gf_u64 length = gf_StringLength(name);
+	for (gf_u64 slot = gf_HashBytes(name, length) & index->slotMask; index->slots[slot]; slot = (slot + 1) & index->slotMask) {
+		gf_IndexRecord *record = &index->records[index->slots[slot] - 1];
+		if (gf_AreStringSpansEqual(record->name, record->nameLength, name, length)) {
+			if (occurrence == 0) {
+				*ordinal = index->slots[slot] - 1;
+				return 1;
+			}
+			occurrence--;
+		}
+	}
+	return 0;
 }
 
-int gf_SaveVariableS32(gf_Saver *saver, FILE *file, const char *identifier, gf_s32 *value) {
-	assert(saver);
-	assert(file);
-	assert(identifier);
-	assert(value);
+int gf_LoadRecords(gf_Loader *loader, gf_Index *index, const gf_u64 *ordinals, gf_u64 count, gf_LogAllocateFreeFunctions *funcs) {
+	assert(loader);
+	assert(index);
+	assert(ordinals || count == 0);
 
-	int result = 0;
+	gf_InitLoader(loader, funcs);
 
-	result = gf_PrintIndent(saver, file);
-	if (!result) { return 0; }
+	// Each record is followed by a newline, and the text by a NULL terminator.
+	gf_u64 bufferCount = 1;
+	for (gf_u64 i = 0; i < count; i++) {
+		if (ordinals[i] >= index->recordCount) {
+			GF_LOG(loader, GF_LOG_ERROR, "Failed to load record %" PRIu64 " of [%s]. It only has %" PRIu64 " records", ordinals[i], index->filename, index->recordCount);
+			return 0;
+		}
+		bufferCount += index->records[ordinals[i]].length + 1;
+	}
 
-	result = fprintf(file, "%s { %" PRIi32 " }\n", identifier, *value);
-	if (result < 0) {
-		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableS32", result);
+	loader->fileContentsBuffer = (char *)gf_Allocate(loader, bufferCount);
+	if (!loader->fileContentsBuffer) {
+		GF_LOG(loader, GF_LOG_ERROR, "Out of memory. Failed to allocate buffer for the records of [%s]", index->filename);
 		return 0;
 	}
-	return 1;
+	loader->fileContentsCapacity = bufferCount;
+
+	FILE *file = fopen(index->filename, "rb");
+	if (!file) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to load file [%s]. It could not be opened", index->filename);
+		return 0;
+	}
+
+	char *p = loader->fileContentsBuffer;
+	for (gf_u64 i = 0; i < count; i++) {
+		gf_IndexRecord *record = &index->records[ordinals[i]];
+		if (record->offset > (gf_u64)INT64_MAX || !gf_SeekFile(file, (gf_s64)record->offset, SEEK_SET) || fread(p, 1, (size_t)record->length, file) != record->length) {
+			GF_LOG(loader, GF_LOG_ERROR, "Failed to read record %" PRIu64 " of [%s]", ordinals[i], index->filename);
+			fclose(file);
+			return 0;
+		}
+		if (record->length < record->nameLength || memcmp(p, record->name, (size_t)record->nameLength) != 0) {
+			GF_LOG(loader, GF_LOG_ERROR, "Record %" PRIu64 " of [%s] is not where the index says. The index is out of date", ordinals[i], index->filename);
+			fclose(file);
+			return 0;
+		}
+		p += record->length;
+		*p++ = '\n';
+	}
+	*p = '\0';
+	fclose(file);
+
+	return gf_LoadInternal(loader, loader->fileContentsBuffer, bufferCount);
 }
 
-int gf_SaveVariableU32(gf_Saver *saver, FILE *file, const char *identifier, gf_u32 *value) {
+int gf_LoadRecord(gf_Loader *loader, gf_Index *index, const char *name, gf_LogAllocateFreeFunctions *funcs) {
+	assert(loader);
+	assert(index);
+	assert(name);
+
+	gf_u64 ordinal = 0;
+	if (!gf_FindRecord(index, name, 0, &ordinal)) {
+		gf_InitLoader(loader, funcs);
+		GF_LOG(loader, GF_LOG_ERROR, "There is no record named [%s] in the index of [%s]", name, index->filename);
+		return 0;
+	}
+	return gf_LoadRecords(loader, index, &ordinal, 1, funcs);
+}
+
+/*-----------------------------------------------------------------------------------*/
+
+/*-----------------------------------RECORD LOG--------------------------------------*/
+
+int gf_AppendRecords(gf_Saver *saver, FILE *file, FILE *indexFile, gf_LoaderNode *node) {
 	assert(saver);
 	assert(file);
-	assert(identifier);
-	assert(value);
+	assert(saver->target == GF_SAVER_TARGET_FILE);
 
-	int result = 0;
-
-	result = gf_PrintIndent(saver, file);
-	if (!result) { return 0; }
+	if (!node) {
+		GF_LOG(saver, GF_LOG_ERROR, "node is null in gf_AppendRecords");
+		return 0;
+	}
 
-	result = fprintf(file, "%s { %" PRIu32 " }\n", identifier, *value);
-	if (result < 0) {
-		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableU32", result);
+	gf_u64 fileSize = 0;
+	if (!gf_SeekFile(file, 0, SEEK_END) || !gf_TellFile(file, &fileSize)) {
+		GF_LOG(saver, GF_LOG_ERROR, "Failed to find the end of the file to append to");
 		return 0;
 	}
-	return 1;
-}
 
+	// A record can not start on the line of a name or value it would join => "flag" + "units { }"
+	int needsNewline = 0;
+	if (fileSize > 0) {
+		int last = EOF;
+		if (gf_SeekFile(file, -1, SEEK_END)) {
+			last = fgetc(file);
+		}
+		needsNewline = last != '\n' && last != '\r';
+		if (!gf_SeekFile(file, 0, SEEK_END)) {
+			GF_LOG(saver, GF_LOG_ERROR, "Failed to find the end of the file to append to");
+			return 0;
+		}
+	}
+
+	gf_u64 recordCount = 0;
+	gf_Saver indexSaver;
+	gf_InitSaver(&indexSaver, saver->Log);
+	if (indexFile) {
+		gf_u64 indexSize = 0;
+		if (!gf_SeekFile(indexFile, 0, SEEK_END) || !gf_TellFile(indexFile, &indexSize)) {
+			GF_LOG(saver, GF_LOG_ERROR, "Failed to append. The end of the index could not be found");
+			return 0;
+		}
+		char header[GF_INDEX_HEADER_SIZE] = { 'G', 'F', 'I', GF_INDEX_VERSION, 0, 0, 0, 0 };
+
+		if (indexSize == 0) {
+			if (fileSize != 0) {
+				GF_LOG(saver, GF_LOG_ERROR, "Failed to append. The index is empty but the file is not. Index the file with gf_IndexFile first");
+				return 0;
+			}
+			if (!gf_SeekFile(indexFile, 0, SEEK_SET) || !gf_SaverWrite(&indexSaver, indexFile, header, sizeof(header))) return 0;
+		}
+		else {
+			char existing[GF_INDEX_HEADER_SIZE];
+			char footer[GF_INDEX_FOOTER_SIZE];
+			if (indexSize < GF_INDEX_HEADER_SIZE + GF_INDEX_FOOTER_SIZE ||
+				!gf_SeekFile(indexFile, 0, SEEK_SET) || fread(existing, sizeof(existing), 1, indexFile) != 1 || memcmp(existing, header, sizeof(header)) != 0 ||
+				!gf_SeekFile(indexFile, (gf_s64)(indexSize - GF_INDEX_FOOTER_SIZE), SEEK_SET) || fread(footer, sizeof(footer), 1, indexFile) != 1) {
+				GF_LOG(saver, GF_LOG_ERROR, "Failed to append. The index is not a .gfi file of this version");
+				return 0;
+			}
+			if (gf_ReadU64LE(footer + 8) != fileSize) {
+				GF_LOG(saver, GF_LOG_ERROR, "Failed to append. The index is out of date with the file");
+				return 0;
+			}
+			recordCount = gf_ReadU64LE(footer);
+			// The new records go over the footer, and a new footer is written after them.
+			if (!gf_SeekFile(indexFile, (gf_s64)(indexSize - GF_INDEX_FOOTER_SIZE), SEEK_SET)) {
+				GF_LOG(saver, GF_LOG_ERROR, "Failed to append. The footer of the index could not be found");
+				return 0;
+			}
+		}
+	}
+
+	gf_u64 start = gf_SaverGetWrittenCount(saver);
+	if (needsNewline && !gf_SaverWrite(saver, file, "\n", 1)) return 0;
 
-int gf_SaveVariableU64(gf_Saver *saver, FILE *file, const char *identifier, gf_u64 *value) {
-	assert(saver);
-	assert(file);
-	assert(identifier);
-	assert(value);
+	gf_LoaderNode *top = node;
+	if (node->token->type == GF_TOKEN_TYPE_ROOT) {
+		top = node->childrenHead;
+	}
+	int savingSiblings = top != node;
 
-	int result = 0;
+	for (gf_LoaderNode *record = top; record; record = savingSiblings ? record->next : NULL) {
+		gf_u64 offset = fileSize + gf_SaverGetWrittenCount(saver) - start;
+		if (!gf_SaveNode(saver, file, record)) return 0;
 
-	result = gf_PrintIndent(saver, file);
-	if (!result) { return 0; }
+		if (indexFile) {
+			gf_Token *token = record->token;
+			int named = token->type == GF_TOKEN_TYPE_NAME || token->type == GF_TOKEN_TYPE_COMPOSITE_TYPE;
+			gf_u64 length = fileSize + gf_SaverGetWrittenCount(saver) - start - offset;
+			if (!gf_SaveIndexRecord(&indexSaver, indexFile, offset, length, named ? token->start : "", named ? token->length : 0)) return 0;
+		}
+		recordCount++;
+	}
 
-	result = fprintf(file, "%s { %" PRIu64 " }\n", identifier, *value);
-	if (result < 0) {
-		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableU64", result);
+	if (fflush(file) != 0) {
+		GF_LOG(saver, GF_LOG_ERROR, "Failed to flush the records that were appended");
 		return 0;
 	}
+
+	if (indexFile) {
+		char footer[GF_INDEX_FOOTER_SIZE];
+		gf_WriteU64LE(footer, recordCount);
+		gf_WriteU64LE(footer + 8, fileSize + gf_SaverGetWrittenCount(saver) - start);
+		if (!gf_SaverWrite(&indexSaver, indexFile, footer, sizeof(footer))) return 0;
+		if (fflush(indexFile) != 0) {
+			GF_LOG(saver, GF_LOG_ERROR, "Failed to flush the index of the records that were appended");
+			return 0;
+		}
+	}
 	return 1;
 }
 
-int gf_SaveVariableString(gf_Saver *saver, FILE *file, const char *identifier, const char *str) {
-	assert(saver);
-	assert(file);
-	assert(identifier);
-	assert(str);
-
-	int result = 0;
-
-	result = gf_PrintIndent(saver, file);
-	if (!result) { return 0; }
+int gf_OpenRecords(gf_RecordReader *reader, const char *filename, int tail, gf_LogAllocateFreeFunctions *funcs) {
+	assert(reader);
+	assert(filename);
 
-	result = fprintf(file, "%s { \"%s\" }\n", identifier, str);
-	if (result < 0) {
-		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableString", result);
+	gf_InitLoader(&reader->loader, funcs);
+	reader->tail = tail;
+	reader->start = 0;
+	reader->end = 0;
+	reader->offset = 0;
+	reader->recordOffset = 0;
+	reader->readSize = GF_RECORD_READ_SIZE;
+	reader->maxRecordSize = GF_DEFAULT_MAX_RECORD_SIZE;
+
+	reader->file = fopen(filename, "rb");
+	if (!reader->file) {
+		GF_LOG((&reader->loader), GF_LOG_ERROR, "Failed to load file [%s]. It could not be opened", filename);
 		return 0;
 	}
 	return 1;
 }
 
-int gf_SaveVariableF32(gf_Saver *saver, FILE *file, const char *identifier, gf_f32 *value) {
-	assert(saver);
-	assert(file);
-	assert(identifier);
-	assert(value);
-
-	int result = 0;
-
-	result = gf_PrintIndent(saver, file);
-	if (!result) { return 0; }
+int gf_FindNextRecord(gf_RecordReader *reader, int final, gf_u64 *recordStart, gf_u64 *recordEnd) {
+	assert(reader);
+	assert(recordStart);
+	assert(recordEnd);
 
-	result = fprintf(file, "%s { %f }\n", identifier, *value);
-	if (result < 0) {
-		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableF32", result);
+	const char *buffer = reader->loader.fileContentsBuffer;
+	if (!buffer) {
 		return 0;
 	}
 
-	return 1;
-}
+	gf_Tokeniser tokeniser;
+	gf_InitTokeniser(&tokeniser, buffer + reader->start, reader->end - reader->start);
+	// A string or comment that does not end yet may end once more is read, so errors are only logged once nothing more will be.
+	tokeniser.Log = gf_NoLog;
 
-int gf_SaveVariableF64(gf_Saver *saver, FILE *file, const char *identifier, gf_f64 *value) {
-	assert(saver);
-	assert(file);
-	assert(identifier);
-	assert(value);
+	gf_Token token;
+	gf_u64 depth = 0;
+	const char *first = NULL;
+	const char *last = NULL;
 
-	int result = 0;
+	while (1) {
 
-	result = gf_PrintIndent(saver, file);
-	if (!result) { return 0; }
+		if (!gf_NextToken(&tokeniser, &token)) {
+			if (final) {
+				GF_LOG((&reader->loader), GF_LOG_ERROR, "Failed to read the record at offset %" PRIu64 ". %s", reader->offset + reader->start, tokeniser.error);
+				return -1;
+			}
+			return 0;
+		}
 
-	result = fprintf(file, "%s { %lf }\n", identifier, *value);
-	if (result < 0) {
-		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableF64", result);
-		return 0;
-	}
+		const char *start = token.start;
+		const char *end = token.start + token.length;
 
-	return 1;
-}
+		if (token.type == GF_TOKEN_TYPE_END_FILE) {
+			break;
+		}
+		else if (token.type == GF_TOKEN_TYPE_COMMENT) {
+			continue;
+		}
+		else if (token.type == GF_TOKEN_TYPE_STRING) {
+			start--;
+			end++;
+		}
 
-int gf_SaveVariableStringSpan(gf_Saver *saver, FILE *file, const char *identifier, const char *str, int strLen) {
-	assert(saver);
-	assert(file);
-	assert(identifier);
-	assert(str);
+		// Anything but a list at the top level starts the next record, so the one before it is complete.
+		if (depth == 0 && first && token.type != GF_TOKEN_TYPE_VALUE_ASSIGN) {
+			break;
+		}
 
-	int result = 0;
+		if (token.type == GF_TOKEN_TYPE_VALUE_ASSIGN) {
+			depth++;
+		}
+		else if (token.type == GF_TOKEN_TYPE_CURLY_CLOSE) {
+			if (depth == 0) {
+				GF_LOG((&reader->loader), GF_LOG_ERROR, "Failed to read the record at offset %" PRIu64 ". There is a closing brace } without a matching open brace {", reader->offset + (gf_u64)(start - buffer));
+				return -1;
+			}
+			depth--;
+			if (depth == 0) {
+				last = end;
+				break;
+			}
+			continue;
+		}
 
-	result = gf_PrintIndent(saver, file);
-	if (!result) { return 0; }
+		if (!first) {
+			first = start;
+		}
+		last = end;
+	}
 
-	result = fprintf(file, "%s { \"", identifier);
-	if (result < 0) {
-		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableStringSpan", result);
+	if (!first) {
 		return 0;
 	}
-
-	for (int i = 0; i < strLen; i++) {
-		result = fprintf(file, "%c", str[i]);
-		if (result < 0) {
-			GF_LOG(saver, GF_LOG_ERROR, "fputc failed with value [%d] in gf_SaveVariableStringSpan", result);
-			return 0;
+	if (depth > 0 || (token.type == GF_TOKEN_TYPE_END_FILE && !final)) {
+		if (final) {
+			GF_LOG((&reader->loader), GF_LOG_ERROR, "Failed to read the record at offset %" PRIu64 ". The file ends before it does", reader->offset + (gf_u64)(first - buffer));
+			return -1;
 		}
-	}
-	result = fprintf(file, "\" }\n");
-	if (result < 0) {
-		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableStringSpan", result);
 		return 0;
 	}
 
+	*recordStart = (gf_u64)(first - buffer);
+	*recordEnd = (gf_u64)(last - buffer);
 	return 1;
 }
 
-int gf_SaveVariableVec3(gf_Saver *saver, FILE *file, const char *identifier, gf_f32 *x, gf_f32 *y, gf_f32 *z) {
-	assert(saver);
-	assert(file);
-	assert(identifier);
-	assert(x && y && z);
+int gf_ReadMoreRecords(gf_RecordReader *reader, gf_u64 *readCount) {
+	assert(reader);
+	assert(readCount);
 
-	int result = 0;
+	gf_Loader *loader = &reader->loader;
+	*readCount = 0;
 
-	result = gf_PrintIndent(saver, file);
-	if (!result) { return 0; }
+	if (reader->start > 0) {
+		memmove(loader->fileContentsBuffer, loader->fileContentsBuffer + reader->start, (size_t)(reader->end - reader->start));
+		reader->offset += reader->start;
+		reader->end -= reader->start;
+		reader->start = 0;
+	}
 
-	result = fprintf(file, "%s { %f, %f, %f }\n", identifier, *x, *y, *z);
-	if (result < 0) {
-		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveVariableVec3", result);
-		return 0;
+	// One byte is always kept free for the NULL terminator of the record that is parsed.
+	gf_u64 wanted = reader->end + reader->readSize + 1;
+	if (wanted > loader->fileContentsCapacity) {
+		if (reader->end >= reader->maxRecordSize) {
+			GF_LOG(loader, GF_LOG_ERROR, "Failed to read the record at offset %" PRIu64 ". It is bigger than the maximum of %" PRIu64 " bytes", reader->offset, reader->maxRecordSize);
+			return 0;
+		}
+		gf_u64 capacity = loader->fileContentsCapacity * 2 > wanted ? loader->fileContentsCapacity * 2 : wanted;
+		char *buffer = (char *)gf_Reallocate(loader, loader->fileContentsBuffer, loader->fileContentsCapacity, capacity);
+		if (!buffer) {
+			GF_LOG(loader, GF_LOG_ERROR, "Out of memory. Failed to grow the buffer of the records to %" PRIu64 " bytes", capacity);
+			return 0;
+		}
+		loader->fileContentsBuffer = buffer;
+		loader->fileContentsCapacity = capacity;
 	}
 
+	gf_u64 space = loader->fileContentsCapacity - 1 - reader->end;
+	*readCount = (gf_u64)fread(loader->fileContentsBuffer + reader->end, 1, (size_t)space, reader->file);
+	reader->end += *readCount;
+	if (*readCount < space) {
+		// The end of a file that is tailed moves, so it is read from again next time.
+		clearerr(reader->file);
+	}
 	return 1;
 }
 
-int gf_SaveArrayU64(gf_Saver *saver, FILE *file, const char *identifier, gf_u64 *value, int count) {
-	int result = 0;
+gf_RecordStatus gf_NextRecord(gf_RecordReader *reader) {
+	assert(reader);
+	assert(reader->file);
 
-	result = gf_PrintIndent(saver, file);
-	if (!result) { return 0; }
+	gf_Loader *loader = &reader->loader;
+	gf_u64 recordStart = 0;
+	gf_u64 recordEnd = 0;
+	int atEnd = 0;
 
-	if (count) {
-		result = fprintf(file, "%s { ", identifier);
-		if (result < 0) {
-			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayU64", result);
-			return 0;
+	while (1) {
+		int found = gf_FindNextRecord(reader, atEnd && !reader->tail, &recordStart, &recordEnd);
+		if (found < 0) {
+			return GF_RECORD_ERROR;
 		}
-		result = fprintf(file, "%" PRIu64, value[0]);
-		if (result < 0) {
-			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayU64", result);
-			return 0;
+		if (found) {
+			break;
 		}
-		for (int i = 1; i < count; i++) {
-			result = fprintf(file, ", %" PRIi64, value[i]);
-			if (result < 0) {
-				GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayU64", result);
-				return 0;
-			}
+		if (atEnd) {
+			return GF_RECORD_END;
 		}
-		result = fprintf(file, " }\n");
-		if (result < 0) {
-			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayU64", result);
-			return 0;
+
+		gf_u64 readCount = 0;
+		if (!gf_ReadMoreRecords(reader, &readCount)) {
+			return GF_RECORD_ERROR;
 		}
+		atEnd = readCount == 0;
 	}
 
-	return 1;
+	// The byte after the record is put back once it is parsed. The tokens only point at the record.
+	char *buffer = loader->fileContentsBuffer;
+	char after = buffer[recordEnd];
+	buffer[recordEnd] = '\0';
+	gf_ResetLoader(loader);
+	int result = gf_LoadInternal(loader, buffer + recordStart, recordEnd - recordStart + 1);
+	buffer[recordEnd] = after;
+
+	reader->recordOffset = reader->offset + recordStart;
+	reader->start = recordEnd;
+	if (!result) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to load the record at offset %" PRIu64, reader->recordOffset);
+		return GF_RECORD_ERROR;
+	}
+	return GF_RECORD_READY;
 }
 
-int gf_SaveArrayS64(gf_Saver *saver, FILE *file, const char *identifier, gf_s64 *value, int count) {
-	int result = 0;
+void gf_CloseRecords(gf_RecordReader *reader) {
+	assert(reader);
 
-	result = gf_PrintIndent(saver, file);
-	if (!result) { return 0; }
+	if (reader->file) {
+		fclose(reader->file);
+		reader->file = NULL;
+	}
+	gf_Unload(&reader->loader);
+}
 
-	if (count) {
-		result = fprintf(file, "%s { ", identifier);
-		if (result < 0) {
-			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayI64", result);
-			return 0;
+/*-----------------------------------------------------------------------------------*/
+
+/*-------------------------------------BATCH-----------------------------------------*/
+
+gf_u32 gf_CountCores(void) {
+#if defined(GF_POSIX) && defined(_SC_NPROCESSORS_ONLN)
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cores > 0) {
+		return (gf_u32)cores;
+	}
+#endif
+	return 1;
+}
+
+void gf_LoadBatchFiles(gf_Batch *batch) {
+	assert(batch);
+
+	while (1) {
+#ifdef GF_THREADS
+		pthread_mutex_lock(&batch->lock);
+#endif
+		gf_u64 i = batch->next;
+		if (i < batch->count) {
+			batch->next++;
 		}
-		result = fprintf(file, "%" PRIi64, value[0]);
-		if (result < 0) {
-			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayI64", result);
-			return 0;
+#ifdef GF_THREADS
+		pthread_mutex_unlock(&batch->lock);
+#endif
+		if (i >= batch->count) {
+			break;
 		}
-		for (int i = 1; i < count; i++) {
-			result = fprintf(file, ", %" PRIi64, value[i]);
-			if (result < 0) {
-				GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayI64", result);
-				return 0;
-			}
+
+		int result = gf_LoadFromFile(&batch->loaders[i], batch->filenames[i], batch->funcs);
+		if (batch->results) {
+			batch->results[i] = result;
 		}
-		result = fprintf(file, " }\n");
-		if (result < 0) {
-			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayI64", result);
-			return 0;
+		if (!result) {
+#ifdef GF_THREADS
+			pthread_mutex_lock(&batch->lock);
+#endif
+			batch->failures++;
+#ifdef GF_THREADS
+			pthread_mutex_unlock(&batch->lock);
+#endif
 		}
 	}
+}
 
-	return 1;
+#ifdef GF_THREADS
+/*
+The function each thread that gf_LoadBatch() starts runs.
+*/
+void *gf_BatchThread(void *batch) {
+	gf_LoadBatchFiles((gf_Batch *)batch);
+	return NULL;
 }
+#endif
 
+int gf_LoadBatch(gf_Loader *loaders, const char *const *filenames, int *results, gf_u64 count, gf_u32 threadCount, gf_LogAllocateFreeFunctions *funcs) {
+	assert(loaders || count == 0);
+	assert(filenames || count == 0);
 
-int gf_SaveArrayS32(gf_Saver *saver, FILE *file, const char *identifier, gf_s32 *value, int count) {
-	int result = 0;
+	gf_Batch batch;
+	batch.loaders = loaders;
+	batch.filenames = filenames;
+	batch.results = results;
+	batch.count = count;
+	batch.funcs = funcs;
+	batch.next = 0;
+	batch.failures = 0;
 
-	result = gf_PrintIndent(saver, file);
-	if (!result) { return 0; }
+#ifdef GF_THREADS
+	if (threadCount == 0) {
+		threadCount = gf_CountCores();
+	}
+	if (threadCount > GF_MAX_BATCH_THREADS) {
+		threadCount = GF_MAX_BATCH_THREADS;
+	}
+	if (threadCount > count) {
+		threadCount = (gf_u32)count;
+	}
 
-	if (count) {
-		result = fprintf(file, "%s { ", identifier);
-		if (result < 0) {
-			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayS32", result);
-			return 0;
-		}
-		result = fprintf(file, "%" PRIi32, value[0]);
-		if (result < 0) {
-			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayS32", result);
-			return 0;
+	pthread_mutex_init(&batch.lock, NULL);
+
+	// If a thread can not be started its files are loaded by the others.
+	pthread_t threads[GF_MAX_BATCH_THREADS];
+	gf_u32 started = 0;
+	while (started + 1 < threadCount && pthread_create(&threads[started], NULL, gf_BatchThread, &batch) == 0) {
+		started++;
+	}
+	gf_LoadBatchFiles(&batch);
+	for (gf_u32 i = 0; i < started; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	pthread_mutex_destroy(&batch.lock);
+#else
+	(void)threadCount;
+	gf_LoadBatchFiles(&batch);
+#endif
+
+	return batch.failures == 0;
+}
+
+/*-----------------------------------------------------------------------------------*/
+
+/*------------------------------------ASYNC READ-------------------------------------*/
+
+void gf_ParseReadFile(gf_FileLoads *loads, gf_u64 index) {
+	assert(loads);
+	assert(index < loads->count);
+
+	gf_Loader *loader = &loads->loaders[index];
+	int result = loads->readResults[index] && gf_LoadInternal(loader, loader->fileContentsBuffer, loads->sizes[index]);
+	if (loads->results) {
+		loads->results[index] = result;
+	}
+	if (!result) {
+		loads->failures++;
+	}
+}
+
+void gf_ReadFileLoads(gf_FileLoads *loads) {
+	assert(loads);
+
+	while (1) {
+#ifdef GF_THREADS
+		pthread_mutex_lock(&loads->lock);
+#endif
+		gf_u64 i = loads->next;
+		if (i < loads->count) {
+			loads->next++;
 		}
-		for (int i = 1; i < count; i++) {
-			result = fprintf(file, ", %" PRIi32, value[i]);
-			if (result < 0) {
-				GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayS32", result);
-				return 0;
-			}
+#ifdef GF_THREADS
+		pthread_mutex_unlock(&loads->lock);
+#endif
+		if (i >= loads->count) {
+			break;
 		}
-		result = fprintf(file, " }\n");
-		if (result < 0) {
-			GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveArrayS32", result);
-			return 0;
+
+		int result = gf_ReadFileIntoLoader(&loads->loaders[i], loads->filenames[i], &loads->sizes[i]);
+
+#ifdef GF_THREADS
+		pthread_mutex_lock(&loads->lock);
+#endif
+		loads->readResults[i] = result;
+		loads->completed[loads->completedCount++] = i;
+#ifdef GF_THREADS
+		pthread_cond_signal(&loads->readFinished);
+		pthread_mutex_unlock(&loads->lock);
+#endif
+	}
+}
+
+#ifdef GF_THREADS
+/*
+The function each thread that gf_LoadFilesWithThreads() starts runs.
+*/
+void *gf_ReadFileLoadsThread(void *loads) {
+	gf_ReadFileLoads((gf_FileLoads *)loads);
+	return NULL;
+}
+#endif
+
+void gf_LoadFilesWithThreads(gf_FileLoads *loads, gf_u32 readsInFlight) {
+	assert(loads);
+
+#ifdef GF_THREADS
+	if (readsInFlight > GF_MAX_BATCH_THREADS) {
+		readsInFlight = GF_MAX_BATCH_THREADS;
+	}
+	if (readsInFlight > loads->count) {
+		readsInFlight = (gf_u32)loads->count;
+	}
+
+	pthread_mutex_init(&loads->lock, NULL);
+	pthread_cond_init(&loads->readFinished, NULL);
+
+	pthread_t threads[GF_MAX_BATCH_THREADS];
+	gf_u32 started = 0;
+	while (started < readsInFlight && pthread_create(&threads[started], NULL, gf_ReadFileLoadsThread, loads) == 0) {
+		started++;
+	}
+	if (started == 0) {
+		gf_ReadFileLoads(loads);
+	}
+
+	for (gf_u64 parsed = 0; parsed < loads->count; parsed++) {
+		pthread_mutex_lock(&loads->lock);
+		while (loads->completedCount <= parsed) {
+			pthread_cond_wait(&loads->readFinished, &loads->lock);
 		}
+		gf_u64 index = loads->completed[parsed];
+		pthread_mutex_unlock(&loads->lock);
+
+		gf_ParseReadFile(loads, index);
 	}
 
-	return 1;
+	for (gf_u32 i = 0; i < started; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	pthread_cond_destroy(&loads->readFinished);
+	pthread_mutex_destroy(&loads->lock);
+#else
+	(void)readsInFlight;
+	gf_ReadFileLoads(loads);
+	for (gf_u64 parsed = 0; parsed < loads->count; parsed++) {
+		gf_ParseReadFile(loads, loads->completed[parsed]);
+	}
+#endif
 }
 
-int gf_SaveStartList(gf_Saver *saver, FILE *file, const char *identifier) {
-	int result = 0;
+#ifdef GF_IO_URING
 
-	result = gf_PrintIndent(saver, file);
-	if (!result) { return 0; }
+int gf_OpenRing(gf_Ring *ring, gf_u32 entries) {
+	assert(ring);
 
-	result = fprintf(file, "%s {\n", identifier);
-	if (result < 0) {
-		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveStartList", result);
+	memset(ring, 0, sizeof(*ring));
+
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+	if (fd < 0) {
+		return 0;
+	}
+	ring->fd = fd;
+
+	ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cqRingSize > ring->sqRingSize) {
+			ring->sqRingSize = ring->cqRingSize;
+		}
+		ring->cqRingSize = ring->sqRingSize;
+	}
+	ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+	ring->sqRing = mmap(NULL, (size_t)ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, IORING_OFF_SQ_RING);
+	ring->cqRing = ring->sqRing;
+	if (ring->sqRing != MAP_FAILED && !(params.features & IORING_FEAT_SINGLE_MMAP)) {
+		ring->cqRing = mmap(NULL, (size_t)ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, IORING_OFF_CQ_RING);
+	}
+	void *sqes = mmap(NULL, (size_t)ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, IORING_OFF_SQES);
+	if (ring->sqRing == MAP_FAILED || ring->cqRing == MAP_FAILED || sqes == MAP_FAILED) {
+		if (sqes != MAP_FAILED) munmap(sqes, (size_t)ring->sqesSize);
+		if (ring->cqRing != MAP_FAILED && ring->cqRing != ring->sqRing) munmap(ring->cqRing, (size_t)ring->cqRingSize);
+		if (ring->sqRing != MAP_FAILED) munmap(ring->sqRing, (size_t)ring->sqRingSize);
+		close(fd);
 		return 0;
 	}
-	saver->indent++;
 
+	char *sq = (char *)ring->sqRing;
+	char *cq = (char *)ring->cqRing;
+	ring->sqHead = (unsigned *)(sq + params.sq_off.head);
+	ring->sqTail = (unsigned *)(sq + params.sq_off.tail);
+	ring->sqMask = (unsigned *)(sq + params.sq_off.ring_mask);
+	ring->sqArray = (unsigned *)(sq + params.sq_off.array);
+	ring->sqEntries = params.sq_entries;
+	ring->sqes = (struct io_uring_sqe *)sqes;
+	ring->cqHead = (unsigned *)(cq + params.cq_off.head);
+	ring->cqTail = (unsigned *)(cq + params.cq_off.tail);
+	ring->cqMask = (unsigned *)(cq + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
 	return 1;
 }
 
-int gf_SaveEndList(gf_Saver *saver, FILE *file) {
-	int result = 0;
+void gf_CloseRing(gf_Ring *ring) {
+	assert(ring);
 
-	if (saver->indent) {
-		for (unsigned int i = 0; i < saver->indent - 1; i++) {
-			result = fprintf(file, "  ");
-			if (result < 0) {
-				GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveEndList", result);
-				return 0;
-			}
-		}
+	munmap(ring->sqes, (size_t)ring->sqesSize);
+	if (ring->cqRing != ring->sqRing) {
+		munmap(ring->cqRing, (size_t)ring->cqRingSize);
 	}
-	result = fprintf(file, "}\n");
-	if (result < 0) {
-		GF_LOG(saver, GF_LOG_ERROR, "fprintf failed with value [%d] in gf_SaveEndList", result);
+	munmap(ring->sqRing, (size_t)ring->sqRingSize);
+	close(ring->fd);
+}
+
+int gf_QueueRingRead(gf_Ring *ring, int fd, char *buffer, gf_u32 length, gf_u64 offset, gf_u64 userData) {
+	assert(ring);
+	assert(buffer);
+
+	// Only this thread moves the tail. The kernel moves the head as it takes submissions.
+	unsigned tail = *ring->sqTail;
+	if (tail - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE) >= ring->sqEntries) {
 		return 0;
 	}
-	if (saver->indent) saver->indent--;
 
+	unsigned index = tail & *ring->sqMask;
+	struct io_uring_sqe *sqe = &ring->sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = fd;
+	sqe->addr = (gf_u64)(uintptr_t)buffer;
+	sqe->len = length;
+	sqe->off = offset;
+	sqe->user_data = userData;
+	ring->sqArray[index] = index;
+
+	__atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
 	return 1;
 }
 
-/*-----------------------------------------------------------------------------------*/
+int gf_EnterRing(gf_Ring *ring, int wait) {
+	assert(ring);
 
-/*-------------------------------------LOADER----------------------------------------*/
+	unsigned submit = *ring->sqTail - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE);
+	while (1) {
+		long result = syscall(__NR_io_uring_enter, ring->fd, submit, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+		if (result >= 0) {
+			return 1;
+		}
+		if (errno != EINTR) {
+			return 0;
+		}
+	}
+}
 
-void gf_InitLoader(gf_Loader *loader, gf_LogAllocateFreeFunctions *helperfunctions) {
-	assert(loader);
+int gf_ReapRing(gf_Ring *ring, gf_u64 *userData, gf_s32 *result) {
+	assert(ring);
+	assert(userData);
+	assert(result);
 
-	if (!helperfunctions || helperfunctions->Log == NULL) {
-		loader->Log = gf_DefaultLog;
-	}
-	else {
-		loader->Log = helperfunctions->Log;
-	}
-	if (!helperfunctions || helperfunctions->Allocate == NULL) {
-		loader->Allocate = malloc;
-	}
-	else {
-		loader->Allocate = helperfunctions->Allocate;
-	}
-	if (!helperfunctions || helperfunctions->Free == NULL) {
-		loader->Free = free;
-	}
-	else {
-		loader->Free = helperfunctions->Free;
+	unsigned head = *ring->cqHead;
+	if (head == __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE)) {
+		return 0;
 	}
 
-	loader->curToken = NULL;
-	loader->rootNode = NULL;
-	loader->lastNode = NULL;
-	loader->firstToken = NULL;
+	struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cqMask];
+	*userData = cqe->user_data;
+	*result = cqe->res;
+	__atomic_store_n(ring->cqHead, head + 1, __ATOMIC_RELEASE);
+	return 1;
+}
 
-	// Set up the root token
-	loader->rootToken.start = "root";
-	loader->rootToken.length = 4;
-	loader->rootToken.lineno = 0;
-	loader->rootToken.next = NULL;
-	loader->rootToken.type = GF_TOKEN_TYPE_ROOT;
+/*
+Opens the next files that are not being read yet and queues their first reads, until readsInFlight files are being read.
+Files that can not be opened, or are empty, are done at once and added to loads->completed.
+*/
+void gf_StartRingReads(gf_FileLoads *loads, gf_Ring *ring, gf_u32 readsInFlight, gf_u32 *active) {
+	while (*active < readsInFlight && loads->next < loads->count) {
+		gf_u64 i = loads->next++;
+		gf_Loader *loader = &loads->loaders[i];
+		const char *filename = loads->filenames[i];
+
+		struct stat info;
+		int fd = open(filename, O_RDONLY);
+		if (fd < 0 || fstat(fd, &info) != 0) {
+			GF_LOG(loader, GF_LOG_ERROR, "Failed to load file [%s]. It could not be opened", filename);
+			if (fd >= 0) close(fd);
+			loads->readResults[i] = 0;
+			loads->completed[loads->completedCount++] = i;
+			continue;
+		}
 
-	loader->lastToken = &loader->rootToken;
+		gf_u64 size = (gf_u64)info.st_size;
+		loader->fileContentsBuffer = (char *)gf_Allocate(loader, size + 1);
+		if (!loader->fileContentsBuffer) {
+			GF_LOG(loader, GF_LOG_ERROR, "Out of memory. Failed to allocate buffer for file [%s]", filename);
+			close(fd);
+			loads->readResults[i] = 0;
+			loads->completed[loads->completedCount++] = i;
+			continue;
+		}
+		loader->fileContentsCapacity = size + 1;
+		loader->fileContentsBuffer[size] = '\0';
+		loads->sizes[i] = size + 1;
+		loads->readCounts[i] = 0;
+
+		if (size == 0) {
+			close(fd);
+			loads->readResults[i] = 1;
+			loads->completed[loads->completedCount++] = i;
+			continue;
+		}
 
-	loader->fileContentsBuffer = NULL;
-	loader->nestLevel = 0;
+		loads->fds[i] = fd;
+		gf_u32 length = size > GF_MAX_READ_SIZE ? GF_MAX_READ_SIZE : (gf_u32)size;
+		gf_QueueRingRead(ring, fd, loader->fileContentsBuffer, length, 0, i);
+		(*active)++;
+	}
 }
 
-void gf_IncrementLastTokenLength(gf_Loader *loader) {
-	assert(loader);
-	assert(loader->lastToken);
-	loader->lastToken->length++;
+/*
+Reads the rest of a file without io_uring, for kernels that do not support the reads it was given.
+*/
+int gf_FinishRingReadBlocking(gf_FileLoads *loads, gf_u64 i) {
+	gf_u64 size = loads->sizes[i] - 1;
+	char *buffer = loads->loaders[i].fileContentsBuffer;
+	if (lseek(loads->fds[i], (off_t)loads->readCounts[i], SEEK_SET) < 0) {
+		return 0;
+	}
+	while (loads->readCounts[i] < size) {
+		gf_u64 remaining = size - loads->readCounts[i];
+		ssize_t count = read(loads->fds[i], buffer + loads->readCounts[i], (size_t)(remaining > GF_MAX_READ_SIZE ? GF_MAX_READ_SIZE : remaining));
+		if (count <= 0) {
+			return 0;
+		}
+		loads->readCounts[i] += (gf_u64)count;
+	}
+	return 1;
 }
 
-int gf_AddToken(gf_Loader *loader, const char *start, gf_TokenType type, gf_u64 lineno, gf_u64 colno) {
-	assert(loader->lastToken);
+int gf_LoadFilesWithRing(gf_FileLoads *loads, gf_u32 readsInFlight) {
+	assert(loads);
 
-	if (!start) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, loader->lastToken, "Expecting a token but at the end of the file/buffer");
+	gf_Ring ring;
+	if (!gf_OpenRing(&ring, readsInFlight)) {
 		return 0;
 	}
-
-	gf_Token *token = (gf_Token *)loader->Allocate(sizeof(gf_Token));
-	if (!token) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, loader->lastToken, "Out of memory in gf_AddToken");
-		return 0;
+	if (readsInFlight > ring.sqEntries) {
+		readsInFlight = ring.sqEntries;
 	}
 
-	if (!loader->firstToken) {
-		loader->firstToken = token;
-	}
+	gf_u32 active = 0;
+	gf_u64 parsed = 0;
+	while (parsed < loads->count) {
 
-	loader->lastToken->next = token;
-	loader->lastToken = token;
+		gf_StartRingReads(loads, &ring, readsInFlight, &active);
 
-	token->start = start;
-	token->type = type;
-	token->length = 1;
-	token->lineno = lineno;
-	token->colno = colno;
-	token->next = NULL;
+		if (loads->completedCount == parsed && active > 0 && !gf_EnterRing(&ring, 1)) {
+			// The ring can not be used anymore, so the files being read are finished without it.
+			gf_u64 userData;
+			gf_s32 result;
+			while (gf_ReapRing(&ring, &userData, &result)) {
+			}
+			for (gf_u64 i = 0; i < loads->next; i++) {
+				if (loads->fds[i] >= 0) {
+					loads->readResults[i] = gf_FinishRingReadBlocking(loads, i);
+					close(loads->fds[i]);
+					loads->fds[i] = -1;
+					loads->completed[loads->completedCount++] = i;
+				}
+			}
+			active = 0;
+		}
 
-	return 1;
-}
+		gf_u64 i;
+		gf_s32 result;
+		while (gf_ReapRing(&ring, &i, &result)) {
+			gf_u64 size = loads->sizes[i] - 1;
+			int done = 0;
+			if (result > 0) {
+				loads->readCounts[i] += (gf_u64)result;
+				done = loads->readCounts[i] == size;
+			}
+			else {
+				// An error, or the file got shorter. Reading the rest without the ring tells which.
+				loads->readResults[i] = gf_FinishRingReadBlocking(loads, i);
+				if (!loads->readResults[i]) {
+					GF_LOG((&loads->loaders[i]), GF_LOG_ERROR, "Failed to read file [%s]", loads->filenames[i]);
+				}
+				done = -1;
+			}
 
-char *gf_AllocateNullTerminatedBufferFromFile(gf_Loader *loader, const char *filename, gf_u64 *bufferCountWithNullTerminator) {
-	assert(loader);
-	assert(filename);
-	assert(bufferCountWithNullTerminator);
+			if (done == 0) {
+				gf_u64 remaining = size - loads->readCounts[i];
+				gf_u32 length = remaining > GF_MAX_READ_SIZE ? GF_MAX_READ_SIZE : (gf_u32)remaining;
+				gf_QueueRingRead(&ring, loads->fds[i], loads->loaders[i].fileContentsBuffer + loads->readCounts[i], length, loads->readCounts[i], i);
+				continue;
+			}
+			if (done == 1) {
+				loads->readResults[i] = 1;
+			}
+			close(loads->fds[i]);
+			loads->fds[i] = -1;
+			active--;
+			loads->completed[loads->completedCount++] = i;
+		}
 
-	uint64_t fileSize = 0;
-	uint64_t readBytes = 0;
-	FILE *file = NULL;
+		// The next reads are started before parsing, so the disk is busy while the files that arrived are parsed.
+		gf_StartRingReads(loads, &ring, readsInFlight, &active);
+		gf_EnterRing(&ring, 0);
 
-	file = fopen(filename, "rb");
-	if (file == NULL) {
-		GF_LOG(loader, GF_LOG_ERROR, "Failed to load file [%s]. It could not be opened", filename);
-		return NULL;
+		while (parsed < loads->completedCount) {
+			gf_ParseReadFile(loads, loads->completed[parsed]);
+			parsed++;
+		}
 	}
-	fseek(file, 0, SEEK_END);
-	fileSize = (uint64_t)ftell(file);
-	fseek(file, 0, SEEK_SET);
 
-	char *buffer = (char *)loader->Allocate(fileSize + 1);
-	if (buffer == NULL) {
-		GF_LOG(loader, GF_LOG_ERROR, "Out of memory. Failed to allocate buffer for file [%s]", filename);
-		fclose(file);
-		return NULL;
+	gf_CloseRing(&ring);
+	return 1;
+}
+
+#endif
+
+int gf_LoadFiles(gf_Loader *loaders, const char *const *filenames, int *results, gf_u64 count, gf_u32 readsInFlight, gf_LogAllocateFreeFunctions *funcs) {
+	assert(loaders || count == 0);
+	assert(filenames || count == 0);
+
+	if (readsInFlight == 0) {
+		readsInFlight = GF_DEFAULT_READS_IN_FLIGHT;
+	}
+	for (gf_u64 i = 0; i < count; i++) {
+		gf_InitLoader(&loaders[i], funcs);
+	}
+
+	// Where each file is holds the memory of the loads, so it is freed with one gf_Unload().
+	gf_Loader storage;
+	gf_InitLoader(&storage, funcs);
+
+	gf_FileLoads loads;
+	memset(&loads, 0, sizeof(loads));
+	loads.loaders = loaders;
+	loads.filenames = filenames;
+	loads.results = results;
+	loads.count = count;
+	loads.sizes = (gf_u64 *)gf_ArenaAllocate(&storage, (count + 1) * sizeof(gf_u64));
+	loads.readCounts = (gf_u64 *)gf_ArenaAllocate(&storage, (count + 1) * sizeof(gf_u64));
+	loads.fds = (int *)gf_ArenaAllocate(&storage, (count + 1) * sizeof(int));
+	loads.readResults = (int *)gf_ArenaAllocate(&storage, (count + 1) * sizeof(int));
+	loads.completed = (gf_u64 *)gf_ArenaAllocate(&storage, (count + 1) * sizeof(gf_u64));
+	if (!loads.sizes || !loads.readCounts || !loads.fds || !loads.readResults || !loads.completed) {
+		GF_LOG((&storage), GF_LOG_ERROR, "Out of memory. Failed to allocate the state of %" PRIu64 " files", count);
+		gf_Unload(&storage);
+		for (gf_u64 i = 0; i < count; i++) {
+			if (results) {
+				results[i] = 0;
+			}
+		}
+		return 0;
+	}
+	for (gf_u64 i = 0; i < count; i++) {
+		loads.fds[i] = -1;
 	}
 
-	readBytes = fread(buffer, fileSize, sizeof(char), file);
-	if (readBytes != 1) {
-		GF_LOG(loader, GF_LOG_ERROR, "Failed to read file [%s]", filename);
-		fclose(file);
-		return NULL;
+#ifdef GF_IO_URING
+	if (count == 0 || !gf_LoadFilesWithRing(&loads, readsInFlight)) {
+		gf_LoadFilesWithThreads(&loads, readsInFlight);
 	}
+#else
+	gf_LoadFilesWithThreads(&loads, readsInFlight);
+#endif
 
-	fclose(file);
+	gf_Unload(&storage);
+	return loads.failures == 0;
+}
 
-	buffer[fileSize] = '\0';
+/*-----------------------------------------------------------------------------------*/
 
-	*bufferCountWithNullTerminator = fileSize + 1;
+/*-------------------------------------PIPELINE--------------------------------------*/
 
-	return buffer;
+int gf_ReadPipelineBlock(gf_Pipeline *pipeline, char *destination, gf_u64 *length) {
+	assert(pipeline);
+	assert(destination);
+	assert(length);
+
+	gf_u64 remaining = pipeline->size - pipeline->offset;
+	int result = 0;
+	if (pipeline->compressed) {
+		result = gf_ReadCompressedBlock(pipeline->file, pipeline->compressedBlock, pipeline->blockSize, destination, remaining, length);
+	}
+	else {
+		*length = remaining > pipeline->blockSize ? pipeline->blockSize : remaining;
+		result = fread(destination, (size_t)*length, 1, pipeline->file) == 1;
+	}
+	if (result) {
+		pipeline->offset += *length;
+	}
+	return result;
 }
 
-void gf_InitTokeniser(gf_Tokeniser *tokeniser, const char *buffer, gf_u64 count) {
-	assert(tokeniser);
-	assert(buffer);
+void gf_ReadPipeline(gf_Pipeline *pipeline) {
+	assert(pipeline);
 
-	tokeniser->buffer = buffer;
-	tokeniser->count = count;
-	tokeniser->index = 0;
-	tokeniser->lineno = 1;
-	tokeniser->colno = 1;
-}
+	int reading = 1;
+	while (reading && pipeline->offset < pipeline->size) {
+#ifdef GF_THREADS
+		pthread_mutex_lock(&pipeline->lock);
+		while (pipeline->read - pipeline->used == GF_PIPELINE_BLOCK_COUNT && !pipeline->stop) {
+			pthread_cond_wait(&pipeline->blockUsed, &pipeline->lock);
+		}
+		reading = !pipeline->stop;
+		pthread_mutex_unlock(&pipeline->lock);
+		if (!reading) {
+			break;
+		}
+#endif
 
-char gf_GetChar(gf_Tokeniser *tokeniser) {
-	if (tokeniser->index >= tokeniser->count) {
-		return '\0';
-	}
-	return tokeniser->buffer[tokeniser->index];
-}
+		// Only this thread changes read, so the buffer it picks can not be in use by the tokeniser.
+		gf_u64 slot = pipeline->read % GF_PIPELINE_BLOCK_COUNT;
+		gf_u64 length = 0;
+		int result = gf_ReadPipelineBlock(pipeline, pipeline->blocks + slot * pipeline->blockSize, &length);
 
-void gf_IncrementIndex(gf_Tokeniser *tokeniser) {
-	if (tokeniser->index < tokeniser->count) {
-		tokeniser->index++;
-		tokeniser->colno++;
+#ifdef GF_THREADS
+		pthread_mutex_lock(&pipeline->lock);
+#endif
+		if (result) {
+			pipeline->lengths[slot] = length;
+			pipeline->read++;
+		}
+		else {
+			pipeline->failed = 1;
+		}
+		reading = result && !pipeline->stop;
+#ifdef GF_THREADS
+		pthread_cond_signal(&pipeline->blockRead);
+		pthread_mutex_unlock(&pipeline->lock);
+#endif
 	}
 }
 
-void gf_IncrementLineNo(gf_Tokeniser *tokeniser) {
-	tokeniser->lineno++;
-	tokeniser->colno = 1;
-}
-
-const char *gf_Ptr(gf_Tokeniser *tokeniser) {
-	if (tokeniser->index < tokeniser->count) {
-		return &tokeniser->buffer[tokeniser->index];
-	}
+#ifdef GF_THREADS
+/*
+The function the thread that gf_LoadFileWithPipeline() starts runs.
+*/
+void *gf_ReadPipelineThread(void *pipeline) {
+	gf_ReadPipeline((gf_Pipeline *)pipeline);
 	return NULL;
 }
+#endif
 
-int gf_TokeniseInternal(gf_Loader *loader, gf_Tokeniser *tokeniser) {
-	assert(loader);
-	assert(tokeniser);
+int gf_WaitForPipeline(gf_Pipeline *pipeline, const char **block, gf_u64 *length) {
+	assert(pipeline);
+	assert(block);
+	assert(length);
+
+	if (!pipeline->threaded) {
+		*block = pipeline->blocks;
+		return gf_ReadPipelineBlock(pipeline, pipeline->blocks, length);
+	}
 
 	int result = 0;
+#ifdef GF_THREADS
+	pthread_mutex_lock(&pipeline->lock);
+	while (pipeline->read == pipeline->used && !pipeline->failed) {
+		pthread_cond_wait(&pipeline->blockRead, &pipeline->lock);
+	}
+	gf_u64 slot = pipeline->used % GF_PIPELINE_BLOCK_COUNT;
+	result = pipeline->read != pipeline->used;
+	*length = pipeline->lengths[slot];
+	pthread_mutex_unlock(&pipeline->lock);
+	*block = pipeline->blocks + slot * pipeline->blockSize;
+#endif
+	return result;
+}
 
-	while (1) {
+void gf_UsePipelineBlock(gf_Pipeline *pipeline) {
+	assert(pipeline);
 
-		if (gf_GetChar(tokeniser) == '\0') {
+#ifdef GF_THREADS
+	pthread_mutex_lock(&pipeline->lock);
+#endif
+	pipeline->used++;
+#ifdef GF_THREADS
+	pthread_cond_signal(&pipeline->blockUsed);
+	pthread_mutex_unlock(&pipeline->lock);
+#endif
+}
 
-			result = gf_AddToken(loader, "<end token>", GF_TOKEN_TYPE_END_FILE, tokeniser->lineno, tokeniser->colno);
-			if (!result) {
-				GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, loader->lastToken, "Failed to add end file token");
-				return 0;
-			}
-			break;
+int gf_FillPipelineWindow(gf_Loader *loader, gf_Pipeline *pipeline, gf_u64 *windowLength, gf_u64 wanted) {
+	assert(loader);
+	assert(pipeline);
+	assert(windowLength);
+
+	while (*windowLength < wanted && pipeline->windowEnd < pipeline->size) {
+		const char *block = NULL;
+		gf_u64 length = 0;
+		if (!gf_WaitForPipeline(pipeline, &block, &length)) {
+			GF_LOG(loader, GF_LOG_ERROR, "Failed to read file [%s]", pipeline->filename);
+			return 0;
 		}
-		else if (gf_GetChar(tokeniser) == '{') {
-			result = gf_AddToken(loader, gf_Ptr(tokeniser), GF_TOKEN_TYPE_VALUE_ASSIGN, tokeniser->lineno, tokeniser->colno);
-			if (!result) {
-				GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, loader->lastToken, "Failed to add value assign token");
-				return 0;
+
+		gf_u64 needed = *windowLength + length + 1;
+		if (needed > loader->fileContentsCapacity) {
+			// Doubles so a long token that is cut off again and again is not copied every time, but never past the rest
+			// of the text. When all of it is wanted, that is allocated straight away.
+			gf_u64 most = *windowLength + (pipeline->size - pipeline->windowEnd) + 1;
+			gf_u64 capacity = wanted >= most - 1 ? most : loader->fileContentsCapacity * 2;
+			if (capacity < needed) {
+				capacity = needed;
 			}
-			gf_IncrementIndex(tokeniser);
-		}
-		else if (gf_GetChar(tokeniser) == '}') {
-			result = gf_AddToken(loader, gf_Ptr(tokeniser), GF_TOKEN_TYPE_CURLY_CLOSE, tokeniser->lineno, tokeniser->colno);
-			if (!result) {
-				GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, loader->lastToken, "Failed to add curly close token");
+			if (capacity > most) {
+				capacity = most;
+			}
+			char *window = (char *)gf_Allocate(loader, capacity);
+			if (!window) {
+				GF_LOG(loader, GF_LOG_ERROR, "Out of memory. Failed to allocate buffer for file [%s]", pipeline->filename);
 				return 0;
 			}
-			gf_IncrementIndex(tokeniser);
+			if (*windowLength > 0) {
+				memcpy(window, loader->fileContentsBuffer, (size_t)*windowLength);
+			}
+			gf_Free(loader, loader->fileContentsBuffer);
+			loader->fileContentsBuffer = window;
+			loader->fileContentsCapacity = capacity;
 		}
-		else if (gf_GetChar(tokeniser) == '/') {
-
-			gf_IncrementIndex(tokeniser);
 
-			if (gf_GetChar(tokeniser) == '*') {
+		memcpy(loader->fileContentsBuffer + *windowLength, block, (size_t)length);
+		gf_UsePipelineBlock(pipeline);
+		*windowLength += length;
+		pipeline->windowEnd += length;
+	}
 
-				int nestedCommentDepth = 1;
-				gf_IncrementIndex(tokeniser);
+	if (loader->fileContentsBuffer) {
+		loader->fileContentsBuffer[*windowLength] = '\0';
+	}
+	return 1;
+}
 
-				while (nestedCommentDepth > 0) {
+/*
+Moves the line the tokeniser is on forward to the one that the byte at to in the window is on, from the one at from.
+lineStart is where that line starts in the text.
+*/
+void gf_CountPipelineLines(const char *window, gf_u64 windowStart, gf_u64 from, gf_u64 to, gf_u64 *lineno, gf_u64 *lineStart) {
+	gf_u64 breaks = gf_CountLineBreaks(window + from, to - from, NULL);
+	if (breaks > 0) {
+		*lineno += breaks;
+		gf_u64 i = to;
+		while (window[i - 1] != '\n' && window[i - 1] != '\r') {
+			i--;
+		}
+		*lineStart = windowStart + i;
+	}
+}
 
-					if (gf_GetChar(tokeniser) == '\0') {
-						GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, loader->lastToken, "Comment does not end before the file ends");
-						return 0;
-					}
-					else if (gf_GetChar(tokeniser) == '/') {
+int gf_TokenisePipeline(gf_Loader *loader, gf_Pipeline *pipeline, gf_u64 windowLength) {
+	assert(loader);
+	assert(pipeline);
 
-						gf_IncrementIndex(tokeniser);
-						if (gf_GetChar(tokeniser) == '*') {
-							nestedCommentDepth++;
-						}
-					}
-					else if (gf_GetChar(tokeniser) == '*') {
-						gf_IncrementIndex(tokeniser);
-						if (gf_GetChar(tokeniser) == '/') {
-							nestedCommentDepth--;
-						}
-					}
-					else if (gf_GetChar(tokeniser) == '\n') {
-						gf_IncrementLineNo(tokeniser);						
-						gf_IncrementIndex(tokeniser);
-					}
-					else if (gf_GetChar(tokeniser) == '\r') {
-						gf_IncrementLineNo(tokeniser);
-						gf_IncrementIndex(tokeniser);
-						if (gf_GetChar(tokeniser) == '\n') {
-							gf_IncrementIndex(tokeniser);
-						}
-					}
-					else {
-						gf_IncrementIndex(tokeniser);
-					}
-				}
-			}
-		}
-		else if (gf_GetChar(tokeniser) == ' ' || gf_GetChar(tokeniser) == ',' || gf_GetChar(tokeniser) == '\t') {
-			gf_IncrementIndex(tokeniser);
-		}
-		else if (gf_GetChar(tokeniser) == '\n') {
-			gf_IncrementLineNo(tokeniser);
-			gf_IncrementIndex(tokeniser);
-		}
-		else if (gf_GetChar(tokeniser) == '\r') {
-			gf_IncrementLineNo(tokeniser);
-			gf_IncrementIndex(tokeniser);
-			if (gf_GetChar(tokeniser) == '\n') {
-				gf_IncrementIndex(tokeniser);
+	gf_Tokeniser tokeniser;
+	gf_InitTokeniser(&tokeniser, loader->fileContentsBuffer, 0);
+	tokeniser.validateUtf8 = (loader->flags & GF_LOADER_FLAG_VALIDATE_UTF8) != 0;
+	// The window moves and is overwritten, so the tokeniser can not locate anything in it. Errors are logged here instead.
+	tokeniser.Log = gf_NoLog;
+	gf_InitLineIndex(&tokeniser.lines, NULL, NULL, 0);
+
+	gf_u64 windowStart = 0; // Where the window starts in the text.
+	gf_u64 lineno = 1;      // The line the last token that was located is on.
+	gf_u64 lineStart = 0;   // Where that line starts in the text.
+	char *text = NULL;      // Where the text of the next token is copied to in the arena.
+	gf_u64 textLeft = 0;    // How many bytes are left there.
+
+	gf_Token token;
+	while (1) {
+		const char *window = loader->fileContentsBuffer;
+		int finished = pipeline->windowEnd == pipeline->size;
+		tokeniser.buffer = window;
+		tokeniser.count = finished ? windowLength + 1 : windowLength;
+		tokeniser.index = 0;
+		tokeniser.error = NULL;
+		gf_u64 located = 0;
+
+		while (1) {
+			gf_u64 start = tokeniser.index;
+			token.start = NULL;
+			int result = gf_NextToken(&tokeniser, &token);
+
+			// The token might go on in the next block.
+			if (!finished && (!result || token.type == GF_TOKEN_TYPE_END_FILE || tokeniser.index >= windowLength)) {
+				tokeniser.index = start;
+				break;
 			}
-		}
-		else if (gf_GetChar(tokeniser) == '\"') {
 
-			gf_IncrementIndex(tokeniser);
+			// Located like gf_LocateToken() does. Strings at their opening quote, the end token at the end of the text.
+			gf_u64 offset = start;
+			if (result && token.type == GF_TOKEN_TYPE_END_FILE) {
+				offset = windowLength;
+			}
+			else if (token.start >= window && token.start <= window + windowLength) {
+				offset = (gf_u64)(token.start - window);
+				if (result && token.type == GF_TOKEN_TYPE_STRING && offset > 0) {
+					offset--;
+				}
+			}
+			gf_CountPipelineLines(window, windowStart, located, offset, &lineno, &lineStart);
+			located = offset;
+			token.lineno = lineno;
+			token.colno = windowStart + offset - lineStart + 1;
 
-			result = gf_AddToken(loader, gf_Ptr(tokeniser), GF_TOKEN_TYPE_STRING, tokeniser->lineno, tokeniser->colno);
 			if (!result) {
-				GF_LOG(loader, GF_LOG_ERROR, "Failed to add string token");
+				GF_LOG(loader, GF_LOG_ERROR, "Failed to tokenise file [%s] at line %" PRIu64 ", column %" PRIu64 ". %s",
+					pipeline->filename, token.lineno, token.colno, tokeniser.error ? tokeniser.error : "");
 				return 0;
 			}
 
-			if (gf_GetChar(tokeniser) != '\"') {
-				int lastCharPossibleEscapeChar = 0;
-				gf_IncrementIndex(tokeniser);
-				while (1) {
-
-					if (gf_GetChar(tokeniser) == '\0') {
-						GF_LOG(loader, GF_LOG_ERROR, "String does not end before the file ends");
+			// Strings with escapes are decoded into the arena when they are added. Everything else is copied there, NULL
+			// terminated so numbers are read up to their end, without the padding of an allocation each.
+			if (!(token.flags & GF_TOKEN_FLAG_ESCAPED)) {
+				if (token.length + 1 > textLeft) {
+					textLeft = token.length + 1 > GF_ARENA_BLOCK_SIZE / 4 ? token.length + 1 : GF_ARENA_BLOCK_SIZE / 4;
+					text = (char *)gf_ArenaAllocate(loader, textLeft);
+					if (!text) {
+						GF_LOG(loader, GF_LOG_ERROR, "Out of memory. Failed to copy the text of a token of file [%s]", pipeline->filename);
 						return 0;
 					}
-					else if (gf_GetChar(tokeniser) == '\"' && !lastCharPossibleEscapeChar) {
-						break;
-					}
-					else if (gf_GetChar(tokeniser) == '\\') {
-						lastCharPossibleEscapeChar = 1;
-					}
-					else {
-						lastCharPossibleEscapeChar = 0;
-					}
-
-					gf_IncrementLastTokenLength(loader);
-					gf_IncrementIndex(tokeniser);
 				}
+				memcpy(text, token.start, (size_t)token.length);
+				text[token.length] = '\0';
+				token.start = text;
+				text += token.length + 1;
+				textLeft -= token.length + 1;
 			}
 
-			gf_IncrementIndex(tokeniser);
-		}
-		else if (isalpha(gf_GetChar(tokeniser))) {
-
-			result = gf_AddToken(loader, gf_Ptr(tokeniser), GF_TOKEN_TYPE_NAME, tokeniser->lineno, tokeniser->colno);
-			if (!result) {
-				GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, loader->lastToken, "Failed to add name token");
+			if (!gf_AddScannedToken(loader, &token)) {
 				return 0;
 			}
-			gf_IncrementIndex(tokeniser);
-
-			while (isalpha(gf_GetChar(tokeniser)) || isdigit(gf_GetChar(tokeniser)) || gf_GetChar(tokeniser) == '_') {
-				gf_IncrementLastTokenLength(loader);
-				gf_IncrementIndex(tokeniser);
+			if (token.type == GF_TOKEN_TYPE_END_FILE) {
+				return 1;
 			}
 		}
-		else if (isdigit(gf_GetChar(tokeniser)) || gf_GetChar(tokeniser) == '-' || gf_GetChar(tokeniser) == '+') {
 
-			int hasFloatingPoint = 0;
-			int hasPlusOrMinus = gf_GetChar(tokeniser) == '-' || gf_GetChar(tokeniser) == '+';
+		// What is left of the window is a token that was cut off. It is moved to the start and the next block added after it.
+		gf_u64 start = tokeniser.index;
+		gf_CountPipelineLines(window, windowStart, located, start, &lineno, &lineStart);
+		memmove(loader->fileContentsBuffer, loader->fileContentsBuffer + start, (size_t)(windowLength - start));
+		windowLength -= start;
+		windowStart += start;
+		if (!gf_FillPipelineWindow(loader, pipeline, &windowLength, windowLength + 1)) {
+			return 0;
+		}
+	}
+}
 
-			result = gf_AddToken(loader, gf_Ptr(tokeniser), GF_TOKEN_TYPE_FLOAT, tokeniser->lineno, tokeniser->colno);
-			if (!result) {
-				GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, loader->lastToken, "Failed to add float token");
-				return 0;
-			}
-			gf_IncrementIndex(tokeniser);
+int gf_LoadFileWithPipeline(gf_Loader *loader, const char *filename, gf_u64 blockSize) {
+	assert(loader);
+	assert(filename);
+
+	FILE *file = fopen(filename, "rb");
+	if (file == NULL) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to load file [%s]. It could not be opened", filename);
+		return 0;
+	}
+	gf_u64 size = 0;
+	if (!gf_GetOpenFileSize(file, &size)) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to load file [%s]. Its size could not be found, or it is bigger than this build can seek", filename);
+		fclose(file);
+		return 0;
+	}
 
-			while (isdigit(gf_GetChar(tokeniser)) || gf_GetChar(tokeniser) == '.') {
-				if (gf_GetChar(tokeniser) == '.') {
+	gf_Pipeline pipeline;
+	memset(&pipeline, 0, sizeof(pipeline));
+	pipeline.filename = filename;
+	pipeline.file = file;
+	int whole = blockSize == 0;
 
-					if (hasFloatingPoint == 0) {
-						hasFloatingPoint = 1;
-					}
+	char header[GF_COMPRESSED_HEADER_SIZE];
+	if (size >= GF_COMPRESSED_HEADER_SIZE + GF_COMPRESSED_FOOTER_SIZE && fread(header, sizeof(header), 1, file) == 1 && gf_IsCompressed(header, sizeof(header))) {
+		if (!gf_OpenCompressedFile(loader, file, filename, header, size, &blockSize, &size)) {
+			fclose(file);
+			return 0;
+		}
+		pipeline.compressed = 1;
+		pipeline.compressedBlock = (char *)gf_Allocate(loader, blockSize);
+		if (!pipeline.compressedBlock) {
+			GF_LOG(loader, GF_LOG_ERROR, "Out of memory. Failed to allocate a block to decompress file [%s]", filename);
+			fclose(file);
+			return 0;
+		}
+	}
+	else if (!gf_SeekFile(file, 0, SEEK_SET)) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to read file [%s]", filename);
+		fclose(file);
+		return 0;
+	}
+	// A file that fits in one block has nothing to overlap with.
+	whole = whole || size <= blockSize;
+	pipeline.size = size;
+	pipeline.blockSize = whole && !pipeline.compressed ? size : blockSize;
 
-					gf_IncrementLastTokenLength(loader);
-					gf_IncrementIndex(tokeniser);
-					while (isdigit(gf_GetChar(tokeniser))) {
-						gf_IncrementLastTokenLength(loader);
-						gf_IncrementIndex(tokeniser);
-					}
-					break;
-				}
-				else {
-					gf_IncrementLastTokenLength(loader);
-					gf_IncrementIndex(tokeniser);
-				}
+	int result = 1;
+	if (size > (gf_u64)SIZE_MAX - 1) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to load file [%s]. It is too big to load in this build", filename);
+		result = 0;
+	}
+	else if (whole) {
+		if (size + 1 > loader->fileContentsCapacity) {
+			gf_Free(loader, loader->fileContentsBuffer);
+			loader->fileContentsCapacity = 0;
+			loader->fileContentsBuffer = (char *)gf_Allocate(loader, size + 1);
+			if (loader->fileContentsBuffer == NULL) {
+				GF_LOG(loader, GF_LOG_ERROR, "Out of memory. Failed to allocate buffer for file [%s]", filename);
+				result = 0;
 			}
-
-			if (!hasFloatingPoint) {
-				loader->lastToken->type = GF_TOKEN_TYPE_INTEGER;
+			else {
+				loader->fileContentsCapacity = size + 1;
 			}
-			// Prevents just having a + or - as a valid number
-			if (hasPlusOrMinus && loader->lastToken->length == 1) {
-				GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, loader->lastToken, "There is a + or - without a number after it.");
-				return 0;
+		}
+		while (result && pipeline.offset < size) {
+			gf_u64 length = 0;
+			result = gf_ReadPipelineBlock(&pipeline, loader->fileContentsBuffer + pipeline.offset, &length);
+			if (!result) {
+				GF_LOG(loader, GF_LOG_ERROR, "Failed to read file [%s]", filename);
 			}
 		}
-		else {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, loader->lastToken, "Unrecognised character %c", gf_GetChar(tokeniser));
-			return 0;
+		if (result) {
+			loader->fileContentsBuffer[size] = '\0';
+			result = gf_LoadInternal(loader, loader->fileContentsBuffer, size + 1);
 		}
 	}
+	else {
+#ifdef GF_THREADS
+		gf_u64 blockCount = GF_PIPELINE_BLOCK_COUNT;
+#else
+		gf_u64 blockCount = 1;
+#endif
+		pipeline.blocks = (char *)gf_Allocate(loader, blockSize * blockCount);
+		if (!pipeline.blocks) {
+			GF_LOG(loader, GF_LOG_ERROR, "Out of memory. Failed to allocate the blocks to read file [%s] into", filename);
+			gf_Free(loader, pipeline.compressedBlock);
+			fclose(file);
+			return 0;
+		}
 
-	return 1;
-}
+#ifdef GF_THREADS
+		pthread_mutex_init(&pipeline.lock, NULL);
+		pthread_cond_init(&pipeline.blockRead, NULL);
+		pthread_cond_init(&pipeline.blockUsed, NULL);
 
-int gf_Tokenise(gf_Loader *loader, const char *buffer, gf_u64 count) {
-	assert(loader);
-	assert(buffer);
+		pthread_t thread;
+		pipeline.threaded = pthread_create(&thread, NULL, gf_ReadPipelineThread, &pipeline) == 0;
+#endif
 
-	gf_Tokeniser tokeniser;
-	gf_InitTokeniser(&tokeniser, buffer, count);
+		// Binary text is not tokenised and its tokens point into it, so all of it is read first like a file read in one go.
+		gf_u64 windowLength = 0;
+		gf_u64 headerSize = size < GF_BINARY_HEADER_SIZE ? size : GF_BINARY_HEADER_SIZE;
+		result = gf_FillPipelineWindow(loader, &pipeline, &windowLength, headerSize);
+		if (result && (gf_IsBinary(loader->fileContentsBuffer, windowLength) || gf_IsCompressed(loader->fileContentsBuffer, windowLength))) {
+			whole = 1;
+			result = gf_FillPipelineWindow(loader, &pipeline, &windowLength, size) && gf_LoadInternal(loader, loader->fileContentsBuffer, size + 1);
+		}
+		else if (result) {
+			gf_InitLineIndex(&loader->lines, loader, NULL, 0);
+			result = gf_TokenisePipeline(loader, &pipeline, windowLength);
+		}
 
-	return gf_TokeniseInternal(loader, &tokeniser);
-}
+#ifdef GF_THREADS
+		if (pipeline.threaded) {
+			// Reading stops early if loading failed part way through.
+			pthread_mutex_lock(&pipeline.lock);
+			pipeline.stop = 1;
+			pthread_cond_signal(&pipeline.blockUsed);
+			pthread_mutex_unlock(&pipeline.lock);
+			pthread_join(thread, NULL);
+		}
+		pthread_cond_destroy(&pipeline.blockUsed);
+		pthread_cond_destroy(&pipeline.blockRead);
+		pthread_mutex_destroy(&pipeline.lock);
+#endif
+		gf_Free(loader, pipeline.blocks);
+	}
+	gf_Free(loader, pipeline.compressedBlock);
+	fclose(file);
 
-gf_Token *gf_ConsumeToken(gf_Loader *loader) {
-	gf_Token *token = loader->curToken;
-	if (!token) {
-		return NULL;
+	if (!result || whole) {
+		return result;
 	}
-	loader->curToken = loader->curToken->next;
-	return token;
+	return gf_ParseTokens(loader);
 }
 
-gf_Token *gf_PeekToken(gf_Loader *loader) {
-	return loader->curToken;
-}
+/*-----------------------------------------------------------------------------------*/
 
-gf_LoaderNode *gf_AddNode(gf_Loader *loader, gf_Token *token) {
-	gf_LoaderNode *node = (gf_LoaderNode *)loader->Allocate(sizeof(gf_LoaderNode));
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "Out of memory. Failed to allocate loader node");
-		return NULL;
-	}
+/*-----------------------------------COMPRESSION-------------------------------------*/
 
-	if (loader->lastNode) {
-		loader->lastNode->nextAllocated = node;
-	}
-	loader->lastNode = node;
+int gf_IsCompressed(const char *buffer, gf_u64 count) {
+	assert(buffer);
 
-	node->token = token;
-	node->parent = NULL;
-	node->next = NULL;
-	node->prev = NULL;
-	node->childrenHead = NULL;
-	node->childrenTail = NULL;
-	node->nextAllocated = NULL;
-	return node;
+	return count >= GF_COMPRESSED_HEADER_SIZE && buffer[0] == 'G' && buffer[1] == 'F' && buffer[2] == 'Z' && buffer[3] == GF_COMPRESSED_VERSION;
 }
 
-void gf_AddChild(gf_LoaderNode *parent, gf_LoaderNode *child) {
-	if (parent == NULL) return;
-	if (parent->childrenHead == NULL) {
-		parent->childrenHead = child;
-		parent->childrenTail = child;
-		child->next = NULL;
-		child->prev = NULL;
-	}
-	else {
-		parent->childrenTail->next = child;
-		child->prev = parent->childrenTail;
-		child->next = NULL;
-		parent->childrenTail = child;
+/*
+Writes the part of a length that does not fit in its 4 bits of the token, 255 at a time.
+*/
+unsigned char *gf_WriteCompressedLength(unsigned char *out, gf_u64 length) {
+	if (length >= 15) {
+		length -= 15;
+		while (length >= 255) {
+			*out++ = 255;
+			length -= 255;
+		}
+		*out++ = (unsigned char)length;
 	}
-	child->parent = parent;
+	return out;
 }
 
-int gf_Parse(gf_Loader *loader, gf_LoaderNode *parentNode) {
-	assert(loader);
-	assert(loader->curToken);
-	assert(loader->lastToken);
-	assert(parentNode);
+/*
+Reads the rest of a length that is 15 in the token. Returns 0 if the block ends first.
+*/
+int gf_ReadCompressedLength(const unsigned char **in, const unsigned char *end, gf_u64 *length) {
+	if (*length == 15) {
+		unsigned char next;
+		do {
+			if (*in >= end) {
+				return 0;
+			}
+			next = *(*in)++;
+			*length += next;
+		} while (next == 255);
+	}
+	return 1;
+}
 
-	int result = 0;
-	gf_Token *token = NULL;
-	while ((token = gf_ConsumeToken(loader))) {
+/*
+Writes one sequence of literals followed by a match. A matchLength of 0 writes the last sequence, which has no match.
+*/
+unsigned char *gf_WriteCompressedSequence(unsigned char *out, const unsigned char *literals, gf_u64 literalLength, gf_u64 offset, gf_u64 matchLength) {
+	gf_u64 matchCode = matchLength ? matchLength - GF_COMPRESS_MIN_MATCH : 0;
+	*out++ = (unsigned char)(((literalLength < 15 ? literalLength : 15) << 4) | (matchCode < 15 ? matchCode : 15));
+	out = gf_WriteCompressedLength(out, literalLength);
+	memcpy(out, literals, (size_t)literalLength);
+	out += literalLength;
+
+	if (matchLength) {
+		out[0] = (unsigned char)(offset & 0xFF);
+		out[1] = (unsigned char)(offset >> 8);
+		out = gf_WriteCompressedLength(out + 2, matchCode);
+	}
+	return out;
+}
 
-		if (token->type == GF_TOKEN_TYPE_NAME) {
+gf_u64 gf_CompressBlock(const char *source, gf_u64 length, char *destination, gf_u32 *table) {
+	assert(source);
+	assert(destination);
+	assert(table);
 
-			if (parentNode) {
-				parentNode->token->type = GF_TOKEN_TYPE_COMPOSITE_TYPE;
-			}
+	const unsigned char *in = (const unsigned char *)source;
+	unsigned char *out = (unsigned char *)destination;
+	memset(table, 0, sizeof(gf_u32) << GF_COMPRESS_HASH_BITS);
 
-			gf_Token *peek = gf_PeekToken(loader);
-			if (!peek) {
-				return 0;
+	gf_u64 anchor = 0;
+	gf_u64 i = 0;
+	while (i + GF_COMPRESS_MIN_MATCH <= length) {
+		gf_u32 sequence = gf_ReadU32LE(source + i);
+		gf_u32 hash = (gf_u32)(sequence * 2654435761u) >> (32 - GF_COMPRESS_HASH_BITS);
+		gf_u64 candidate = table[hash];
+		table[hash] = (gf_u32)i;
+
+		if (candidate < i && i - candidate <= GF_COMPRESS_MAX_OFFSET && gf_ReadU32LE(source + candidate) == sequence) {
+			gf_u64 matchLength = GF_COMPRESS_MIN_MATCH;
+			while (i + matchLength < length && in[candidate + matchLength] == in[i + matchLength]) {
+				matchLength++;
 			}
+			out = gf_WriteCompressedSequence(out, in + anchor, i - anchor, i - candidate, matchLength);
+			i += matchLength;
+			anchor = i;
+		}
+		else {
+			// Steps further the longer nothing has matched, so text that does not compress is passed over quickly.
+			i += 1 + ((i - anchor) >> 6);
+		}
+	}
 
-			if (peek->type == GF_TOKEN_TYPE_VALUE_ASSIGN) {
+	out = gf_WriteCompressedSequence(out, in + anchor, length - anchor, 0, 0);
+	return (gf_u64)(out - (unsigned char *)destination);
+}
 
-				gf_LoaderNode *node = gf_AddNode(loader, token);
-				if (!node) {
-					return 0;
-				}
+int gf_DecompressBlock(const char *source, gf_u64 sourceLength, char *destination, gf_u64 length) {
+	assert(source);
+	assert(destination);
 
-				gf_AddChild(parentNode, node);
-				gf_ConsumeToken(loader);
+	const unsigned char *in = (const unsigned char *)source;
+	const unsigned char *inEnd = in + sourceLength;
+	unsigned char *start = (unsigned char *)destination;
+	unsigned char *out = start;
+	unsigned char *outEnd = start + length;
 
-				loader->nestLevel++;
-				result = gf_Parse(loader, node);
-				if (!result) {
-					return 0;
-				}
-			}
-			else {
-				gf_LoaderNode *node = gf_AddNode(loader, token);
-				if (!node) {
-					return 0;
-				}
+	while (in < inEnd) {
+		unsigned char token = *in++;
 
-				gf_AddChild(parentNode, node);
-			}
+		gf_u64 literalLength = (gf_u64)(token >> 4);
+		if (!gf_ReadCompressedLength(&in, inEnd, &literalLength) || literalLength > (gf_u64)(inEnd - in) || literalLength > (gf_u64)(outEnd - out)) {
+			return 0;
 		}
-		else if (token->type == GF_TOKEN_TYPE_STRING || token->type == GF_TOKEN_TYPE_FLOAT || token->type == GF_TOKEN_TYPE_INTEGER) {
-
-			gf_LoaderNode *node = gf_AddNode(loader, token);
-			if (!node) {
-				return 0;
-			}
+		memcpy(out, in, (size_t)literalLength);
+		in += literalLength;
+		out += literalLength;
 
-			gf_AddChild(parentNode, node);
-		}
-		else if (token->type == GF_TOKEN_TYPE_CURLY_CLOSE) {
-			loader->nestLevel--;
+		// The last sequence has no match.
+		if (in == inEnd) {
 			break;
 		}
-		else if (token->type == GF_TOKEN_TYPE_END_FILE) {
-			break;
+
+		if (inEnd - in < 2) {
+			return 0;
 		}
-		else if (token->type == GF_TOKEN_TYPE_VALUE_ASSIGN)  {
-			GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, token, "unexpected value assign at token. It is likely because the token before it is not an identifier node.");
+		gf_u64 offset = (gf_u64)in[0] | ((gf_u64)in[1] << 8);
+		in += 2;
+		gf_u64 matchLength = (gf_u64)(token & 15);
+		if (!gf_ReadCompressedLength(&in, inEnd, &matchLength)) {
 			return 0;
 		}
+		matchLength += GF_COMPRESS_MIN_MATCH;
+		if (offset == 0 || offset > (gf_u64)(out - start) || matchLength > (gf_u64)(outEnd - out)) {
+			return 0;
+		}
+
+		// A match can overlap the bytes it makes, like a run of spaces that is 1 back. It is copied in pieces no longer than
+		// how far back they are copied from, and as the pattern repeats every offset bytes that distance can double each time.
+		gf_u64 distance = offset;
+		while (matchLength > 0) {
+			gf_u64 piece = matchLength < distance ? matchLength : distance;
+			memcpy(out, out - distance, (size_t)piece);
+			out += piece;
+			matchLength -= piece;
+			distance *= 2;
+		}
 	}
 
-	return 1;
+	return out == outEnd;
 }
 
-
-int gf_LoadInternal(gf_Loader *loader, const char *buffer, gf_u64 bufferCount) {
-	assert(loader);
+int gf_DecompressBuffer(const char *buffer, gf_u64 count, char *text, gf_u64 *textLength) {
 	assert(buffer);
+	assert(textLength);
 
-	int result = gf_Tokenise(loader, buffer, bufferCount);
-	if (!result) {
-		GF_LOG(loader, GF_LOG_ERROR, "Failed to tokenise");
-		return 0;
-	}
-
-	loader->rootNode = gf_AddNode(loader, &loader->rootToken);
-	if (!loader->rootNode) {
+	if (!gf_IsCompressed(buffer, count)) {
 		return 0;
 	}
-	loader->curToken = &loader->rootToken;
+	gf_u64 blockSize = gf_ReadU32LE(buffer + 4);
 
-	loader->nestLevel = 0;
-	result = gf_Parse(loader, loader->rootNode);
+	gf_u64 position = GF_COMPRESSED_HEADER_SIZE;
+	gf_u64 offset = 0;
+	while (1) {
+		if (count - position < GF_COMPRESSED_BLOCK_HEADER_SIZE) {
+			return 0;
+		}
+		gf_u64 length = gf_ReadU32LE(buffer + position);
+		gf_u64 storedLength = gf_ReadU32LE(buffer + position + 4);
+		position += GF_COMPRESSED_BLOCK_HEADER_SIZE;
 
-	if (loader->nestLevel != 0) {
-		GF_LOG(loader, GF_LOG_ERROR, "There is a missing closing brace }. A brace has been opened { without a matching close.");
-		result = 0;
+		if (length == 0) {
+			if (storedLength != 0) {
+				return 0;
+			}
+			break;
+		}
+		if (length > blockSize || storedLength > length || storedLength > count - position) {
+			return 0;
+		}
+		if (text) {
+			if (length > *textLength - offset) {
+				return 0;
+			}
+			if (storedLength == length) {
+				memcpy(text + offset, buffer + position, (size_t)length);
+			}
+			else if (!gf_DecompressBlock(buffer + position, storedLength, text + offset, length)) {
+				return 0;
+			}
+		}
+		offset += length;
+		position += storedLength;
 	}
 
-	if (!result) {
-		GF_LOG(loader, GF_LOG_ERROR, "Failed to parse");
+	if (count - position < 8 || gf_ReadU64LE(buffer + position) != offset) {
 		return 0;
 	}
-
+	*textLength = offset;
 	return 1;
 }
 
-int gf_LoadFromBuffer(gf_Loader *loader, const char *buffer, gf_u64 bufferCount, gf_LogAllocateFreeFunctions *funcs) {
+int gf_LoadCompressedInternal(gf_Loader *loader, const char *buffer, gf_u64 bufferCount) {
 	assert(loader);
 	assert(buffer);
 
-	gf_InitLoader(loader, funcs);
-
-	return gf_LoadInternal(loader, buffer, bufferCount);
-}
-
-int gf_LoadFromFile(gf_Loader *loader, const char *filename, gf_LogAllocateFreeFunctions *funcs) {
-	assert(loader);
-	assert(filename);
-
-	gf_InitLoader(loader, funcs);
-
-	gf_u64 bufferCount = 0;
-	loader->fileContentsBuffer = gf_AllocateNullTerminatedBufferFromFile(loader, filename, &bufferCount);
-	if (!loader->fileContentsBuffer) {
+	gf_u64 length = 0;
+	if (!gf_DecompressBuffer(buffer, bufferCount, NULL, &length)) {
+		GF_LOG(loader, GF_LOG_ERROR, "The compressed text is broken and can not be decompressed");
 		return 0;
 	}
 
-	return gf_LoadInternal(loader, loader->fileContentsBuffer, bufferCount);
-}
-
-void gf_Unload(gf_Loader *loader) {
-	assert(loader);
-
-	gf_Token *token = loader->firstToken;
-	gf_Token *nextToken;
-	while (token) {
-		nextToken = token->next;
-		loader->Free(token);
-		token = nextToken;
+	char *text = (char *)gf_ArenaAllocate(loader, length + 1);
+	if (!text) {
+		GF_LOG(loader, GF_LOG_ERROR, "Out of memory. Failed to allocate [%" PRIu64 "] bytes to decompress into", length + 1);
+		return 0;
 	}
-
-	gf_LoaderNode *node = loader->rootNode;
-	gf_LoaderNode *nextNode;
-	while (node) {
-		nextNode = node->nextAllocated;
-		loader->Free(node);
-		node = nextNode;
+	if (!gf_DecompressBuffer(buffer, bufferCount, text, &length)) {
+		GF_LOG(loader, GF_LOG_ERROR, "The compressed text is broken and can not be decompressed");
+		return 0;
 	}
+	text[length] = '\0';
 
-	loader->Free(loader->fileContentsBuffer);
-	loader->fileContentsBuffer = NULL;
+	return gf_LoadInternal(loader, text, length + 1);
 }
 
-int gf_LoaderNodeToU32(gf_Loader *loader, gf_LoaderNode *node, gf_u32 *value) {
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null in gf_LoaderNodeToU32");
-		return 0;
-	}
-	if (node->token->type != GF_TOKEN_TYPE_INTEGER) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "node type is not integer");
+int gf_OpenCompressedFile(gf_Loader *loader, FILE *file, const char *filename, const char *header, gf_u64 fileSize, gf_u64 *blockSize, gf_u64 *textSize) {
+	assert(loader);
+	assert(file);
+	assert(filename);
+	assert(header);
+	assert(blockSize);
+	assert(textSize);
+
+	char footer[GF_COMPRESSED_FOOTER_SIZE];
+	if (!gf_SeekFile(file, (gf_s64)(fileSize - GF_COMPRESSED_FOOTER_SIZE), SEEK_SET) || fread(footer, sizeof(footer), 1, file) != 1 ||
+		!gf_SeekFile(file, GF_COMPRESSED_HEADER_SIZE, SEEK_SET)) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to read file [%s]", filename);
 		return 0;
 	}
-	if (!gf_StringSpanToU32(node->token->start, node->token->length, value)) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "unable to convert token to u32 in gf_LoaderNodeToU32");
+
+	// Every block takes atleast the bytes of its header, which limits how much text there can be.
+	*blockSize = gf_ReadU32LE(header + 4);
+	*textSize = gf_ReadU64LE(footer + 8);
+	gf_u64 maxBlocks = (fileSize - GF_COMPRESSED_HEADER_SIZE) / GF_COMPRESSED_BLOCK_HEADER_SIZE;
+	if (gf_ReadU64LE(footer) != 0 || *blockSize == 0 || *blockSize > GF_MAX_COMPRESS_BLOCK_SIZE || *textSize / *blockSize > maxBlocks) {
+		GF_LOG(loader, GF_LOG_ERROR, "Failed to load file [%s]. It is compressed but its header or footer is broken", filename);
 		return 0;
 	}
 	return 1;
 }
 
-int gf_LoaderNodeToU64(gf_Loader *loader, gf_LoaderNode *node, gf_u64 *value) {
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null in gf_LoaderNodeToU64");
+int gf_ReadCompressedBlock(FILE *file, char *compressedBlock, gf_u64 blockSize, char *destination, gf_u64 remaining, gf_u64 *length) {
+	assert(file);
+	assert(compressedBlock);
+	assert(destination);
+	assert(length);
+
+	char header[GF_COMPRESSED_BLOCK_HEADER_SIZE];
+	if (fread(header, sizeof(header), 1, file) != 1) {
 		return 0;
 	}
-	if (node->token->type != GF_TOKEN_TYPE_INTEGER) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "node type is not integer");
+	*length = gf_ReadU32LE(header);
+	gf_u64 storedLength = gf_ReadU32LE(header + 4);
+	if (*length == 0 || *length > blockSize || *length > remaining || storedLength > *length) {
 		return 0;
 	}
-	if (!gf_StringSpanToU64(node->token->start, node->token->length, value)) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "unable to convert token to u64 in gf_LoaderNodeToU64");
-		return 0;
+
+	if (storedLength == *length) {
+		return fread(destination, (size_t)*length, 1, file) == 1;
 	}
-	return 1;
+	return fread(compressedBlock, (size_t)storedLength, 1, file) == 1 && gf_DecompressBlock(compressedBlock, storedLength, destination, *length);
 }
 
-int gf_LoaderNodeToS32(gf_Loader *loader, gf_LoaderNode *node, gf_s32 *value) {
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null in gf_LoaderNodeToS32");
-		return 0;
-	}
-	if (node->token->type != GF_TOKEN_TYPE_INTEGER) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "node type is not integer");
+/*
+Frees the buffers of a compressor.
+*/
+void gf_FreeCompressor(gf_Compressor *compressor) {
+	gf_Free(&compressor->storage, compressor->block);
+	gf_Free(&compressor->storage, compressor->compressed);
+	gf_Free(&compressor->storage, compressor->table);
+	compressor->block = NULL;
+	compressor->compressed = NULL;
+	compressor->table = NULL;
+}
+
+int gf_SaverBeginCompressed(gf_Saver *saver, gf_Compressor *compressor, FILE *file, gf_LogAllocateFreeFunctions *funcs) {
+	assert(saver);
+	assert(compressor);
+	assert(file);
+
+	gf_InitLoader(&compressor->storage, funcs);
+	compressor->file = file;
+	compressor->blockUsed = 0;
+	compressor->total = 0;
+	compressor->block = (char *)gf_Allocate(&compressor->storage, GF_COMPRESS_BLOCK_SIZE + 1);
+	compressor->compressed = (char *)gf_Allocate(&compressor->storage, GF_COMPRESS_BOUND(GF_COMPRESS_BLOCK_SIZE));
+	compressor->table = (gf_u32 *)gf_Allocate(&compressor->storage, sizeof(gf_u32) << GF_COMPRESS_HASH_BITS);
+	if (!compressor->block || !compressor->compressed || !compressor->table) {
+		GF_LOG((&compressor->storage), GF_LOG_ERROR, "Out of memory. Failed to allocate the buffers to compress with");
+		gf_FreeCompressor(compressor);
 		return 0;
 	}
-	if (!gf_StringSpanToS32(node->token->start, node->token->length, value)) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "unable to convert token to S64 in gf_LoaderNodeToS32");
+
+	char header[GF_COMPRESSED_HEADER_SIZE];
+	header[0] = 'G';
+	header[1] = 'F';
+	header[2] = 'Z';
+	header[3] = GF_COMPRESSED_VERSION;
+	gf_WriteU32LE(header + 4, GF_COMPRESS_BLOCK_SIZE);
+	if (fwrite(header, sizeof(header), 1, file) != 1) {
+		GF_LOG((&compressor->storage), GF_LOG_ERROR, "fwrite failed to write the header of a compressed file");
+		gf_FreeCompressor(compressor);
 		return 0;
 	}
+
+	saver->target = GF_SAVER_TARGET_COMPRESSED;
+	saver->compressor = compressor;
+	saver->memory = NULL;
+	saver->memoryCapacity = 0;
+	saver->written = 0;
 	return 1;
 }
 
+int gf_SaverEndCompressed(gf_Saver *saver) {
+	assert(saver);
+	assert(saver->target == GF_SAVER_TARGET_COMPRESSED);
+
+	gf_Compressor *compressor = saver->compressor;
+	int result = gf_FlushCompressor(compressor);
+	if (result) {
+		char footer[GF_COMPRESSED_FOOTER_SIZE];
+		gf_WriteU64LE(footer, 0);
+		gf_WriteU64LE(footer + 8, compressor->total);
+		if (fwrite(footer, sizeof(footer), 1, compressor->file) != 1) {
+			GF_LOG((&compressor->storage), GF_LOG_ERROR, "fwrite failed to write the footer of a compressed file");
+			result = 0;
+		}
+	}
 
-int gf_LoaderNodeToS64(gf_Loader *loader, gf_LoaderNode *node, gf_s64 *value) {
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null in gf_LoaderNodeToS64");
-		return 0;
+	gf_FreeCompressor(compressor);
+	saver->target = GF_SAVER_TARGET_FILE;
+	saver->compressor = NULL;
+	return result;
+}
+
+int gf_FlushCompressor(gf_Compressor *compressor) {
+	assert(compressor);
+
+	if (compressor->blockUsed == 0) {
+		return 1;
 	}
-	if (node->token->type != GF_TOKEN_TYPE_INTEGER) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "node type is not integer");
-		return 0;
+
+	const char *stored = compressor->compressed;
+	gf_u64 storedLength = gf_CompressBlock(compressor->block, compressor->blockUsed, compressor->compressed, compressor->table);
+	if (storedLength >= compressor->blockUsed) {
+		stored = compressor->block;
+		storedLength = compressor->blockUsed;
 	}
-	if (!gf_StringSpanToS64(node->token->start, node->token->length, value)) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "unable to convert token to S64 in gf_LoaderNodeToS64");
+
+	char header[GF_COMPRESSED_BLOCK_HEADER_SIZE];
+	gf_WriteU32LE(header, (gf_u32)compressor->blockUsed);
+	gf_WriteU32LE(header + 4, (gf_u32)storedLength);
+	if (fwrite(header, sizeof(header), 1, compressor->file) != 1 || fwrite(stored, (size_t)storedLength, 1, compressor->file) != 1) {
+		GF_LOG((&compressor->storage), GF_LOG_ERROR, "fwrite failed to write a compressed block of [%" PRIu64 "] bytes", storedLength);
 		return 0;
 	}
+
+	compressor->total += compressor->blockUsed;
+	compressor->blockUsed = 0;
 	return 1;
 }
 
-int gf_LoaderNodeToF64(gf_Loader *loader, gf_LoaderNode *node, gf_f64 *value) {
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null in gf_LoaderNodeToF64");
-		return 0;
-	}
-	if (node->token->type != GF_TOKEN_TYPE_FLOAT) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "node type is not float");
-		return 0;
-	}
-	if (!gf_StringSpanToF64(node->token->start, node->token->length, value)) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "unable to convert token to S64 in gf_LoaderNodeToF64");
-		return 0;
+int gf_CompressorWrite(gf_Compressor *compressor, const char *data, gf_u64 length) {
+	assert(compressor);
+	assert(data);
+
+	while (length > 0) {
+		if (compressor->blockUsed == GF_COMPRESS_BLOCK_SIZE && !gf_FlushCompressor(compressor)) {
+			return 0;
+		}
+		gf_u64 space = GF_COMPRESS_BLOCK_SIZE - compressor->blockUsed;
+		gf_u64 count = length < space ? length : space;
+		memcpy(compressor->block + compressor->blockUsed, data, (size_t)count);
+		compressor->blockUsed += count;
+		data += count;
+		length -= count;
 	}
 	return 1;
 }
 
-int gf_LoaderNodeToF32(gf_Loader *loader, gf_LoaderNode *node, gf_f32 *value) {
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null in gf_LoaderNodeToF32");
-		return 0;
+int gf_CompressorPrintf(gf_Compressor *compressor, const char *format, va_list args, va_list retry) {
+	assert(compressor);
+	assert(format);
+
+	// The block has room for a NULL terminator after it.
+	gf_u64 space = GF_COMPRESS_BLOCK_SIZE - compressor->blockUsed;
+	int result = vsnprintf(compressor->block + compressor->blockUsed, (size_t)space + 1, format, args);
+	if (result < 0 || (gf_u64)result <= space) {
+		if (result > 0) {
+			compressor->blockUsed += (gf_u64)result;
+		}
+		return result;
 	}
-	if (node->token->type != GF_TOKEN_TYPE_FLOAT) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "node type is not float");
-		return 0;
+
+	if (!gf_FlushCompressor(compressor)) {
+		return -1;
 	}
-	if (!gf_StringSpanToF32(node->token->start, node->token->length, value)) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "unable to convert token to S64 in gf_LoaderNodeToF32");
-		return 0;
+	if ((gf_u64)result <= GF_COMPRESS_BLOCK_SIZE) {
+		vsnprintf(compressor->block, GF_COMPRESS_BLOCK_SIZE + 1, format, retry);
+		compressor->blockUsed = (gf_u64)result;
+		return result;
 	}
-	return 1;
+
+	// Text longer than a whole block is formatted on its own first.
+	char *text = (char *)gf_Allocate(&compressor->storage, (gf_u64)result + 1);
+	if (!text) {
+		GF_LOG((&compressor->storage), GF_LOG_ERROR, "Out of memory. Failed to allocate [%d] bytes to format text into", result + 1);
+		return -1;
+	}
+	vsnprintf(text, (size_t)result + 1, format, retry);
+	if (!gf_CompressorWrite(compressor, text, (gf_u64)result)) {
+		result = -1;
+	}
+	gf_Free(&compressor->storage, text);
+	return result;
 }
 
-int gf_LoaderNodeToString(gf_Loader *loader, gf_LoaderNode *node, char *src, gf_u64 srcCapacityIncludesNullTerminator) {
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null in gf_LoaderNodeToString");
+int gf_CompressFile(const char *inputFilename, const char *outputFilename, gf_LogAllocateFreeFunctions *funcs) {
+	assert(inputFilename);
+	assert(outputFilename);
+
+	gf_Loader loader;
+	gf_InitLoader(&loader, funcs);
+	gf_u64 count = 0;
+	if (!gf_ReadFileIntoLoader(&loader, inputFilename, &count)) {
+		gf_Unload(&loader);
 		return 0;
 	}
-	if (node->token->type != GF_TOKEN_TYPE_STRING) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "node type is not a string");
-		return 0;
+
+	gf_Saver saver;
+	gf_InitSaver(&saver, funcs ? funcs->Log : NULL);
+
+	int result = 0;
+	FILE *file = fopen(outputFilename, "wb");
+	if (!file) {
+		GF_LOG((&loader), GF_LOG_ERROR, "Failed to open %s to write to", outputFilename);
 	}
-	if (node->token->length >= srcCapacityIncludesNullTerminator) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "unable to convert token to string in gf_LoaderNodeToString");
-		return 0;
+	else {
+		gf_Compressor compressor;
+		if (gf_SaverBeginCompressed(&saver, &compressor, file, funcs)) {
+			result = gf_SaverWrite(&saver, NULL, loader.fileContentsBuffer, count - 1);
+			result = gf_SaverEndCompressed(&saver) && result;
+		}
+		if (fclose(file) != 0) {
+			result = 0;
+		}
 	}
-	memcpy(src, node->token->start, node->token->length);
-	src[node->token->length] = '\0';
 
-	return 1;
+	gf_Unload(&loader);
+	return result;
 }
 
+/*-----------------------------------------------------------------------------------*/
+
+#endif
 
-gf_LoaderNode *gf_GetRoot(gf_Loader *loader) {
-	assert(loader);
+#ifdef GF_IMPLEMENTATION_WITH_TESTS
 
-	if (!loader->rootNode) {
-		GF_LOG(loader, GF_LOG_WARNING, "loader has no root node");
-		return NULL;
+/*-------------------------------------TESTS-----------------------------------------*/
+
+// Counts the allocations made through the context of a loader so the tests can check everything is freed.
+typedef struct gf_TestAllocatorContext {
+	gf_u64 allocations; // The number of allocations that have not been freed yet.
+	gf_u64 total;       // The number of allocations ever made.
+} gf_TestAllocatorContext;
+
+void *gf_TestAllocate(void *context, size_t size) {
+	gf_TestAllocatorContext *counter = (gf_TestAllocatorContext *)context;
+	counter->allocations++;
+	counter->total++;
+	return malloc(size);
+}
+
+void gf_TestFree(void *context, void *pointer) {
+	gf_TestAllocatorContext *counter = (gf_TestAllocatorContext *)context;
+	if (pointer) {
+		counter->allocations--;
 	}
-	return loader->rootNode;
+	free(pointer);
 }
 
-gf_LoaderNode *gf_GetNext(gf_Loader *loader, gf_LoaderNode *node) {
-	assert(loader);
+// The position of the last token logged by gf_TestLogPosition.
+gf_u64 gf_TestLoggedLineno;
+gf_u64 gf_TestLoggedColno;
 
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null");
-		return NULL;
+void gf_TestLogPosition(gf_LogLevel level, int lineno, gf_Token *token, const char *format, va_list vlist) {
+	(void)level;
+	(void)lineno;
+	(void)format;
+	(void)vlist;
+	if (token) {
+		gf_TestLoggedLineno = token->lineno;
+		gf_TestLoggedColno = token->colno;
 	}
-	else if (!node->next) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_WARNING, node->token, "node's next is null");
-		return NULL;
+}
+
+int gf_Test(void) {
+
+	{
+		const char *str = "a {";
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
+		GF_TEST_ASSERT(result == 0, str);
+		gf_Unload(&loader);
 	}
-	else {
-		return node->next;
+	{
+		const char *str = "{{{{{{{{{{{{{}}";
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
+		GF_TEST_ASSERT(result == 0, str);
+		gf_Unload(&loader);
+	}
+	{
+		const char *str = "{{{{{{{{{{{{{a}}}}}}}}}}}}}";
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
+		GF_TEST_ASSERT(result == 0, str);
+		gf_Unload(&loader);
+	}
+	{
+		const char *str = "   ";
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
+		GF_TEST_ASSERT(result == 1, str);
+		gf_Unload(&loader);
+	}
+	{
+		const char *str = "/* this is a comment */";
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
+		GF_TEST_ASSERT(result == 1, str);
+		gf_Unload(&loader);
+	}
+	{
+		const char *str = "3.0 { a }";
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
+		GF_TEST_ASSERT(result == 0, str);
+		gf_Unload(&loader);
+	}
+	{
+		const char *str = "{ a, b, c, d }";
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
+		GF_TEST_ASSERT(result == 0, str);
+		gf_Unload(&loader);
+	}
+	{
+		const char *str = "a, b, c, d";
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
+		GF_TEST_ASSERT(result == 1, str);
+		gf_Unload(&loader);
+	}
+	{
+		gf_Loader loader;
+		static char src[1 << 20];
+		memset(src, '-', sizeof(src) - 1);
+		int result = gf_LoadFromBuffer(&loader, src, sizeof(src) - 1, 0);
+		GF_TEST_ASSERT(result == 0, "big test");
+		gf_Unload(&loader);
 	}
-}
 
-gf_LoaderNode *gf_GetChild(gf_Loader *loader, gf_LoaderNode *node) {
-	assert(loader);
+	{
+		const char *str = "a b c d e ";
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
+		GF_TEST_ASSERT(result == 1, str);
+		gf_Unload(&loader);
+	}
+	{
+		const char *str = "a /*";
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
+		GF_TEST_ASSERT(result == 0, str);
+		gf_Unload(&loader);
+	}
+	{
+		const char *str = "a \"";
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
+		GF_TEST_ASSERT(result == 0, str);
+		gf_Unload(&loader);
+	}
+	{
+		const char *str = "1, 1.0";
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
+		GF_TEST_ASSERT(result == 1, str);
 
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null");
-		return NULL;
+		gf_LoaderNode *root = gf_GetRoot(&loader);
+		gf_LoaderNode *intNode = gf_GetChild(&loader, root);
+		GF_TEST_ASSERT(intNode, str);
+		GF_TEST_ASSERT(gf_GetType(&loader, intNode) == GF_TOKEN_TYPE_INTEGER, str);
+		gf_LoaderNode *floatNode = gf_GetNext(&loader, intNode);
+		GF_TEST_ASSERT(floatNode, str);
+		GF_TEST_ASSERT(gf_GetType(&loader, floatNode) == GF_TOKEN_TYPE_FLOAT, str);
+		gf_Unload(&loader);
 	}
-	else if (!node->childrenHead) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_WARNING, node->token, "node's child is null");
-		return NULL;
+	{
+		const char *str =
+			"MyStruct {\n"
+			"  a { 3.14000 }\n"
+			"  b { 101 }\n"
+			"  c { -13 }\n"
+			"  str { \"hello\" }\n"
+			"}\n";
+
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
+		GF_TEST_ASSERT(result == 1, str);
+		gf_Unload(&loader);
 	}
-	else {
-		return node->childrenHead;
+	{
+		const char *str =
+			"1.0\n"
+			"2.0\n"
+			"Hello\n";
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
+		GF_TEST_ASSERT(result == 1, str);
+		gf_Unload(&loader);
 	}
-}
-
-gf_TokenType gf_GetType(gf_Loader *loader, gf_LoaderNode *node) {
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null");
-		return GF_TOKEN_TYPE_END_FILE;
+	{
+		const char *str = "/* this is a comment */";
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
+		GF_TEST_ASSERT(result == 1, str);
+		gf_Unload(&loader);
 	}
-	return node->token->type;
-}
+	{
+		const char *str =
+			"MyStruct {\n"
+			"  a { 3.14000 }\n"
+			"  b { *$3dnNONSENSE }\n"
+			"  c { -13 }\n"
+			"  str { \"hello\" }\n"
+			"}\n";
 
-gf_LoaderNode *gf_FindFirstChild(gf_Loader *loader, gf_LoaderNode *node, const char *str) {
-	// TODO: change to hash map?
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null");
-		return NULL;
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
+		GF_TEST_ASSERT(result == 0, str);
+		gf_Unload(&loader);
 	}
+	{
+		FILE *file = tmpfile();
+		GF_TEST_ASSERT(file, "compact saver");
+
+		gf_Saver saver;
+		gf_InitSaverWithFormat(&saver, NULL, GF_SAVER_FORMAT_COMPACT);
+		gf_s32 a = 1;
+		gf_s32 b[] = { 1, 2, 3 };
+		gf_SaveStartList(&saver, file, "MyStruct");
+		gf_SaveVariableS32(&saver, file, "a", &a);
+		gf_SaveArrayS32(&saver, file, "b", b, 3);
+		gf_SaveEndList(&saver, file);
+
+		char out[256];
+		rewind(file);
+		out[fread(out, 1, sizeof(out) - 1, file)] = '\0';
+		fclose(file);
 
-	gf_u64 len = gf_StringLength(str);
-
-	gf_LoaderNode *child = node->childrenHead;
-	while (child) {
-		if (child->token->type == GF_TOKEN_TYPE_COMPOSITE_TYPE || child->token->type == GF_TOKEN_TYPE_NAME) {
-			if (gf_AreStringSpansEqual(child->token->start, child->token->length, str, len)) {
-				return child;
-			}
-		}
-		child = child->next;
+		const char *expected = "MyStruct{\na{1}\nb{1 2 3}\n}\n";
+		GF_TEST_ASSERT(gf_AreStringSpansEqual(out, gf_StringLength(out), expected, gf_StringLength(expected)), "compact saver");
 	}
+	{
+		FILE *file = tmpfile();
+		GF_TEST_ASSERT(file, "single line saver");
+
+		gf_Saver saver;
+		gf_InitSaverWithFormat(&saver, NULL, GF_SAVER_FORMAT_SINGLE_LINE);
+		gf_s32 a = 1;
+		gf_s32 b[] = { 1, 2, 3 };
+		gf_SaveStartList(&saver, file, "MyStruct");
+		gf_SaveVariableS32(&saver, file, "a", &a);
+		gf_SaveArrayS32(&saver, file, "b", b, 3);
+		gf_SaveStartList(&saver, file, "Inner");
+		gf_SaveVariableString(&saver, file, "c", "s");
+		gf_SaveEndList(&saver, file);
+		gf_SaveEndList(&saver, file);
+		gf_SaveVariableS32(&saver, file, "next", &a);
+
+		char out[256];
+		rewind(file);
+		out[fread(out, 1, sizeof(out) - 1, file)] = '\0';
+		fclose(file);
 
-	return NULL;
-}
+		const char *expected = "MyStruct{a{1} b{1 2 3} Inner{c{\"s\"}}}\nnext{1}\n";
+		GF_TEST_ASSERT(gf_AreStringSpansEqual(out, gf_StringLength(out), expected, gf_StringLength(expected)), "single line saver");
 
-gf_LoaderNode *gf_FindFirstNext(gf_Loader *loader, gf_LoaderNode *node, const char *str) {
-	// TODO: change to hash map?
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null");
-		return NULL;
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, out, gf_StringLength(out), NULL);
+		GF_TEST_ASSERT(result == 1, out);
+		gf_s32 loaded[3];
+		GF_TEST_ASSERT(gf_LoadArrayS32(&loader, gf_FindFirstChild(&loader, gf_FindFirstChild(&loader, gf_GetRoot(&loader), "MyStruct"), "b"), loaded, 3), out);
+		GF_TEST_ASSERT(loaded[2] == 3, out);
+		gf_Unload(&loader);
 	}
+	{
+		const char *str = "MyStruct{a{1}b{1 2 3}Inner{c{\"s\"}}} 1 2 name";
+		FILE *file = tmpfile();
+		GF_TEST_ASSERT(file, str);
 
-	gf_u64 len = gf_StringLength(str);
-
-	gf_LoaderNode *next = node->next;
-	while (next) {
-		if (next->token->type == GF_TOKEN_TYPE_COMPOSITE_TYPE || next->token->type == GF_TOKEN_TYPE_NAME) {
-			if (gf_AreStringSpansEqual(next->token->start, next->token->length, str, len)) {
-				return next;
-			}
-		}
-		next = next->next;
-	}
+		gf_Saver saver;
+		gf_InitSaver(&saver, NULL);
+		int result = gf_Reformat(&saver, file, str, gf_StringLength(str));
+		GF_TEST_ASSERT(result == 1, str);
 
-	return NULL;
-}
+		char out[256];
+		rewind(file);
+		out[fread(out, 1, sizeof(out) - 1, file)] = '\0';
+		fclose(file);
 
-int gf_LoadVariableU32(gf_Loader *loader, gf_LoaderNode *node, gf_u32 *value) {
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null");
-		return 0;
+		const char *expected =
+			"MyStruct {\n"
+			"  a { 1 }\n"
+			"  b { 1, 2, 3 }\n"
+			"  Inner {\n"
+			"    c { \"s\" }\n"
+			"  }\n"
+			"}\n"
+			"1, 2\n"
+			"name\n";
+		GF_TEST_ASSERT(gf_AreStringSpansEqual(out, gf_StringLength(out), expected, gf_StringLength(expected)), str);
 	}
+	{
+		const char *str = "a { b { 1 }";
+		FILE *file = tmpfile();
+		GF_TEST_ASSERT(file, str);
 
-	gf_LoaderNode *child = gf_GetChild(loader, node);
-	if (!child) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "child is null");
-		return 0;
+		gf_Saver saver;
+		gf_InitSaverWithFormat(&saver, NULL, GF_SAVER_FORMAT_COMPACT);
+		int result = gf_Reformat(&saver, file, str, gf_StringLength(str));
+		GF_TEST_ASSERT(result == 0, str);
+		fclose(file);
 	}
-	return gf_LoaderNodeToU32(loader, child, value);
-}
+	{
+		gf_Saver saver;
+		gf_InitSaver(&saver, NULL);
+		gf_u64 big = 18446744073709551614ULL;
+		gf_f32 x = 1.0f, y = 2.0f, z = 3.0f;
+		gf_s64 list[] = { -1, 0, 1 };
+
+		gf_u64 count = 0;
+		char *memory = NULL;
+		for (int pass = 0; pass < 2; pass++) {
+			if (pass == 0) {
+				gf_SaverBeginMeasure(&saver);
+			}
+			else {
+				memory = (char *)malloc(count + 1);
+				GF_TEST_ASSERT(memory, "measure and save to memory");
+				gf_SaverBeginMemory(&saver, memory, count + 1);
+			}
+			gf_SaveStartList(&saver, NULL, "MyStruct");
+			gf_SaveVariableU64(&saver, NULL, "big", &big);
+			gf_SaveVariableVec3(&saver, NULL, "xyz", &x, &y, &z);
+			gf_SaveArrayS64(&saver, NULL, "list", list, 3);
+			gf_SaveVariableStringSpan(&saver, NULL, "str", "hello", 3);
+			gf_SaveEndList(&saver, NULL);
+			if (pass == 0) {
+				count = gf_SaverGetWrittenCount(&saver);
+			}
+		}
+		GF_TEST_ASSERT(gf_SaverGetWrittenCount(&saver) == count, "measure and save to memory");
+		GF_TEST_ASSERT(gf_StringLength(memory) == count, "measure and save to memory");
 
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, memory, count, NULL);
+		GF_TEST_ASSERT(result == 1, memory);
+		gf_u64 loadedBig = 0;
+		GF_TEST_ASSERT(gf_LoadVariableU64(&loader, gf_FindFirstChild(&loader, gf_FindFirstChild(&loader, gf_GetRoot(&loader), "MyStruct"), "big"), &loadedBig), memory);
+		GF_TEST_ASSERT(loadedBig == big, memory);
+		gf_Unload(&loader);
 
-int gf_LoadVariableU64(gf_Loader *loader, gf_LoaderNode *node, gf_u64 *value) {
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null");
-		return 0;
-	}
+		// One byte too small leaves no room for the NULL terminator so the last write fails.
+		gf_SaverBeginMemory(&saver, memory, count);
+		gf_SaveStartList(&saver, NULL, "MyStruct");
+		gf_SaveVariableU64(&saver, NULL, "big", &big);
+		gf_SaveVariableVec3(&saver, NULL, "xyz", &x, &y, &z);
+		gf_SaveArrayS64(&saver, NULL, "list", list, 3);
+		gf_SaveVariableStringSpan(&saver, NULL, "str", "hello", 3);
+		result = gf_SaveEndList(&saver, NULL);
+		GF_TEST_ASSERT(result == 0, "save to memory that is too small");
+		GF_TEST_ASSERT(gf_StringLength(memory) == gf_SaverGetWrittenCount(&saver), "save to memory that is too small");
 
-	gf_LoaderNode *child = gf_GetChild(loader, node);
-	if (!child) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "child is null");
-		return 0;
+		free(memory);
 	}
-	return gf_LoaderNodeToU64(loader, child, value);
-}
+	{
+		const char *str =
+			"/* comment */ MyStruct { a { 3.14000 } list { -1 +2 \"three\" } Inner { x { } y } }\n"
+			"1 2 bare";
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
+		GF_TEST_ASSERT(result == 1, str);
 
-int gf_LoadVariableS32(gf_Loader *loader, gf_LoaderNode *node, gf_s32 *value) {
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null");
-		return 0;
-	}
+		gf_Saver saver;
+		gf_InitSaver(&saver, NULL);
+		gf_SaverBeginMeasure(&saver);
+		result = gf_SaveNode(&saver, NULL, gf_GetRoot(&loader));
+		GF_TEST_ASSERT(result == 1, str);
 
-	gf_LoaderNode *child = gf_GetChild(loader, node);
-	if (!child) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "child is null");
-		return 0;
-	}
-	return gf_LoaderNodeToS32(loader, child, value);
-}
+		char out[256];
+		GF_TEST_ASSERT(gf_SaverGetWrittenCount(&saver) < sizeof(out), str);
+		gf_SaverBeginMemory(&saver, out, gf_SaverGetWrittenCount(&saver) + 1);
+		result = gf_SaveNode(&saver, NULL, gf_GetRoot(&loader));
+		GF_TEST_ASSERT(result == 1, str);
 
-int gf_LoadVariableS64(gf_Loader *loader, gf_LoaderNode *node, gf_s64 *value) {
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null");
-		return 0;
-	}
+		const char *expected =
+			"MyStruct {\n"
+			"  a { 3.14000 }\n"
+			"  list { -1, +2, \"three\" }\n"
+			"  Inner {\n"
+			"    x {\n"
+			"    }\n"
+			"    y\n"
+			"  }\n"
+			"}\n"
+			"1, 2\n"
+			"bare\n";
+		GF_TEST_ASSERT(gf_AreStringSpansEqual(out, gf_StringLength(out), expected, gf_StringLength(expected)), out);
+
+		gf_InitSaverWithFormat(&saver, NULL, GF_SAVER_FORMAT_SINGLE_LINE);
+		gf_SaverBeginMemory(&saver, out, sizeof(out));
+		gf_LoaderNode *inner = gf_FindFirstChild(&loader, gf_FindFirstChild(&loader, gf_GetRoot(&loader), "MyStruct"), "Inner");
+		result = gf_SaveNode(&saver, NULL, inner);
+		GF_TEST_ASSERT(result == 1, str);
+		expected = "Inner{x{} y}\n";
+		GF_TEST_ASSERT(gf_AreStringSpansEqual(out, gf_StringLength(out), expected, gf_StringLength(expected)), out);
 
-	gf_LoaderNode *child = gf_GetChild(loader, node);
-	if (!child) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "child is null");
-		return 0;
+		gf_Unload(&loader);
 	}
-	return gf_LoaderNodeToS64(loader, child, value);
-}
 
-int gf_LoadVariableF64(gf_Loader *loader, gf_LoaderNode *node, gf_f64 *value) {
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null");
-		return 0;
-	}
+	{
+		gf_Loader loader;
+		int result = gf_LoadEmpty(&loader, NULL);
+		GF_TEST_ASSERT(result == 1, "gf_LoadEmpty");
 
-	gf_LoaderNode *child = gf_GetChild(loader, node);
-	if (!child) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "child is null");
-		return 0;
-	}
-	return gf_LoaderNodeToF64(loader, child, value);
-}
+		gf_LoaderNode *root = gf_GetRoot(&loader);
+		gf_LoaderNode *player = gf_CreateComposite(&loader, "Player");
+		gf_LoaderNode *health = gf_CreateComposite(&loader, "health");
+		gf_LoaderNode *pos = gf_CreateComposite(&loader, "pos");
+		gf_LoaderNode *name = gf_CreateComposite(&loader, "name");
+		gf_LoaderNode *dead = gf_CreateName(&loader, "dead");
+
+		// Built out of order, moved around and edited before it is saved.
+		GF_TEST_ASSERT(gf_AppendChild(&loader, root, player), "builder append");
+		GF_TEST_ASSERT(gf_AppendChild(&loader, player, pos), "builder append");
+		GF_TEST_ASSERT(gf_InsertBefore(&loader, pos, health), "builder insert before");
+		GF_TEST_ASSERT(gf_InsertAfter(&loader, pos, dead), "builder insert after");
+		GF_TEST_ASSERT(gf_AppendChild(&loader, root, name), "builder append");
+		GF_TEST_ASSERT(gf_AppendChild(&loader, player, name), "builder move");
+		GF_TEST_ASSERT(gf_AppendChild(&loader, health, gf_CreateS64(&loader, 100)), "builder value");
+		GF_TEST_ASSERT(gf_AppendChild(&loader, pos, gf_CreateF64(&loader, 0.1)), "builder value");
+		GF_TEST_ASSERT(gf_AppendChild(&loader, pos, gf_CreateF64(&loader, -2.0)), "builder value");
+		GF_TEST_ASSERT(gf_AppendChild(&loader, name, gf_CreateString(&loader, "temp")), "builder value");
+		GF_TEST_ASSERT(gf_SetString(&loader, name->childrenHead, "hero"), "builder set");
+		GF_TEST_ASSERT(gf_SetS64(&loader, health->childrenHead, -5), "builder set");
+		GF_TEST_ASSERT(gf_RemoveNode(&loader, dead), "builder remove");
+		GF_TEST_ASSERT(gf_SetName(&loader, player, "Hero"), "builder rename");
+
+		GF_TEST_ASSERT(gf_AppendChild(&loader, health, player) == 0, "builder cycle");
+		GF_TEST_ASSERT(gf_AppendChild(&loader, health->childrenHead, dead) == 0, "builder child of value");
+		GF_TEST_ASSERT(gf_CreateName(&loader, "1abc") == NULL, "builder name");
+		GF_TEST_ASSERT(gf_CreateF64(&loader, HUGE_VAL) == NULL, "builder float");
+
+		char out[256];
+		gf_Saver saver;
+		gf_InitSaverWithFormat(&saver, NULL, GF_SAVER_FORMAT_SINGLE_LINE);
+		gf_SaverBeginMemory(&saver, out, sizeof(out));
+		result = gf_SaveNode(&saver, NULL, root);
+		GF_TEST_ASSERT(result == 1, "builder save");
+		const char *expected = "Hero{health{-5} pos{0.1 -2.0} name{\"hero\"}}\n";
+		GF_TEST_ASSERT(gf_AreStringSpansEqual(out, gf_StringLength(out), expected, gf_StringLength(expected)), out);
 
+		gf_Unload(&loader);
 
-int gf_LoadVariableF32(gf_Loader *loader, gf_LoaderNode *node, gf_f32 *value) {
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null");
-		return 0;
-	}
+		char saved[256];
+		memcpy(saved, out, sizeof(out));
+		result = gf_LoadFromBuffer(&loader, saved, gf_StringLength(saved), NULL);
+		GF_TEST_ASSERT(result == 1, out);
+		gf_f64 x = 0.0, y = 0.0;
+		gf_LoaderNode *posNode = gf_FindFirstChild(&loader, gf_FindFirstChild(&loader, gf_GetRoot(&loader), "Hero"), "pos");
+		result = gf_LoaderNodeToF64(&loader, gf_GetChild(&loader, posNode), &x) && gf_LoaderNodeToF64(&loader, gf_GetNext(&loader, gf_GetChild(&loader, posNode)), &y);
+		GF_TEST_ASSERT(result == 1 && x == 0.1 && y == -2.0, out);
+
+		// A loaded graph can be edited with the same functions.
+		gf_LoaderNode *hero = gf_FindFirstChild(&loader, gf_GetRoot(&loader), "Hero");
+		gf_LoaderNode *level = gf_CreateComposite(&loader, "level");
+		GF_TEST_ASSERT(gf_AppendChild(&loader, level, gf_CreateU64(&loader, 18446744073709551614ULL)), "builder value");
+		GF_TEST_ASSERT(gf_InsertBefore(&loader, hero->childrenHead, level), "builder insert before");
+		GF_TEST_ASSERT(gf_RemoveNode(&loader, gf_FindFirstChild(&loader, hero, "name")), "builder remove");
+		gf_SaverBeginMemory(&saver, out, sizeof(out));
+		result = gf_SaveNode(&saver, NULL, gf_GetRoot(&loader));
+		GF_TEST_ASSERT(result == 1, "builder save");
+		expected = "Hero{level{18446744073709551614} health{-5} pos{0.1 -2.0}}\n";
+		GF_TEST_ASSERT(gf_AreStringSpansEqual(out, gf_StringLength(out), expected, gf_StringLength(expected)), out);
 
-	gf_LoaderNode *child = gf_GetChild(loader, node);
-	if (!child) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "child is null");
-		return 0;
+		gf_Unload(&loader);
 	}
-	return gf_LoaderNodeToF32(loader, child, value);
-}
-
-int gf_LoadVariableVec3(gf_Loader *loader, gf_LoaderNode *node, gf_f32 *x, gf_f32 *y, gf_f32 *z) {
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null");
-		return 0;
+	{
+		char text[GF_F64_STRING_CAPACITY];
+		gf_f64 values[] = { 0.0, 1.0, -0.5, 0.1, 1.0 / 3.0, 123456789.125, 1e300, 5e-324, -1.7976931348623157e308 };
+		for (gf_u64 i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+			GF_TEST_ASSERT(gf_F64ToString(values[i], text, sizeof(text)), "gf_F64ToString");
+			GF_TEST_ASSERT(strchr(text, '.') && !strchr(text, 'e') && strtod(text, NULL) == values[i], text);
+		}
 	}
 
-	gf_LoaderNode *nodeX = gf_GetChild(loader, node);
-	if (!nodeX) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "child is null");
-		return 0;
-	}
+	{
+		const char *str = "a { b { 1 2 } c { \"x\" } }";
+		gf_TestAllocatorContext counter = { 0, 0 };
+		gf_LogAllocateFreeFunctions funcs;
+		memset(&funcs, 0, sizeof(funcs));
+		funcs.context = &counter;
+		funcs.AllocateWithContext = gf_TestAllocate;
+		funcs.FreeWithContext = gf_TestFree;
 
-	gf_LoaderNode *nodeY = gf_GetNext(loader, nodeX);
-	if (!nodeY) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, nodeX->token, "y value is null");
-		return 0;
-	}
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), &funcs);
+		GF_TEST_ASSERT(result == 1, str);
+		GF_TEST_ASSERT(gf_AppendChild(&loader, gf_GetRoot(&loader), gf_CreateName(&loader, "d")), str);
+		GF_TEST_ASSERT(counter.allocations > 0, "allocate with context");
 
-	gf_LoaderNode *nodeZ = gf_GetNext(loader, nodeY);
-	if (!nodeZ) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, nodeY->token, "z value is null");
-		return 0;
-	}
+		char *grown = (char *)gf_Reallocate(&loader, NULL, 0, 4);
+		GF_TEST_ASSERT(grown, "reallocate with context");
+		memcpy(grown, "abc", 4);
+		grown = (char *)gf_Reallocate(&loader, grown, 4, 64);
+		GF_TEST_ASSERT(grown && gf_AreStringSpansEqual(grown, 3, "abc", 3), "reallocate with context");
+		gf_Free(&loader, grown);
 
-	if (!gf_LoaderNodeToF32(loader, nodeX, x)) {
-		return 0;
-	}
-	if (!gf_LoaderNodeToF32(loader, nodeY, y)) {
-		return 0;
-	}
-	if (!gf_LoaderNodeToF32(loader, nodeZ, z)) {
-		return 0;
+		gf_Unload(&loader);
+		GF_TEST_ASSERT(counter.allocations == 0 && counter.total > 0, "free with context");
 	}
 
-	return 1;
-}
-
-int gf_LoadVariableString(gf_Loader *loader, gf_LoaderNode *node, char *str, gf_u64 lenWithNullTerminator) {
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null");
-		return 0;
-	}
+	{
+		const char *first = "a { b { 1 2 } c { \"x\" } }";
+		const char *second = "d { 3 } e { f { 4.0 } }";
+		gf_TestAllocatorContext counter = { 0, 0 };
+		gf_LogAllocateFreeFunctions funcs;
+		memset(&funcs, 0, sizeof(funcs));
+		funcs.context = &counter;
+		funcs.AllocateWithContext = gf_TestAllocate;
+		funcs.FreeWithContext = gf_TestFree;
 
-	gf_LoaderNode *child = gf_GetChild(loader, node);
-	if (!child) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "child is null");
-		return 0;
-	}
+		gf_Loader loader;
+		int result = gf_LoadFromBuffer(&loader, first, gf_StringLength(first), &funcs);
+		GF_TEST_ASSERT(result == 1, first);
+
+		// Once the loader has seen a document this big, loading again does not allocate.
+		gf_u64 total = counter.total;
+		for (int i = 0; i < 100; i++) {
+			const char *str = (i & 1) ? second : first;
+			result = gf_ReloadFromBuffer(&loader, str, gf_StringLength(str));
+			GF_TEST_ASSERT(result == 1, "gf_ReloadFromBuffer");
+		}
+		GF_TEST_ASSERT(counter.total == total, "gf_ReloadFromBuffer allocated");
 
-	gf_u64 index = 0;
-	for (index = 0; index < lenWithNullTerminator - 1 && index < child->token->length; index++) {
-		str[index] = child->token->start[index];
-	}
-	str[index] = '\0';
+		gf_f32 f = 0.0f;
+		gf_LoaderNode *e = gf_FindFirstChild(&loader, gf_GetRoot(&loader), "e");
+		result = gf_LoadVariableF32(&loader, gf_FindFirstChild(&loader, e, "f"), &f);
+		GF_TEST_ASSERT(result == 1 && f == 4.0f, second);
 
-	return 1;
-}
+		result = gf_ReloadFromBuffer(&loader, "a {", 3);
+		GF_TEST_ASSERT(result == 0, "gf_ReloadFromBuffer of a broken document");
 
-int gf_LoadArrayS32(gf_Loader *loader, gf_LoaderNode *node, gf_s32 *value, gf_u64 count) {
-	if (!node) {
-		GF_LOG(loader, GF_LOG_ERROR, "node is null");
-		return 0;
-	}
+		gf_ResetLoader(&loader);
+		gf_TrimLoader(&loader, 0);
+		GF_TEST_ASSERT(counter.allocations == 0, "gf_TrimLoader");
 
-	gf_LoaderNode *child = gf_GetChild(loader, node);
-	if (!child) {
-		GF_LOG_WITH_TOKEN(loader, GF_LOG_ERROR, node->token, "child is null");
-		return 0;
+		result = gf_ReloadFromBuffer(&loader, first, gf_StringLength(first));
+		GF_TEST_ASSERT(result == 1, first);
+		gf_Unload(&loader);
+		GF_TEST_ASSERT(counter.allocations == 0, "gf_Unload after gf_TrimLoader");
 	}
 
-	gf_u64 index = 0;
-	while (child && index < count) {
-		if (!gf_LoaderNodeToS32(loader, child, &value[index])) {
-			return 0;
+	{
+		gf_ValidateError error;
+		const char *valid = "/* header */ a { b { 1, 2.5, \"s\" } c } d";
+		GF_TEST_ASSERT(gf_Validate(valid, gf_StringLength(valid), &error) == 1, valid);
+
+		// Every buffer here fails gf_Validate and gf_LoadFromBuffer alike.
+		const char *invalid[] = { "a {\n b { 1 }\n } }", "a {\n b { 1 }\n", "1 { 2 }", "a { \"no end }", "a { - }", "a { # }", "/* open" };
+		gf_u64 lines[] = { 3, 3, 1, 1, 1, 1, 1 };
+		gf_LogAllocateFreeFunctions funcs;
+		memset(&funcs, 0, sizeof(funcs));
+		funcs.Log = gf_NoLog;
+		for (gf_u64 i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+			error.message = NULL;
+			GF_TEST_ASSERT(gf_Validate(invalid[i], gf_StringLength(invalid[i]), &error) == 0, invalid[i]);
+			GF_TEST_ASSERT(error.message && error.lineno == lines[i] && error.offset <= gf_StringLength(invalid[i]), invalid[i]);
+
+			gf_Loader loader;
+			int result = gf_LoadFromBuffer(&loader, invalid[i], gf_StringLength(invalid[i]), &funcs);
+			gf_Unload(&loader);
+			GF_TEST_ASSERT(result == 0, invalid[i]);
 		}
-		child = child->next;
-		index++;
-	}
-
-	return 1;
-}
 
-/*-----------------------------------------------------------------------------------*/
-
-#endif
-
-#ifdef GF_IMPLEMENTATION_WITH_TESTS
+		const char *extraBrace = "a { 1 } }";
+		GF_TEST_ASSERT(gf_Validate(extraBrace, gf_StringLength(extraBrace), &error) == 0 && error.offset == 8, extraBrace);
+		GF_TEST_ASSERT(gf_Validate(extraBrace, gf_StringLength(extraBrace), NULL) == 0, extraBrace);
+	}
 
-/*-------------------------------------TESTS-----------------------------------------*/
+	{
+		// Strings can span lines and columns start at 1 on every line.
+		const char *text = "a {\n\"x\ny\" b_2\r\n\t-1.5 }";
+		gf_Tokeniser tokeniser;
+		gf_Token token;
+		gf_InitTokeniser(&tokeniser, text, gf_StringLength(text));
+		gf_u64 expected[][3] = {
+			{ GF_TOKEN_TYPE_NAME, 1, 1 }, { GF_TOKEN_TYPE_VALUE_ASSIGN, 1, 3 }, { GF_TOKEN_TYPE_STRING, 2, 1 },
+			{ GF_TOKEN_TYPE_NAME, 3, 4 }, { GF_TOKEN_TYPE_FLOAT, 4, 2 }, { GF_TOKEN_TYPE_CURLY_CLOSE, 4, 7 }, { GF_TOKEN_TYPE_END_FILE, 4, 8 }
+		};
+		for (gf_u64 i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+			GF_TEST_ASSERT(gf_NextToken(&tokeniser, &token), "gf_NextToken");
+			GF_TEST_ASSERT(gf_LocateToken(&tokeniser.lines, &token), "gf_LocateToken");
+			GF_TEST_ASSERT(token.type == expected[i][0] && token.lineno == expected[i][1] && token.colno == expected[i][2], "Token position");
+		}
 
-int gf_Test(void) {
+		for (int c = 0; c < 256; c++) {
+			int nameChar = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+			GF_TEST_ASSERT(nameChar == (gf_CharClasses[c] >= GF_CHAR_CLASS_DIGIT), "gf_CharClasses");
+		}
+	}
 
 	{
-		const char *str = "a {";
+		// The index the loader builds and the counting the tokeniser does agree everywhere, including
+		// a \r\n split across the 16 byte blocks.
+		const char *text = "a {\r\n b { 1 }\r\r\n c {\n\t\"two\nlines\" }\n\nd{2.5}/* x\r\n y */ e { -3 }\r\n}";
+		gf_u64 length = gf_StringLength(text);
 		gf_Loader loader;
-		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
-		GF_TEST_ASSERT(result == 0, str);
+		GF_TEST_ASSERT(gf_LoadFromBuffer(&loader, text, length, NULL), text);
+
+		gf_Tokeniser tokeniser;
+		gf_InitTokeniser(&tokeniser, text, length);
+		gf_u64 lineno, colno, indexedLineno, indexedColno;
+		for (gf_u64 offset = 0; offset <= length; offset++) {
+			GF_TEST_ASSERT(gf_LocateOffset(&tokeniser.lines, offset, &lineno, &colno), "gf_LocateOffset");
+			GF_TEST_ASSERT(gf_LocateOffset(&loader.lines, offset, &indexedLineno, &indexedColno), "gf_LocateOffset");
+			GF_TEST_ASSERT(lineno == indexedLineno && colno == indexedColno, "gf_LineIndex");
+		}
+		GF_TEST_ASSERT(loader.lines.built && loader.lines.lineCount == 9 && lineno == 10 && colno == 2, "gf_LineIndex");
+		gf_Unload(&loader);
+
+		gf_LogAllocateFreeFunctions funcs;
+		memset(&funcs, 0, sizeof(funcs));
+		funcs.Log = gf_TestLogPosition;
+		const char *invalid = "a {\r\n  b { 1 }\n\n  c { { 2 } }\n}";
+		GF_TEST_ASSERT(gf_LoadFromBuffer(&loader, invalid, gf_StringLength(invalid), &funcs) == 0, invalid);
+		GF_TEST_ASSERT(gf_TestLoggedLineno == 4 && gf_TestLoggedColno == 7, invalid);
+		gf_Unload(&loader);
+
+		// A string with escapes is decoded into the arena, but is still reported where it is in the text.
+		const char *escaped = "a { 1 }\r\n\nname {\n  \"x\\ty\" }";
+		GF_TEST_ASSERT(gf_LoadFromBuffer(&loader, escaped, gf_StringLength(escaped), &funcs), escaped);
+		gf_u32 value = 0;
+		gf_TestLoggedLineno = 0;
+		GF_TEST_ASSERT(!gf_LoaderNodeToU32(&loader, gf_GetChild(&loader, gf_FindFirstChild(&loader, gf_GetRoot(&loader), "name")), &value), escaped);
+		GF_TEST_ASSERT(gf_TestLoggedLineno == 4 && gf_TestLoggedColno == 3, escaped);
 		gf_Unload(&loader);
 	}
+
 	{
-		const char *str = "{{{{{{{{{{{{{}}";
-		gf_Loader loader;
-		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
-		GF_TEST_ASSERT(result == 0, str);
-		gf_Unload(&loader);
+		// Strings and comments longer than a 16 byte block, with escapes and nesting on either side of the block edges.
+		const char *text = "/* a long comment /* that nests ** / */ and goes on for a while */ s { \"0123456789abcdef \\\" quoted \\\\\" \"ends with \\\\\\\\\" }";
+		gf_Tokeniser tokeniser;
+		gf_Token token;
+		gf_InitTokeniser(&tokeniser, text, gf_StringLength(text));
+		gf_TokenType types[] = { GF_TOKEN_TYPE_NAME, GF_TOKEN_TYPE_VALUE_ASSIGN, GF_TOKEN_TYPE_STRING, GF_TOKEN_TYPE_STRING, GF_TOKEN_TYPE_CURLY_CLOSE, GF_TOKEN_TYPE_END_FILE };
+		const char *strings[] = { "0123456789abcdef \\\" quoted \\\\", "ends with \\\\\\\\" };
+		gf_u64 stringIndex = 0;
+		for (gf_u64 i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+			do {
+				GF_TEST_ASSERT(gf_NextToken(&tokeniser, &token), text);
+			} while (token.type == GF_TOKEN_TYPE_COMMENT);
+			GF_TEST_ASSERT(token.type == types[i], text);
+			if (token.type == GF_TOKEN_TYPE_STRING) {
+				GF_TEST_ASSERT(token.length == gf_StringLength(strings[stringIndex]) && memcmp(token.start, strings[stringIndex], token.length) == 0, strings[stringIndex]);
+				stringIndex++;
+			}
+		}
+
+		gf_LogAllocateFreeFunctions funcs;
+		memset(&funcs, 0, sizeof(funcs));
+		funcs.Log = gf_NoLog;
+		const char *invalid[] = { "a { \"a string that ends in an escaped quote \\\" }", "/* a comment /* that is not closed enough */ a { 1 }" };
+		for (gf_u64 i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+			gf_Loader loader;
+			int result = gf_LoadFromBuffer(&loader, invalid[i], gf_StringLength(invalid[i]), &funcs);
+			gf_Unload(&loader);
+			GF_TEST_ASSERT(result == 0, invalid[i]);
+		}
 	}
+
 	{
-		const char *str = "{{{{{{{{{{{{{a}}}}}}}}}}}}}";
+		const char *text = "a { \"say \\\"hi\\\"\\tto C:\\\\temp\\\\new and C:\\old\" \"plain\" }";
 		gf_Loader loader;
-		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
-		GF_TEST_ASSERT(result == 0, str);
+		GF_TEST_ASSERT(gf_LoadFromBuffer(&loader, text, gf_StringLength(text), NULL), text);
+		gf_LoaderNode *escaped = gf_GetChild(&loader, gf_FindFirstChild(&loader, gf_GetRoot(&loader), "a"));
+		gf_LoaderNode *plain = gf_GetNext(&loader, escaped);
+		char value[64];
+		const char *decoded = "say \"hi\"\tto C:\\temp\\new and C:\\old";
+		GF_TEST_ASSERT(gf_LoaderNodeToString(&loader, escaped, value, sizeof(value)) && strcmp(value, decoded) == 0, value);
+		// Strings without escapes still point into the buffer.
+		GF_TEST_ASSERT(plain->token->start == strstr(text, "plain"), "plain string");
+
+		gf_StringView view;
+		GF_TEST_ASSERT(gf_LoaderNodeToStringView(&loader, plain, &view) && view.start == plain->token->start && view.length == 5, "gf_LoaderNodeToStringView");
+		GF_TEST_ASSERT(gf_LoadVariableStringView(&loader, gf_FindFirstChild(&loader, gf_GetRoot(&loader), "a"), &view), "gf_LoadVariableStringView");
+		GF_TEST_ASSERT(gf_AreStringSpansEqual(view.start, view.length, decoded, gf_StringLength(decoded)), "gf_LoadVariableStringView");
+
+		// Saving escapes the text again so it loads back the same, while reformatting keeps it as written.
+		char out[256];
+		char saved[256];
+		gf_Saver saver;
+		gf_InitSaverWithFormat(&saver, NULL, GF_SAVER_FORMAT_SINGLE_LINE);
+		gf_SaverBeginMemory(&saver, out, sizeof(out));
+		GF_TEST_ASSERT(gf_SaveNode(&saver, NULL, gf_GetRoot(&loader)), "gf_SaveNode");
 		gf_Unload(&loader);
+		memcpy(saved, out, sizeof(out));
+		GF_TEST_ASSERT(gf_LoadFromBuffer(&loader, saved, gf_StringLength(saved), NULL), saved);
+		escaped = gf_GetChild(&loader, gf_FindFirstChild(&loader, gf_GetRoot(&loader), "a"));
+		GF_TEST_ASSERT(gf_LoaderNodeToString(&loader, escaped, value, sizeof(value)) && strcmp(value, decoded) == 0, value);
+
+		gf_SaverBeginMemory(&saver, out, sizeof(out));
+		GF_TEST_ASSERT(gf_Reformat(&saver, NULL, text, gf_StringLength(text)), "gf_Reformat");
+		GF_TEST_ASSERT(strstr(out, "\"say \\\"hi\\\"\\tto C:\\\\temp\\\\new and C:\\old\""), out);
+
+		GF_TEST_ASSERT(gf_SetString(&loader, escaped, "a \"quote\""), "gf_SetString");
+		gf_SaverBeginMemory(&saver, out, sizeof(out));
+		GF_TEST_ASSERT(gf_SaveNode(&saver, NULL, gf_GetRoot(&loader)) && strstr(out, "{\"a \\\"quote\\\"\""), out);
+		gf_Unload(&loader);
+
+		gf_SaverBeginMemory(&saver, out, sizeof(out));
+		GF_TEST_ASSERT(gf_SaveVariableString(&saver, NULL, "s", "back\\slash \"") && strstr(out, "\"back\\\\slash \\\"\""), out);
 	}
+
 	{
-		const char *str = "   ";
+		const char *valid = "a { \"caf\xC3\xA9 \xE2\x9C\x93 \xF0\x9F\x98\x80 and some more plain ascii text\" }";
+		gf_LogAllocateFreeFunctions funcs;
+		memset(&funcs, 0, sizeof(funcs));
+		funcs.Log = gf_NoLog;
+		funcs.loaderFlags = GF_LOADER_FLAG_VALIDATE_UTF8;
 		gf_Loader loader;
-		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
-		GF_TEST_ASSERT(result == 1, str);
+		int result = gf_LoadFromBuffer(&loader, valid, gf_StringLength(valid), &funcs);
 		gf_Unload(&loader);
+		GF_TEST_ASSERT(result == 1, "valid UTF-8");
+
+		// Overlong, surrogate, cut short, above U+10FFFF, a lone continuation byte and an invalid byte after a long ASCII run.
+		const char *invalid[] = {
+			"a { \"x\xC0\x80\" }", "a { \"x\xED\xA0\x80\" }", "a { \"x\xE2\x82\" }", "a { \"x\xF4\x90\x80\x80\" }", "a { \"x\x80\" }",
+			"a {\n \"xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx\xFF\" }"
+		};
+		gf_u64 offsets[] = { 6, 6, 6, 6, 6, 56 };
+		for (gf_u64 i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+			result = gf_LoadFromBuffer(&loader, invalid[i], gf_StringLength(invalid[i]), &funcs);
+			gf_Unload(&loader);
+			GF_TEST_ASSERT(result == 0, invalid[i]);
+
+			gf_Tokeniser tokeniser;
+			gf_Token token;
+			gf_InitTokeniser(&tokeniser, invalid[i], gf_StringLength(invalid[i]));
+			tokeniser.Log = gf_NoLog;
+			tokeniser.validateUtf8 = 1;
+			while (gf_NextToken(&tokeniser, &token) && token.type != GF_TOKEN_TYPE_END_FILE) {
+			}
+			GF_TEST_ASSERT(tokeniser.error && tokeniser.index == offsets[i], invalid[i]);
+
+			// Without the flag the bytes are loaded as they are.
+			funcs.loaderFlags = GF_LOADER_FLAG_NONE;
+			result = gf_LoadFromBuffer(&loader, invalid[i], gf_StringLength(invalid[i]), &funcs);
+			gf_Unload(&loader);
+			funcs.loaderFlags = GF_LOADER_FLAG_VALIDATE_UTF8;
+			GF_TEST_ASSERT(result == 1, invalid[i]);
+		}
 	}
+
 	{
-		const char *str = "/* this is a comment */";
+		// Long enough for the SSE2 path and for the arena to need several blocks without presizing.
+		gf_u64 capacity = 200000;
+		char *big = (char *)malloc(capacity);
+		GF_TEST_ASSERT(big, "presize");
+		gf_u64 length = 0;
+		for (int i = 0; length + 64 < capacity; i++) {
+			length += (gf_u64)snprintf(big + length, capacity - length, "item%d { -%d +2.5 \"s %d\" x_1y } /* c */\n", i, i, i);
+		}
+
+		gf_u64 tokenBound = 0;
+		gf_u64 nodeBound = 0;
+		gf_CountTokenBounds(big, length, &tokenBound, &nodeBound);
+
+		gf_TestAllocatorContext counter = { 0, 0 };
+		gf_LogAllocateFreeFunctions funcs;
+		memset(&funcs, 0, sizeof(funcs));
+		funcs.context = &counter;
+		funcs.AllocateWithContext = gf_TestAllocate;
+		funcs.FreeWithContext = gf_TestFree;
+		funcs.loaderFlags = GF_LOADER_FLAG_PRESIZE;
+
 		gf_Loader loader;
-		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
-		GF_TEST_ASSERT(result == 1, str);
+		int result = gf_LoadFromBuffer(&loader, big, length, &funcs);
+		GF_TEST_ASSERT(result == 1, "presize");
+		GF_TEST_ASSERT(counter.total == 1, "presize allocates once");
+
+		gf_u64 tokens = 0;
+		for (gf_Token *token = loader.firstToken; token; token = token->next) {
+			tokens++;
+		}
+		gf_u64 nodes = 0;
+		for (gf_LoaderNode *node = loader.rootNode; node; node = node->nextAllocated) {
+			nodes++;
+		}
+		GF_TEST_ASSERT(tokens <= tokenBound && nodes <= nodeBound, "gf_CountTokenBounds");
+		gf_Unload(&loader);
+
+		funcs.loaderFlags = GF_LOADER_FLAG_NONE;
+		counter.total = 0;
+		result = gf_LoadFromBuffer(&loader, big, length, &funcs);
+		GF_TEST_ASSERT(result == 1 && counter.total > 1, "without presize");
 		gf_Unload(&loader);
+
+		free(big);
+
+		const char *small = "1a-2 ab_c1 { \"q\" }";
+		gf_CountTokenBounds(small, gf_StringLength(small), &tokenBound, &nodeBound);
+		GF_TEST_ASSERT(tokenBound >= 9 && nodeBound >= 6, small);
 	}
+
 	{
-		const char *str = "3.0 { a }";
+		// Far deeper than the C stack would allow a recursive parser to go.
+		gf_u64 levels = 200000;
+		char *deep = (char *)malloc(levels * 3 + 2);
+		GF_TEST_ASSERT(deep, "deep nesting");
+		for (gf_u64 i = 0; i < levels; i++) {
+			deep[i * 2] = 'a';
+			deep[i * 2 + 1] = '{';
+		}
+		deep[levels * 2] = '1';
+		memset(deep + levels * 2 + 1, '}', levels);
+		deep[levels * 3 + 1] = '\0';
+		gf_u64 length = levels * 3 + 1;
+
+		gf_LogAllocateFreeFunctions funcs;
+		memset(&funcs, 0, sizeof(funcs));
+		funcs.Log = gf_NoLog;
+
 		gf_Loader loader;
-		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
-		GF_TEST_ASSERT(result == 0, str);
+		int result = gf_LoadFromBuffer(&loader, deep, length, &funcs);
 		gf_Unload(&loader);
+		GF_TEST_ASSERT(result == 0, "nesting deeper than the default maximum depth");
+		GF_TEST_ASSERT(gf_Validate(deep, length, NULL) == 0, "nesting deeper than the default maximum depth");
+
+		funcs.maxDepth = levels;
+		result = gf_LoadFromBuffer(&loader, deep, length, &funcs);
+		GF_TEST_ASSERT(result == 1, "deep nesting");
+
+		gf_Saver saver;
+		gf_InitSaverWithFormat(&saver, NULL, GF_SAVER_FORMAT_COMPACT);
+		gf_SaverBeginMeasure(&saver);
+		result = gf_SaveNode(&saver, NULL, gf_GetRoot(&loader));
+		GF_TEST_ASSERT(result == 1, "deep nesting");
+		gf_Unload(&loader);
+
+		funcs.maxDepth = levels - 1;
+		result = gf_LoadFromBuffer(&loader, deep, length, &funcs);
+		gf_Unload(&loader);
+		GF_TEST_ASSERT(result == 0, "nesting one deeper than the maximum depth");
+
+		free(deep);
+
+		const char *extraBrace = "a { 1 } } b";
+		result = gf_LoadFromBuffer(&loader, extraBrace, gf_StringLength(extraBrace), &funcs);
+		gf_Unload(&loader);
+		GF_TEST_ASSERT(result == 0, extraBrace);
 	}
+
 	{
-		const char *str = "{ a, b, c, d }";
+		const char *text = "a { 1, -2, 18446744073709551615, 2.5 } b { c { \"q\\\"uote\" \"x\" } d { } e } f -9223372036854775808 0.1";
+
+		gf_LogAllocateFreeFunctions funcs;
+		memset(&funcs, 0, sizeof(funcs));
+		funcs.Log = gf_NoLog;
+
 		gf_Loader loader;
-		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
-		GF_TEST_ASSERT(result == 0, str);
+		int result = gf_LoadFromBuffer(&loader, text, gf_StringLength(text), NULL);
+		GF_TEST_ASSERT(result == 1, "binary");
+
+		gf_Saver saver;
+		gf_InitSaverWithFormat(&saver, NULL, GF_SAVER_FORMAT_COMPACT);
+		char expected[256];
+		gf_SaverBeginMemory(&saver, expected, sizeof(expected));
+		GF_TEST_ASSERT(gf_SaveNode(&saver, NULL, gf_GetRoot(&loader)), "binary");
+
+		char binary[512];
+		gf_SaverBeginMemory(&saver, binary, sizeof(binary));
+		GF_TEST_ASSERT(gf_SaveBinary(&saver, NULL, gf_GetRoot(&loader)), "gf_SaveBinary");
+		gf_u64 count = gf_SaverGetWrittenCount(&saver);
+		GF_TEST_ASSERT(count % 8 == 0 && gf_IsBinary(binary, count), "gf_SaveBinary");
+		gf_Unload(&loader);
+
+		// The NULL terminator the saver keeps after the file is ignored, like the one gf_LoadFromFile() adds.
+		result = gf_LoadFromBuffer(&loader, binary, count + 1, NULL);
+		GF_TEST_ASSERT(result == 1, "load binary");
+
+		char actual[256];
+		gf_SaverBeginMemory(&saver, actual, sizeof(actual));
+		GF_TEST_ASSERT(gf_SaveNode(&saver, NULL, gf_GetRoot(&loader)), "binary to text");
+		GF_TEST_ASSERT(strcmp(expected, actual) == 0, "binary to text");
+
+		gf_LoaderNode *value = gf_GetChild(&loader, gf_FindFirstChild(&loader, gf_GetRoot(&loader), "a"));
+		gf_s32 s32 = 0;
+		gf_u64 u64 = 0;
+		gf_s64 s64 = 0;
+		gf_f32 f32 = 0;
+		GF_TEST_ASSERT(gf_LoaderNodeToS32(&loader, value, &s32) && s32 == 1, "binary s32");
+		value = gf_GetNext(&loader, value);
+		loader.Log = gf_NoLog;
+		GF_TEST_ASSERT(!gf_LoaderNodeToU64(&loader, value, &u64), "negative binary u64");
+		value = gf_GetNext(&loader, value);
+		GF_TEST_ASSERT(gf_LoaderNodeToU64(&loader, value, &u64) && u64 == UINT64_MAX, "binary u64");
+		GF_TEST_ASSERT(!gf_LoaderNodeToS64(&loader, value, &s64), "binary s64 out of range");
+		value = gf_GetNext(&loader, value);
+		GF_TEST_ASSERT(gf_LoaderNodeToF32(&loader, value, &f32) && f32 == 2.5f, "binary f32");
+		value = gf_GetNext(&loader, gf_FindFirstChild(&loader, gf_GetRoot(&loader), "f"));
+		GF_TEST_ASSERT(gf_LoaderNodeToS64(&loader, value, &s64) && s64 == INT64_MIN, "binary s64");
+		gf_Unload(&loader);
+
+		// Damaged files are rejected.
+		binary[count - 24] ^= 1;
+		result = gf_LoadFromBuffer(&loader, binary, count, &funcs);
 		gf_Unload(&loader);
+		binary[count - 24] ^= 1;
+		GF_TEST_ASSERT(result == 0, "damaged node count");
+		result = gf_LoadFromBuffer(&loader, binary, count - 8, &funcs);
+		gf_Unload(&loader);
+		GF_TEST_ASSERT(result == 0, "truncated binary");
+		binary[GF_BINARY_HEADER_SIZE] = 9;
+		result = gf_LoadFromBuffer(&loader, binary, count, &funcs);
+		gf_Unload(&loader);
+		GF_TEST_ASSERT(result == 0, "unknown record");
+
+		// Saving a single list keeps it and nothing after it.
+		result = gf_LoadFromBuffer(&loader, text, gf_StringLength(text), NULL);
+		gf_SaverBeginMemory(&saver, binary, sizeof(binary));
+		GF_TEST_ASSERT(gf_SaveBinary(&saver, NULL, gf_FindFirstChild(&loader, gf_GetRoot(&loader), "b")), "gf_SaveBinary of a list");
+		count = gf_SaverGetWrittenCount(&saver);
+		gf_Unload(&loader);
+		result = gf_LoadFromBuffer(&loader, binary, count, NULL);
+		gf_SaverBeginMemory(&saver, actual, sizeof(actual));
+		GF_TEST_ASSERT(result == 1 && gf_SaveNode(&saver, NULL, gf_GetRoot(&loader)), "gf_SaveBinary of a list");
+		GF_TEST_ASSERT(strcmp(actual, "b{\nc{\"q\\\"uote\" \"x\"}\nd{\n}\ne\n}\n") == 0, actual);
+		gf_Unload(&loader);
+
+		// Strings in binary files are checked too when GF_LOADER_FLAG_VALIDATE_UTF8 is set.
+		const char *strings[2] = { "a { \"caf\xC3\xA9\" \"plain\" }", "a { \"plain\" \"x\xC0\x80\" }" };
+		for (int i = 0; i < 2; i++) {
+			result = gf_LoadFromBuffer(&loader, strings[i], gf_StringLength(strings[i]), NULL);
+			gf_SaverBeginMemory(&saver, binary, sizeof(binary));
+			GF_TEST_ASSERT(result == 1 && gf_SaveBinary(&saver, NULL, gf_GetRoot(&loader)), strings[i]);
+			count = gf_SaverGetWrittenCount(&saver);
+			gf_Unload(&loader);
+			funcs.loaderFlags = GF_LOADER_FLAG_VALIDATE_UTF8;
+			result = gf_LoadFromBuffer(&loader, binary, count, &funcs);
+			gf_Unload(&loader);
+			funcs.loaderFlags = GF_LOADER_FLAG_NONE;
+			GF_TEST_ASSERT(result == (i == 0), "binary UTF-8");
+		}
 	}
+
 	{
-		const char *str = "a, b, c, d";
+		const char *text = "item { id { 1 } name { \"a\\\"b\" } } item { id { 2 } name { \"c\" } } empty { } flag";
+
 		gf_Loader loader;
-		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
-		GF_TEST_ASSERT(result == 1, str);
+		int result = gf_LoadFromBuffer(&loader, text, gf_StringLength(text), NULL);
+		GF_TEST_ASSERT(result == 1, "snapshot");
+
+		gf_Saver saver;
+		gf_InitSaverWithFormat(&saver, NULL, GF_SAVER_FORMAT_COMPACT);
+		char expected[256];
+		gf_SaverBeginMemory(&saver, expected, sizeof(expected));
+		GF_TEST_ASSERT(gf_SaveNode(&saver, NULL, gf_GetRoot(&loader)), "snapshot");
+
+		gf_SaverBeginMeasure(&saver);
+		GF_TEST_ASSERT(gf_SaveSnapshot(&saver, NULL, &loader), "gf_SaveSnapshot");
+		gf_u64 count = gf_SaverGetWrittenCount(&saver);
+		char *image = (char *)malloc(count + 1);
+		GF_TEST_ASSERT(image, "gf_SaveSnapshot");
+		gf_SaverBeginMemory(&saver, image, count + 1);
+		GF_TEST_ASSERT(gf_SaveSnapshot(&saver, NULL, &loader), "gf_SaveSnapshot");
+
+		FILE *file = fopen("gf_test_snapshot.gfs", "wb");
+		GF_TEST_ASSERT(file, "gf_SaveSnapshot to a file");
+		gf_Saver fileSaver;
+		gf_InitSaver(&fileSaver, NULL);
+		result = gf_SaveSnapshot(&fileSaver, file, &loader);
+		fclose(file);
+		GF_TEST_ASSERT(result == 1, "gf_SaveSnapshot to a file");
+		gf_Unload(&loader);
+
+		// The names item, id and name are stored once each.
+		gf_SnapshotHeader header;
+		memcpy(&header, image, sizeof(header));
+		GF_TEST_ASSERT(header.nodeCount == 13 && header.textSize == 39, "snapshot interns names");
+
+		char actual[256];
+		for (int mapped = 0; mapped < 2; mapped++) {
+			result = mapped ? gf_MapSnapshot(&loader, "gf_test_snapshot.gfs", NULL) : gf_LoadSnapshotFromBuffer(&loader, image, count, NULL);
+			GF_TEST_ASSERT(result == 1, "load snapshot");
+			gf_SaverBeginMemory(&saver, actual, sizeof(actual));
+			GF_TEST_ASSERT(gf_SaveNode(&saver, NULL, gf_GetRoot(&loader)), "save snapshot");
+			GF_TEST_ASSERT(strcmp(expected, actual) == 0, actual);
+
+			gf_LoaderNode *item = gf_GetNext(&loader, gf_FindFirstChild(&loader, gf_GetRoot(&loader), "item"));
+			gf_u32 id = 0;
+			GF_TEST_ASSERT(gf_LoaderNodeToU32(&loader, gf_GetChild(&loader, gf_FindFirstChild(&loader, item, "id")), &id) && id == 2, "snapshot accessors");
+
+			// The builder still works on a snapshot.
+			gf_LoaderNode *node = gf_CreateNodeInArena(&loader, GF_TOKEN_TYPE_INTEGER, "3", 1);
+			GF_TEST_ASSERT(node && gf_AppendChild(&loader, gf_FindFirstChild(&loader, gf_GetRoot(&loader), "empty"), node), "edit snapshot");
+			gf_Unload(&loader);
+		}
+		remove("gf_test_snapshot.gfs");
+
+		gf_LogAllocateFreeFunctions funcs;
+		memset(&funcs, 0, sizeof(funcs));
+		funcs.Log = gf_NoLog;
+
+		// Relocating changed the image, so it is saved again for each damaged copy.
+		gf_u64 offsets[3] = { 0, header.nodesOffset + sizeof(gf_Token *) + 7, header.tokensOffset + 7 };
+		for (int i = 0; i < 3; i++) {
+			result = gf_LoadFromBuffer(&loader, text, gf_StringLength(text), NULL);
+			gf_SaverBeginMemory(&saver, image, count + 1);
+			GF_TEST_ASSERT(result == 1 && gf_SaveSnapshot(&saver, NULL, &loader), "damaged snapshot");
+			gf_Unload(&loader);
+
+			image[offsets[i]] = (char)0x7F;
+			result = gf_LoadSnapshotFromBuffer(&loader, image, count, &funcs);
+			gf_Unload(&loader);
+			GF_TEST_ASSERT(result == 0, "damaged snapshot");
+		}
+		result = gf_LoadSnapshotFromBuffer(&loader, image, sizeof(gf_SnapshotHeader) - 1, &funcs);
 		gf_Unload(&loader);
+		GF_TEST_ASSERT(result == 0, "truncated snapshot");
+		free(image);
 	}
+
 	{
+		const char *filename = "gf_test_cache.graph";
+		const char *cacheFilename = "gf_test_cache.graph.gfs";
+		const char *texts[2] = { "value { 1 } name { \"first\" }", "value { 2 } name { \"other\" }" };
+
+		gf_LogAllocateFreeFunctions funcs;
+		memset(&funcs, 0, sizeof(funcs));
+		funcs.Log = gf_NoLog;
+		funcs.loaderFlags = GF_LOADER_FLAG_CACHE;
+
+		// The second text is the same size, so only the hash of its contents shows the cache is stale.
 		gf_Loader loader;
-		static char src[1 << 20];
-		memset(src, '-', sizeof(src) - 1);
-		int result = gf_LoadFromBuffer(&loader, src, sizeof(src) - 1, 0);
-		GF_TEST_ASSERT(result == 0, "big test");
+		for (int i = 0; i < 2; i++) {
+			FILE *file = fopen(filename, "wb");
+			GF_TEST_ASSERT(file, "cache");
+			fputs(texts[i], file);
+			fclose(file);
+
+			for (int load = 0; load < 2; load++) {
+				int result = load == 0 && i == 0 ? gf_LoadFromFile(&loader, filename, &funcs) : gf_ReloadFromFile(&loader, filename);
+				GF_TEST_ASSERT(result == 1, "load with a cache");
+
+				// A text load keeps its tokens in a list, a mapped snapshot does not.
+				int fromCache = loader.firstToken == NULL;
+				GF_TEST_ASSERT(fromCache == load, "the cache is made by the first load and used by the second");
+
+				gf_u32 value = 0;
+				GF_TEST_ASSERT(gf_LoadVariableU32(&loader, gf_FindFirstChild(&loader, gf_GetRoot(&loader), "value"), &value) && value == (gf_u32)i + 1, texts[i]);
+			}
+		}
+		gf_Unload(&loader);
+
+		// A damaged cache is not trusted even when it is mapped at its base address. The file is loaded from its text instead.
+		FILE *file = fopen(cacheFilename, "r+b");
+		GF_TEST_ASSERT(file, "cache file");
+		gf_SnapshotHeader header;
+		GF_TEST_ASSERT(fread(&header, sizeof(header), 1, file) == 1, "cache file");
+		// The top byte of childrenHead of the root, which comes after its token, parent, next and prev.
+		fseek(file, (long)(header.nodesOffset + sizeof(gf_Token *) * 4 + 7), SEEK_SET);
+		fputc(0x7F, file);
+		fclose(file);
+
+		int result = gf_LoadFromFile(&loader, filename, &funcs);
+		gf_u32 value = 0;
+		GF_TEST_ASSERT(result == 1 && loader.firstToken != NULL, "damaged cache");
+		GF_TEST_ASSERT(gf_LoadVariableU32(&loader, gf_FindFirstChild(&loader, gf_GetRoot(&loader), "value"), &value) && value == 2, "damaged cache");
 		gf_Unload(&loader);
+		remove(filename);
+		remove(cacheFilename);
+
+		GF_TEST_ASSERT(gf_HashBytes(texts[0], 28) != gf_HashBytes(texts[1], 28), "gf_HashBytes");
+		GF_TEST_ASSERT(gf_HashBytes(texts[0], 3) != gf_HashBytes(texts[0], 4), "gf_HashBytes");
 	}
 
+#ifdef GF_SHM
 	{
-		const char *str = "a b c d e ";
+		const char *text = "units { unit { hp { 10 } } unit { hp { 20 } } } name { \"shared\" }";
+		char name[64];
+		snprintf(name, sizeof(name), "/gf_test_%ld", (long)getpid());
+
 		gf_Loader loader;
-		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
-		GF_TEST_ASSERT(result == 1, str);
+		int result = gf_LoadFromBuffer(&loader, text, gf_StringLength(text), NULL);
+		GF_TEST_ASSERT(result == 1 && gf_ShareSnapshot(&loader, name), "gf_ShareSnapshot");
+
+		gf_Saver saver;
+		gf_InitSaverWithFormat(&saver, NULL, GF_SAVER_FORMAT_COMPACT);
+		char expected[256];
+		gf_SaverBeginMemory(&saver, expected, sizeof(expected));
+		GF_TEST_ASSERT(gf_SaveNode(&saver, NULL, gf_GetRoot(&loader)), "gf_ShareSnapshot");
+		gf_Unload(&loader);
+
+		gf_LogAllocateFreeFunctions funcs;
+		memset(&funcs, 0, sizeof(funcs));
+		funcs.Log = gf_NoLog;
+
+		gf_Loader shared;
+		result = gf_AttachSnapshot(&shared, name, &funcs);
+		GF_TEST_ASSERT(result == 1, "gf_AttachSnapshot");
+		char actual[256];
+		gf_SaverBeginMemory(&saver, actual, sizeof(actual));
+		GF_TEST_ASSERT(gf_SaveNode(&saver, NULL, gf_GetRoot(&shared)), "gf_AttachSnapshot");
+		GF_TEST_ASSERT(strcmp(expected, actual) == 0, actual);
+
+		// The base address is taken by the first attach, so the second gets a copy that the builder functions can change.
+		// They fail on a read only mapping instead of writing to it.
+		gf_Loader copy;
+		result = gf_AttachSnapshot(&copy, name, &funcs);
+		GF_TEST_ASSERT(result == 1 && !copy.readOnly, "attaching twice");
+		GF_TEST_ASSERT(gf_AppendChild(&copy, gf_GetRoot(&copy), gf_CreateS64(&copy, 5)), "attaching twice");
+		gf_Unload(&copy);
+		gf_LoaderNode *unit = gf_FindFirstChild(&shared, gf_FindFirstChild(&shared, gf_GetRoot(&shared), "units"), "unit");
+		gf_LoaderNode *hp = gf_GetChild(&shared, gf_FindFirstChild(&shared, unit, "hp"));
+		GF_TEST_ASSERT(hp && gf_SetS64(&shared, hp, 5) == !shared.readOnly, "builder on a shared snapshot");
+		GF_TEST_ASSERT(!shared.readOnly || (!gf_CreateS64(&shared, 5) && !gf_RemoveNode(&shared, unit)), "builder on a shared snapshot");
+
+		// The name is taken until it is unshared. Attached loaders keep their mapping.
+		result = gf_LoadFromBuffer(&loader, text, gf_StringLength(text), &funcs);
+		GF_TEST_ASSERT(result == 1 && !gf_ShareSnapshot(&loader, name), "sharing a name twice");
 		gf_Unload(&loader);
+		GF_TEST_ASSERT(gf_UnshareSnapshot(name), "gf_UnshareSnapshot");
+		GF_TEST_ASSERT(gf_FindFirstChild(&shared, gf_GetRoot(&shared), "name"), "attached after unsharing");
+		gf_Unload(&shared);
+
+		result = gf_AttachSnapshot(&shared, name, &funcs);
+		gf_Unload(&shared);
+		GF_TEST_ASSERT(result == 0 && !gf_UnshareSnapshot(name), "attach after unsharing");
 	}
+#endif
+
 	{
-		const char *str = "a /*";
-		gf_Loader loader;
-		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
-		GF_TEST_ASSERT(result == 0, str);
-		gf_Unload(&loader);
+		const char *filename = "gf_test_index.graph";
+		const char *indexFilename = "gf_test_index.graph.gfi";
+		const char *text = "units { unit { hp { 10 } } }\n\"title\"\nversion { 2 }\n/* the second */ units { unit { hp { 20 } } } flag";
+
+		FILE *file = fopen(filename, "wb");
+		GF_TEST_ASSERT(file, "index");
+		fputs(text, file);
+		fclose(file);
+		GF_TEST_ASSERT(gf_IndexFile(filename, NULL), "gf_IndexFile");
+
+		gf_Loader whole;
+		int result = gf_LoadFromBuffer(&whole, text, gf_StringLength(text), NULL);
+		GF_TEST_ASSERT(result == 1, "index");
+		gf_LoaderNode *secondUnits = gf_FindFirstNext(&whole, gf_FindFirstChild(&whole, gf_GetRoot(&whole), "units")->next, "units");
+		GF_TEST_ASSERT(secondUnits, "index");
+
+		gf_Saver saver;
+		gf_InitSaverWithFormat(&saver, NULL, GF_SAVER_FORMAT_COMPACT);
+		char expected[256];
+		gf_SaverBeginMemory(&saver, expected, sizeof(expected));
+		GF_TEST_ASSERT(gf_SaveNode(&saver, NULL, secondUnits) && gf_SaveNode(&saver, NULL, gf_FindFirstChild(&whole, gf_GetRoot(&whole), "version")), "index");
+
+		// Both the scan and the saver make an index that loads the same records.
+		for (int i = 0; i < 2; i++) {
+			if (i == 1) {
+				gf_Saver fileSaver;
+				gf_InitSaver(&fileSaver, NULL);
+				file = fopen(filename, "wb");
+				FILE *indexFile = fopen(indexFilename, "wb");
+				GF_TEST_ASSERT(file && indexFile, "gf_SaveIndexed");
+				result = gf_SaveIndexed(&fileSaver, file, indexFile, gf_GetRoot(&whole));
+				fclose(indexFile);
+				fclose(file);
+				GF_TEST_ASSERT(result == 1, "gf_SaveIndexed");
+			}
+
+			gf_Index index;
+			GF_TEST_ASSERT(gf_OpenIndex(&index, filename, NULL) && index.recordCount == 5, "gf_OpenIndex");
+
+			gf_u64 ordinals[2] = { 0, 0 };
+			GF_TEST_ASSERT(gf_FindRecord(&index, "units", 1, &ordinals[0]) && ordinals[0] == 3, "gf_FindRecord");
+			GF_TEST_ASSERT(gf_FindRecord(&index, "version", 0, &ordinals[1]) && ordinals[1] == 2, "gf_FindRecord");
+			GF_TEST_ASSERT(!gf_FindRecord(&index, "units", 2, &ordinals[1]) && !gf_FindRecord(&index, "unit", 0, &ordinals[1]), "gf_FindRecord");
+			ordinals[1] = 2;
+
+			gf_Loader loader;
+			result = gf_LoadRecords(&loader, &index, ordinals, 2, NULL);
+			GF_TEST_ASSERT(result == 1, "gf_LoadRecords");
+			char actual[256];
+			gf_SaverBeginMemory(&saver, actual, sizeof(actual));
+			GF_TEST_ASSERT(gf_SaveNode(&saver, NULL, gf_GetRoot(&loader)), "gf_LoadRecords");
+			GF_TEST_ASSERT(strcmp(expected, actual) == 0, actual);
+			gf_Unload(&loader);
+
+			result = gf_LoadRecord(&loader, &index, "flag", NULL);
+			GF_TEST_ASSERT(result == 1 && gf_GetType(&loader, gf_GetChild(&loader, gf_GetRoot(&loader))) == GF_TOKEN_TYPE_NAME, "gf_LoadRecord");
+			gf_Unload(&loader);
+			gf_CloseIndex(&index);
+		}
+
+		gf_LogAllocateFreeFunctions funcs;
+		memset(&funcs, 0, sizeof(funcs));
+		funcs.Log = gf_NoLog;
+
+		// Changing the size of the file makes the index out of date.
+		file = fopen(filename, "ab");
+		GF_TEST_ASSERT(file, "index");
+		fputs(" more", file);
+		fclose(file);
+		gf_Index index;
+		result = gf_OpenIndex(&index, filename, &funcs);
+		gf_CloseIndex(&index);
+		GF_TEST_ASSERT(result == 0, "an out of date index");
+
+		gf_Unload(&whole);
+		remove(filename);
+		remove(indexFilename);
 	}
+
 	{
-		const char *str = "a \"";
-		gf_Loader loader;
-		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
-		GF_TEST_ASSERT(result == 0, str);
-		gf_Unload(&loader);
+		const char *filename = "gf_test_log.graph";
+		const char *indexFilename = "gf_test_log.graph.gfi";
+		const char *names[4] = { "frame", "frame", "event", "frame" };
+		remove(filename);
+
+		gf_Loader frames;
+		const char *text = "frame { time { 1 } values { 1, 2 } } frame { time { 2 } values { 3, 4 } } event { \"start\" }";
+		int result = gf_LoadFromBuffer(&frames, text, gf_StringLength(text), NULL);
+		GF_TEST_ASSERT(result == 1, "append");
+
+		gf_Saver saver;
+		gf_InitSaverWithFormat(&saver, NULL, GF_SAVER_FORMAT_SINGLE_LINE);
+
+		// Each append opens the files again, like a program that writes a snapshot now and then.
+		for (int i = 0; i < 2; i++) {
+			FILE *file = fopen(filename, "a+b");
+			FILE *indexFile = fopen(indexFilename, i == 0 ? "w+b" : "r+b");
+			GF_TEST_ASSERT(file && indexFile, "append");
+			gf_LoaderNode *node = i == 0 ? gf_GetRoot(&frames) : gf_GetChild(&frames, gf_GetRoot(&frames));
+			result = gf_AppendRecords(&saver, file, indexFile, node);
+			fclose(indexFile);
+			fclose(file);
+			GF_TEST_ASSERT(result == 1, "gf_AppendRecords");
+		}
+
+		gf_Index index;
+		GF_TEST_ASSERT(gf_OpenIndex(&index, filename, NULL) && index.recordCount == 4, "gf_AppendRecords updates the index");
+		gf_CloseIndex(&index);
+
+		// Every record is read through a buffer that starts smaller than a record.
+		gf_RecordReader reader;
+		GF_TEST_ASSERT(gf_OpenRecords(&reader, filename, 0, NULL), "gf_OpenRecords");
+		reader.readSize = 8;
+		for (int i = 0; i < 4; i++) {
+			GF_TEST_ASSERT(gf_NextRecord(&reader) == GF_RECORD_READY, names[i]);
+			gf_LoaderNode *record = gf_GetChild(&reader.loader, gf_GetRoot(&reader.loader));
+			GF_TEST_ASSERT(record && !record->next && gf_FindFirstChild(&reader.loader, gf_GetRoot(&reader.loader), names[i]) == record, names[i]);
+		}
+		GF_TEST_ASSERT(gf_NextRecord(&reader) == GF_RECORD_END, "the end of the records");
+		gf_CloseRecords(&reader);
+
+		// A tailing reader waits for records that are still being written.
+		GF_TEST_ASSERT(gf_OpenRecords(&reader, filename, 1, NULL), "gf_OpenRecords");
+		for (int i = 0; i < 4; i++) {
+			GF_TEST_ASSERT(gf_NextRecord(&reader) == GF_RECORD_READY, names[i]);
+		}
+		GF_TEST_ASSERT(gf_NextRecord(&reader) == GF_RECORD_END, "tail");
+
+		const char *parts[3] = { "late { \"a } b", "\" } fl", "ag\n" };
+		gf_RecordStatus expected[3] = { GF_RECORD_END, GF_RECORD_READY, GF_RECORD_END };
+		for (int i = 0; i < 3; i++) {
+			FILE *file = fopen(filename, "ab");
+			GF_TEST_ASSERT(file, "tail");
+			fputs(parts[i], file);
+			fclose(file);
+			GF_TEST_ASSERT(gf_NextRecord(&reader) == expected[i], parts[i]);
+			if (expected[i] == GF_RECORD_READY) {
+				gf_StringView view;
+				gf_LoaderNode *late = gf_FindFirstChild(&reader.loader, gf_GetRoot(&reader.loader), "late");
+				GF_TEST_ASSERT(gf_LoadVariableStringView(&reader.loader, late, &view) && gf_AreStringSpansEqual(view.start, view.length, "a } b", 5), parts[i]);
+			}
+		}
+		gf_CloseRecords(&reader);
+
+		// Without tailing, the end of the file ends the name at the end of it.
+		gf_LogAllocateFreeFunctions funcs;
+		memset(&funcs, 0, sizeof(funcs));
+		funcs.Log = gf_NoLog;
+		GF_TEST_ASSERT(gf_OpenRecords(&reader, filename, 0, &funcs), "gf_OpenRecords");
+		gf_RecordStatus status;
+		gf_u64 count = 0;
+		while ((status = gf_NextRecord(&reader)) == GF_RECORD_READY) {
+			count++;
+		}
+		GF_TEST_ASSERT(status == GF_RECORD_END && count == 6, "records without tailing");
+		gf_CloseRecords(&reader);
+
+		FILE *file = fopen(filename, "ab");
+		GF_TEST_ASSERT(file, "append");
+		fputs("broken { 1", file);
+		fclose(file);
+		GF_TEST_ASSERT(gf_OpenRecords(&reader, filename, 0, &funcs), "gf_OpenRecords");
+		for (gf_u64 i = 0; i < count; i++) {
+			gf_NextRecord(&reader);
+		}
+		GF_TEST_ASSERT(gf_NextRecord(&reader) == GF_RECORD_ERROR, "a file that ends inside a record");
+		gf_CloseRecords(&reader);
+
+		gf_Unload(&frames);
+		remove(filename);
+		remove(indexFilename);
 	}
+
+#ifdef GF_POSIX
 	{
-		const char *str = "1, 1.0";
-		gf_Loader loader;
-		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
-		GF_TEST_ASSERT(result == 1, str);
+		// A record appended past 4 GiB is indexed and loaded from where it is. The file is sparse, so it takes no room on disk.
+		// Builds that can only seek as far as a 32 bit long goes fail instead of seeking to the wrong place.
+		const char *filename = "gf_test_huge.graph";
+		const char *indexFilename = "gf_test_huge.graph.gfi";
+		gf_u64 fileSize = 0x100000000ULL + 10;
+#ifdef GF_FSEEKO
+		int wide = sizeof(off_t) >= 8;
+#else
+		int wide = sizeof(long) >= 8;
+#endif
 
-		gf_LoaderNode *root = gf_GetRoot(&loader);
-		gf_LoaderNode *intNode = gf_GetChild(&loader, root);
-		GF_TEST_ASSERT(intNode, str);
-		GF_TEST_ASSERT(gf_GetType(&loader, intNode) == GF_TOKEN_TYPE_INTEGER, str);
-		gf_LoaderNode *floatNode = gf_GetNext(&loader, intNode);
-		GF_TEST_ASSERT(floatNode, str);
-		GF_TEST_ASSERT(gf_GetType(&loader, floatNode) == GF_TOKEN_TYPE_FLOAT, str);
-		gf_Unload(&loader);
+		FILE *file = fopen(filename, "wb");
+		GF_TEST_ASSERT(file, "a file past 4 GiB");
+		int seeked = gf_SeekFile(file, (gf_s64)fileSize - 1, SEEK_SET) && fputc('\n', file) != EOF;
+		fclose(file);
+		GF_TEST_ASSERT(seeked == wide, "gf_SeekFile past 4 GiB");
+
+		if (wide) {
+			gf_u64 size = 0;
+			file = fopen(filename, "r+b");
+			GF_TEST_ASSERT(file && gf_GetOpenFileSize(file, &size) && size == fileSize, "gf_GetOpenFileSize past 4 GiB");
+
+			// An index of no records for the file as it is.
+			char footer[GF_INDEX_HEADER_SIZE + GF_INDEX_FOOTER_SIZE] = { 'G', 'F', 'I', GF_INDEX_VERSION, 0, 0, 0, 0 };
+			gf_WriteU64LE(footer + GF_INDEX_HEADER_SIZE, 0);
+			gf_WriteU64LE(footer + GF_INDEX_HEADER_SIZE + 8, fileSize);
+			FILE *indexFile = fopen(indexFilename, "w+b");
+			GF_TEST_ASSERT(indexFile && fwrite(footer, sizeof(footer), 1, indexFile) == 1, "a file past 4 GiB");
+
+			gf_Loader loader;
+			const char *text = "big { 7 }";
+			GF_TEST_ASSERT(gf_LoadFromBuffer(&loader, text, gf_StringLength(text), NULL), "a file past 4 GiB");
+			gf_Saver saver;
+			gf_InitSaverWithFormat(&saver, NULL, GF_SAVER_FORMAT_SINGLE_LINE);
+			int result = gf_AppendRecords(&saver, file, indexFile, gf_GetRoot(&loader));
+			fclose(indexFile);
+			fclose(file);
+			gf_Unload(&loader);
+			GF_TEST_ASSERT(result == 1, "gf_AppendRecords past 4 GiB");
+
+			gf_Index index;
+			GF_TEST_ASSERT(gf_OpenIndex(&index, filename, NULL) && index.recordCount == 1 && index.records[0].offset == fileSize, "gf_AppendRecords past 4 GiB");
+			gf_u32 value = 0;
+			result = gf_LoadRecord(&loader, &index, "big", NULL);
+			GF_TEST_ASSERT(result == 1 && gf_LoadVariableU32(&loader, gf_FindFirstChild(&loader, gf_GetRoot(&loader), "big"), &value) && value == 7, "gf_LoadRecord past 4 GiB");
+			gf_Unload(&loader);
+			gf_CloseIndex(&index);
+		}
+		remove(filename);
+		remove(indexFilename);
 	}
+#endif
+
 	{
-		const char *str =
-			"MyStruct {\n"
-			"  a { 3.14000 }\n"
-			"  b { 101 }\n"
-			"  c { -13 }\n"
-			"  str { \"hello\" }\n"
-			"}\n";
+		const char *filenames[5] = { "gf_test_batch0.graph", "gf_test_batch1.graph", "gf_test_batch2.graph", "gf_test_batch_missing.graph", "gf_test_batch4.graph" };
+		for (int i = 0; i < 5; i++) {
+			if (i == 3) {
+				continue;
+			}
+			FILE *file = fopen(filenames[i], "wb");
+			GF_TEST_ASSERT(file, "batch");
+			fprintf(file, "file { %d } ", i);
+			for (int j = 0; j < 1000 * i; j++) {
+				fprintf(file, "padding { %d } ", j);
+			}
+			fclose(file);
+		}
+
+		gf_LogAllocateFreeFunctions funcs;
+		memset(&funcs, 0, sizeof(funcs));
+		funcs.Log = gf_NoLog;
+
+		// Each file ends up in its own loader whatever thread loaded it, and the missing one fails on its own.
+		gf_u32 threadCounts[3] = { 1, 3, 0 };
+		for (int t = 0; t < 3; t++) {
+			gf_Loader loaders[5];
+			int results[5];
+			int result = gf_LoadBatch(loaders, filenames, results, 5, threadCounts[t], &funcs);
+			GF_TEST_ASSERT(result == 0 && results[3] == 0, "gf_LoadBatch");
+			for (int i = 0; i < 5; i++) {
+				if (i != 3) {
+					gf_s32 value = -1;
+					GF_TEST_ASSERT(results[i] == 1 && gf_LoadVariableS32(&loaders[i], gf_FindFirstChild(&loaders[i], gf_GetRoot(&loaders[i]), "file"), &value) && value == i, filenames[i]);
+				}
+				gf_Unload(&loaders[i]);
+			}
+		}
 
 		gf_Loader loader;
-		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
-		GF_TEST_ASSERT(result == 1, str);
+		GF_TEST_ASSERT(gf_LoadBatch(&loader, filenames, NULL, 1, 4, NULL), "gf_LoadBatch");
 		gf_Unload(&loader);
+		GF_TEST_ASSERT(gf_LoadBatch(NULL, NULL, NULL, 0, 0, NULL), "an empty batch");
+
+		// The same file on every thread makes its cache on all of them at once. Each writes its own temporary file, so the
+		// cache that is left is a whole one.
+		const char *sameFilenames[4] = { filenames[4], filenames[4], filenames[4], filenames[4] };
+		funcs.loaderFlags = GF_LOADER_FLAG_CACHE;
+		for (int load = 0; load < 2; load++) {
+			gf_Loader loaders[4];
+			int results[4];
+			GF_TEST_ASSERT(gf_LoadBatch(loaders, sameFilenames, results, 4, 4, &funcs), "gf_LoadBatch with a cache");
+			for (int i = 0; i < 4; i++) {
+				gf_s32 value = -1;
+				GF_TEST_ASSERT(gf_LoadVariableS32(&loaders[i], gf_FindFirstChild(&loaders[i], gf_GetRoot(&loaders[i]), "file"), &value) && value == 4, "gf_LoadBatch with a cache");
+				GF_TEST_ASSERT(load == 0 || loaders[i].firstToken == NULL, "the cache made by the batch is used");
+				gf_Unload(&loaders[i]);
+			}
+		}
+		remove("gf_test_batch4.graph.gfs");
+
+		for (int i = 0; i < 5; i++) {
+			remove(filenames[i]);
+		}
 	}
+
 	{
-		const char *str =
-			"1.0\n"
-			"2.0\n"
-			"Hello\n";
-		gf_Loader loader;
-		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
-		GF_TEST_ASSERT(result == 1, str);
-		gf_Unload(&loader);
+		const char *filenames[6] = { "gf_test_files0.graph", "gf_test_files1.graph", "gf_test_files_missing.graph", "gf_test_files3.graph", "gf_test_files4.graph", "gf_test_files5.graph" };
+		for (int i = 0; i < 6; i++) {
+			if (i == 2) {
+				continue;
+			}
+			FILE *file = fopen(filenames[i], "wb");
+			GF_TEST_ASSERT(file, "files");
+			// The last file is empty.
+			if (i != 5) {
+				fprintf(file, "file { %d } ", i);
+				for (int j = 0; j < 2000 * i; j++) {
+					fprintf(file, "padding { %d } ", j);
+				}
+			}
+			fclose(file);
+		}
+
+		gf_LogAllocateFreeFunctions funcs;
+		memset(&funcs, 0, sizeof(funcs));
+		funcs.Log = gf_NoLog;
+
+		// Fewer reads in flight than files makes later files wait for a free slot.
+		gf_u32 readsInFlight[3] = { 1, 2, 0 };
+		for (int r = 0; r < 3; r++) {
+			gf_Loader loaders[6];
+			int results[6];
+			int result = gf_LoadFiles(loaders, filenames, results, 6, readsInFlight[r], &funcs);
+			GF_TEST_ASSERT(result == 0 && results[2] == 0 && results[5] == 1 && !gf_GetChild(&loaders[5], gf_GetRoot(&loaders[5])), "gf_LoadFiles");
+			for (int i = 0; i < 6; i++) {
+				if (i != 2 && i != 5) {
+					gf_s32 value = -1;
+					GF_TEST_ASSERT(results[i] == 1 && gf_LoadVariableS32(&loaders[i], gf_FindFirstChild(&loaders[i], gf_GetRoot(&loaders[i]), "file"), &value) && value == i, filenames[i]);
+				}
+				gf_Unload(&loaders[i]);
+			}
+		}
+
+		GF_TEST_ASSERT(gf_LoadFiles(NULL, NULL, NULL, 0, 0, NULL), "no files");
+
+		for (int i = 0; i < 6; i++) {
+			remove(filenames[i]);
+		}
 	}
+
 	{
-		const char *str = "/* this is a comment */";
+		const char *filename = "gf_test_pipeline.graph";
+		FILE *file = fopen(filename, "wb");
+		GF_TEST_ASSERT(file, "pipeline");
+		for (int i = 0; i < 50; i++) {
+			fprintf(file, "record%d { id { %d } value { -%d.25 } /* a /* nested */ comment */\r\n  name { \"item \\\"%d\\\"\" } flags { +1, 22, 333 } }\n", i, i, i, i);
+		}
+		fclose(file);
+
 		gf_Loader loader;
-		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
-		GF_TEST_ASSERT(result == 1, str);
+		GF_TEST_ASSERT(gf_LoadFromFile(&loader, filename, NULL), "pipeline");
+		gf_Saver saver;
+		gf_InitSaver(&saver, NULL);
+		gf_SaverBeginMeasure(&saver);
+		GF_TEST_ASSERT(gf_SaveNode(&saver, NULL, gf_GetRoot(&loader)), "pipeline");
+		gf_u64 count = gf_SaverGetWrittenCount(&saver);
+		char *expected = (char *)malloc(count + 1);
+		char *out = (char *)malloc(count + 1);
+		gf_SaverBeginMemory(&saver, expected, count + 1);
+		GF_TEST_ASSERT(gf_SaveNode(&saver, NULL, gf_GetRoot(&loader)), "pipeline");
+		gf_Unload(&loader);
+
+		// Small blocks cut every kind of token in two somewhere.
+		gf_u64 blockSizes[5] = { 1, 2, 7, 100, GF_PIPELINE_BLOCK_SIZE };
+		for (int b = 0; b < 5; b++) {
+			gf_InitLoader(&loader, NULL);
+			GF_TEST_ASSERT(gf_LoadFileWithPipeline(&loader, filename, blockSizes[b]), "gf_LoadFileWithPipeline");
+			gf_SaverBeginMemory(&saver, out, count + 1);
+			GF_TEST_ASSERT(gf_SaveNode(&saver, NULL, gf_GetRoot(&loader)), "gf_LoadFileWithPipeline");
+			GF_TEST_ASSERT(gf_AreStringSpansEqual(out, count, expected, count), "gf_LoadFileWithPipeline");
+			// Only the blocks and the token cut off at the end of them are kept, never the whole file.
+			GF_TEST_ASSERT(blockSizes[b] == GF_PIPELINE_BLOCK_SIZE || loader.fileContentsCapacity * 4 < count, "gf_LoadFileWithPipeline memory");
+			gf_Unload(&loader);
+		}
+
+		gf_LogAllocateFreeFunctions funcs;
+		memset(&funcs, 0, sizeof(funcs));
+		funcs.Log = gf_TestLogPosition;
+
+		// Errors are at the line and column they are at in the file, though the blocks they were in are gone.
+		const char *invalid = "a {\r\n  b { 1 }\n\n  c { { 2 } }\n}";
+		file = fopen(filename, "wb");
+		GF_TEST_ASSERT(file, "pipeline");
+		fputs(invalid, file);
+		fclose(file);
+		gf_TestLoggedLineno = 0;
+		gf_InitLoader(&loader, &funcs);
+		GF_TEST_ASSERT(!gf_LoadFileWithPipeline(&loader, filename, 2), invalid);
+		GF_TEST_ASSERT(gf_TestLoggedLineno == 4 && gf_TestLoggedColno == 7, invalid);
+		gf_Unload(&loader);
+
+		file = fopen(filename, "wb");
+		GF_TEST_ASSERT(file, "pipeline");
+		GF_TEST_ASSERT(fwrite(expected, (size_t)count, 1, file) == 1, "pipeline");
+		fclose(file);
+		funcs.Log = gf_NoLog;
+		funcs.loaderFlags = GF_LOADER_FLAG_PIPELINE;
+		GF_TEST_ASSERT(gf_LoadFromFile(&loader, filename, &funcs), "GF_LOADER_FLAG_PIPELINE");
+		GF_TEST_ASSERT(gf_ReloadFromFile(&loader, filename), "GF_LOADER_FLAG_PIPELINE");
+		gf_SaverBeginMemory(&saver, out, count + 1);
+		GF_TEST_ASSERT(gf_SaveNode(&saver, NULL, gf_GetRoot(&loader)), "GF_LOADER_FLAG_PIPELINE");
+		GF_TEST_ASSERT(gf_AreStringSpansEqual(out, count, expected, count), "GF_LOADER_FLAG_PIPELINE");
+
+		// Binary files load through the pipeline too.
+		file = fopen(filename, "wb");
+		gf_InitSaver(&saver, NULL);
+		GF_TEST_ASSERT(file && gf_SaveBinary(&saver, file, gf_GetRoot(&loader)), "pipeline binary");
+		fclose(file);
+		gf_Unload(&loader);
+		gf_InitLoader(&loader, &funcs);
+		GF_TEST_ASSERT(gf_LoadFileWithPipeline(&loader, filename, 3), "pipeline binary");
+		gf_s32 id = -1;
+		gf_LoaderNode *record = gf_FindFirstChild(&loader, gf_GetRoot(&loader), "record49");
+		GF_TEST_ASSERT(gf_LoadVariableS32(&loader, gf_FindFirstChild(&loader, record, "id"), &id) && id == 49, "pipeline binary");
 		gf_Unload(&loader);
+
+		// A string that is still open when the file ends fails, however the file was cut into blocks.
+		const char *broken[3] = { "a { \"never ends }", "a { 1 } b { -", "a { 1 } } " };
+		for (int i = 0; i < 3; i++) {
+			file = fopen(filename, "wb");
+			GF_TEST_ASSERT(file, "pipeline");
+			fputs(broken[i], file);
+			fclose(file);
+			gf_InitLoader(&loader, &funcs);
+			GF_TEST_ASSERT(!gf_LoadFileWithPipeline(&loader, filename, 2), broken[i]);
+			gf_Unload(&loader);
+		}
+
+		free(expected);
+		free(out);
+		remove(filename);
+	}
+
+	{
+		// Runs, repeated text and bytes that never repeat all come back the same.
+		char source[3000];
+		char compressed[GF_COMPRESS_BOUND(3000)];
+		char back[3000];
+		gf_u32 *table = (gf_u32 *)malloc(sizeof(gf_u32) << GF_COMPRESS_HASH_BITS);
+		GF_TEST_ASSERT(table, "gf_CompressBlock");
+		gf_u32 random = 12345;
+		for (int kind = 0; kind < 3; kind++) {
+			for (gf_u64 i = 0; i < sizeof(source); i++) {
+				random = random * 1103515245u + 12345u;
+				source[i] = kind == 0 ? ' ' : kind == 1 ? "name { 12 }\n"[i % 12] : (char)(random >> 24);
+			}
+			gf_u64 lengths[4] = { 0, 3, 100, sizeof(source) };
+			for (int l = 0; l < 4; l++) {
+				gf_u64 compressedLength = gf_CompressBlock(source, lengths[l], compressed, table);
+				GF_TEST_ASSERT(compressedLength <= GF_COMPRESS_BOUND(lengths[l]), "gf_CompressBlock");
+				GF_TEST_ASSERT(gf_DecompressBlock(compressed, compressedLength, back, lengths[l]) && memcmp(source, back, (size_t)lengths[l]) == 0, "gf_DecompressBlock");
+				GF_TEST_ASSERT(lengths[l] == 0 || !gf_DecompressBlock(compressed, compressedLength, back, lengths[l] - 1), "gf_DecompressBlock too long");
+				if (kind < 2 && lengths[l] == sizeof(source)) {
+					GF_TEST_ASSERT(compressedLength * 20 < lengths[l], "gf_CompressBlock repeated text");
+				}
+			}
+		}
+		free(table);
 	}
+
 	{
-		const char *str =
-			"MyStruct {\n"
-			"  a { 3.14000 }\n"
-			"  b { *$3dnNONSENSE }\n"
-			"  c { -13 }\n"
-			"  str { \"hello\" }\n"
-			"}\n";
+		const char *textFilename = "gf_test_compress.graph";
+		const char *filename = "gf_test_compress.gfz";
+		FILE *file = fopen(textFilename, "wb");
+		GF_TEST_ASSERT(file, "compress");
+		for (int i = 0; i < 3000; i++) {
+			fprintf(file, "record%d { id { %d } value { -%d.25 } name { \"item \\\"%d\\\"\" } flags { +1, 22, 333 } }\n", i, i, i, i);
+		}
+		fclose(file);
 
 		gf_Loader loader;
-		int result = gf_LoadFromBuffer(&loader, str, gf_StringLength(str), NULL);
-		GF_TEST_ASSERT(result == 0, str);
+		GF_TEST_ASSERT(gf_LoadFromFile(&loader, textFilename, NULL), "compress");
+		gf_Saver saver;
+		gf_InitSaver(&saver, NULL);
+		gf_SaverBeginMeasure(&saver);
+		GF_TEST_ASSERT(gf_SaveNode(&saver, NULL, gf_GetRoot(&loader)), "compress");
+		gf_u64 count = gf_SaverGetWrittenCount(&saver);
+		char *expected = (char *)malloc(count + 1);
+		char *out = (char *)malloc(count + 1);
+		gf_SaverBeginMemory(&saver, expected, count + 1);
+		GF_TEST_ASSERT(gf_SaveNode(&saver, NULL, gf_GetRoot(&loader)), "compress");
+
+		gf_Compressor compressor;
+		file = fopen(filename, "wb");
+		GF_TEST_ASSERT(file && gf_SaverBeginCompressed(&saver, &compressor, file, NULL), "gf_SaverBeginCompressed");
+		GF_TEST_ASSERT(gf_SaveNode(&saver, NULL, gf_GetRoot(&loader)) && gf_SaverGetWrittenCount(&saver) == count, "gf_SaverBeginCompressed");
+		GF_TEST_ASSERT(gf_SaverEndCompressed(&saver) && saver.target == GF_SAVER_TARGET_FILE, "gf_SaverEndCompressed");
+		fclose(file);
+		gf_Unload(&loader);
+
+		gf_u64 compressedSize = 0;
+		gf_s64 modified = 0;
+		GF_TEST_ASSERT(gf_GetFileInfo(filename, &compressedSize, &modified) && compressedSize * 4 < count, "compressed size");
+
+		// It loads like text, one block at a time or in one go.
+		gf_LogAllocateFreeFunctions funcs;
+		memset(&funcs, 0, sizeof(funcs));
+		funcs.Log = gf_NoLog;
+		gf_u32 flags[2] = { GF_LOADER_FLAG_NONE, GF_LOADER_FLAG_PIPELINE };
+		for (int f = 0; f < 2; f++) {
+			funcs.loaderFlags = flags[f];
+			GF_TEST_ASSERT(gf_LoadFromFile(&loader, filename, &funcs), "load compressed");
+			GF_TEST_ASSERT(gf_ReloadFromFile(&loader, filename), "reload compressed");
+			gf_SaverBeginMemory(&saver, out, count + 1);
+			GF_TEST_ASSERT(gf_SaveNode(&saver, NULL, gf_GetRoot(&loader)), "load compressed");
+			GF_TEST_ASSERT(gf_AreStringSpansEqual(out, count, expected, count), "load compressed");
+			gf_Unload(&loader);
+		}
+
+		gf_Loader storage;
+		gf_InitLoader(&storage, &funcs);
+		gf_u64 compressedCount = 0;
+		GF_TEST_ASSERT(gf_ReadFileIntoLoader(&storage, filename, &compressedCount), "load compressed buffer");
+		GF_TEST_ASSERT(gf_LoadFromBuffer(&loader, storage.fileContentsBuffer, compressedCount, &funcs), "load compressed buffer");
+		gf_SaverBeginMemory(&saver, out, count + 1);
+		GF_TEST_ASSERT(gf_SaveNode(&saver, NULL, gf_GetRoot(&loader)), "load compressed buffer");
+		GF_TEST_ASSERT(gf_AreStringSpansEqual(out, count, expected, count), "load compressed buffer");
+		gf_Unload(&loader);
+
+		// A broken byte anywhere fails to load or loads something else, but never reads or writes outside the buffers.
+		char *broken = (char *)malloc(compressedCount);
+		for (gf_u64 i = 0; i < compressedCount; i += 97) {
+			memcpy(broken, storage.fileContentsBuffer, (size_t)compressedCount);
+			broken[i] = (char)(broken[i] ^ 0x5A);
+			gf_LoadFromBuffer(&loader, broken, compressedCount, &funcs);
+			gf_Unload(&loader);
+		}
+		free(broken);
+
+		// A file cut short fails.
+		file = fopen(filename, "wb");
+		GF_TEST_ASSERT(file, "compress");
+		fwrite(storage.fileContentsBuffer, (size_t)(compressedCount / 2), 1, file);
+		fclose(file);
+		funcs.loaderFlags = GF_LOADER_FLAG_NONE;
+		GF_TEST_ASSERT(!gf_LoadFromFile(&loader, filename, &funcs), "truncated compressed file");
 		gf_Unload(&loader);
+		GF_TEST_ASSERT(!gf_LoadFromBuffer(&loader, storage.fileContentsBuffer, compressedCount / 2, &funcs), "truncated compressed buffer");
+		gf_Unload(&loader);
+		gf_Unload(&storage);
+
+		GF_TEST_ASSERT(gf_CompressFile(textFilename, filename, NULL), "gf_CompressFile");
+		GF_TEST_ASSERT(gf_LoadFromFile(&loader, filename, NULL), "gf_CompressFile");
+		gf_s32 id = -1;
+		gf_LoaderNode *record = gf_FindFirstChild(&loader, gf_GetRoot(&loader), "record2999");
+		GF_TEST_ASSERT(gf_LoadVariableS32(&loader, gf_FindFirstChild(&loader, record, "id"), &id) && id == 2999, "gf_CompressFile");
+		gf_Unload(&loader);
+
+		free(expected);
+		free(out);
+		remove(textFilename);
+		remove(filename);
 	}
 
 	puts("All tests passed!");